@@ -179,6 +179,35 @@ TEST(Capability, TailCall) {
   EXPECT_EQ(1, callerCallCount);
 }
 
+TEST(Capability, RepeatedPipelinedCalls) {
+  // Many pipelined calls on the same path should share one capability and arrive in order.
+
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int callCount = 0;
+  test::TestTailCallee::Client callee(kj::heap<TestTailCalleeImpl>(callCount));
+
+  auto request = callee.fooRequest();
+  request.setI(123);
+  auto promise = request.send();
+
+  auto firstHook = ClientHook::from(promise.getC());
+  EXPECT_EQ(firstHook.get(), ClientHook::from(promise.getC()).get());
+
+  kj::Vector<RemotePromise<test::TestCallOrder::GetCallSequenceResults>> calls;
+  for (uint i = 0; i < 100; i++) {
+    auto call = promise.getC().getCallSequenceRequest();
+    call.setExpected(i);
+    calls.add(call.send());
+  }
+
+  for (uint i = 0; i < calls.size(); i++) {
+    EXPECT_EQ(i, calls[i].wait(waitScope).getN());
+  }
+  EXPECT_EQ(1, callCount);
+}
+
 TEST(Capability, AsyncCancelation) {
   // Tests allowCancellation().
 
@@ -1031,6 +1060,151 @@ TEST(Capability, TransferCap) {
   }).wait(waitScope);
 }
 
+class TestDeadlineImpl final: public test::TestInterface::Server {
+public:
+  int callCount = 0;
+  kj::Maybe<kj::TimePoint> deadline;
+
+protected:
+  kj::Promise<void> foo(FooContext context) override {
+    ++callCount;
+    deadline = context.getDeadline();
+    context.getResults().setX("foo");
+    return kj::READY_NOW;
+  }
+};
+
+TEST(Capability, Deadline) {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>() + 100 * kj::SECONDS);
+
+  auto serverImpl = kj::heap<TestDeadlineImpl>();
+  auto& server = *serverImpl;
+  test::TestInterface::Client client(kj::mv(serverImpl));
+
+  {
+    auto request = client.fooRequest();
+    request.setTimeout(timer, 5 * kj::SECONDS);
+    EXPECT_EQ("foo", request.send().wait(waitScope).getX());
+    EXPECT_TRUE(KJ_ASSERT_NONNULL(server.deadline) == timer.now() + 5 * kj::SECONDS);
+  }
+
+  {
+    auto request = client.fooRequest();
+    request.send().wait(waitScope);
+    EXPECT_TRUE(server.deadline == nullptr);
+  }
+
+  {
+    // A call queued on a promise that resolves after the deadline is never delivered.
+    auto paf = kj::newPromiseAndFulfiller<test::TestInterface::Client>();
+    test::TestInterface::Client promiseClient(kj::mv(paf.promise));
+
+    auto request = promiseClient.fooRequest();
+    request.setTimeout(timer, 5 * kj::SECONDS);
+    auto promise = request.send();
+
+    timer.advanceTo(timer.now() + 5 * kj::SECONDS);
+    paf.fulfiller->fulfill(kj::cp(client));
+
+    KJ_IF_MAYBE(e, kj::runCatchingExceptions([&]() { promise.wait(waitScope); })) {
+      EXPECT_EQ(kj::Exception::Type::OVERLOADED, e->getType());
+    } else {
+      ADD_FAILURE() << "Expected call to fail.";
+    }
+    kj::evalLater([]() {}).wait(waitScope);
+    kj::evalLater([]() {}).wait(waitScope);
+    EXPECT_EQ(2, server.callCount);
+  }
+}
+
+class CountingClientHook final: public ClientHook, public kj::Refcounted {
+  // Forwards to another capability, counting the references and calls made through it.
+
+public:
+  CountingClientHook(kj::Own<ClientHook>&& inner): inner(kj::mv(inner)) {}
+
+  uint addRefCount = 0;
+  uint newCallCount = 0;
+  uint newCallWithRefCount = 0;
+
+  Request<AnyPointer, AnyPointer> newCall(
+      uint64_t interfaceId, uint16_t methodId, kj::Maybe<MessageSize> sizeHint) override {
+    ++newCallCount;
+    return inner->newCall(interfaceId, methodId, sizeHint);
+  }
+
+  Request<AnyPointer, AnyPointer> newCallWithRef(
+      kj::Own<ClientHook>&& self, uint64_t interfaceId, uint16_t methodId,
+      kj::Maybe<MessageSize> sizeHint) override {
+    ++newCallWithRefCount;
+    self = nullptr;
+    return inner->newCall(interfaceId, methodId, sizeHint);
+  }
+
+  VoidPromiseAndPipeline call(uint64_t interfaceId, uint16_t methodId,
+                              kj::Own<CallContextHook>&& context) override {
+    return inner->call(interfaceId, methodId, kj::mv(context));
+  }
+
+  kj::Maybe<ClientHook&> getResolved() override { return nullptr; }
+  kj::Maybe<kj::Promise<kj::Own<ClientHook>>> whenMoreResolved() override { return nullptr; }
+
+  kj::Own<ClientHook> addRef() override {
+    ++addRefCount;
+    return kj::addRef(*this);
+  }
+
+  const void* getBrand() override { return nullptr; }
+
+private:
+  kj::Own<ClientHook> inner;
+};
+
+TEST(Capability, RvalueClientsDontAddRefs) {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int callCount = 0;
+  auto counterOwn = kj::refcounted<CountingClientHook>(ClientHook::from(
+      test::TestInterface::Client(kj::heap<TestInterfaceImpl>(callCount))));
+  auto& counter = *counterOwn;
+  Capability::Client client(kj::mv(counterOwn));
+
+  // Copies and lvalue casts add references; moves and rvalue casts don't.
+  Capability::Client copy = client;
+  EXPECT_EQ(1u, counter.addRefCount);
+  auto typed = kj::mv(copy).castAs<test::TestInterface>();
+  EXPECT_EQ(1u, counter.addRefCount);
+  auto typed2 = client.castAs<test::TestInterface>();
+  EXPECT_EQ(2u, counter.addRefCount);
+
+  // An rvalue client hands its reference to the request.
+  {
+    auto request = kj::mv(typed).castAs<Capability>()
+        .typelessRequest(typeId<test::TestInterface>(), 0, nullptr);
+    auto params = request.initAs<test::TestInterface::FooParams>();
+    params.setI(123);
+    params.setJ(true);
+    auto response = request.send().wait(waitScope);
+    EXPECT_EQ("foo", response.getAs<test::TestInterface::FooResults>().getX());
+  }
+  EXPECT_EQ(2u, counter.addRefCount);
+  EXPECT_EQ(0u, counter.newCallCount);
+  EXPECT_EQ(1u, counter.newCallWithRefCount);
+
+  // Generated methods on an lvalue go through newCall() as usual.
+  {
+    auto request = typed2.fooRequest();
+    request.setI(123);
+    request.setJ(true);
+    EXPECT_EQ("foo", request.send().wait(waitScope).getX());
+  }
+  EXPECT_EQ(1u, counter.newCallCount);
+  EXPECT_EQ(2, callCount);
+}
+
 }  // namespace
 }  // namespace _
 }  // namespace capnp
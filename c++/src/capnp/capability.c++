@@ -88,6 +88,14 @@ kj::Promise<void> Capability::Server::internalUnimplemented(
 
 ResponseHook::~ResponseHook() noexcept(false) {}
 
+Request<AnyPointer, AnyPointer> ClientHook::newCallWithRef(
+    kj::Own<ClientHook>&& self, uint64_t interfaceId, uint16_t methodId,
+    kj::Maybe<MessageSize> sizeHint) {
+  auto result = newCall(interfaceId, methodId, sizeHint);
+  self = nullptr;
+  return result;
+}
+
 kj::Promise<void> ClientHook::whenResolved() {
   KJ_IF_MAYBE(promise, whenMoreResolved()) {
     return promise->then([](kj::Own<ClientHook>&& resolution) {
@@ -119,9 +127,20 @@ public:
 class LocalCallContext final: public CallContextHook, public kj::Refcounted {
 public:
   LocalCallContext(kj::Own<MallocMessageBuilder>&& request, kj::Own<ClientHook> clientRef,
-                   kj::Own<kj::PromiseFulfiller<void>> cancelAllowedFulfiller)
+                   kj::Own<kj::PromiseFulfiller<void>> cancelAllowedFulfiller,
+                   kj::Maybe<kj::Own<CallContextHook>> resultsTarget = nullptr)
       : request(kj::mv(request)), clientRef(kj::mv(clientRef)),
-        cancelAllowedFulfiller(kj::mv(cancelAllowedFulfiller)) {}
+        cancelAllowedFulfiller(kj::mv(cancelAllowedFulfiller)),
+        resultsTarget(kj::mv(resultsTarget)) {}
+
+  void setDeadline(kj::Timer& timer, kj::TimePoint deadline) {
+    this->timer = timer;
+    this->deadline = deadline;
+  }
+
+  void setTraceContext(kj::Array<byte> context) {
+    traceContext = kj::mv(context);
+  }
 
   AnyPointer::Reader getParams() override {
     KJ_IF_MAYBE(r, request) {
@@ -134,6 +153,9 @@ public:
     request = nullptr;
   }
   AnyPointer::Builder getResults(kj::Maybe<MessageSize> sizeHint) override {
+    KJ_IF_MAYBE(t, resultsTarget) {
+      return t->get()->getResults(sizeHint);
+    }
     if (response == nullptr) {
       auto localResponse = kj::refcounted<LocalResponse>(sizeHint);
       responseBuilder = localResponse->message.getRoot<AnyPointer>();
@@ -151,6 +173,11 @@ public:
   ClientHook::VoidPromiseAndPipeline directTailCall(kj::Own<RequestHook>&& request) override {
     KJ_REQUIRE(response == nullptr, "Can't call tailCall() after initializing the results struct.");
 
+    KJ_IF_MAYBE(t, resultsTarget) {
+      // Our results belong to the context that tail-called us, so pass the buck.
+      return t->get()->directTailCall(kj::mv(request));
+    }
+
     auto promise = request->send();
 
     auto voidPromise = promise.then([this](Response<AnyPointer>&& tailResponse) {
@@ -170,6 +197,20 @@ public:
   kj::Own<CallContextHook> addRef() override {
     return kj::addRef(*this);
   }
+  kj::Maybe<kj::TimePoint> getDeadline() override {
+    return deadline;
+  }
+  kj::ArrayPtr<const byte> getTraceContext() override {
+    // A local call doesn't get a span of its own, so calls made on its behalf belong to its
+    // caller's.
+    return traceContext;
+  }
+  bool isPastDeadline() override {
+    KJ_IF_MAYBE(t, timer) {
+      return t->now() >= KJ_ASSERT_NONNULL(deadline);
+    }
+    return false;
+  }
 
   kj::Maybe<kj::Own<MallocMessageBuilder>> request;
   kj::Maybe<Response<AnyPointer>> response;
@@ -177,6 +218,28 @@ public:
   kj::Own<ClientHook> clientRef;
   kj::Maybe<kj::Own<kj::PromiseFulfiller<AnyPointer::Pipeline>>> tailCallPipelineFulfiller;
   kj::Own<kj::PromiseFulfiller<void>> cancelAllowedFulfiller;
+
+  kj::Maybe<kj::Own<CallContextHook>> resultsTarget;
+  // If non-null, this call is the target of a tail call made by `resultsTarget`, and results are
+  // built directly in its results rather than in `response`.
+
+  kj::Maybe<kj::Timer&> timer;
+  kj::Maybe<kj::TimePoint> deadline;
+  // Set by setDeadline() if the caller set a timeout.
+
+  kj::Array<byte> traceContext;
+  // Set by setTraceContext() if the caller set a trace parent.
+};
+
+class TailCallTargetResponse final: public ResponseHook {
+  // Keeps the LocalCallContext (and through it, the tail-calling context holding the results)
+  // alive for a response returned by `LocalRequest::sendWithResultsIn()`.
+
+public:
+  TailCallTargetResponse(kj::Own<LocalCallContext>&& context): context(kj::mv(context)) {}
+
+private:
+  kj::Own<LocalCallContext> context;
 };
 
 class LocalRequest final: public RequestHook {
@@ -187,6 +250,43 @@ public:
         interfaceId(interfaceId), methodId(methodId), client(kj::mv(client)) {}
 
   RemotePromise<AnyPointer> send() override {
+    return sendImpl(nullptr);
+  }
+
+  kj::Maybe<RemotePromise<AnyPointer>> sendWithResultsIn(CallContextHook& context) override {
+    return sendImpl(context.addRef());
+  }
+
+  void setTimeout(kj::Timer& timer, kj::Duration timeout) override {
+    this->timer = timer;
+    this->timeout = timeout;
+  }
+
+  void setTraceParent(kj::ArrayPtr<const byte> context) override {
+    if (context.size() > 0) {
+      traceParent = kj::heapArray(context);
+    }
+  }
+
+  const void* getBrand() override {
+    return nullptr;
+  }
+
+  kj::Own<MallocMessageBuilder> message;
+
+private:
+  uint64_t interfaceId;
+  uint16_t methodId;
+  kj::Own<ClientHook> client;
+
+  kj::Maybe<kj::Timer&> timer;
+  kj::Duration timeout = 0 * kj::NANOSECONDS;
+  // Set by setTimeout().
+
+  kj::Array<byte> traceParent;
+  // Set by setTraceParent().
+
+  RemotePromise<AnyPointer> sendImpl(kj::Maybe<kj::Own<CallContextHook>> resultsTarget) {
     KJ_REQUIRE(message.get() != nullptr, "Already called send() on this request.");
 
     // For the lambda capture.
@@ -194,10 +294,17 @@ public:
     uint16_t methodId = this->methodId;
 
     auto cancelPaf = kj::newPromiseAndFulfiller<void>();
+    bool redirected = resultsTarget != nullptr;
 
+    // The request is single-use, so the context can take over our reference to the client.
+    ClientHook& target = *client;
     auto context = kj::refcounted<LocalCallContext>(
-        kj::mv(message), client->addRef(), kj::mv(cancelPaf.fulfiller));
-    auto promiseAndPipeline = client->call(interfaceId, methodId, kj::addRef(*context));
+        kj::mv(message), kj::mv(client), kj::mv(cancelPaf.fulfiller), kj::mv(resultsTarget));
+    KJ_IF_MAYBE(t, timer) {
+      context->setDeadline(*t, t->now() + timeout);
+    }
+    context->setTraceContext(kj::mv(traceParent));
+    auto promiseAndPipeline = target.call(interfaceId, methodId, kj::addRef(*context));
 
     // We have to make sure the call is not canceled unless permitted.  We need to fork the promise
     // so that if the client drops their copy, the promise isn't necessarily canceled.
@@ -212,28 +319,33 @@ public:
 
     // Now the other branch returns the response from the context.
     auto promise = forked.addBranch().then(kj::mvCapture(context,
-        [](kj::Own<LocalCallContext>&& context) {
+        [redirected](kj::Own<LocalCallContext>&& context) {
+      if (redirected) {
+        auto results = context->getResults(MessageSize { 0, 0 }).asReader();
+        return Response<AnyPointer>(results, kj::heap<TailCallTargetResponse>(kj::mv(context)));
+      }
       context->getResults(MessageSize { 0, 0 });  // force response allocation
       return kj::mv(KJ_ASSERT_NONNULL(context->response));
     }));
 
+    KJ_IF_MAYBE(t, timer) {
+      promise = t->timeoutAfter(timeout, kj::mv(promise));
+    }
+
     // We return the other branch.
     return RemotePromise<AnyPointer>(
         kj::mv(promise), AnyPointer::Pipeline(kj::mv(promiseAndPipeline.pipeline)));
   }
-
-  const void* getBrand() override {
-    return nullptr;
-  }
-
-  kj::Own<MallocMessageBuilder> message;
-
-private:
-  uint64_t interfaceId;
-  uint16_t methodId;
-  kj::Own<ClientHook> client;
 };
 
+static Request<AnyPointer, AnyPointer> newLocalRequest(
+    uint64_t interfaceId, uint16_t methodId, kj::Maybe<MessageSize> sizeHint,
+    kj::Own<ClientHook>&& client) {
+  auto hook = kj::heap<LocalRequest>(interfaceId, methodId, sizeHint, kj::mv(client));
+  auto root = hook->message->getRoot<AnyPointer>();
+  return Request<AnyPointer, AnyPointer>(root, kj::mv(hook));
+}
+
 // =======================================================================================
 // Call queues
 //
@@ -249,8 +361,10 @@ public:
       : promise(promiseParam.fork()),
         selfResolutionOp(promise.addBranch().then([this](kj::Own<PipelineHook>&& inner) {
           redirect = kj::mv(inner);
+          caps.clear();
         }, [this](kj::Exception&& exception) {
           redirect = newBrokenPipeline(kj::mv(exception));
+          caps.clear();
         }).eagerlyEvaluate(nullptr)) {}
 
   kj::Own<PipelineHook> addRef() override {
@@ -258,11 +372,7 @@ public:
   }
 
   kj::Own<ClientHook> getPipelinedCap(kj::ArrayPtr<const PipelineOp> ops) override {
-    auto copy = kj::heapArrayBuilder<PipelineOp>(ops.size());
-    for (auto& op: ops) {
-      copy.add(op);
-    }
-    return getPipelinedCap(copy.finish());
+    return getPipelinedCap(kj::heapArray(ops));
   }
 
   kj::Own<ClientHook> getPipelinedCap(kj::Array<PipelineOp>&& ops) override;
@@ -270,6 +380,10 @@ public:
 private:
   kj::ForkedPromise<kj::Own<PipelineHook>> promise;
 
+  PipelinedCapCache caps;
+  // The QueuedClients we've handed out while waiting, so that repeated calls on the same path
+  // share one queue.  Cleared once redirected, after which we defer to the redirect.
+
   kj::Maybe<kj::Own<PipelineHook>> redirect;
   // Once the promise resolves, this will become non-null and point to the underlying object.
 
@@ -294,10 +408,14 @@ public:
 
   Request<AnyPointer, AnyPointer> newCall(
       uint64_t interfaceId, uint16_t methodId, kj::Maybe<MessageSize> sizeHint) override {
-    auto hook = kj::heap<LocalRequest>(
-        interfaceId, methodId, sizeHint, kj::addRef(*this));
-    auto root = hook->message->getRoot<AnyPointer>();
-    return Request<AnyPointer, AnyPointer>(root, kj::mv(hook));
+    return newLocalRequest(interfaceId, methodId, sizeHint, kj::addRef(*this));
+  }
+
+  Request<AnyPointer, AnyPointer> newCallWithRef(
+      kj::Own<ClientHook>&& self, uint64_t interfaceId, uint16_t methodId,
+      kj::Maybe<MessageSize> sizeHint) override {
+    KJ_DASSERT(self.get() == this);
+    return newLocalRequest(interfaceId, methodId, sizeHint, kj::mv(self));
   }
 
   VoidPromiseAndPipeline call(uint64_t interfaceId, uint16_t methodId,
@@ -308,47 +426,21 @@ public:
     // The problem is, these are two independent objects, but they both depend on the result of
     // one future call.
     //
-    // So, we need to set up a continuation that will initiate the call later, then we need to
-    // fork the promise for that continuation in order to send the completion promise and the
-    // pipeline to their respective places.
-    //
-    // TODO(perf):  Too much reference counting?  Can we do better?  Maybe a way to fork
-    //   Promise<Tuple<T, U>> into Tuple<Promise<T>, Promise<U>>?
-
-    struct CallResultHolder: public kj::Refcounted {
-      // Essentially acts as a refcounted \VoidPromiseAndPipeline, so that we can create a promise
-      // for it and fork that promise.
-
-      VoidPromiseAndPipeline content;
-      // One branch of the fork will use content.promise, the other branch will use
-      // content.pipeline.  Neither branch will touch the other's piece.
-
-      inline CallResultHolder(VoidPromiseAndPipeline&& content): content(kj::mv(content)) {}
+    // So, we need to set up a continuation that will initiate the call later, then split the
+    // promise for that continuation in order to send the completion promise and the pipeline to
+    // their respective places.  (Splitting rather than forking lets each branch take its piece by
+    // move, without a refcounted holder.)
+    auto split = promiseForCallForwarding.addBranch().then(kj::mvCapture(context,
+        [=](kj::Own<CallContextHook>&& context, kj::Own<ClientHook>&& client){
+          auto result = client->call(interfaceId, methodId, kj::mv(context));
+          return kj::tuple(kj::mv(result.pipeline), kj::mv(result.promise));
+        })).split();
 
-      kj::Own<CallResultHolder> addRef() { return kj::addRef(*this); }
-    };
+    // The first branch gets the pipeline; construct our QueuedPipeline to chain to it.
+    auto pipeline = kj::refcounted<QueuedPipeline>(kj::mv(kj::get<0>(split)));
 
-    // Create a promise for the call initiation.
-    kj::ForkedPromise<kj::Own<CallResultHolder>> callResultPromise =
-        promiseForCallForwarding.addBranch().then(kj::mvCapture(context,
-        [=](kj::Own<CallContextHook>&& context, kj::Own<ClientHook>&& client){
-          return kj::refcounted<CallResultHolder>(
-              client->call(interfaceId, methodId, kj::mv(context)));
-        })).fork();
-
-    // Create a promise that extracts the pipeline from the call initiation, and construct our
-    // QueuedPipeline to chain to it.
-    auto pipelinePromise = callResultPromise.addBranch().then(
-        [](kj::Own<CallResultHolder>&& callResult){
-          return kj::mv(callResult->content.pipeline);
-        });
-    auto pipeline = kj::refcounted<QueuedPipeline>(kj::mv(pipelinePromise));
-
-    // Create a promise that simply chains to the void promise produced by the call initiation.
-    auto completionPromise = callResultPromise.addBranch().then(
-        [](kj::Own<CallResultHolder>&& callResult){
-          return kj::mv(callResult->content.promise);
-        });
+    // The second branch simply chains to the void promise produced by the call initiation.
+    auto completionPromise = kj::mv(kj::get<1>(split));
 
     // OK, now we can actually return our thing.
     return VoidPromiseAndPipeline { kj::mv(completionPromise), kj::mv(pipeline) };
@@ -406,13 +498,15 @@ private:
 kj::Own<ClientHook> QueuedPipeline::getPipelinedCap(kj::Array<PipelineOp>&& ops) {
   KJ_IF_MAYBE(r, redirect) {
     return r->get()->getPipelinedCap(kj::mv(ops));
+  } else KJ_IF_MAYBE(cap, caps.find(ops)) {
+    return kj::mv(*cap);
   } else {
-    auto clientPromise = promise.addBranch().then(kj::mvCapture(ops,
+    auto clientPromise = promise.addBranch().then(kj::mvCapture(kj::heapArray(ops.asPtr()),
         [](kj::Array<PipelineOp>&& ops, kj::Own<PipelineHook> pipeline) {
           return pipeline->getPipelinedCap(kj::mv(ops));
         }));
 
-    return kj::refcounted<QueuedClient>(kj::mv(clientPromise));
+    return caps.add(kj::mv(ops), kj::refcounted<QueuedClient>(kj::mv(clientPromise)));
   }
 }
 
@@ -455,10 +549,14 @@ public:
 
   Request<AnyPointer, AnyPointer> newCall(
       uint64_t interfaceId, uint16_t methodId, kj::Maybe<MessageSize> sizeHint) override {
-    auto hook = kj::heap<LocalRequest>(
-        interfaceId, methodId, sizeHint, kj::addRef(*this));
-    auto root = hook->message->getRoot<AnyPointer>();
-    return Request<AnyPointer, AnyPointer>(root, kj::mv(hook));
+    return newLocalRequest(interfaceId, methodId, sizeHint, kj::addRef(*this));
+  }
+
+  Request<AnyPointer, AnyPointer> newCallWithRef(
+      kj::Own<ClientHook>&& self, uint64_t interfaceId, uint16_t methodId,
+      kj::Maybe<MessageSize> sizeHint) override {
+    KJ_DASSERT(self.get() == this);
+    return newLocalRequest(interfaceId, methodId, sizeHint, kj::mv(self));
   }
 
   VoidPromiseAndPipeline call(uint64_t interfaceId, uint16_t methodId,
@@ -473,7 +571,12 @@ public:
     //
     // Note also that QueuedClient depends on this evalLater() to ensure that pipelined calls don't
     // complete before 'whenMoreResolved()' promises resolve.
-    auto promise = kj::evalLater([this,interfaceId,methodId,contextPtr]() {
+    auto promise = kj::evalLater([this,interfaceId,methodId,contextPtr]() -> kj::Promise<void> {
+      if (contextPtr->isPastDeadline()) {
+        // The caller has given up on this call, so don't bother.
+        return KJ_EXCEPTION(OVERLOADED, "Call's deadline passed before it was delivered.",
+                            interfaceId, methodId);
+      }
       return server->dispatchCall(interfaceId, methodId,
                                   CallContext<AnyPointer, AnyPointer>(*contextPtr));
     }).attach(kj::addRef(*this));
@@ -570,6 +673,10 @@ public:
         AnyPointer::Pipeline(kj::refcounted<BrokenPipeline>(exception)));
   }
 
+  void setTimeout(kj::Timer& timer, kj::Duration timeout) override {
+    // The call fails immediately anyway.
+  }
+
   const void* getBrand() override {
     return nullptr;
   }
@@ -655,6 +762,39 @@ Request<AnyPointer, AnyPointer> newBrokenRequest(
 
 // =======================================================================================
 
+namespace {
+
+bool samePath(kj::ArrayPtr<const PipelineOp> a, kj::ArrayPtr<const PipelineOp> b) {
+  if (a.size() != b.size()) return false;
+  for (auto i: kj::indices(a)) {
+    if (a[i].type != b[i].type) return false;
+    if (a[i].type == PipelineOp::GET_POINTER_FIELD && a[i].pointerIndex != b[i].pointerIndex) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+kj::Maybe<kj::Own<ClientHook>> PipelinedCapCache::find(kj::ArrayPtr<const PipelineOp> ops) {
+  for (auto& entry: entries) {
+    if (samePath(entry.ops, ops)) {
+      return entry.client->addRef();
+    }
+  }
+  return nullptr;
+}
+
+kj::Own<ClientHook> PipelinedCapCache::add(
+    kj::Array<PipelineOp>&& ops, kj::Own<ClientHook>&& client) {
+  auto result = client->addRef();
+  entries.add(Entry { kj::mv(ops), kj::mv(client) });
+  return result;
+}
+
+// =======================================================================================
+
 ReaderCapabilityTable::ReaderCapabilityTable(
     kj::Array<kj::Maybe<kj::Own<ClientHook>>> table)
     : table(kj::mv(table)) {
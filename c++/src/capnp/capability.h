@@ -31,6 +31,7 @@
 #endif
 
 #include <kj/async.h>
+#include <kj/time.h>
 #include <kj/vector.h>
 #include "raw-schema.h"
 #include "any.h"
@@ -96,6 +97,20 @@ class ResponseHook;
 class PipelineHook;
 class ClientHook;
 
+enum class CallPriority: uint8_t {
+  // How urgently a call should be put on the wire relative to other calls on the same connection.
+  // See `Request::setPriority()`.
+
+  LOW,
+  // Bulk traffic which can tolerate waiting behind other calls.
+
+  NORMAL,
+  // The default.
+
+  HIGH
+  // Latency-sensitive calls which should go ahead of queued normal and bulk traffic.
+};
+
 template <typename Params, typename Results>
 class Request: public Params::Builder {
   // A call that hasn't been sent yet.  This class extends a Builder for the call's "Params"
@@ -113,6 +128,31 @@ public:
   RemotePromise<Results> send() KJ_WARN_UNUSED_RESULT;
   // Send the call and return a promise for the results.
 
+  void setTimeout(kj::Timer& timer, kj::Duration timeout);
+  // Gives up on the call if it hasn't returned within `timeout` (as measured by `timer`) of being
+  // sent:  the promise returned by send() then fails with an OVERLOADED exception, and dropping it
+  // cancels the call as usual.  The timeout also travels with the call, so the callee can see it
+  // via `CallContext::getDeadline()` and avoid working on calls whose caller has given up.  A call
+  // whose timeout is not positive fails without being delivered.
+  //
+  // Pipelined calls made on the results are not affected; give them their own timeouts.
+
+  void setPriority(CallPriority priority);
+  // Hints that the call should be sent ahead of (or behind) other calls waiting to be written to
+  // the same connection.  This never changes the order of calls made on the same capability, and
+  // network implementations are free to ignore it, so it cannot be used to affect semantics.
+  // Must be called before send().
+
+  void setTraceParent(kj::ArrayPtr<const byte> context);
+  // For distributed tracing (see `RpcTracer` in rpc-trace.h):  marks the call as being made on
+  // behalf of the call whose `CallContext::getTraceContext()` returned `context`, so that tracers
+  // can link the two.  A server making calls while handling a call would typically write:
+  //
+  //     request.setTraceParent(context.getTraceContext());
+  //
+  // The context is copied if needed.  Does nothing if `context` is empty.  Must be called before
+  // send().
+
 private:
   kj::Own<RequestHook> hook;
 
@@ -179,13 +219,15 @@ public:
   // For use by the RPC implementation:  Wrap a ClientHook.
 
   template <typename T>
-  typename T::Client castAs();
+  typename T::Client castAs() &;
+  template <typename T>
+  typename T::Client castAs() &&;
   // Reinterpret the capability as implementing the given interface.  Note that no error will occur
   // here if the capability does not actually implement this interface, but later method calls will
   // fail.  It's up to the application to decide how indicate that additional interfaces are
   // supported.
   //
-  // TODO(perf):  GCC 4.8 / Clang 3.3:  rvalue-qualified version for better performance.
+  // Casting an rvalue moves the reference rather than adding a new one.
 
   template <typename T>
   typename T::Client castAs(InterfaceSchema schema);
@@ -200,9 +242,16 @@ public:
 
   Request<AnyPointer, AnyPointer> typelessRequest(
       uint64_t interfaceId, uint16_t methodId,
-      kj::Maybe<MessageSize> sizeHint);
+      kj::Maybe<MessageSize> sizeHint) &;
+  Request<AnyPointer, AnyPointer> typelessRequest(
+      uint64_t interfaceId, uint16_t methodId,
+      kj::Maybe<MessageSize> sizeHint) &&;
   // Make a request without knowing the types of the params or results. You specify the type ID
   // and method number manually.
+  //
+  // Calling this on an rvalue (e.g. `kj::mv(client).typelessRequest(...)`, or on a capability
+  // fresh out of a pipeline) hands the client's reference over to the request, so making the call
+  // doesn't touch the capability's refcount.
 
   // TODO(someday):  method(s) for Join
 
@@ -234,6 +283,7 @@ private:
 // Capability servers
 
 class CallContextHook;
+class RawCallParams;
 
 template <typename Params, typename Results>
 class CallContext: public kj::DisallowConstCopy {
@@ -286,6 +336,24 @@ public:
   // In general, this should be the last thing a method implementation calls, and the promise
   // returned from `tailCall()` should then be returned by the method implementation.
 
+  kj::Maybe<kj::TimePoint> getDeadline();
+  // If the caller set a timeout on this call (see `Request::setTimeout()`), the time after which
+  // the caller will no longer wait for the results.  The time is in terms of the timer the
+  // caller passed to setTimeout() for a local call, or that passed to `RpcSystem::setTimer()` for
+  // a call received over the network.  Null if there is no deadline, or if no timer is available
+  // to measure it.
+  //
+  // Calls that are still queued when their deadline passes (e.g. because they were made on a
+  // promise that hadn't resolved yet) fail with an OVERLOADED exception instead of being
+  // delivered.  Calls that have called allowCancellation() are canceled when their deadline passes,
+  // and fail with an OVERLOADED exception.  Other calls run to completion; they may check the
+  // deadline themselves, e.g. to skip optional work or to pass the remaining time on to the calls
+  // they make.
+
+  kj::ArrayPtr<const byte> getTraceContext();
+  // Returns the context to pass to `Request::setTraceParent()` on calls made on behalf of this
+  // one, so that distributed tracing can follow the chain.  Empty if the call isn't being traced.
+
   void allowCancellation();
   // Indicate that it is OK for the RPC system to discard its Promise for this call's result if
   // the caller cancels the call, thereby transitively canceling any asynchronous operations the
@@ -379,6 +447,8 @@ public:
   explicit ReaderCapabilityTable(kj::Array<kj::Maybe<kj::Own<ClientHook>>> table);
   KJ_DISALLOW_COPY(ReaderCapabilityTable);
 
+  inline kj::ArrayPtr<kj::Maybe<kj::Own<ClientHook>>> getTable() { return table; }
+
   template <typename T>
   T imbue(T reader);
   // Return a reader equivalent to `reader` except that when reading capability-valued fields,
@@ -472,6 +542,26 @@ public:
   // discover when tail call is going to be sent over its own connection and therefore can be
   // optimized into a remote tail call.
 
+  virtual void setTimeout(kj::Timer& timer, kj::Duration timeout) {}
+  // Implements `Request::setTimeout()`.  Must be called before send().  The default implementation
+  // ignores it, so the call simply never times out.
+
+  virtual void setPriority(CallPriority priority) {}
+  // Implements `Request::setPriority()`.  Must be called before send().  Since priority is only a
+  // hint, the default implementation ignores it.
+
+  virtual void setTraceParent(kj::ArrayPtr<const byte> context) {}
+  // Implements `Request::setTraceParent()`.  Must be called before send().  Requests which are
+  // never traced can ignore it.
+
+  virtual kj::Maybe<RemotePromise<AnyPointer>> sendWithResultsIn(CallContextHook& context) {
+    return nullptr;
+  }
+  // Like send(), but used when `context` is tail-calling this request: the callee builds its
+  // results directly in `context.getResults()` instead of in a separate message which the context
+  // would then have to copy.  The returned response reads from those results.  Returns null if
+  // this request doesn't support it, in which case the caller should use send() instead.
+
   template <typename T, typename U>
   inline static kj::Own<RequestHook> from(Request<T, U>&& request) {
     return kj::mv(request.hook);
@@ -505,6 +595,13 @@ public:
   // Start a new call, allowing the client to allocate request/response objects as it sees fit.
   // This version is used when calls are made from application code in the local process.
 
+  virtual Request<AnyPointer, AnyPointer> newCallWithRef(
+      kj::Own<ClientHook>&& self, uint64_t interfaceId, uint16_t methodId,
+      kj::Maybe<MessageSize> sizeHint);
+  // Like newCall(), but the caller gives up its reference to this hook, `self`, which the request
+  // may keep instead of adding a reference of its own.  Used when calling through a Client that is
+  // about to be discarded anyway.  The default implementation calls newCall() and drops `self`.
+
   struct VoidPromiseAndPipeline {
     kj::Promise<void> promise;
     kj::Own<PipelineHook> pipeline;
@@ -585,6 +682,46 @@ public:
   // promise fulfiller for onTailCall() with the returned pipeline.
 
   virtual kj::Own<CallContextHook> addRef() = 0;
+
+  virtual kj::Maybe<kj::TimePoint> getDeadline() { return nullptr; }
+  // Implements `CallContext::getDeadline()`.
+
+  virtual kj::ArrayPtr<const byte> getTraceContext() { return nullptr; }
+  // Implements `CallContext::getTraceContext()`.
+
+  virtual bool isPastDeadline() { return false; }
+  // Returns true if the call has a deadline and it has passed, in which case a server about to
+  // deliver the call should fail it instead.
+
+  virtual kj::Maybe<kj::Own<RawCallParams>> detachRawParams() { return nullptr; }
+  // Like releaseParams(), but if the params are still held in the message in which they arrived,
+  // hands that message to the caller rather than freeing it, so that a call being forwarded to
+  // another vat can be transmitted without copying the params. Returns null -- without releasing
+  // anything -- if the implementation doesn't support this or judges it not worthwhile (e.g.
+  // because the params are small); the caller should then use getParams() as usual.
+};
+
+class RawCallParams {
+  // Call params detached from their CallContextHook by `detachRawParams()`, still backed by the
+  // message in which they were received.
+
+public:
+  virtual AnyPointer::Reader getContent() = 0;
+  // The params, imbued such that capability pointers are resolved through `getCapTable()`.
+
+  virtual kj::ArrayPtr<kj::Maybe<kj::Own<ClientHook>>> getCapTable() = 0;
+  // The capabilities referenced by the params. Capability pointers in the content are indexes into
+  // this table.
+
+  virtual kj::ArrayPtr<const kj::ArrayPtr<const word>> getSegments() = 0;
+  // The raw segments of the message containing the params, which stay valid as long as this
+  // object lives. An RPC system may transmit the params out of these in place, as long as it
+  // preserves their segment IDs and the cap table indexes. Note that they also contain whatever
+  // else the sender put in the original message -- the call header, the sender's cap descriptors,
+  // and so on -- which must not be passed along (use `_::PointerReader::getTargetRanges()` to tell
+  // the params apart).
+
+  virtual kj::Own<RawCallParams> addRef() = 0;
 };
 
 kj::Own<ClientHook> newLocalPromiseClient(kj::Promise<kj::Own<ClientHook>>&& promise);
@@ -607,6 +744,36 @@ Request<AnyPointer, AnyPointer> newBrokenRequest(
     kj::Exception&& reason, kj::Maybe<MessageSize> sizeHint);
 // Helper function that creates a Request object that simply throws exceptions when sent.
 
+class PipelinedCapCache {
+  // Helper for PipelineHook implementations:  remembers the capability returned for each path
+  // passed to getPipelinedCap() while the pipeline is unresolved, so that asking for the same path
+  // again (as every pipelined call through a generated Pipeline does) reuses the same queueing
+  // client rather than building a new one.  Once the pipeline resolves, implementations should
+  // clear() the cache and defer to the resolution instead, since the final results may substitute
+  // capabilities.
+  //
+  // Lookups are linear; a pipeline rarely sees more than a handful of distinct paths.
+
+public:
+  kj::Maybe<kj::Own<ClientHook>> find(kj::ArrayPtr<const PipelineOp> ops);
+  // Returns a new reference to the capability cached for `ops`, if there is one.
+
+  kj::Own<ClientHook> add(kj::Array<PipelineOp>&& ops, kj::Own<ClientHook>&& client);
+  // Caches `client` as the capability for `ops`, and returns a new reference to it.
+
+  void clear() { entries.clear(); }
+  // Drops the cached capabilities, so that those nobody else holds are released right away rather
+  // than living as long as the pipeline.
+
+private:
+  struct Entry {
+    kj::Array<PipelineOp> ops;
+    kj::Own<ClientHook> client;
+  };
+
+  kj::Vector<Entry> entries;
+};
+
 // =======================================================================================
 // Extend PointerHelpers for interfaces
 
@@ -754,6 +921,19 @@ RemotePromise<Results> Request<Params, Results>::send() {
   return RemotePromise<Results>(kj::mv(typedPromise), kj::mv(typedPipeline));
 }
 
+template <typename Params, typename Results>
+inline void Request<Params, Results>::setTimeout(kj::Timer& timer, kj::Duration timeout) {
+  hook->setTimeout(timer, timeout);
+}
+template <typename Params, typename Results>
+inline void Request<Params, Results>::setPriority(CallPriority priority) {
+  hook->setPriority(priority);
+}
+template <typename Params, typename Results>
+inline void Request<Params, Results>::setTraceParent(kj::ArrayPtr<const byte> context) {
+  hook->setTraceParent(context);
+}
+
 inline Capability::Client::Client(kj::Own<ClientHook>&& hook): hook(kj::mv(hook)) {}
 template <typename T, typename>
 inline Capability::Client::Client(kj::Own<T>&& server)
@@ -767,17 +947,27 @@ inline Capability::Client& Capability::Client::operator=(Client& other) {
   return *this;
 }
 template <typename T>
-inline typename T::Client Capability::Client::castAs() {
+inline typename T::Client Capability::Client::castAs() & {
   return typename T::Client(hook->addRef());
 }
+template <typename T>
+inline typename T::Client Capability::Client::castAs() && {
+  return typename T::Client(kj::mv(hook));
+}
 inline kj::Promise<void> Capability::Client::whenResolved() {
   return hook->whenResolved();
 }
 inline Request<AnyPointer, AnyPointer> Capability::Client::typelessRequest(
     uint64_t interfaceId, uint16_t methodId,
-    kj::Maybe<MessageSize> sizeHint) {
+    kj::Maybe<MessageSize> sizeHint) & {
   return newCall<AnyPointer, AnyPointer>(interfaceId, methodId, sizeHint);
 }
+inline Request<AnyPointer, AnyPointer> Capability::Client::typelessRequest(
+    uint64_t interfaceId, uint16_t methodId,
+    kj::Maybe<MessageSize> sizeHint) && {
+  auto& target = *hook;
+  return target.newCallWithRef(kj::mv(hook), interfaceId, methodId, sizeHint);
+}
 template <typename Params, typename Results>
 inline Request<Params, Results> Capability::Client::newCall(
     uint64_t interfaceId, uint16_t methodId, kj::Maybe<MessageSize> sizeHint) {
@@ -827,6 +1017,14 @@ inline kj::Promise<void> CallContext<Params, Results>::tailCall(
   return hook->tailCall(kj::mv(tailRequest.hook));
 }
 template <typename Params, typename Results>
+inline kj::Maybe<kj::TimePoint> CallContext<Params, Results>::getDeadline() {
+  return hook->getDeadline();
+}
+template <typename Params, typename Results>
+inline kj::ArrayPtr<const byte> CallContext<Params, Results>::getTraceContext() {
+  return hook->getTraceContext();
+}
+template <typename Params, typename Results>
 inline void CallContext<Params, Results>::allowCancellation() {
   hook->allowCancellation();
 }
@@ -0,0 +1,152 @@
+// Copyright (c) 2015 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "cross-thread.h"
+#include <kj/test.h>
+#include <kj/thread.h>
+#include <kj/mutex.h>
+#include <kj/vector.h>
+#include "test-util.h"
+
+namespace capnp {
+namespace _ {
+namespace {
+
+KJ_TEST("CrossThreadClient calls from other threads") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int callCount = 0;
+  CrossThreadClient shared(kj::heap<TestInterfaceImpl>(callCount));
+
+  constexpr uint THREAD_COUNT = 3;
+  constexpr uint CALLS_PER_THREAD = 10;
+
+  auto paf1 = kj::newCrossThreadPromiseAndFulfiller<kj::String>();
+  auto paf2 = kj::newCrossThreadPromiseAndFulfiller<kj::String>();
+  auto paf3 = kj::newCrossThreadPromiseAndFulfiller<kj::String>();
+  kj::PromiseFulfiller<kj::String>* fulfillers[THREAD_COUNT] = {
+    paf1.fulfiller.get(), paf2.fulfiller.get(), paf3.fulfiller.get()
+  };
+
+  kj::Vector<kj::Own<kj::Thread>> threads;
+  for (auto fulfiller: fulfillers) {
+    threads.add(kj::heap<kj::Thread>([&shared,fulfiller]() {
+      kj::EventLoop loop;
+      kj::WaitScope waitScope(loop);
+
+      fulfiller->rejectIfThrows([&]() {
+        auto client = shared.getClient<test::TestInterface>();
+
+        kj::Vector<kj::Promise<kj::String>> calls;
+        for (uint i = 0; i < CALLS_PER_THREAD; i++) {
+          auto request = client.fooRequest();
+          request.setI(123);
+          request.setJ(true);
+          calls.add(request.send().then([](Response<test::TestInterface::FooResults>&& response) {
+            return kj::heapString(response.getX());
+          }));
+        }
+
+        auto results = kj::joinPromises(calls.releaseAsArray()).wait(waitScope);
+        fulfiller->fulfill(kj::strArray(results, ","));
+      });
+    }));
+  }
+
+  kj::Vector<kj::StringPtr> expectedParts;
+  for (uint i = 0; i < CALLS_PER_THREAD; i++) expectedParts.add("foo");
+  auto expected = kj::strArray(expectedParts, ",");
+  KJ_EXPECT(paf1.promise.wait(waitScope) == expected);
+  KJ_EXPECT(paf2.promise.wait(waitScope) == expected);
+  KJ_EXPECT(paf3.promise.wait(waitScope) == expected);
+  KJ_EXPECT(callCount == THREAD_COUNT * CALLS_PER_THREAD);
+}
+
+KJ_TEST("CrossThreadClient refuses capabilities") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int callCount = 0;
+  int handleCount = 0;
+  CrossThreadClient shared(kj::heap<TestMoreStuffImpl>(callCount, handleCount));
+
+  auto paf = kj::newCrossThreadPromiseAndFulfiller<kj::Exception::Type>();
+  kj::Thread thread([&]() {
+    kj::EventLoop loop;
+    kj::WaitScope waitScope(loop);
+
+    int innerCallCount = 0;
+    auto request = shared.getClient<test::TestMoreStuff>().callFooRequest();
+    request.setCap(kj::heap<TestInterfaceImpl>(innerCallCount));
+    paf.fulfiller->fulfill(request.send().then([](Response<test::TestMoreStuff::CallFooResults>&&) {
+      return kj::Exception::Type::OVERLOADED;  // unexpected success
+    }, [](kj::Exception&& e) {
+      return e.getType();
+    }).wait(waitScope));
+  });
+
+  KJ_EXPECT(paf.promise.wait(waitScope) == kj::Exception::Type::UNIMPLEMENTED);
+  KJ_EXPECT(callCount == 0);
+}
+
+KJ_TEST("CrossThreadClient disconnects when destroyed") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int callCount = 0;
+  auto shared = kj::heap<CrossThreadClient>(kj::heap<TestInterfaceImpl>(callCount));
+  auto& sharedRef = *shared;
+
+  auto readyPaf = kj::newCrossThreadPromiseAndFulfiller<void>();
+  auto resultPaf = kj::newCrossThreadPromiseAndFulfiller<kj::Exception::Type>();
+  kj::MutexGuarded<bool> destroyed(false);
+
+  kj::Thread thread([&]() {
+    kj::EventLoop loop;
+    kj::WaitScope waitScope(loop);
+
+    auto client = sharedRef.getClient<test::TestInterface>();
+    readyPaf.fulfiller->fulfill();
+    destroyed.when([](bool value) { return value; }, [](bool&) {});
+
+    auto request = client.fooRequest();
+    request.setI(123);
+    request.setJ(true);
+    resultPaf.fulfiller->fulfill(request.send().then([](Response<test::TestInterface::FooResults>&&) {
+      return kj::Exception::Type::OVERLOADED;  // unexpected success
+    }, [](kj::Exception&& e) {
+      return e.getType();
+    }).wait(waitScope));
+  });
+
+  readyPaf.promise.wait(waitScope);
+  shared = nullptr;
+  *destroyed.lockExclusive() = true;
+
+  KJ_EXPECT(resultPaf.promise.wait(waitScope) == kj::Exception::Type::DISCONNECTED);
+  KJ_EXPECT(callCount == 0);
+}
+
+}  // namespace
+}  // namespace _
+}  // namespace capnp
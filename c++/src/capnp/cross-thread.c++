@@ -0,0 +1,205 @@
+// Copyright (c) 2015 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "cross-thread.h"
+#include "message.h"
+#include <kj/debug.h>
+#include <kj/vector.h>
+
+namespace capnp {
+namespace _ {  // private
+
+class CrossThreadMailbox final: private kj::Disposer {
+  // Queue of calls from other threads, drained by the CrossThreadClient on the owning thread.
+  // References are held by the CrossThreadClient and by every client handed out by getClient(),
+  // and are dropped on various threads, so the refcount lives under the lock.
+
+public:
+  struct Call {
+    uint64_t interfaceId;
+    uint16_t methodId;
+    kj::Own<MallocMessageBuilder> params;
+    kj::Own<kj::PromiseFulfiller<kj::Own<MallocMessageBuilder>>> fulfiller;
+    // Fulfiller for a promise on the calling thread's EventLoop.
+  };
+
+  struct State {
+    uint refcount = 1;
+    bool closed = false;
+    kj::Vector<Call> calls;
+    kj::Maybe<kj::Own<kj::PromiseFulfiller<void>>> wakeOwner;
+    // Set while the owning thread is waiting for calls.
+  };
+
+  kj::MutexGuarded<State> state;
+
+  static kj::Own<CrossThreadMailbox> make() {
+    auto mailbox = new CrossThreadMailbox;
+    return kj::Own<CrossThreadMailbox>(mailbox, *mailbox);
+  }
+
+  kj::Own<CrossThreadMailbox> addRef() const {
+    auto mutableThis = const_cast<CrossThreadMailbox*>(this);
+    ++state.lockExclusive()->refcount;
+    return kj::Own<CrossThreadMailbox>(mutableThis, *mutableThis);
+  }
+
+  void send(Call&& call) const {
+    kj::Maybe<kj::Own<kj::PromiseFulfiller<void>>> wakeOwner;
+    {
+      auto lock = state.lockExclusive();
+      if (lock->closed) {
+        call.fulfiller->reject(KJ_EXCEPTION(DISCONNECTED,
+            "CrossThreadClient was destroyed; capability is no longer available."));
+        return;
+      }
+      lock->calls.add(kj::mv(call));
+      wakeOwner = kj::mv(lock->wakeOwner);
+    }
+
+    KJ_IF_MAYBE(w, wakeOwner) {
+      w->get()->fulfill();
+    }
+  }
+
+  void close() {
+    kj::Vector<Call> calls;
+    kj::Maybe<kj::Own<kj::PromiseFulfiller<void>>> wakeOwner;
+    {
+      auto lock = state.lockExclusive();
+      lock->closed = true;
+      calls = kj::mv(lock->calls);
+      wakeOwner = kj::mv(lock->wakeOwner);
+    }
+
+    for (auto& call: calls) {
+      call.fulfiller->reject(KJ_EXCEPTION(DISCONNECTED,
+          "CrossThreadClient was destroyed before the call was delivered."));
+    }
+  }
+
+private:
+  void disposeImpl(void* pointer) const override {
+    if (--state.lockExclusive()->refcount == 0) {
+      delete this;
+    }
+  }
+};
+
+namespace {
+
+class CrossThreadForwarder final: public Capability::Server {
+  // Server living on the calling thread which forwards each call to the mailbox.
+
+public:
+  explicit CrossThreadForwarder(kj::Own<CrossThreadMailbox>&& mailbox)
+      : mailbox(kj::mv(mailbox)) {}
+
+  kj::Promise<void> dispatchCall(uint64_t interfaceId, uint16_t methodId,
+                                 CallContext<AnyPointer, AnyPointer> context) override {
+    auto params = context.getParams();
+    auto size = params.targetSize();
+    if (size.capCount != 0) {
+      KJ_UNIMPLEMENTED("CrossThreadClient cannot pass capabilities between threads.");
+    }
+
+    auto message = kj::heap<MallocMessageBuilder>(size.wordCount + 1);
+    message->getRoot<AnyPointer>().set(params);
+    context.releaseParams();
+
+    auto paf = kj::newCrossThreadPromiseAndFulfiller<kj::Own<MallocMessageBuilder>>();
+    mailbox->send({ interfaceId, methodId, kj::mv(message), kj::mv(paf.fulfiller) });
+
+    return paf.promise.then([context](kj::Own<MallocMessageBuilder>&& response) mutable {
+      auto results = response->getRoot<AnyPointer>().asReader();
+      context.getResults(results.targetSize()).set(results);
+    });
+  }
+
+private:
+  kj::Own<CrossThreadMailbox> mailbox;
+};
+
+kj::Own<MallocMessageBuilder> copyResults(AnyPointer::Reader results) {
+  auto size = results.targetSize();
+  if (size.capCount != 0) {
+    KJ_UNIMPLEMENTED("CrossThreadClient cannot pass capabilities between threads.");
+  }
+
+  auto message = kj::heap<MallocMessageBuilder>(size.wordCount + 1);
+  message->getRoot<AnyPointer>().set(results);
+  return kj::mv(message);
+}
+
+}  // namespace
+}  // namespace _ (private)
+
+CrossThreadClient::CrossThreadClient(Capability::Client cap)
+    : mailbox(_::CrossThreadMailbox::make()), cap(kj::mv(cap)), tasks(*this),
+      dispatchLoop(receive()) {}
+
+CrossThreadClient::~CrossThreadClient() noexcept(false) {
+  mailbox->close();
+}
+
+Capability::Client CrossThreadClient::getClient() const {
+  return Capability::Client(kj::heap<_::CrossThreadForwarder>(mailbox->addRef()));
+}
+
+kj::Promise<void> CrossThreadClient::receive() {
+  kj::Vector<_::CrossThreadMailbox::Call> calls;
+  {
+    auto lock = mailbox->state.lockExclusive();
+    if (lock->calls.empty()) {
+      if (lock->closed) return kj::READY_NOW;
+      auto paf = kj::newCrossThreadPromiseAndFulfiller<void>();
+      lock->wakeOwner = kj::mv(paf.fulfiller);
+      return paf.promise.then([this]() { return receive(); });
+    }
+    calls = kj::mv(lock->calls);
+  }
+
+  for (auto& call: calls) {
+    auto params = call.params->getRoot<AnyPointer>().asReader();
+    auto request = cap.typelessRequest(call.interfaceId, call.methodId, params.targetSize());
+    request.set(params);
+    call.params = nullptr;
+
+    auto& fulfiller = *call.fulfiller;
+    tasks.add(request.send().then([&fulfiller](Response<AnyPointer>&& response) {
+      fulfiller.rejectIfThrows([&]() {
+        fulfiller.fulfill(_::copyResults(response));
+      });
+    }, [&fulfiller](kj::Exception&& exception) {
+      fulfiller.reject(kj::mv(exception));
+    }).attach(kj::mv(call.fulfiller)));
+  }
+
+  // Let the calls we just started make progress before checking for more.
+  return kj::evalLater([this]() { return receive(); });
+}
+
+void CrossThreadClient::taskFailed(kj::Exception&& exception) {
+  KJ_LOG(ERROR, exception);
+}
+
+}  // namespace capnp
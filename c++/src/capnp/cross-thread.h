@@ -0,0 +1,109 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef CAPNP_CROSS_THREAD_H_
+#define CAPNP_CROSS_THREAD_H_
+// Calling capabilities that live on another thread's EventLoop.
+//
+// A Capability::Client is tied to the EventLoop of the thread that created it and may only be
+// used on that thread. A CrossThreadClient lets other threads, each running their own EventLoop,
+// call the capability anyway. The calls are carried across threads in plain messages, so no
+// sockets or RPC protocol are involved. This is useful, for example, to spread a CPU-heavy server
+// across several cores.
+//
+// Example:
+//
+//     // On the thread that owns the capability:
+//     capnp::CrossThreadClient shared(kj::heap<MyCalculatorImpl>());
+//
+//     kj::Thread worker([&]() {
+//       kj::EventLoop loop;
+//       kj::WaitScope waitScope(loop);
+//       Calculator::Client calc = shared.getClient<Calculator>();
+//       auto result = calc.evaluateRequest().send().wait(waitScope);
+//     });
+//
+//     // Meanwhile the owning thread must keep running its event loop to serve the calls.
+//
+// Limitations:
+// - Params and results are copied between threads, so they must not contain capabilities.
+//   Calls that try to pass capabilities fail with an UNIMPLEMENTED exception.
+// - Promise pipelining is not supported, since there are no capabilities in results to pipeline
+//   on anyway.
+// - Canceling a call on the calling side does not cancel it on the owning side; the result is
+//   just discarded.
+
+#if defined(__GNUC__) && !defined(CAPNP_HEADER_WARNINGS)
+#pragma GCC system_header
+#endif
+
+#include "capability.h"
+
+namespace capnp {
+
+namespace _ { class CrossThreadMailbox; }  // private
+
+class CrossThreadClient: private kj::TaskSet::ErrorHandler {
+  // Makes a capability callable from other threads. Construct it on the thread which owns the
+  // capability, and keep it alive as long as other threads need to call the capability. The
+  // owning thread must keep its EventLoop running to serve the calls.
+  //
+  // The CrossThreadClient itself must be constructed and destroyed on the owning thread, but
+  // getClient() may be called from any thread.
+
+public:
+  explicit CrossThreadClient(Capability::Client cap);
+  KJ_DISALLOW_COPY(CrossThreadClient);
+  ~CrossThreadClient() noexcept(false);
+  // Calls still queued when the CrossThreadClient is destroyed, as well as any made later, fail
+  // with DISCONNECTED. Calls already being served on the owning thread are canceled.
+
+  Capability::Client getClient() const;
+  // Returns a client which can be used on the *calling* thread to call the capability. Each call
+  // is queued to the owning thread, and its results are delivered back to the calling thread's
+  // EventLoop, whose EventPort must support `wake()` (see kj::newCrossThreadPromiseAndFulfiller).
+  // Thread-safe.
+
+  template <typename T>
+  typename T::Client getClient() const;
+  // Like above, but cast to the given interface type.
+
+private:
+  kj::Own<_::CrossThreadMailbox> mailbox;
+  Capability::Client cap;
+  kj::TaskSet tasks;
+  kj::Promise<void> dispatchLoop;
+
+  kj::Promise<void> receive();
+  void taskFailed(kj::Exception&& exception) override;
+};
+
+// =======================================================================================
+// inline implementation details
+
+template <typename T>
+inline typename T::Client CrossThreadClient::getClient() const {
+  return getClient().castAs<T>();
+}
+
+}  // namespace capnp
+
+#endif  // CAPNP_CROSS_THREAD_H_
@@ -90,4 +90,16 @@ RemotePromise<DynamicStruct> Request<DynamicStruct, DynamicStruct>::send() {
   return RemotePromise<DynamicStruct>(kj::mv(typedPromise), kj::mv(typedPipeline));
 }
 
+void Request<DynamicStruct, DynamicStruct>::setTimeout(kj::Timer& timer, kj::Duration timeout) {
+  hook->setTimeout(timer, timeout);
+}
+
+void Request<DynamicStruct, DynamicStruct>::setPriority(CallPriority priority) {
+  hook->setPriority(priority);
+}
+
+void Request<DynamicStruct, DynamicStruct>::setTraceParent(kj::ArrayPtr<const byte> context) {
+  hook->setTraceParent(context);
+}
+
 }  // namespace capnp
@@ -540,6 +540,15 @@ public:
   RemotePromise<DynamicStruct> send();
   // Send the call and return a promise for the results.
 
+  void setTimeout(kj::Timer& timer, kj::Duration timeout);
+  // See `Request<T, U>::setTimeout()`.
+
+  void setPriority(CallPriority priority);
+  // See `Request<T, U>::setPriority()`.
+
+  void setTraceParent(kj::ArrayPtr<const byte> context);
+  // See `Request<T, U>::setTraceParent()`.
+
 private:
   kj::Own<RequestHook> hook;
   StructSchema resultSchema;
@@ -570,6 +579,8 @@ public:
   Orphanage getResultsOrphanage(kj::Maybe<MessageSize> sizeHint = nullptr);
   template <typename SubParams>
   kj::Promise<void> tailCall(Request<SubParams, DynamicStruct>&& tailRequest);
+  kj::Maybe<kj::TimePoint> getDeadline();
+  kj::ArrayPtr<const byte> getTraceContext();
   void allowCancellation();
 
 private:
@@ -1641,6 +1652,12 @@ inline kj::Promise<void> CallContext<DynamicStruct, DynamicStruct>::tailCall(
     Request<SubParams, DynamicStruct>&& tailRequest) {
   return hook->tailCall(kj::mv(tailRequest.hook));
 }
+inline kj::Maybe<kj::TimePoint> CallContext<DynamicStruct, DynamicStruct>::getDeadline() {
+  return hook->getDeadline();
+}
+inline kj::ArrayPtr<const byte> CallContext<DynamicStruct, DynamicStruct>::getTraceContext() {
+  return hook->getTraceContext();
+}
 inline void CallContext<DynamicStruct, DynamicStruct>::allowCancellation() {
   hook->allowCancellation();
 }
@@ -21,7 +21,12 @@
 
 #include "ez-rpc.h"
 #include "test-util.h"
+#include <kj/async-io.h>
 #include <kj/compat/gtest.h>
+#include <kj/miniposix.h>
+#include <kj/mutex.h>
+#include <kj/thread.h>
+#include <kj/vector.h>
 
 namespace capnp {
 namespace _ {
@@ -68,6 +73,192 @@ TEST(EzRpc, DeprecatedNames) {
       .getCallSequenceRequest().send().wait(server.getWaitScope()).getN());
 }
 
+TEST(EzRpc, LoadBalanced) {
+  int callCount1 = 0;
+  int callCount2 = 0;
+  EzRpcServer server1(kj::heap<TestInterfaceImpl>(callCount1), "localhost");
+  EzRpcServer server2(kj::heap<TestInterfaceImpl>(callCount2), "localhost");
+  auto& waitScope = server1.getWaitScope();
+
+  auto address1 = kj::str("localhost:", server1.getPort().wait(waitScope));
+  auto address2 = kj::str("localhost:", server2.getPort().wait(waitScope));
+  kj::StringPtr addresses[] = { address1, address2 };
+  EzRpcClient client(addresses);
+
+  auto cap = client.getMain<test::TestInterface>();
+  kj::Vector<kj::Promise<void>> promises;
+  for (uint i = 0; i < 10; i++) {
+    auto request = cap.fooRequest();
+    request.setI(123);
+    request.setJ(true);
+    promises.add(request.send().ignoreResult());
+  }
+  kj::joinPromises(promises.releaseAsArray()).wait(waitScope);
+
+  EXPECT_EQ(5, callCount1);
+  EXPECT_EQ(5, callCount2);
+}
+
+TEST(EzRpc, LoadBalancedReconnect) {
+  int callCount1 = 0;
+  int callCount2 = 0;
+  EzRpcServer server1(kj::heap<TestInterfaceImpl>(callCount1), "localhost");
+  auto server2 = kj::heap<EzRpcServer>(kj::heap<TestInterfaceImpl>(callCount2), "localhost");
+  server1.exportCap("cap", kj::heap<TestInterfaceImpl>(callCount1));
+  server2->exportCap("cap", kj::heap<TestInterfaceImpl>(callCount2));
+  auto& waitScope = server1.getWaitScope();
+  auto& timer = server1.getIoProvider().getTimer();
+
+  auto port2 = server2->getPort().wait(waitScope);
+  auto address1 = kj::str("localhost:", server1.getPort().wait(waitScope));
+  auto address2 = kj::str("localhost:", port2);
+  kj::StringPtr addresses[] = { address1, address2 };
+  EzRpcClient client(addresses);
+  auto cap = client.getMain<test::TestInterface>();
+  auto imported = client.importCap<test::TestInterface>("cap");
+
+  auto callMany = [&](test::TestInterface::Client& cap) {
+    kj::Vector<kj::Promise<void>> promises;
+    for (uint i = 0; i < 10; i++) {
+      auto request = cap.fooRequest();
+      request.setI(123);
+      request.setJ(true);
+      promises.add(request.send().then([](auto&&) {}, [](kj::Exception&&) {}));
+    }
+    kj::joinPromises(promises.releaseAsArray()).wait(waitScope);
+  };
+
+  callMany(cap);
+  EXPECT_EQ(5, callCount2);
+  callMany(imported);
+  EXPECT_EQ(10, callCount2);
+
+  // Take the second server down, and bring it back at the same address.  The client reconnects
+  // on its own, for both the main interface and the imported capability.
+  server2 = nullptr;
+  timer.afterDelay(10 * kj::MILLISECONDS).wait(waitScope);
+  callMany(cap);
+  callMany(imported);
+
+  int callCount3 = 0;
+  int importCount3 = 0;
+  server2 = kj::heap<EzRpcServer>(kj::heap<TestInterfaceImpl>(callCount3), "localhost", port2);
+  server2->exportCap("cap", kj::heap<TestInterfaceImpl>(importCount3));
+  for (uint i = 0; i < 50 && (callCount3 == 0 || importCount3 == 0); i++) {
+    timer.afterDelay(100 * kj::MILLISECONDS).wait(waitScope);
+    callMany(cap);
+    callMany(imported);
+  }
+  EXPECT_GT(callCount3, 0);
+  EXPECT_GT(importCount3, 0);
+}
+
+#if !_WIN32
+
+class TestBootstrapFactory final: public BootstrapFactory<rpc::twoparty::VatId> {
+public:
+  explicit TestBootstrapFactory(int& callCount): callCount(callCount) {}
+
+  Capability::Client createFor(rpc::twoparty::VatId::Reader clientId) override {
+    return kj::heap<TestInterfaceImpl>(callCount);
+  }
+
+private:
+  int& callCount;
+};
+
+TEST(EzRpc, ThreadedServer) {
+  constexpr uint THREAD_COUNT = 3;
+  constexpr uint CLIENT_COUNT = 8;
+  constexpr uint CALLS_PER_CLIENT = 10;
+
+  int callCounts[THREAD_COUNT] = { 0, 0, 0 };
+  uint factoryCount = 0;
+
+  {
+    // Each worker gets its own call counter, so counters are never shared between threads.
+    EzRpcThreadedServer server([&]() -> kj::Own<BootstrapFactory<rpc::twoparty::VatId>> {
+      KJ_ASSERT(factoryCount < THREAD_COUNT);
+      return kj::heap<TestBootstrapFactory>(callCounts[factoryCount++]);
+    }, "localhost", THREAD_COUNT);
+    auto& waitScope = server.getWaitScope();
+    uint port = server.getPort().wait(waitScope);
+
+    kj::Vector<kj::Own<EzRpcClient>> clients;
+    kj::Vector<kj::Promise<void>> calls;
+    for (uint i = 0; i < CLIENT_COUNT; i++) {
+      clients.add(kj::heap<EzRpcClient>("localhost", port));
+      auto cap = clients.back()->getMain<test::TestInterface>();
+      for (uint j = 0; j < CALLS_PER_CLIENT; j++) {
+        auto request = cap.fooRequest();
+        request.setI(123);
+        request.setJ(true);
+        calls.add(request.send().then([](Response<test::TestInterface::FooResults>&& response) {
+          EXPECT_EQ("foo", response.getX());
+        }));
+      }
+    }
+
+    kj::joinPromises(calls.releaseAsArray()).wait(waitScope);
+  }
+
+  // The server's destructor has joined all workers, so their counters are now safe to read.
+  EXPECT_EQ(THREAD_COUNT, factoryCount);
+  int total = 0;
+  for (auto count: callCounts) {
+    total += count;
+  }
+  EXPECT_EQ(CLIENT_COUNT * CALLS_PER_CLIENT, total);
+}
+
+TEST(EzRpc, ThreadedServerShutdownWithQueuedConnections) {
+  constexpr uint THREAD_COUNT = 2;
+  constexpr uint CLIENT_COUNT = 6;
+
+  int callCounts[THREAD_COUNT] = { 0, 0 };
+  uint factoryCount = 0;
+  kj::MutexGuarded<bool> released(false);
+  auto server = kj::heap<EzRpcThreadedServer>(
+      [&]() -> kj::Own<BootstrapFactory<rpc::twoparty::VatId>> {
+    // Hold the workers up, so that the connections handed to them are still queued when the
+    // server shuts down.
+    released.when([](const bool& released) { return released; }, [](bool&) {});
+    return kj::heap<TestBootstrapFactory>(callCounts[factoryCount++]);
+  }, "localhost", THREAD_COUNT);
+  auto& waitScope = server->getWaitScope();
+  uint port = server->getPort().wait(waitScope);
+
+  kj::Vector<kj::Own<EzRpcClient>> clients;
+  kj::Vector<kj::Promise<void>> calls;
+  for (uint i = 0; i < CLIENT_COUNT; i++) {
+    clients.add(kj::heap<EzRpcClient>("localhost", port));
+    auto request = clients.back()->getMain<test::TestInterface>().fooRequest();
+    request.setI(123);
+    request.setJ(true);
+    calls.add(request.send().then([](auto&&) {}, [](kj::Exception&&) {}));
+  }
+  auto& timer = clients[0]->getIoProvider().getTimer();
+  timer.afterDelay(50 * kj::MILLISECONDS).wait(waitScope);
+
+  {
+    // Let the workers go only once the server is already shutting down.
+    kj::Thread releaser([&]() {
+      usleep(50000);
+      *released.lockExclusive() = true;
+    });
+    server = nullptr;
+  }
+
+  // Every connection was closed rather than leaked, so every call completes.
+  kj::joinPromises(calls.releaseAsArray())
+      .exclusiveJoin(timer.afterDelay(5 * kj::SECONDS).then([]() {
+        KJ_FAIL_EXPECT("calls on queued connections never completed");
+      }))
+      .wait(waitScope);
+}
+
+#endif  // !_WIN32
+
 }  // namespace
 }  // namespace _
 }  // namespace capnp
@@ -27,6 +27,18 @@
 #include <kj/threadlocal.h>
 #include <map>
 
+#if !_WIN32
+#include <kj/async-unix.h>
+#include <kj/io.h>
+#include <kj/mutex.h>
+#include <kj/thread.h>
+#include <kj/vector.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
 namespace capnp {
 
 KJ_THREADLOCAL_PTR(EzRpcContext) threadEzContext = nullptr;
@@ -76,6 +88,11 @@ kj::Promise<kj::Own<kj::AsyncIoStream>> connectAttach(kj::Own<kj::NetworkAddress
   return addr->connect().attach(kj::mv(addr));
 }
 
+constexpr kj::Duration MIN_RECONNECT_DELAY = 100 * kj::MILLISECONDS;
+constexpr kj::Duration MAX_RECONNECT_DELAY = 10 * kj::SECONDS;
+// When load balancing, how long to wait before reconnecting to a server which disconnected.  The
+// delay doubles each time a reconnection fails, up to the maximum.
+
 struct EzRpcClient::Impl {
   kj::Own<EzRpcContext> context;
 
@@ -150,6 +167,168 @@ struct EzRpcClient::Impl {
         clientContext(kj::heap<ClientContext>(
             context->getLowLevelIoProvider().wrapSocketFd(socketFd),
             readerOpts)) {}
+
+  struct PoolServer {
+    kj::String address;
+    kj::Own<Impl> impl;
+    kj::Duration reconnectDelay = MIN_RECONNECT_DELAY;
+
+    uint generation = 0;
+    // How many times we've reconnected to the server.
+
+    kj::Maybe<kj::ForkedPromise<void>> reconnected = nullptr;
+    // Resolves once `impl` has been replaced for the current generation.
+  };
+
+  struct PoolLink: public kj::Refcounted {
+    // Lets the balanced client, which may outlive us, reach the pool to reconnect to a server.
+
+    kj::Own<EzRpcContext> context;
+    kj::Maybe<Impl&> impl;
+    // Null once the EzRpcClient has been destroyed.
+  };
+
+  struct Reconnector {
+    // A balanced client's `reconnect` callback.  The main interface and each imported capability
+    // have their own balanced client, but share the connections, so the first of them to eject a
+    // server reconnects to it and the rest pick up the new connection.
+
+    kj::Own<PoolLink> link;
+    kj::Maybe<kj::String> name;
+    // The name of the imported capability, or null for the main interface.
+
+    kj::Array<uint> generations;
+    // The generation of each server's connection our current backend for it came from.
+
+    kj::Promise<Capability::Client> operator()(uint index) {
+      KJ_IF_MAYBE(impl, link->impl) {
+        return impl->reconnect(index, generations[index])
+            .then([this,index]() -> kj::Promise<Capability::Client> {
+          KJ_IF_MAYBE(impl, link->impl) {
+            auto& server = impl->pool[index];
+            generations[index] = server.generation;
+            KJ_IF_MAYBE(n, name) {
+              return server.impl->importCap(*n);
+            } else {
+              return server.impl->getMain();
+            }
+          } else {
+            return kj::NEVER_DONE;
+          }
+        });
+      } else {
+        return kj::NEVER_DONE;
+      }
+    }
+  };
+
+  kj::Array<PoolServer> pool;
+  uint defaultPort = 0;
+  ReaderOptions readerOpts;
+  kj::Own<PoolLink> poolLink;
+  LoadBalancerOptions::Strategy strategy = LoadBalancerOptions::Strategy::LEAST_OUTSTANDING;
+  kj::Maybe<Capability::Client> balancedMain;
+  // When connected to several servers, one Impl per server, and a client balancing over their
+  // main interfaces.
+
+  Impl(kj::ArrayPtr<const kj::StringPtr> serverAddresses, uint defaultPort,
+       LoadBalancerOptions&& balancerOpts, ReaderOptions readerOpts)
+      : context(EzRpcContext::getThreadLocal()),
+        setupPromise(kj::Promise<void>(kj::READY_NOW).fork()),
+        pool(KJ_MAP(address, serverAddresses) {
+          return PoolServer { kj::heapString(address),
+                              kj::heap<Impl>(address, defaultPort, readerOpts) };
+        }),
+        defaultPort(defaultPort), readerOpts(readerOpts),
+        poolLink(kj::refcounted<PoolLink>()),
+        strategy(balancerOpts.strategy) {
+    KJ_REQUIRE(serverAddresses.size() > 0, "Need at least one server address.");
+    poolLink->context = kj::addRef(*context);
+    poolLink->impl = *this;
+
+    if (balancerOpts.reconnect == nullptr) {
+      balancerOpts.reconnect = newReconnector(nullptr);
+    }
+    balancedMain = newLoadBalancedClient(
+        KJ_MAP(server, pool) { return server.impl->getMain(); }, kj::mv(balancerOpts));
+  }
+
+  ~Impl() noexcept(false) {
+    if (poolLink.get() != nullptr) {
+      poolLink->impl = nullptr;
+    }
+  }
+
+  kj::Function<kj::Promise<Capability::Client>(uint)> newReconnector(
+      kj::Maybe<kj::String> name) {
+    return Reconnector { kj::addRef(*poolLink), kj::mv(name),
+                         KJ_MAP(server, pool) { return server.generation; } };
+  }
+
+  kj::Promise<void> reconnect(uint index, uint generation) {
+    // Called by a balanced client when it ejects the server at `index`, whose connection it got
+    // at `generation`.  Connects to the server again after a while, waiting longer each time if it
+    // can't be reached, unless that has already been done since.
+
+    auto& server = pool[index];
+    if (generation != server.generation) {
+      KJ_IF_MAYBE(r, server.reconnected) {
+        return r->addBranch();
+      }
+      return kj::READY_NOW;
+    }
+
+    if (server.impl->clientContext == nullptr) {
+      server.reconnectDelay = kj::min(server.reconnectDelay * 2, MAX_RECONNECT_DELAY);
+    } else {
+      // We were connected, so the server may well be back already.
+      server.reconnectDelay = MIN_RECONNECT_DELAY;
+    }
+
+    ++server.generation;
+    server.reconnected = context->getIoProvider().getTimer().afterDelay(server.reconnectDelay)
+        .then(kj::mvCapture(kj::addRef(*poolLink),
+            [index](kj::Own<PoolLink>&& link) -> kj::Promise<void> {
+      KJ_IF_MAYBE(impl, link->impl) {
+        auto& server = impl->pool[index];
+        server.impl = kj::heap<Impl>(server.address, impl->defaultPort, impl->readerOpts);
+        return kj::READY_NOW;
+      } else {
+        return kj::NEVER_DONE;
+      }
+    })).fork();
+    return KJ_ASSERT_NONNULL(server.reconnected).addBranch();
+  }
+
+  Capability::Client getMain() {
+    KJ_IF_MAYBE(main, balancedMain) {
+      return *main;
+    } else KJ_IF_MAYBE(client, clientContext) {
+      return client->get()->getMain();
+    } else {
+      return setupPromise.addBranch().then([this]() {
+        return KJ_ASSERT_NONNULL(clientContext)->getMain();
+      });
+    }
+  }
+
+  Capability::Client importCap(kj::StringPtr name) {
+    if (pool.size() > 0) {
+      // The method ordinals of an imported capability aren't known here, so no call is retried.
+      LoadBalancerOptions options;
+      options.strategy = strategy;
+      options.reconnect = newReconnector(kj::heapString(name));
+      return newLoadBalancedClient(
+          KJ_MAP(server, pool) { return server.impl->importCap(name); }, kj::mv(options));
+    } else KJ_IF_MAYBE(client, clientContext) {
+      return client->get()->restore(name);
+    } else {
+      return setupPromise.addBranch().then(kj::mvCapture(kj::heapString(name),
+          [this](kj::String&& name) {
+        return KJ_ASSERT_NONNULL(clientContext)->restore(name);
+      }));
+    }
+  }
 };
 
 EzRpcClient::EzRpcClient(kj::StringPtr serverAddress, uint defaultPort, ReaderOptions readerOpts)
@@ -161,27 +340,18 @@ EzRpcClient::EzRpcClient(const struct sockaddr* serverAddress, uint addrSize, Re
 EzRpcClient::EzRpcClient(int socketFd, ReaderOptions readerOpts)
     : impl(kj::heap<Impl>(socketFd, readerOpts)) {}
 
+EzRpcClient::EzRpcClient(kj::ArrayPtr<const kj::StringPtr> serverAddresses, uint defaultPort,
+                         LoadBalancerOptions balancerOpts, ReaderOptions readerOpts)
+    : impl(kj::heap<Impl>(serverAddresses, defaultPort, kj::mv(balancerOpts), readerOpts)) {}
+
 EzRpcClient::~EzRpcClient() noexcept(false) {}
 
 Capability::Client EzRpcClient::getMain() {
-  KJ_IF_MAYBE(client, impl->clientContext) {
-    return client->get()->getMain();
-  } else {
-    return impl->setupPromise.addBranch().then([this]() {
-      return KJ_ASSERT_NONNULL(impl->clientContext)->getMain();
-    });
-  }
+  return impl->getMain();
 }
 
 Capability::Client EzRpcClient::importCap(kj::StringPtr name) {
-  KJ_IF_MAYBE(client, impl->clientContext) {
-    return client->get()->restore(name);
-  } else {
-    return impl->setupPromise.addBranch().then(kj::mvCapture(kj::heapString(name),
-        [this](kj::String&& name) {
-      return KJ_ASSERT_NONNULL(impl->clientContext)->restore(name);
-    }));
-  }
+  return impl->importCap(name);
 }
 
 kj::WaitScope& EzRpcClient::getWaitScope() {
@@ -355,4 +525,351 @@ kj::LowLevelAsyncIoProvider& EzRpcServer::getLowLevelIoProvider() {
   return impl->context->getLowLevelIoProvider();
 }
 
+// =======================================================================================
+
+#if !_WIN32
+
+struct EzRpcThreadedServer::Impl final: public kj::TaskSet::ErrorHandler {
+  kj::Own<EzRpcContext> context;
+  kj::MutexGuarded<MakeBootstrapFactory> makeBootstrapFactory;
+  uint threadCount;
+  ReaderOptions readerOpts;
+
+  kj::ForkedPromise<uint> portPromise;
+
+  kj::Maybe<kj::Own<kj::ConnectionReceiver>> listener;
+  // The listen socket, if we bound it ourselves.  Must outlive the workers.
+
+  class WorkerContext;
+
+  struct Worker {
+    kj::Own<kj::Thread> thread;
+
+    kj::Own<const kj::Executor> executor;
+    WorkerContext* context = nullptr;
+    // The worker's event loop, through which it is handed connections and told to stop, and its
+    // state, which may only be touched on that loop.  Set by the worker before it marks itself
+    // `started`; left null if it failed to start.
+
+    kj::MutexGuarded<bool> started;
+  };
+
+  kj::Vector<kj::Own<Worker>> workers;
+
+  kj::Own<kj::Thread> acceptor;
+  kj::AutoCloseFd acceptorStopFd;
+  // The thread which accepts connections and hands them out to the workers, and our end of a
+  // socketpair whose other end it watches.  Closing it tells the acceptor to shut down.
+
+  kj::TaskSet tasks;
+
+  struct ServerContext {
+    kj::AutoCloseFd fd;
+    kj::Own<kj::AsyncIoStream> stream;
+    TwoPartyVatNetwork network;
+    RpcSystem<rpc::twoparty::VatId> rpcSystem;
+
+    ServerContext(kj::AutoCloseFd&& fd, kj::LowLevelAsyncIoProvider& provider,
+                  BootstrapFactory<rpc::twoparty::VatId>& bootstrapFactory,
+                  ReaderOptions readerOpts)
+        : fd(kj::mv(fd)),
+          stream(provider.wrapSocketFd(this->fd, CONNECTION_FLAGS)),
+          network(*this->stream, rpc::twoparty::Side::SERVER, readerOpts),
+          rpcSystem(makeRpcServer(network, bootstrapFactory)) {}
+  };
+
+#if __linux__ && !__BIONIC__
+  static constexpr uint CONNECTION_FLAGS = kj::LowLevelAsyncIoProvider::ALREADY_CLOEXEC |
+                                           kj::LowLevelAsyncIoProvider::ALREADY_NONBLOCK;
+#else
+  static constexpr uint CONNECTION_FLAGS = 0;
+#endif
+  // How the acceptor leaves the connections it accepts.
+
+  class WorkerContext final: public kj::TaskSet::ErrorHandler {
+    // State of one worker, living on the worker's thread.
+
+  public:
+    WorkerContext(kj::LowLevelAsyncIoProvider& provider, ReaderOptions readerOpts)
+        : provider(provider), readerOpts(readerOpts), tasks(*this) {
+      auto paf = kj::newPromiseAndFulfiller<void>();
+      stopped = kj::mv(paf.promise);
+      stopper = kj::mv(paf.fulfiller);
+    }
+
+    kj::Promise<void> run(kj::Own<BootstrapFactory<rpc::twoparty::VatId>>&& factory) {
+      // Services connections as they're handed over, until stop() is called.
+
+      bootstrapFactory = kj::mv(factory);
+      return kj::mv(stopped);
+    }
+
+    void accept(kj::AutoCloseFd&& connection) {
+      auto server = kj::heap<ServerContext>(kj::mv(connection), provider, *bootstrapFactory,
+                                            readerOpts);
+      tasks.add(server->network.onDisconnect().attach(kj::mv(server)));
+    }
+
+    void stop() {
+      stopper->fulfill();
+    }
+
+    void taskFailed(kj::Exception&& exception) override {
+      // One connection failing mustn't take down the others on this worker.
+      KJ_LOG(ERROR, "EzRpcThreadedServer connection failed", exception);
+    }
+
+  private:
+    kj::LowLevelAsyncIoProvider& provider;
+    ReaderOptions readerOpts;
+    kj::Own<BootstrapFactory<rpc::twoparty::VatId>> bootstrapFactory;
+    kj::Promise<void> stopped = nullptr;
+    kj::Own<kj::PromiseFulfiller<void>> stopper;
+    kj::TaskSet tasks;
+  };
+
+  struct HandOff {
+    // Run on a worker's loop to hand it a connection.  If the worker stops first, this is
+    // destroyed without being run, closing the connection.
+
+    kj::AutoCloseFd connection;
+    WorkerContext* worker;
+
+    void operator()() {
+      worker->accept(kj::mv(connection));
+    }
+  };
+
+  Impl(MakeBootstrapFactory&& makeBootstrapFactory, kj::StringPtr bindAddress,
+       uint defaultPort, uint threadCount, ReaderOptions readerOpts)
+      : context(EzRpcContext::getThreadLocal()),
+        makeBootstrapFactory(kj::mv(makeBootstrapFactory)),
+        threadCount(threadCount), readerOpts(readerOpts),
+        portPromise(nullptr), tasks(*this) {
+    KJ_REQUIRE(threadCount > 0, "EzRpcThreadedServer needs at least one thread");
+
+    auto paf = kj::newPromiseAndFulfiller<uint>();
+    portPromise = paf.promise.fork();
+
+    tasks.add(context->getIoProvider().getNetwork().parseAddress(bindAddress, defaultPort)
+        .then(kj::mvCapture(paf.fulfiller,
+          [this](kj::Own<kj::PromiseFulfiller<uint>>&& portFulfiller,
+                 kj::Own<kj::NetworkAddress>&& addr) {
+      auto ownListener = addr->listen();
+      int fd = KJ_REQUIRE_NONNULL(ownListener->getFd(),
+          "EzRpcThreadedServer requires a listener backed by a file descriptor");
+      uint port = ownListener->getPort();
+      listener = kj::mv(ownListener);
+      startWorkers(fd);
+      portFulfiller->fulfill(kj::cp(port));
+    })));
+  }
+
+  Impl(MakeBootstrapFactory&& makeBootstrapFactory, int socketFd, uint port,
+       uint threadCount, ReaderOptions readerOpts)
+      : context(EzRpcContext::getThreadLocal()),
+        makeBootstrapFactory(kj::mv(makeBootstrapFactory)),
+        threadCount(threadCount), readerOpts(readerOpts),
+        portPromise(kj::Promise<uint>(port).fork()), tasks(*this) {
+    KJ_REQUIRE(threadCount > 0, "EzRpcThreadedServer needs at least one thread");
+
+    // The acceptor waits for the socket to become readable, so it must not block in accept().
+    int flags;
+    KJ_SYSCALL(flags = fcntl(socketFd, F_GETFL));
+    if ((flags & O_NONBLOCK) == 0) {
+      KJ_SYSCALL(fcntl(socketFd, F_SETFL, flags | O_NONBLOCK));
+    }
+
+    startWorkers(socketFd);
+  }
+
+  ~Impl() noexcept(false) {
+    // Stop the acceptor first, since it hands connections to the workers.  Then signal all
+    // workers before joining any of them, so that they shut down in parallel.  A worker's stop
+    // request is queued behind any connections still on their way to it, and those it hasn't
+    // serviced yet are closed along with its loop.
+    acceptorStopFd = nullptr;
+    acceptor = nullptr;
+    for (auto& worker: workers) {
+      if (worker->executor.get() != nullptr) {
+        WorkerContext* context = worker->context;
+        worker->executor->executeAsync([context]() { context->stop(); })
+            .detach([](kj::Exception&&) {});
+      }
+    }
+    workers.clear();
+  }
+
+  static kj::AutoCloseFd newChannel(kj::Function<void(int, uint)> startThread) {
+    // Creates a socketpair, starts a thread with the one end (and the flags with which to wrap
+    // it), and returns the other, blocking end.
+
+    int fds[2];
+    int type = SOCK_STREAM;
+    uint newFdFlags = kj::LowLevelAsyncIoProvider::TAKE_OWNERSHIP;
+#if __linux__ && !__BIONIC__
+    type |= SOCK_CLOEXEC;
+    newFdFlags |= kj::LowLevelAsyncIoProvider::ALREADY_CLOEXEC;
+#endif
+    KJ_SYSCALL(socketpair(AF_UNIX, type, 0, fds));
+    kj::AutoCloseFd ours(fds[0]);
+    {
+      KJ_ON_SCOPE_FAILURE(close(fds[1]));
+      startThread(fds[1], newFdFlags);
+    }
+    return ours;
+  }
+
+  void startWorkers(int listenFd) {
+    // Each worker is fed by the one acceptor, rather than all of them watching the listen socket:
+    // otherwise every idle worker would wake up for every incoming connection, only for all but
+    // one of them to find nothing to accept.
+
+    workers.reserve(threadCount);
+    for (uint i = 0; i < threadCount; i++) {
+      auto worker = kj::heap<Worker>();
+      auto& workerRef = *worker;
+      worker->thread = kj::heap<kj::Thread>([this,&workerRef]() {
+        runWorker(workerRef);
+      });
+      workers.add(kj::mv(worker));
+    }
+
+    // The acceptor reads the workers' executors without locking, so they must all be set first.
+    for (auto& worker: workers) {
+      worker->started.when([](const bool& started) { return started; }, [](bool&) {});
+    }
+
+    acceptorStopFd = newChannel([&](int stopFd, uint flags) {
+      acceptor = kj::heap<kj::Thread>([this,listenFd,stopFd,flags]() {
+        runAcceptor(listenFd, stopFd, flags);
+      });
+    });
+  }
+
+  void runAcceptor(int listenFd, int stopFd, uint stopFdFlags) {
+    // Runs on the acceptor thread until the other end of `stopFd` is closed.
+
+    auto io = kj::setupAsyncIo();
+    auto stopStream = io.lowLevelProvider->wrapSocketFd(stopFd, stopFdFlags);
+    kj::UnixEventPort::FdObserver observer(io.unixEventPort, listenFd,
+                                           kj::UnixEventPort::FdObserver::OBSERVE_READ);
+
+    byte dummy;
+    stopStream->tryRead(&dummy, 1, 1).ignoreResult()
+        .exclusiveJoin(acceptLoop(observer, listenFd, 0))
+        .wait(io.waitScope);
+  }
+
+  kj::Promise<void> acceptLoop(kj::UnixEventPort::FdObserver& observer, int listenFd,
+                               uint nextWorker) {
+    // Accepts every connection that is ready, handing them to the workers in turn, then waits for
+    // more.
+
+    for (;;) {
+      int newFd;
+#if __linux__ && !__BIONIC__
+      newFd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+      newFd = ::accept(listenFd, nullptr, nullptr);
+#endif
+
+      if (newFd < 0) {
+        int error = errno;
+        switch (error) {
+          case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+          case EWOULDBLOCK:
+#endif
+            return observer.whenBecomesReadable().then([this,&observer,listenFd,nextWorker]() {
+              return acceptLoop(observer, listenFd, nextWorker);
+            });
+
+          case EINTR:
+          case ENETDOWN:
+#ifdef EPROTO
+          case EPROTO:
+#endif
+          case EHOSTDOWN:
+          case EHOSTUNREACH:
+          case ENETUNREACH:
+          case ECONNABORTED:
+          case ETIMEDOUT:
+            // The connection broke before we could accept it, or similar.  See
+            // FdConnectionReceiver::handleAcceptError() in kj/async-io-unix.c++.
+            continue;
+
+          default:
+            KJ_FAIL_SYSCALL("accept", error);
+        }
+      }
+
+      kj::AutoCloseFd connection(newFd);
+      for (uint i = 0; i < workers.size(); i++) {
+        Worker& worker = *workers[nextWorker];
+        nextWorker = (nextWorker + 1) % workers.size();
+
+        // Skip workers which died, e.g. because their BootstrapFactory couldn't be made.
+        if (worker.executor.get() != nullptr && worker.executor->isLive()) {
+          worker.executor->executeAsync(HandOff { kj::mv(connection), worker.context })
+              .detach([](kj::Exception&& exception) {
+            KJ_LOG(ERROR, "EzRpcThreadedServer couldn't hand off connection", exception);
+          });
+          break;
+        }
+      }
+
+      if (connection.get() >= 0) {
+        KJ_LOG(ERROR, "all EzRpcThreadedServer workers have died; dropping connection");
+      }
+    }
+  }
+
+  void runWorker(Worker& worker) {
+    // Runs on a worker thread until it is told to stop.
+
+    bool started = false;
+    KJ_DEFER(if (!started) *worker.started.lockExclusive() = true);
+
+    auto io = kj::setupAsyncIo();
+    WorkerContext context(*io.lowLevelProvider, readerOpts);
+    worker.executor = kj::getCurrentThreadExecutor().addRef();
+    worker.context = &context;
+    *worker.started.lockExclusive() = true;
+    started = true;
+
+    // Connections may be handed to us while the factory is being made; they wait in the queue.
+    auto bootstrapFactory = (*makeBootstrapFactory.lockExclusive())();
+    context.run(kj::mv(bootstrapFactory)).wait(io.waitScope);
+  }
+
+  void taskFailed(kj::Exception&& exception) override {
+    kj::throwFatalException(kj::mv(exception));
+  }
+};
+
+EzRpcThreadedServer::EzRpcThreadedServer(
+    MakeBootstrapFactory makeBootstrapFactory, kj::StringPtr bindAddress,
+    uint threadCount, uint defaultPort, ReaderOptions readerOpts)
+    : impl(kj::heap<Impl>(kj::mv(makeBootstrapFactory), bindAddress, defaultPort,
+                          threadCount, readerOpts)) {}
+
+EzRpcThreadedServer::EzRpcThreadedServer(
+    MakeBootstrapFactory makeBootstrapFactory, int socketFd, uint port,
+    uint threadCount, ReaderOptions readerOpts)
+    : impl(kj::heap<Impl>(kj::mv(makeBootstrapFactory), socketFd, port,
+                          threadCount, readerOpts)) {}
+
+EzRpcThreadedServer::~EzRpcThreadedServer() noexcept(false) {}
+
+kj::Promise<uint> EzRpcThreadedServer::getPort() {
+  return impl->portPromise.addBranch();
+}
+
+kj::WaitScope& EzRpcThreadedServer::getWaitScope() {
+  return impl->context->getWaitScope();
+}
+
+#endif  // !_WIN32
+
 }  // namespace capnp
@@ -28,6 +28,8 @@
 
 #include "rpc.h"
 #include "message.h"
+#include "load-balancer.h"
+#include "rpc-twoparty.capnp.h"
 
 struct sockaddr;
 
@@ -122,6 +124,17 @@ public:
   // Create a client on top of an already-connected socket.
   // `readerOpts` acts as in the first constructor.
 
+  EzRpcClient(kj::ArrayPtr<const kj::StringPtr> serverAddresses, uint defaultPort = 0,
+              LoadBalancerOptions balancerOpts = LoadBalancerOptions(),
+              ReaderOptions readerOpts = ReaderOptions());
+  // Connect to each of several servers which export the same main interface.  getMain() then
+  // returns a client which spreads calls over them, skipping any which can't be reached or
+  // disconnect; see `newLoadBalancedClient()` in `capnp/load-balancer.h`.  Unless
+  // `balancerOpts.reconnect` is set, a server which is skipped is dialed again after a short
+  // delay, which doubles each time it can't be reached, up to ten seconds.  importCap() likewise
+  // balances over the servers, and reconnects to them the same way regardless of
+  // `balancerOpts.reconnect`.  The other parameters act as in the first constructor.
+
   ~EzRpcClient() noexcept(false);
 
   template <typename Type>
@@ -236,6 +249,66 @@ private:
   kj::Own<Impl> impl;
 };
 
+#if !_WIN32
+
+class EzRpcThreadedServer {
+  // Like `EzRpcServer`, but services connections on a pool of worker threads so that one server
+  // process can make use of more than one core.  Example:
+  //
+  //     capnp::EzRpcThreadedServer server([]() {
+  //       return kj::heap<MyBootstrapFactory>();
+  //     }, "*:3456", 4);
+  //     kj::NEVER_DONE.wait(server.getWaitScope());
+  //
+  // The listen socket is bound on the calling thread.  One additional thread accepts connections
+  // from it and hands them to the workers in turn; each worker runs its own `kj::EventLoop` and
+  // services each connection it is handed (with its own `RpcSystem`) for the connection's whole
+  // lifetime.  Capabilities never cross threads: each worker builds its own
+  // bootstrap capabilities, so servers that share state between connections on different
+  // workers must synchronize it themselves.
+
+public:
+  typedef kj::Function<kj::Own<BootstrapFactory<rpc::twoparty::VatId>>()> MakeBootstrapFactory;
+  // Called once on each worker thread, as the worker starts up, to create the BootstrapFactory
+  // which will supply bootstrap capabilities to that worker's connections.  Calls are serialized,
+  // so the function need not be thread-safe, but the objects it returns are used only by the
+  // calling worker.
+
+  EzRpcThreadedServer(MakeBootstrapFactory makeBootstrapFactory, kj::StringPtr bindAddress,
+                      uint threadCount, uint defaultPort = 0,
+                      ReaderOptions readerOpts = ReaderOptions());
+  // Construct a new server that binds to the given address and services connections on
+  // `threadCount` worker threads.  `bindAddress`, `defaultPort`, and `readerOpts` are as for
+  // `EzRpcServer`.  The workers start once the address has been resolved and bound, i.e. by the
+  // time the promise returned by `getPort()` resolves.
+
+  EzRpcThreadedServer(MakeBootstrapFactory makeBootstrapFactory, int socketFd, uint port,
+                      uint threadCount, ReaderOptions readerOpts = ReaderOptions());
+  // Create a server on top of an already-listening socket.  The socket is not closed by the
+  // server, and is put into non-blocking mode.  `port` is returned by `getPort()` -- it serves no
+  // other purpose.
+
+  ~EzRpcThreadedServer() noexcept(false);
+  // Stops accepting, stops all workers, disconnecting their clients -- including any whose
+  // connections were accepted but not yet picked up -- and waits for them to exit.  If a worker
+  // failed with an exception, e.g. from `makeBootstrapFactory`, it is rethrown here.  Until then,
+  // new connections go to the remaining workers.
+
+  kj::Promise<uint> getPort();
+  // Get the IP port number on which this server is listening.  See `EzRpcServer::getPort()`.
+
+  kj::WaitScope& getWaitScope();
+  // Get the `WaitScope` for the calling thread's `EventLoop`.  Note that the workers do not run
+  // on this loop, but the address is resolved on it, so something must wait on it (e.g. for
+  // `getPort()`) before the server can start.
+
+private:
+  struct Impl;
+  kj::Own<Impl> impl;
+};
+
+#endif  // !_WIN32
+
 // =======================================================================================
 // inline implementation details
 
@@ -882,6 +882,173 @@ struct WireHelpers {
     return result;
   }
 
+  static bool addTargetRange(SegmentReader* segment, const word* start, uint64_t size,
+                             kj::ArrayPtr<WordRange> ranges, uint& count) {
+    if (size == 0) return true;
+
+    uint segmentId = segment->getSegmentId().value;
+    uint offset = start - segment->getStartPtr();
+    if (count > 0) {
+      WordRange& last = ranges[count - 1];
+      if (last.segmentId == segmentId && last.offset + last.size == offset) {
+        last.size += size;
+        return true;
+      }
+    }
+    if (count == ranges.size()) return false;
+    ranges[count++] = WordRange { segmentId, offset, static_cast<uint>(size) };
+    return true;
+  }
+
+  static bool targetRanges(SegmentReader* segment, const WirePointer* ref, int nestingLimit,
+                           kj::ArrayPtr<WordRange> ranges, uint& count) {
+    // Like totalSize(), but records where the words are -- landing pads included -- instead of
+    // counting them.  Returns false if `ranges` fills up.
+
+    if (ref->isNull()) {
+      return true;
+    }
+
+    KJ_REQUIRE(nestingLimit > 0, "Message is too deeply-nested.") {
+      return false;
+    }
+    --nestingLimit;
+
+    if (ref->kind() == WirePointer::FAR) {
+      SegmentReader* padSegment = segment->getArena()->tryGetSegment(ref->farRef.segmentId.get());
+      if (padSegment != nullptr) {
+        const word* pad = ref->farTarget(padSegment);
+        auto padWords = (ONE + bounded(ref->isDoubleFar())) * POINTER_SIZE_IN_WORDS;
+        if (boundsCheck(padSegment, pad, padWords) &&
+            !addTargetRange(padSegment, pad, unbound(padWords / WORDS), ranges, count)) {
+          return false;
+        }
+      }
+    }
+
+    const word* ptr;
+    KJ_IF_MAYBE(p, followFars(ref, ref->target(segment), segment)) {
+      ptr = p;
+    } else {
+      return false;
+    }
+
+    switch (ref->kind()) {
+      case WirePointer::STRUCT: {
+        KJ_REQUIRE(boundsCheck(segment, ptr, ref->structRef.wordSize()),
+                   "Message contained out-of-bounds struct pointer.") {
+          return false;
+        }
+        if (!addTargetRange(segment, ptr, unbound(ref->structRef.wordSize() / WORDS),
+                            ranges, count)) {
+          return false;
+        }
+
+        const WirePointer* pointerSection =
+            reinterpret_cast<const WirePointer*>(ptr + ref->structRef.dataSize.get());
+        for (auto i: kj::zeroTo(ref->structRef.ptrCount.get())) {
+          if (!targetRanges(segment, pointerSection + i, nestingLimit, ranges, count)) {
+            return false;
+          }
+        }
+        return true;
+      }
+      case WirePointer::LIST: {
+        switch (ref->listRef.elementSize()) {
+          case ElementSize::VOID:
+            return true;
+          case ElementSize::BIT:
+          case ElementSize::BYTE:
+          case ElementSize::TWO_BYTES:
+          case ElementSize::FOUR_BYTES:
+          case ElementSize::EIGHT_BYTES: {
+            auto totalWords = roundBitsUpToWords(
+                upgradeBound<uint64_t>(ref->listRef.elementCount()) *
+                dataBitsPerElement(ref->listRef.elementSize()));
+            KJ_REQUIRE(boundsCheck(segment, ptr, totalWords),
+                       "Message contained out-of-bounds list pointer.") {
+              return false;
+            }
+            return addTargetRange(segment, ptr, unbound(totalWords / WORDS), ranges, count);
+          }
+          case ElementSize::POINTER: {
+            auto elementCount = ref->listRef.elementCount() * (POINTERS / ELEMENTS);
+            KJ_REQUIRE(boundsCheck(segment, ptr, elementCount * WORDS_PER_POINTER),
+                       "Message contained out-of-bounds list pointer.") {
+              return false;
+            }
+            if (!addTargetRange(segment, ptr, unbound(elementCount * WORDS_PER_POINTER / WORDS),
+                                ranges, count)) {
+              return false;
+            }
+            for (auto i: kj::zeroTo(elementCount)) {
+              if (!targetRanges(segment, reinterpret_cast<const WirePointer*>(ptr) + i,
+                                nestingLimit, ranges, count)) {
+                return false;
+              }
+            }
+            return true;
+          }
+          case ElementSize::INLINE_COMPOSITE: {
+            auto wordCount = ref->listRef.inlineCompositeWordCount();
+            KJ_REQUIRE(boundsCheck(segment, ptr, wordCount + POINTER_SIZE_IN_WORDS),
+                       "Message contained out-of-bounds list pointer.") {
+              return false;
+            }
+            if (!addTargetRange(segment, ptr,
+                                unbound((wordCount + POINTER_SIZE_IN_WORDS) / WORDS),
+                                ranges, count)) {
+              return false;
+            }
+
+            const WirePointer* elementTag = reinterpret_cast<const WirePointer*>(ptr);
+            auto elementCount = elementTag->inlineCompositeListElementCount();
+            KJ_REQUIRE(elementTag->kind() == WirePointer::STRUCT,
+                       "Don't know how to handle non-STRUCT inline composite.") {
+              return false;
+            }
+            KJ_REQUIRE(elementTag->structRef.wordSize() / ELEMENTS *
+                           upgradeBound<uint64_t>(elementCount) <= wordCount,
+                       "Struct list pointer's elements overran size.") {
+              return false;
+            }
+
+            WordCount dataSize = elementTag->structRef.dataSize.get();
+            WirePointerCount pointerCount = elementTag->structRef.ptrCount.get();
+
+            if (pointerCount > ZERO * POINTERS) {
+              const word* pos = ptr + POINTER_SIZE_IN_WORDS;
+              for (auto i KJ_UNUSED: kj::zeroTo(elementCount)) {
+                pos += dataSize;
+
+                for (auto j KJ_UNUSED: kj::zeroTo(pointerCount)) {
+                  if (!targetRanges(segment, reinterpret_cast<const WirePointer*>(pos),
+                                    nestingLimit, ranges, count)) {
+                    return false;
+                  }
+                  pos += POINTER_SIZE_IN_WORDS;
+                }
+              }
+            }
+            return true;
+          }
+        }
+        KJ_UNREACHABLE;
+      }
+      case WirePointer::FAR:
+        KJ_FAIL_REQUIRE("Unexpected FAR pointer.") {
+          return false;
+        }
+      case WirePointer::OTHER:
+        KJ_REQUIRE(ref->isCapability(), "Unknown pointer type.") {
+          return false;
+        }
+        return true;
+    }
+
+    KJ_UNREACHABLE;
+  }
+
   // -----------------------------------------------------------------
   // Copy from an unchecked message.
 
@@ -2631,6 +2798,68 @@ void PointerBuilder::copyFrom(PointerReader other, bool canonical) {
   }
 }
 
+bool PointerBuilder::referTo(PointerReader other,
+                             kj::ArrayPtr<const kj::ArrayPtr<const word>> otherSegments,
+                             uint selfSegmentId) {
+  KJ_REQUIRE(pointer->isNull(), "referTo() can only be used to initialize a null pointer.");
+
+  const WirePointer* src = other.pointer;
+  if (src == nullptr || src->isNull()) {
+    return true;
+  }
+
+  if (other.segment == nullptr) {
+    // Unchecked message; we don't know where it lives.
+    return false;
+  }
+  uint srcSegmentId = other.segment->getSegmentId().value;
+  if (srcSegmentId >= otherSegments.size() ||
+      otherSegments[srcSegmentId].begin() != other.segment->getStartPtr()) {
+    return false;
+  }
+
+  switch (src->kind()) {
+    case WirePointer::FAR:
+    case WirePointer::OTHER:
+      // Far pointers name their landing pads by segment ID, which the caller preserves. Capability
+      // pointers are indexes into the cap table, which the caller also preserves.
+      WireHelpers::copyMemory(pointer, src);
+      return true;
+
+    case WirePointer::STRUCT:
+    case WirePointer::LIST: {
+      // The offset is relative to the source pointer's location, so we need a double-far landing
+      // pad in our own segment giving the target's absolute position in its segment.
+      const word* srcStart = otherSegments[srcSegmentId].begin();
+      ptrdiff_t targetOffset = reinterpret_cast<const word*>(src + 1) +
+          (static_cast<int32_t>(src->offsetAndKind.get()) >> 2) - srcStart;
+      if (targetOffset < 0 ||
+          targetOffset > static_cast<ptrdiff_t>(otherSegments[srcSegmentId].size())) {
+        // Out-of-bounds; let the copy path report the error.
+        return false;
+      }
+
+      WirePointer* pad = reinterpret_cast<WirePointer*>(segment->allocate(G(2) * WORDS));
+      if (pad == nullptr) {
+        return false;
+      }
+      ptrdiff_t padOffset = reinterpret_cast<word*>(pad) - segment->getStartPtr();
+
+      pad[0].offsetAndKind.set((static_cast<uint32_t>(targetOffset) << 3) | WirePointer::FAR);
+      pad[0].farRef.segmentId.set(SegmentId(srcSegmentId));
+      pad[1].setKindWithZeroOffset(src->kind());
+      WireHelpers::copyMemory(&pad[1].upper32Bits, &src->upper32Bits);
+
+      pointer->offsetAndKind.set((static_cast<uint32_t>(padOffset) << 3) | (1 << 2) |
+                                 WirePointer::FAR);
+      pointer->farRef.segmentId.set(SegmentId(selfSegmentId));
+      return true;
+    }
+  }
+
+  KJ_UNREACHABLE;
+}
+
 PointerReader PointerBuilder::asReader() const {
   return PointerReader(segment, capTable, pointer, kj::maxValue);
 }
@@ -2710,6 +2939,23 @@ MessageSizeCounts PointerReader::targetSize() const {
                             : WireHelpers::totalSize(segment, pointer, nestingLimit);
 }
 
+kj::Maybe<uint> PointerReader::getTargetRanges(kj::ArrayPtr<WordRange> ranges) const {
+  if (pointer == nullptr) {
+    return uint(0);
+  }
+  if (segment == nullptr) {
+    // Unchecked message; we don't know where it lives.
+    return nullptr;
+  }
+
+  uint count = 0;
+  if (WireHelpers::targetRanges(segment, pointer, nestingLimit, ranges, count)) {
+    return count;
+  } else {
+    return nullptr;
+  }
+}
+
 PointerType PointerReader::getPointerType() const {
   if(pointer == nullptr || pointer->isNull()) {
     return PointerType::NULL_;
@@ -182,6 +182,14 @@ struct MessageSizeCounts {
   }
 };
 
+struct WordRange {
+  // A run of words within a segment, as reported by PointerReader::getTargetRanges().
+
+  uint segmentId;
+  uint offset;
+  uint size;
+};
+
 // =============================================================================
 
 template <int wordCount>
@@ -395,6 +403,17 @@ public:
   // If you set the canonical flag, it will attempt to lay the target out
   // canonically, provided enough space is available.
 
+  bool referTo(PointerReader other, kj::ArrayPtr<const kj::ArrayPtr<const word>> otherSegments,
+               uint selfSegmentId);
+  // Makes this (null) pointer refer to `other`'s target in-place instead of copying it. This only
+  // makes sense to a writer that intends to transmit `otherSegments` verbatim -- under their
+  // original segment IDs -- followed by the segment containing this pointer at ID
+  // `selfSegmentId`; the pointer cannot be followed through this builder. Capability pointers are
+  // copied as-is, so the caller must preserve `other`'s cap table indexes.
+  //
+  // Returns false, leaving this pointer null, if `other` does not live in `otherSegments` or there
+  // is no room for a landing pad in this pointer's segment. The caller should copy instead.
+
   PointerReader asReader() const;
 
   BuilderArena* getArena() const;
@@ -439,6 +458,13 @@ public:
   // use the result as a hint for allocating the first segment, do the copy, and then throw an
   // exception if it overruns.
 
+  kj::Maybe<uint> getTargetRanges(kj::ArrayPtr<WordRange> ranges) const;
+  // Fill `ranges` with the location of every word making up the target object and everything to
+  // which it points, including far pointer landing pads but not this pointer itself, and return
+  // the number of ranges used.  Ranges that directly follow one another in traversal order are
+  // merged, so a message built in the usual way needs only a few.  Returns null if the message is
+  // unchecked or `ranges` is too small.
+
   inline bool isNull() const { return getPointerType() == PointerType::NULL_; }
   PointerType getPointerType() const;
 
@@ -0,0 +1,238 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "load-balancer.h"
+#include <kj/test.h>
+#include <kj/vector.h>
+#include "test-util.h"
+#include "rpc-twoparty.h"
+#include <kj/async-io.h>
+
+namespace capnp {
+namespace _ {
+namespace {
+
+class DisconnectingImpl final: public test::TestInterface::Server {
+  // Fails every call as if its vat had gone away.
+
+public:
+  explicit DisconnectingImpl(int& callCount): callCount(callCount) {}
+
+protected:
+  kj::Promise<void> foo(FooContext context) override {
+    ++callCount;
+    return KJ_EXCEPTION(DISCONNECTED, "backend went away");
+  }
+
+private:
+  int& callCount;
+};
+
+kj::Promise<void> callFoo(test::TestInterface::Client& cap) {
+  auto request = cap.fooRequest();
+  request.setI(123);
+  request.setJ(true);
+  return request.send().then([](Response<test::TestInterface::FooResults>&& response) {
+    KJ_EXPECT(response.getX() == "foo");
+  });
+}
+
+void callFooMany(test::TestInterface::Client& cap, uint count, kj::WaitScope& waitScope) {
+  auto promises = kj::heapArrayBuilder<kj::Promise<void>>(count);
+  for (uint i = 0; i < count; i++) {
+    promises.add(callFoo(cap));
+  }
+  kj::joinPromises(promises.finish()).wait(waitScope);
+}
+
+KJ_TEST("load balancer spreads calls by outstanding count") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int callCounts[3] = { 0, 0, 0 };
+  auto backends = kj::heapArrayBuilder<Capability::Client>(3);
+  for (auto& callCount: callCounts) {
+    backends.add(kj::heap<TestInterfaceImpl>(callCount));
+  }
+  auto cap = newLoadBalancedClient(backends.finish()).castAs<test::TestInterface>();
+
+  // Local calls don't complete until the event loop runs, so all of these are outstanding at once.
+  callFooMany(cap, 30, waitScope);
+  KJ_EXPECT(callCounts[0] == 10);
+  KJ_EXPECT(callCounts[1] == 10);
+  KJ_EXPECT(callCounts[2] == 10);
+}
+
+KJ_TEST("load balancer with power of two choices") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int callCounts[4] = { 0, 0, 0, 0 };
+  auto backends = kj::heapArrayBuilder<Capability::Client>(4);
+  for (auto& callCount: callCounts) {
+    backends.add(kj::heap<TestInterfaceImpl>(callCount));
+  }
+  LoadBalancerOptions options;
+  options.strategy = LoadBalancerOptions::Strategy::POWER_OF_TWO_CHOICES;
+  auto cap = newLoadBalancedClient(backends.finish(), kj::mv(options))
+      .castAs<test::TestInterface>();
+
+  callFooMany(cap, 100, waitScope);
+
+  // The less loaded of two choices keeps the spread tight.
+  for (auto callCount: callCounts) {
+    KJ_EXPECT(callCount >= 15 && callCount <= 35, callCount);
+  }
+  KJ_EXPECT(callCounts[0] + callCounts[1] + callCounts[2] + callCounts[3] == 100);
+}
+
+KJ_TEST("load balancer ejects disconnected backends and retries idempotent calls") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int badCount = 0;
+  int goodCount = 0;
+  auto backends = kj::heapArrayBuilder<Capability::Client>(2);
+  backends.add(kj::heap<DisconnectingImpl>(badCount));
+  backends.add(kj::heap<TestInterfaceImpl>(goodCount));
+
+  LoadBalancerOptions options;
+  options.isIdempotent = kj::Function<bool(uint64_t, uint16_t)>(
+      [](uint64_t interfaceId, uint16_t methodId) {
+    return interfaceId == typeId<test::TestInterface>() && methodId == 0;  // foo()
+  });
+  auto cap = newLoadBalancedClient(backends.finish(), kj::mv(options))
+      .castAs<test::TestInterface>();
+
+  callFooMany(cap, 10, waitScope);
+  KJ_EXPECT(badCount == 5);    // all sent before the first failure came back
+  KJ_EXPECT(goodCount == 10);  // including the retries
+
+  // The bad backend has been ejected.
+  callFooMany(cap, 10, waitScope);
+  KJ_EXPECT(badCount == 5);
+  KJ_EXPECT(goodCount == 20);
+}
+
+KJ_TEST("load balancer doesn't retry other calls") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int badCount = 0;
+  auto backends = kj::heapArrayBuilder<Capability::Client>(1);
+  backends.add(kj::heap<DisconnectingImpl>(badCount));
+  auto cap = newLoadBalancedClient(backends.finish()).castAs<test::TestInterface>();
+
+  KJ_EXPECT_THROW_MESSAGE("backend went away", callFoo(cap).wait(waitScope));
+  KJ_EXPECT(badCount == 1);
+
+  // Nothing is left.
+  KJ_EXPECT_THROW_MESSAGE("All backends", callFoo(cap).wait(waitScope));
+  KJ_EXPECT(badCount == 1);
+}
+
+KJ_TEST("load balancer ejects backends which resolve to broken capabilities") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int callCount = 0;
+  auto backends = kj::heapArrayBuilder<Capability::Client>(2);
+  backends.add(Capability::Client(kj::Promise<Capability::Client>(
+      KJ_EXCEPTION(DISCONNECTED, "connection refused"))));
+  backends.add(kj::heap<TestInterfaceImpl>(callCount));
+  auto cap = newLoadBalancedClient(backends.finish()).castAs<test::TestInterface>();
+
+  kj::evalLater([]() {}).wait(waitScope);
+  callFooMany(cap, 4, waitScope);
+  KJ_EXPECT(callCount == 4);
+}
+
+KJ_TEST("load balancer ejects backends whose bootstrap fails") {
+  auto ioContext = kj::setupAsyncIo();
+  auto pipe1 = ioContext.provider->newTwoWayPipe();
+  auto pipe2 = ioContext.provider->newTwoWayPipe();
+
+  // One server vat exposes no bootstrap interface, and the other's is broken.
+  TwoPartyClient server1(*pipe1.ends[0], nullptr, rpc::twoparty::Side::SERVER);
+  TwoPartyClient server2(*pipe2.ends[0], KJ_EXCEPTION(FAILED, "backend failed to start"),
+                         rpc::twoparty::Side::SERVER);
+  TwoPartyClient client1(*pipe1.ends[1]);
+  TwoPartyClient client2(*pipe2.ends[1]);
+
+  int callCount = 0;
+  auto backends = kj::heapArrayBuilder<Capability::Client>(3);
+  backends.add(client1.bootstrap());
+  backends.add(client2.bootstrap());
+  backends.add(kj::heap<TestInterfaceImpl>(callCount));
+  auto cap = newLoadBalancedClient(backends.finish()).castAs<test::TestInterface>();
+
+  // Calls to the failed bootstraps fail with FAILED, so they'd never eject them.  The balancer
+  // has to notice from their resolution.
+  auto ignore = [](kj::Exception&&) {};
+  client1.bootstrap().whenResolved().then([]() {}, ignore).wait(ioContext.waitScope);
+  client2.bootstrap().whenResolved().then([]() {}, ignore).wait(ioContext.waitScope);
+  callFooMany(cap, 6, ioContext.waitScope);
+  KJ_EXPECT(callCount == 6);
+}
+
+KJ_TEST("load balancer replaces ejected backends") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+
+  int badCount = 0;
+  int goodCount = 0;
+  int replacementCount = 0;
+  auto backends = kj::heapArrayBuilder<Capability::Client>(2);
+  backends.add(kj::heap<TestInterfaceImpl>(goodCount));
+  backends.add(kj::heap<DisconnectingImpl>(badCount));
+
+  kj::Vector<uint> reconnected;
+  auto paf = kj::newPromiseAndFulfiller<Capability::Client>();
+  LoadBalancerOptions options;
+  options.reconnect = kj::Function<kj::Promise<Capability::Client>(uint)>(
+      [&](uint index) -> kj::Promise<Capability::Client> {
+    reconnected.add(index);
+    return kj::mv(paf.promise);
+  });
+  auto cap = newLoadBalancedClient(backends.finish(), kj::mv(options))
+      .castAs<test::TestInterface>();
+
+  KJ_EXPECT_THROW_MESSAGE("backend went away", callFooMany(cap, 2, waitScope));
+  KJ_ASSERT(reconnected.size() == 1);
+  KJ_EXPECT(reconnected[0] == 1);
+
+  // Until the replacement arrives, only the good backend is used.
+  callFooMany(cap, 4, waitScope);
+  KJ_EXPECT(goodCount == 5);
+  KJ_EXPECT(badCount == 1);
+
+  paf.fulfiller->fulfill(kj::heap<TestInterfaceImpl>(replacementCount));
+  kj::evalLater([]() {}).wait(waitScope);
+  callFooMany(cap, 4, waitScope);
+  KJ_EXPECT(goodCount == 7);
+  KJ_EXPECT(replacementCount == 2);
+  KJ_EXPECT(badCount == 1);
+}
+
+}  // namespace
+}  // namespace _
+}  // namespace capnp
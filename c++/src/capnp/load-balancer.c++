@@ -0,0 +1,428 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "load-balancer.h"
+#include "message.h"
+#include <kj/debug.h>
+#include <kj/vector.h>
+
+namespace capnp {
+
+namespace {
+
+static const char DUMMY = 0;
+static constexpr const void* LOAD_BALANCER_BRAND = &DUMMY;
+
+class Backend final: public kj::Refcounted {
+public:
+  Backend(uint index, kj::Own<ClientHook>&& hook): index(index), hook(kj::mv(hook)) {}
+
+  uint index;
+  // Position in the array given to newLoadBalancedClient() of the backend this is, or replaces.
+
+  kj::Own<ClientHook> hook;
+  // Replaced with the resolution if the backend starts out as a promise.
+
+  uint inFlight = 0;
+  bool ejected = false;
+};
+
+class InFlight {
+  // Counts a call against its backend for as long as the call is outstanding.
+
+public:
+  explicit InFlight(kj::Own<Backend>&& backend): backend(kj::mv(backend)) {
+    ++this->backend->inFlight;
+  }
+  KJ_DISALLOW_COPY(InFlight);
+  ~InFlight() { finish(); }
+
+  Backend& getBackend() { return *backend; }
+
+  void finish() {
+    if (!finished) {
+      finished = true;
+      --backend->inFlight;
+    }
+  }
+
+private:
+  kj::Own<Backend> backend;
+  bool finished = false;
+};
+
+struct RequestSettings {
+  // Settings applied to a request, remembered so that they can be applied again to a retry.
+
+  kj::Maybe<kj::Timer&> timer;
+  kj::TimePoint deadline = kj::origin<kj::TimePoint>();
+  kj::Maybe<CallPriority> priority;
+  kj::Array<byte> traceParent;
+
+  bool applyTo(Request<AnyPointer, AnyPointer>& request) {
+    // Returns false if the deadline has already passed.
+
+    KJ_IF_MAYBE(t, timer) {
+      auto now = t->now();
+      if (now >= deadline) return false;
+      request.setTimeout(*t, deadline - now);
+    }
+    KJ_IF_MAYBE(p, priority) {
+      request.setPriority(*p);
+    }
+    if (traceParent.size() > 0) {
+      request.setTraceParent(traceParent);
+    }
+    return true;
+  }
+};
+
+class LoadBalancerHook final: public ClientHook, public kj::Refcounted,
+                              private kj::TaskSet::ErrorHandler {
+public:
+  LoadBalancerHook(kj::Array<Capability::Client>&& clients, LoadBalancerOptions&& options)
+      : options(kj::mv(options)), randomState(reinterpret_cast<uintptr_t>(this) | 1),
+        tasks(*this) {
+    for (auto i: kj::indices(clients)) {
+      add(i, kj::mv(clients[i]));
+    }
+  }
+
+  void add(uint index, Capability::Client&& client) {
+    auto backend = kj::refcounted<Backend>(index, ClientHook::from(kj::mv(client)));
+    KJ_IF_MAYBE(promise, backend->hook->whenMoreResolved()) {
+      tasks.add(watch(kj::addRef(*backend), kj::mv(*promise)));
+    }
+    backends.add(kj::mv(backend));
+  }
+
+  kj::Maybe<kj::Own<Backend>> pick() {
+    size_t n = backends.size();
+    if (n == 0) return nullptr;
+
+    size_t best = 0;
+    switch (options.strategy) {
+      case LoadBalancerOptions::Strategy::LEAST_OUTSTANDING: {
+        size_t start = nextStart++ % n;
+        best = start;
+        for (size_t i = 1; i < n; i++) {
+          size_t candidate = (start + i) % n;
+          if (backends[candidate]->inFlight < backends[best]->inFlight) {
+            best = candidate;
+          }
+        }
+        break;
+      }
+
+      case LoadBalancerOptions::Strategy::POWER_OF_TWO_CHOICES: {
+        best = random() % n;
+        if (n > 1) {
+          size_t other = random() % (n - 1);
+          if (other >= best) ++other;
+          if (backends[other]->inFlight < backends[best]->inFlight) {
+            best = other;
+          }
+        }
+        break;
+      }
+    }
+
+    return kj::addRef(*backends[best]);
+  }
+
+  void eject(Backend& backend) {
+    if (backend.ejected) return;
+    backend.ejected = true;
+
+    for (size_t i = 0; i < backends.size(); i++) {
+      if (backends[i].get() == &backend) {
+        if (i + 1 < backends.size()) {
+          backends[i] = kj::mv(backends.back());
+        }
+        backends.removeLast();
+        break;
+      }
+    }
+
+    KJ_IF_MAYBE(reconnect, options.reconnect) {
+      uint index = backend.index;
+      tasks.add((*reconnect)(index).then([this,index](Capability::Client&& replacement) {
+        add(index, kj::mv(replacement));
+      }));
+    }
+  }
+
+  bool isRetryable(uint64_t interfaceId, uint16_t methodId) {
+    if (options.maxRetries == 0) return false;
+    KJ_IF_MAYBE(f, options.isIdempotent) {
+      return (*f)(interfaceId, methodId);
+    }
+    return false;
+  }
+
+  uint getMaxRetries() { return options.maxRetries; }
+
+  RemotePromise<AnyPointer> sendTo(kj::Own<Backend>&& backend, kj::Own<RequestHook>&& request) {
+    // Sends `request`, which was made by `backend`, counting it as in flight until it completes.
+
+    auto inFlight = kj::heap<InFlight>(kj::mv(backend));
+    auto& inFlightRef = *inFlight;
+    auto promise = request->send();
+
+    kj::Promise<Response<AnyPointer>> response = promise.then(
+        [&inFlightRef](Response<AnyPointer>&& response) -> kj::Promise<Response<AnyPointer>> {
+      inFlightRef.finish();
+      return kj::mv(response);
+    }, [this,&inFlightRef](kj::Exception&& exception) -> kj::Promise<Response<AnyPointer>> {
+      inFlightRef.finish();
+      if (exception.getType() == kj::Exception::Type::DISCONNECTED) {
+        eject(inFlightRef.getBackend());
+      }
+      return kj::mv(exception);
+    }).attach(kj::mv(inFlight), kj::addRef(*this));
+
+    return RemotePromise<AnyPointer>(kj::mv(response), kj::mv(promise));
+  }
+
+  static kj::Exception noBackends() {
+    return KJ_EXCEPTION(DISCONNECTED, "All backends of the load-balanced capability have failed.");
+  }
+
+  Request<AnyPointer, AnyPointer> newCall(
+      uint64_t interfaceId, uint16_t methodId, kj::Maybe<MessageSize> sizeHint) override;
+
+  VoidPromiseAndPipeline call(uint64_t interfaceId, uint16_t methodId,
+                              kj::Own<CallContextHook>&& context) override {
+    auto params = context->getParams();
+    auto request = newCall(interfaceId, methodId, params.targetSize());
+    request.set(params);
+    context->releaseParams();
+    return context->directTailCall(RequestHook::from(kj::mv(request)));
+  }
+
+  kj::Maybe<ClientHook&> getResolved() override {
+    return nullptr;
+  }
+
+  kj::Maybe<kj::Promise<kj::Own<ClientHook>>> whenMoreResolved() override {
+    return nullptr;
+  }
+
+  kj::Own<ClientHook> addRef() override {
+    return kj::addRef(*this);
+  }
+
+  const void* getBrand() override {
+    return LOAD_BALANCER_BRAND;
+  }
+
+private:
+  LoadBalancerOptions options;
+  kj::Vector<kj::Own<Backend>> backends;
+  // Backends which haven't been ejected.
+
+  size_t nextStart = 0;
+  uint64_t randomState;
+
+  kj::TaskSet tasks;
+  // Watches backends which are promises, and waits for replacements of ejected ones.
+
+  uint64_t random() {
+    // xorshift64*; we only need to spread choices evenly, not unpredictably.
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 2685821657736338717ull;
+  }
+
+  kj::Promise<void> watch(kj::Own<Backend>&& backend, kj::Promise<kj::Own<ClientHook>>&& promise) {
+    auto& backendRef = *backend;
+    return promise.then([this,&backendRef](kj::Own<ClientHook>&& resolved) -> kj::Promise<void> {
+      if (backendRef.ejected) return kj::READY_NOW;
+
+      if (resolved->isNull()) {
+        // Calls to it would fail, but not with DISCONNECTED, so they'd never eject it.
+        eject(backendRef);
+        return kj::READY_NOW;
+      }
+
+      // Send future calls straight to the resolution rather than through the promise.
+      backendRef.hook = kj::mv(resolved);
+      KJ_IF_MAYBE(next, backendRef.hook->whenMoreResolved()) {
+        // An RPC promise which fails, e.g. a failed bootstrap, is fulfilled with a broken
+        // capability rather than rejected.  A broken capability's own whenMoreResolved() is
+        // rejected, so keep following the chain until it settles one way or the other.
+        return watch(kj::addRef(backendRef), kj::mv(*next));
+      }
+      return kj::READY_NOW;
+    }, [this,&backendRef](kj::Exception&& exception) {
+      eject(backendRef);
+    }).attach(kj::mv(backend));
+  }
+
+  void taskFailed(kj::Exception&& exception) override {
+    KJ_LOG(ERROR, exception);
+  }
+};
+
+class RetryingCall final: public kj::Refcounted {
+  // State of a call to an idempotent method, which may be sent to several backends in turn.
+
+public:
+  RetryingCall(kj::Own<LoadBalancerHook>&& balancer, uint64_t interfaceId, uint16_t methodId,
+               AnyPointer::Reader params, RequestSettings&& settings)
+      : balancer(kj::mv(balancer)), interfaceId(interfaceId), methodId(methodId),
+        params(params.targetSize().wordCount + 1), settings(kj::mv(settings)),
+        retriesLeft(this->balancer->getMaxRetries()) {
+    this->params.getRoot<AnyPointer>().set(params);
+  }
+
+  kj::Promise<Response<AnyPointer>> attempt(kj::Own<Backend>&& backend,
+                                            kj::Own<RequestHook>&& request) {
+    auto promise = balancer->sendTo(kj::mv(backend), kj::mv(request));
+    kj::Promise<Response<AnyPointer>> response = kj::mv(promise);
+    pipeline = PipelineHook::from(kj::mv(promise));
+
+    return response.then(
+        [this](Response<AnyPointer>&& response) -> kj::Promise<Response<AnyPointer>> {
+      KJ_IF_MAYBE(f, pipelineFulfiller) {
+        f->get()->fulfill(kj::mv(pipeline));
+        pipelineFulfiller = nullptr;
+      }
+      return kj::mv(response);
+    }, [this](kj::Exception&& exception) -> kj::Promise<Response<AnyPointer>> {
+      if (exception.getType() == kj::Exception::Type::DISCONNECTED && retriesLeft > 0) {
+        KJ_IF_MAYBE(backend, balancer->pick()) {
+          auto request = backend->get()->hook->newCall(
+              interfaceId, methodId, this->params.getRoot<AnyPointer>().targetSize());
+          request.set(this->params.getRoot<AnyPointer>().asReader());
+          if (settings.applyTo(request)) {
+            --retriesLeft;
+            return attempt(kj::mv(*backend), RequestHook::from(kj::mv(request)));
+          }
+        }
+      }
+
+      KJ_IF_MAYBE(f, pipelineFulfiller) {
+        f->get()->reject(kj::cp(exception));
+        pipelineFulfiller = nullptr;
+      }
+      return kj::mv(exception);
+    });
+  }
+
+  kj::Own<PipelineHook> getPipeline() {
+    // Pipelined calls wait for whichever attempt succeeds.
+    auto paf = kj::newPromiseAndFulfiller<kj::Own<PipelineHook>>();
+    pipelineFulfiller = kj::mv(paf.fulfiller);
+    return newLocalPromisePipeline(kj::mv(paf.promise));
+  }
+
+private:
+  kj::Own<LoadBalancerHook> balancer;
+  uint64_t interfaceId;
+  uint16_t methodId;
+  MallocMessageBuilder params;
+  RequestSettings settings;
+  uint retriesLeft;
+
+  kj::Own<PipelineHook> pipeline;
+  // Pipeline of the current attempt.
+
+  kj::Maybe<kj::Own<kj::PromiseFulfiller<kj::Own<PipelineHook>>>> pipelineFulfiller;
+};
+
+class BalancedRequest final: public RequestHook {
+public:
+  BalancedRequest(kj::Own<LoadBalancerHook>&& balancer, kj::Own<Backend>&& backend,
+                  uint64_t interfaceId, uint16_t methodId,
+                  AnyPointer::Builder params, kj::Own<RequestHook>&& inner)
+      : balancer(kj::mv(balancer)), backend(kj::mv(backend)),
+        interfaceId(interfaceId), methodId(methodId), params(params), inner(kj::mv(inner)) {}
+
+  RemotePromise<AnyPointer> send() override {
+    if (!balancer->isRetryable(interfaceId, methodId)) {
+      return balancer->sendTo(kj::mv(backend), kj::mv(inner));
+    }
+
+    auto call = kj::refcounted<RetryingCall>(
+        kj::addRef(*balancer), interfaceId, methodId, params.asReader(), kj::mv(settings));
+    auto pipeline = call->getPipeline();
+    auto promise = call->attempt(kj::mv(backend), kj::mv(inner));
+    return RemotePromise<AnyPointer>(promise.attach(kj::mv(call)),
+                                     AnyPointer::Pipeline(kj::mv(pipeline)));
+  }
+
+  const void* getBrand() override {
+    return nullptr;
+  }
+
+  void setTimeout(kj::Timer& timer, kj::Duration timeout) override {
+    inner->setTimeout(timer, timeout);
+    settings.timer = timer;
+    settings.deadline = timer.now() + timeout;
+  }
+
+  void setPriority(CallPriority priority) override {
+    inner->setPriority(priority);
+    settings.priority = priority;
+  }
+
+  void setTraceParent(kj::ArrayPtr<const byte> context) override {
+    inner->setTraceParent(context);
+    settings.traceParent = kj::heapArray(context);
+  }
+
+private:
+  kj::Own<LoadBalancerHook> balancer;
+  kj::Own<Backend> backend;
+  uint64_t interfaceId;
+  uint16_t methodId;
+  AnyPointer::Builder params;
+  kj::Own<RequestHook> inner;
+  RequestSettings settings;
+};
+
+Request<AnyPointer, AnyPointer> LoadBalancerHook::newCall(
+    uint64_t interfaceId, uint16_t methodId, kj::Maybe<MessageSize> sizeHint) {
+  KJ_IF_MAYBE(backend, pick()) {
+    // Let the backend allocate the params, so that they needn't be copied unless the call may be
+    // retried.
+    auto inner = backend->get()->hook->newCall(interfaceId, methodId, sizeHint);
+    AnyPointer::Builder params = inner;
+    auto hook = kj::heap<BalancedRequest>(kj::addRef(*this), kj::mv(*backend),
+                                          interfaceId, methodId, params,
+                                          RequestHook::from(kj::mv(inner)));
+    return Request<AnyPointer, AnyPointer>(params, kj::mv(hook));
+  } else {
+    return newBrokenRequest(noBackends(), sizeHint);
+  }
+}
+
+}  // namespace
+
+Capability::Client newLoadBalancedClient(
+    kj::Array<Capability::Client> backends, LoadBalancerOptions options) {
+  return Capability::Client(kj::refcounted<LoadBalancerHook>(kj::mv(backends), kj::mv(options)));
+}
+
+}  // namespace capnp
@@ -0,0 +1,97 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef CAPNP_LOAD_BALANCER_H_
+#define CAPNP_LOAD_BALANCER_H_
+// Spreading calls over several equivalent capabilities.
+//
+// A load-balanced client stands in for a pool of capabilities which all implement the same
+// interface, typically the bootstrap interfaces of several identical backend vats.  Each call is
+// sent to one of them, chosen according to how many calls each one has in flight.  Backends which
+// turn out to be broken are dropped from the pool (and optionally replaced), and calls to methods
+// declared idempotent which fail because their backend went away are retried on another.
+//
+// Example:
+//
+//     auto backends = kj::heapArrayBuilder<capnp::Capability::Client>(2);
+//     backends.add(client1.getMain());
+//     backends.add(client2.getMain());
+//     Calculator::Client calc =
+//         capnp::newLoadBalancedClient(backends.finish()).castAs<Calculator>();
+//
+// See also `EzRpcClient`'s constructor which accepts a list of addresses.
+
+#if defined(__GNUC__) && !defined(CAPNP_HEADER_WARNINGS)
+#pragma GCC system_header
+#endif
+
+#include "capability.h"
+#include <kj/function.h>
+
+namespace capnp {
+
+struct LoadBalancerOptions {
+  enum class Strategy: uint8_t {
+    LEAST_OUTSTANDING,
+    // Send each call to the backend with the fewest calls in flight, taking turns among those tied.
+    // Scans the whole pool on each call.
+
+    POWER_OF_TWO_CHOICES
+    // Pick two backends at random and send the call to the one with fewer calls in flight.  Does
+    // nearly as well as LEAST_OUTSTANDING, at constant cost per call, so prefer it for large pools.
+  };
+
+  Strategy strategy = Strategy::LEAST_OUTSTANDING;
+
+  kj::Maybe<kj::Function<bool(uint64_t interfaceId, uint16_t methodId)>> isIdempotent;
+  // Tells whether the given method may safely be delivered more than once.  A call to such a
+  // method which fails with a DISCONNECTED exception is retried on another backend.  If null, no
+  // call is retried.
+  //
+  // Retrying requires keeping a copy of the params until the call completes, so only calls to
+  // idempotent methods pay for it.  Such calls also can't be pipelined on until they complete.
+
+  uint maxRetries = 2;
+  // How many times a single call may be retried.
+
+  kj::Maybe<kj::Function<kj::Promise<Capability::Client>(uint index)>> reconnect;
+  // Called when a backend is ejected, with its index in the array originally passed to
+  // `newLoadBalancedClient()`, to get a replacement for it, e.g. by connecting to its vat again.
+  // The replacement joins the pool once the returned promise resolves, and is itself replaced if
+  // it is ejected in turn.  If the backend's vat may stay unreachable for a while, delay resolving
+  // the promise, so as not to spin reconnecting.  If the promise is rejected, the backend stays
+  // out of the pool.  If null, ejected backends are never replaced.
+};
+
+Capability::Client newLoadBalancedClient(
+    kj::Array<Capability::Client> backends, LoadBalancerOptions options = LoadBalancerOptions());
+// Returns a client which spreads calls over `backends`, which must all implement the interfaces
+// the client will be used as.
+//
+// A backend is ejected from the pool when a call to it fails with a DISCONNECTED exception, or
+// when it is a promise which resolves to a broken or null capability.  Ejected backends are never
+// used again, though `options.reconnect` may supply replacements for them.  While every backend is
+// out of the pool, calls fail with DISCONNECTED.
+
+}  // namespace capnp
+
+#endif  // CAPNP_LOAD_BALANCER_H_
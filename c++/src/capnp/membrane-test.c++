@@ -258,6 +258,79 @@ KJ_TEST("apply membrane using copyOutOfMembrane() on AnyPointer") {
   }, "inside", "inbound", "inside", "inside");
 }
 
+KJ_TEST("wrapping the same capability twice reuses the wrapper") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+  auto policy = kj::refcounted<MembranePolicyImpl>();
+
+  Thing::Client thing = kj::heap<ThingImpl>("inside");
+  auto wrapped1 = membrane(thing, policy->addRef());
+  auto wrapped2 = membrane(thing, policy->addRef());
+  KJ_EXPECT(ClientHook::from(kj::mv(wrapped1)).get() == ClientHook::from(kj::cp(wrapped2)).get());
+
+  // A different direction gets a different wrapper.
+  auto reversed = reverseMembrane(thing, policy->addRef());
+  KJ_EXPECT(ClientHook::from(kj::mv(reversed)).get() != ClientHook::from(kj::cp(wrapped2)).get());
+
+  KJ_EXPECT(wrapped2.passThroughRequest().send().wait(waitScope).getText() == "inside");
+}
+
+class CountingMembranePolicy final: public MembranePolicy, public kj::Refcounted {
+public:
+  uint inboundCount = 0;
+  uint cacheQueryCount = 0;
+
+  kj::Maybe<Capability::Client> inboundCall(uint64_t interfaceId, uint16_t methodId,
+                                            Capability::Client target) override {
+    ++inboundCount;
+    if (interfaceId == capnp::typeId<Thing>() && methodId == 1) {
+      return Capability::Client(kj::heap<ThingImpl>("inbound"));
+    } else {
+      return nullptr;
+    }
+  }
+
+  kj::Maybe<Capability::Client> outboundCall(uint64_t interfaceId, uint16_t methodId,
+                                             Capability::Client target) override {
+    return nullptr;
+  }
+
+  bool canCacheDecision(uint64_t interfaceId, uint16_t methodId) override {
+    ++cacheQueryCount;
+    return interfaceId == capnp::typeId<Thing>();
+  }
+
+  kj::Own<MembranePolicy> addRef() override {
+    return kj::addRef(*this);
+  }
+};
+
+KJ_TEST("cacheable membrane decisions skip the policy") {
+  // Makes many calls through a membrane. Pass-through decisions declared cacheable should hit
+  // the policy only once, while redirects must be checked every time.
+
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+  auto policy = kj::refcounted<CountingMembranePolicy>();
+
+  auto thing = membrane<Thing::Client>(kj::heap<ThingImpl>("inside"), policy->addRef());
+  for (uint i = 0; i < 100; i++) {
+    KJ_EXPECT(thing.passThroughRequest().send().wait(waitScope).getText() == "inside");
+  }
+  KJ_EXPECT(policy->inboundCount == 1);
+
+  for (uint i = 0; i < 100; i++) {
+    KJ_EXPECT(thing.interceptRequest().send().wait(waitScope).getText() == "inbound");
+  }
+  KJ_EXPECT(policy->inboundCount == 101);
+  KJ_EXPECT(policy->cacheQueryCount == 2);
+
+  // The cache is per-membrane, not per-wrapper.
+  auto thing2 = membrane<Thing::Client>(kj::heap<ThingImpl>("inside2"), policy->addRef());
+  KJ_EXPECT(thing2.passThroughRequest().send().wait(waitScope).getText() == "inside2");
+  KJ_EXPECT(policy->inboundCount == 101);
+}
+
 struct TestRpcEnv {
   kj::AsyncIoContext io;
   kj::TwoWayPipe pipe;
@@ -21,11 +21,119 @@
 
 #include "membrane.h"
 #include <kj/debug.h>
+#include <unordered_map>
 
 namespace capnp {
 
+namespace _ {  // private
+
+class MembraneCaches {
+  // Per-policy state shared by every wrapper in a membrane:
+  // - A map from inner capability to the wrapper currently wrapping it, so that a capability
+  //   which crosses the membrane repeatedly is wrapped only once. Entries are weak; a wrapper
+  //   removes itself when destroyed.
+  // - The decisions that the policy has declared cacheable (see
+  //   MembranePolicy::canCacheDecision()).
+
+public:
+  static MembraneCaches& get(MembranePolicy& policy) {
+    if (policy.caches.get() == nullptr) {
+      policy.caches = kj::heap<MembraneCaches>();
+    }
+    return *policy.caches;
+  }
+
+  kj::Maybe<ClientHook&> findWrapper(ClientHook& inner, bool reverse) {
+    auto& map = wrappers[reverse];
+    auto iter = map.find(&inner);
+    if (iter == map.end()) {
+      return nullptr;
+    } else {
+      return *iter->second;
+    }
+  }
+
+  void addWrapper(ClientHook& inner, bool reverse, ClientHook& wrapper) {
+    wrappers[reverse][&inner] = &wrapper;
+  }
+
+  void removeWrapper(ClientHook& inner, bool reverse, ClientHook& wrapper) {
+    auto& map = wrappers[reverse];
+    auto iter = map.find(&inner);
+    if (iter != map.end() && iter->second == &wrapper) {
+      map.erase(iter);
+    }
+  }
+
+  kj::Maybe<Capability::Client> checkCall(MembranePolicy& policy, bool reverse,
+                                          uint64_t interfaceId, uint16_t methodId,
+                                          ClientHook& target) {
+    // Applies the policy to a call, skipping it if a pass-through decision has been cached.
+
+    auto insertResult = decisions.insert(std::make_pair(
+        DecisionKey { interfaceId, methodId, reverse }, Decision::CHECK_EVERY_CALL));
+    Decision& decision = insertResult.first->second;
+    if (insertResult.second) {
+      if (policy.canCacheDecision(interfaceId, methodId)) {
+        decision = Decision::CACHEABLE;
+      }
+    } else if (decision == Decision::PASS_THROUGH) {
+      return nullptr;
+    }
+
+    auto redirect = reverse
+        ? policy.outboundCall(interfaceId, methodId, Capability::Client(target.addRef()))
+        : policy.inboundCall(interfaceId, methodId, Capability::Client(target.addRef()));
+    if (redirect == nullptr && decision == Decision::CACHEABLE) {
+      // (References into an unordered_map stay valid even if the policy caused a rehash.)
+      decision = Decision::PASS_THROUGH;
+    }
+    return kj::mv(redirect);
+  }
+
+private:
+  std::unordered_map<ClientHook*, ClientHook*> wrappers[2];
+  // Indexed by `reverse`.
+
+  enum class Decision: uint8_t {
+    CHECK_EVERY_CALL,
+    CACHEABLE,
+    PASS_THROUGH
+  };
+
+  struct DecisionKey {
+    uint64_t interfaceId;
+    uint16_t methodId;
+    bool reverse;
+
+    inline bool operator==(const DecisionKey& other) const {
+      return interfaceId == other.interfaceId && methodId == other.methodId &&
+             reverse == other.reverse;
+    }
+  };
+
+  struct DecisionKeyHash {
+    inline size_t operator()(const DecisionKey& key) const {
+      return std::hash<uint64_t>()(key.interfaceId) * 65537 + key.methodId * 2 + key.reverse;
+    }
+  };
+
+  std::unordered_map<DecisionKey, Decision, DecisionKeyHash> decisions;
+};
+
+}  // namespace _ (private)
+
+bool MembranePolicy::canCacheDecision(uint64_t interfaceId, uint16_t methodId) {
+  return false;
+}
+
+MembranePolicy::MembranePolicy() {}
+MembranePolicy::~MembranePolicy() noexcept(false) {}
+
 namespace {
 
+using _::MembraneCaches;
+
 static const char DUMMY = 0;
 static constexpr const void* MEMBRANE_BRAND = &DUMMY;
 
@@ -211,6 +319,18 @@ public:
     return RemotePromise<AnyPointer>(kj::mv(newPromise), kj::mv(newPipeline));
   }
 
+  void setTimeout(kj::Timer& timer, kj::Duration timeout) override {
+    inner->setTimeout(timer, timeout);
+  }
+
+  void setPriority(CallPriority priority) override {
+    inner->setPriority(priority);
+  }
+
+  void setTraceParent(kj::ArrayPtr<const byte> context) override {
+    inner->setTraceParent(context);
+  }
+
   const void* getBrand() override {
     return MEMBRANE_BRAND;
   }
@@ -222,6 +342,39 @@ private:
   MembraneCapTableBuilder capTable;
 };
 
+class MembraneRawCallParams final: public RawCallParams, public kj::Refcounted {
+  // Raw params detached from a call passing through the membrane. The content is untouched, but
+  // every capability in the table is wrapped, just as MembraneCapTableReader would.
+
+public:
+  MembraneRawCallParams(kj::Own<RawCallParams>&& inner, MembranePolicy& policy, bool reverse)
+      : inner(kj::mv(inner)),
+        capTable(KJ_MAP(cap, this->inner->getCapTable()) -> kj::Maybe<kj::Own<ClientHook>> {
+          return cap.map([&](kj::Own<ClientHook>& c) {
+            return membrane(c->addRef(), policy, reverse);
+          });
+        }),
+        content(capTable.imbue(this->inner->getContent())) {}
+
+  AnyPointer::Reader getContent() override {
+    return content;
+  }
+  kj::ArrayPtr<kj::Maybe<kj::Own<ClientHook>>> getCapTable() override {
+    return capTable.getTable();
+  }
+  kj::ArrayPtr<const kj::ArrayPtr<const word>> getSegments() override {
+    return inner->getSegments();
+  }
+  kj::Own<RawCallParams> addRef() override {
+    return kj::addRef(*this);
+  }
+
+private:
+  kj::Own<RawCallParams> inner;
+  ReaderCapabilityTable capTable;
+  AnyPointer::Reader content;
+};
+
 class MembraneCallContextHook final: public CallContextHook, public kj::Refcounted {
 public:
   MembraneCallContextHook(kj::Own<CallContextHook>&& inner,
@@ -286,6 +439,29 @@ public:
     return kj::addRef(*this);
   }
 
+  kj::Maybe<kj::TimePoint> getDeadline() override {
+    return inner->getDeadline();
+  }
+
+  kj::ArrayPtr<const byte> getTraceContext() override {
+    return inner->getTraceContext();
+  }
+
+  bool isPastDeadline() override {
+    return inner->isPastDeadline();
+  }
+
+  kj::Maybe<kj::Own<RawCallParams>> detachRawParams() override {
+    KJ_REQUIRE(!releasedParams);
+    KJ_IF_MAYBE(raw, inner->detachRawParams()) {
+      releasedParams = true;
+      return kj::Own<RawCallParams>(
+          kj::refcounted<MembraneRawCallParams>(kj::mv(*raw), *policy, reverse));
+    } else {
+      return nullptr;
+    }
+  }
+
 private:
   kj::Own<CallContextHook> inner;
   kj::Own<MembranePolicy> policy;
@@ -302,7 +478,13 @@ private:
 class MembraneHook final: public ClientHook, public kj::Refcounted {
 public:
   MembraneHook(kj::Own<ClientHook>&& inner, kj::Own<MembranePolicy>&& policy, bool reverse)
-      : inner(kj::mv(inner)), policy(kj::mv(policy)), reverse(reverse) {}
+      : inner(kj::mv(inner)), policy(kj::mv(policy)), reverse(reverse),
+        caches(MembraneCaches::get(*this->policy)) {
+    caches.addWrapper(*this->inner, reverse, *this);
+  }
+  ~MembraneHook() noexcept(false) {
+    caches.removeWrapper(*inner, reverse, *this);
+  }
 
   static kj::Own<ClientHook> wrap(ClientHook& cap, MembranePolicy& policy, bool reverse) {
     if (cap.getBrand() == MEMBRANE_BRAND) {
@@ -314,6 +496,10 @@ public:
       }
     }
 
+    KJ_IF_MAYBE(existing, MembraneCaches::get(policy).findWrapper(cap, reverse)) {
+      return existing->addRef();
+    }
+
     return kj::refcounted<MembraneHook>(cap.addRef(), policy.addRef(), reverse);
   }
 
@@ -327,6 +513,10 @@ public:
       }
     }
 
+    KJ_IF_MAYBE(existing, MembraneCaches::get(policy).findWrapper(*cap, reverse)) {
+      return existing->addRef();
+    }
+
     return kj::refcounted<MembraneHook>(kj::mv(cap), policy.addRef(), reverse);
   }
 
@@ -336,9 +526,7 @@ public:
       return r->get()->newCall(interfaceId, methodId, sizeHint);
     }
 
-    auto redirect = reverse
-        ? policy->outboundCall(interfaceId, methodId, Capability::Client(inner->addRef()))
-        : policy->inboundCall(interfaceId, methodId, Capability::Client(inner->addRef()));
+    auto redirect = caches.checkCall(*policy, reverse, interfaceId, methodId, *inner);
     KJ_IF_MAYBE(r, redirect) {
       // The policy says that *if* this capability points into the membrane, then we want to
       // redirect the call. However, if this capability is a promise, then it could resolve to
@@ -363,9 +551,7 @@ public:
       return r->get()->call(interfaceId, methodId, kj::mv(context));
     }
 
-    auto redirect = reverse
-        ? policy->outboundCall(interfaceId, methodId, Capability::Client(inner->addRef()))
-        : policy->inboundCall(interfaceId, methodId, Capability::Client(inner->addRef()));
+    auto redirect = caches.checkCall(*policy, reverse, interfaceId, methodId, *inner);
     KJ_IF_MAYBE(r, redirect) {
       // The policy says that *if* this capability points into the membrane, then we want to
       // redirect the call. However, if this capability is a promise, then it could resolve to
@@ -433,6 +619,7 @@ private:
   kj::Own<ClientHook> inner;
   kj::Own<MembranePolicy> policy;
   bool reverse;
+  MembraneCaches& caches;
   kj::Maybe<kj::Own<ClientHook>> resolved;
 };
 
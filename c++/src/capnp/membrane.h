@@ -52,6 +52,8 @@
 
 namespace capnp {
 
+namespace _ { class MembraneCaches; }  // private
+
 class MembranePolicy {
   // Applications may implement this interface to define a membrane policy, which allows some
   // calls crossing the membrane to be blocked or redirected.
@@ -94,6 +96,18 @@ public:
   //   will enter and then exit the membrane, but calls on the eventual resolution will not cross
   //   the membrane at all, so it is important that these two cases behave the same.
 
+  virtual bool canCacheDecision(uint64_t interfaceId, uint16_t methodId);
+  // Returns true if the policy promises that, for this method, `inboundCall()` and
+  // `outboundCall()` always make the same decision regardless of the target capability or the
+  // time of the call. When this is the case, the first time either one lets a call to the method
+  // pass through (returns null), the membrane remembers that and stops consulting the policy for
+  // that method in that direction, saving a virtual call and a reference to the target on every
+  // subsequent call. Redirects and exceptions are never cached.
+  //
+  // This is consulted at most once per method and direction. The default implementation returns
+  // false, so every call is checked. A policy whose decisions can change over time (e.g. a
+  // revocable membrane) must not return true for any method it may later want to block.
+
   virtual kj::Own<MembranePolicy> addRef() = 0;
   // Return a new owned pointer to the same policy.
   //
@@ -104,11 +118,23 @@ public:
   // object actually to be the *same* membrane. This is relevant when an object passes into the
   // membrane and then back out (or out and then back in): instead of double-wrapping the object,
   // the wrapping will be removed.
+
+  MembranePolicy();
+  virtual ~MembranePolicy() noexcept(false);
+
+private:
+  kj::Own<_::MembraneCaches> caches;
+  // Wrappers and cached decisions belonging to this membrane. Allocated on first use.
+
+  friend class _::MembraneCaches;
 };
 
 Capability::Client membrane(Capability::Client inner, kj::Own<MembranePolicy> policy);
 // Wrap `inner` in a membrane specified by `policy`. `inner` is considered "inside" the membrane,
 // while the returned capability should only be called from outside the membrane.
+//
+// While a wrapper for `inner` in this membrane is still alive, wrapping `inner` again returns the
+// same wrapper rather than allocating a new one.
 
 Capability::Client reverseMembrane(Capability::Client outer, kj::Own<MembranePolicy> policy);
 // Like `membrane` but treat the input capability as "outside" the membrane, and return a
@@ -0,0 +1,180 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "rpc-metrics.h"
+#include "rpc-twoparty.h"
+#include "test-util.h"
+#include <kj/debug.h>
+#include <kj/test.h>
+
+namespace capnp {
+namespace _ {  // private
+namespace {
+
+KJ_TEST("LatencyHistogram percentiles") {
+  LatencyHistogram histogram;
+  KJ_EXPECT(histogram.getPercentile(0.5) == 0 * kj::NANOSECONDS);
+
+  for (int i = 1; i <= 1000; i++) {
+    histogram.record(i * kj::MICROSECONDS);
+  }
+  KJ_EXPECT(histogram.getCount() == 1000);
+
+  auto near = [](kj::Duration actual, kj::Duration expected) {
+    return actual >= expected && actual <= expected + expected / 8;
+  };
+  KJ_EXPECT(near(histogram.getPercentile(0.5), 500 * kj::MICROSECONDS));
+  KJ_EXPECT(near(histogram.getPercentile(0.99), 990 * kj::MICROSECONDS));
+  KJ_EXPECT(histogram.getPercentile(1) == 1000 * kj::MICROSECONDS);
+  KJ_EXPECT(near(histogram.getPercentile(0), 1 * kj::MICROSECONDS));
+
+  // Small values are exact, and huge or negative ones don't break anything.
+  kj::Duration huge = int64_t(kj::maxValue) * kj::NANOSECONDS;
+  LatencyHistogram small;
+  small.record(3 * kj::NANOSECONDS);
+  small.record(-5 * kj::NANOSECONDS);
+  small.record(huge);
+  KJ_EXPECT(small.getPercentile(0.3) == 0 * kj::NANOSECONDS);
+  KJ_EXPECT(small.getPercentile(0.6) == 3 * kj::NANOSECONDS);
+  KJ_EXPECT(small.getPercentile(1) == huge);
+
+  MallocMessageBuilder message;
+  auto builder = message.initRoot<rpc::metrics::Histogram>();
+  small.writeTo(builder);
+  KJ_EXPECT(builder.getCount() == 3);
+  KJ_EXPECT(builder.getMinNanos() == 0);
+  KJ_EXPECT(builder.getBuckets().size() == 3);
+  KJ_EXPECT(builder.getBuckets()[1].getLowerBoundNanos() == 3);
+}
+
+class TestMetricsImpl final: public test::TestInterface::Server {
+  // foo() takes 5ms according to `timer`; bar() throws.
+
+public:
+  TestMetricsImpl(kj::TimerImpl& timer): timer(timer) {}
+
+protected:
+  kj::Promise<void> foo(FooContext context) override {
+    timer.advanceTo(timer.now() + 5 * kj::MILLISECONDS);
+    context.getResults().setX("foo");
+    return kj::READY_NOW;
+  }
+
+private:
+  kj::TimerImpl& timer;
+};
+
+KJ_TEST("RpcMetrics records calls, tables, and traffic") {
+  auto ioContext = kj::setupAsyncIo();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+  RpcMetrics clientMetrics(timer);
+  RpcMetrics serverMetrics(timer);
+
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[0], rpc::twoparty::Side::SERVER);
+  serverNetwork.setMetrics(serverMetrics);
+  auto rpcServer = makeRpcServer(serverNetwork, kj::heap<TestMetricsImpl>(timer));
+  rpcServer.setMetrics(serverMetrics);
+
+  TwoPartyVatNetwork clientNetwork(*pipe.ends[1], rpc::twoparty::Side::CLIENT);
+  clientNetwork.setMetrics(clientMetrics);
+  auto rpcClient = makeRpcClient(clientNetwork);
+  rpcClient.setMetrics(clientMetrics);
+
+  MallocMessageBuilder vatIdMessage(8);
+  auto vatId = vatIdMessage.initRoot<rpc::twoparty::VatId>();
+  vatId.setSide(rpc::twoparty::Side::SERVER);
+  auto cap = rpcClient.bootstrap(vatId).castAs<test::TestInterface>();
+
+  for (int i = 0; i < 3; i++) {
+    cap.fooRequest().send().wait(ioContext.waitScope);
+  }
+  KJ_EXPECT(cap.barRequest().send().then([](auto&&) { return false; },
+                                         [](kj::Exception&&) { return true; })
+                .wait(ioContext.waitScope));
+
+  // Let the last Finish messages arrive.
+  ioContext.provider->getTimer().afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+
+  auto clientResponse = clientMetrics.newMonitor().getSnapshotRequest().send()
+      .wait(ioContext.waitScope);
+  auto serverResponse = serverMetrics.newMonitor().getSnapshotRequest().send()
+      .wait(ioContext.waitScope);
+  auto clientSnapshot = clientResponse.getSnapshot();
+  auto serverSnapshot = serverResponse.getSnapshot();
+
+  // foo is method 0 and bar is method 1.
+  auto clientMethods = clientSnapshot.getMethods();
+  KJ_ASSERT(clientMethods.size() == 2);
+  KJ_EXPECT(clientMethods[0].getInterfaceId() == typeId<test::TestInterface>());
+  KJ_EXPECT(clientMethods[0].getMethodId() == 0);
+  KJ_EXPECT(clientMethods[0].getCallsSent() == 3);
+  KJ_EXPECT(clientMethods[0].getCallsReceived() == 0);
+  KJ_EXPECT(clientMethods[0].getErrorsReceived() == 0);
+  KJ_EXPECT(clientMethods[0].getCallLatency().getCount() == 3);
+  KJ_EXPECT(clientMethods[0].getCallLatency().getP50Nanos() == 5000000);
+  KJ_EXPECT(clientMethods[1].getMethodId() == 1);
+  KJ_EXPECT(clientMethods[1].getCallsSent() == 1);
+  KJ_EXPECT(clientMethods[1].getErrorsReceived() == 1);
+
+  auto serverMethods = serverSnapshot.getMethods();
+  KJ_ASSERT(serverMethods.size() == 2);
+  KJ_EXPECT(serverMethods[0].getCallsReceived() == 3);
+  KJ_EXPECT(serverMethods[0].getServiceLatency().getCount() == 3);
+  KJ_EXPECT(serverMethods[0].getServiceLatency().getMaxNanos() == 5000000);
+  KJ_EXPECT(serverMethods[1].getCallsReceived() == 1);
+  KJ_EXPECT(serverMethods[1].getErrorsReturned() == 1);
+
+  KJ_ASSERT(clientSnapshot.getConnections().size() == 1);
+  KJ_ASSERT(serverSnapshot.getConnections().size() == 1);
+  KJ_EXPECT(clientSnapshot.getConnections()[0].getImports() == 1);
+  KJ_EXPECT(serverSnapshot.getConnections()[0].getExports() == 1);
+
+  // Bootstrap, four calls, and their Finishes went one way; returns came back the other.
+  KJ_EXPECT(clientSnapshot.getMessagesSent() >= 5);
+  KJ_EXPECT(clientSnapshot.getMessagesSent() == serverSnapshot.getMessagesReceived());
+  KJ_EXPECT(clientSnapshot.getBytesSent() == serverSnapshot.getBytesReceived());
+  KJ_EXPECT(serverSnapshot.getMessagesSent() == clientSnapshot.getMessagesReceived());
+  KJ_EXPECT(serverSnapshot.getBytesSent() == clientSnapshot.getBytesReceived());
+  KJ_EXPECT(clientSnapshot.getBytesSent() > 0);
+}
+
+KJ_TEST("RpcMonitor outliving its RpcMetrics") {
+  kj::EventLoop loop;
+  kj::WaitScope waitScope(loop);
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+
+  auto metrics = kj::heap<RpcMetrics>(timer);
+  auto monitor = metrics->newMonitor();
+  monitor.getSnapshotRequest().send().wait(waitScope);
+
+  metrics = nullptr;
+  auto result = monitor.getSnapshotRequest().send().then(
+      [](auto&&) -> kj::Maybe<kj::Exception> { return nullptr; },
+      [](kj::Exception&& e) -> kj::Maybe<kj::Exception> { return kj::mv(e); })
+      .wait(waitScope);
+  KJ_ASSERT(result != nullptr);
+  KJ_EXPECT(KJ_ASSERT_NONNULL(result).getType() == kj::Exception::Type::DISCONNECTED);
+}
+
+}  // namespace
+}  // namespace _ (private)
+}  // namespace capnp
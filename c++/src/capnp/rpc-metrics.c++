@@ -0,0 +1,217 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "rpc-metrics.h"
+#include <kj/debug.h>
+#include <string.h>
+
+namespace capnp {
+
+namespace {
+
+uint highestBit(uint64_t value) {
+  // Returns the index of the highest set bit of `value`, which must be nonzero.
+  uint result = 0;
+  for (uint shift: {32, 16, 8, 4, 2, 1}) {
+    if (value >> shift) {
+      value >>= shift;
+      result += shift;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() {
+  memset(buckets, 0, sizeof(buckets));
+}
+
+uint LatencyHistogram::bucketFor(uint64_t nanos) {
+  // Values below 2 * SUB_BUCKETS get a bucket each.  Above that, a value whose highest bit is `e`
+  // is shifted right until only SUB_BUCKET_BITS bits remain below the highest, and those bits pick
+  // one of SUB_BUCKETS buckets for that power of two.
+  if (nanos < 2 * SUB_BUCKETS) return nanos;
+  uint shift = highestBit(nanos) - SUB_BUCKET_BITS;
+  return shift * SUB_BUCKETS + (nanos >> shift);
+}
+
+uint64_t LatencyHistogram::lowerBound(uint bucket) {
+  if (bucket < 2 * SUB_BUCKETS) return bucket;
+  uint shift = bucket / SUB_BUCKETS - 1;
+  return uint64_t(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+}
+
+void LatencyHistogram::record(kj::Duration duration) {
+  int64_t signedNanos = duration / kj::NANOSECONDS;
+  uint64_t nanos = signedNanos < 0 ? 0 : signedNanos;
+
+  ++count;
+  sum += nanos;
+  min = kj::min(min, nanos);
+  max = kj::max(max, nanos);
+  ++buckets[bucketFor(nanos)];
+}
+
+uint64_t LatencyHistogram::percentileNanos(double fraction) const {
+  if (count == 0) return 0;
+
+  uint64_t rank = kj::max(uint64_t(1), uint64_t(fraction * count + 0.5));
+  uint64_t seen = 0;
+  for (uint i = 0; i < BUCKET_COUNT; i++) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      // Report the top of the bucket, but never past the largest sample.
+      uint64_t top = i + 1 < BUCKET_COUNT ? lowerBound(i + 1) - 1 : kj::maxValue;
+      return kj::max(min, kj::min(max, top));
+    }
+  }
+  return max;
+}
+
+kj::Duration LatencyHistogram::getPercentile(double fraction) const {
+  return int64_t(percentileNanos(fraction)) * kj::NANOSECONDS;
+}
+
+void LatencyHistogram::writeTo(rpc::metrics::Histogram::Builder builder) const {
+  builder.setCount(count);
+  if (count == 0) return;
+
+  builder.setMinNanos(min);
+  builder.setMaxNanos(max);
+  builder.setMeanNanos(sum / count);
+  builder.setP50Nanos(percentileNanos(0.5));
+  builder.setP90Nanos(percentileNanos(0.9));
+  builder.setP99Nanos(percentileNanos(0.99));
+  builder.setP999Nanos(percentileNanos(0.999));
+
+  uint nonEmpty = 0;
+  for (auto n: buckets) {
+    if (n > 0) ++nonEmpty;
+  }
+  auto list = builder.initBuckets(nonEmpty);
+  uint pos = 0;
+  for (uint i = 0; i < BUCKET_COUNT; i++) {
+    if (buckets[i] > 0) {
+      list[pos].setLowerBoundNanos(lowerBound(i));
+      list[pos].setCount(buckets[i]);
+      ++pos;
+    }
+  }
+}
+
+// =======================================================================================
+
+class RpcMetrics::MonitorLink final: public kj::Refcounted {
+  // Lets monitors outlive the RpcMetrics they serve:  the destructor clears `metrics`.
+
+public:
+  explicit MonitorLink(RpcMetrics& metrics): metrics(metrics) {}
+
+  kj::Maybe<RpcMetrics&> metrics;
+};
+
+RpcMetrics::RpcMetrics(kj::Timer& timer)
+    : timer(timer), monitorLink(kj::refcounted<MonitorLink>(*this)) {}
+
+RpcMetrics::~RpcMetrics() noexcept(false) {
+  monitorLink->metrics = nullptr;
+
+  KJ_REQUIRE(tableSources.empty(), "RpcMetrics destroyed while RpcSystems still report to it") {
+    break;
+  }
+}
+
+RpcMetrics::MethodStats& RpcMetrics::getMethodStats(uint64_t interfaceId, uint16_t methodId) {
+  return methods[std::make_pair(interfaceId, methodId)];
+}
+
+void RpcMetrics::addTableSource(TableSource& source) {
+  tableSources.add(&source);
+}
+
+void RpcMetrics::removeTableSource(TableSource& source) {
+  for (auto i: kj::indices(tableSources)) {
+    if (tableSources[i] == &source) {
+      tableSources[i] = tableSources.back();
+      tableSources.removeLast();
+      return;
+    }
+  }
+}
+
+void RpcMetrics::getSnapshot(rpc::metrics::Snapshot::Builder builder) {
+  kj::Vector<TableSizes> tables;
+  for (auto source: tableSources) {
+    source->getTableSizes(tables);
+  }
+  auto connections = builder.initConnections(tables.size());
+  for (auto i: kj::indices(tables)) {
+    connections[i].setQuestions(tables[i].questions);
+    connections[i].setAnswers(tables[i].answers);
+    connections[i].setExports(tables[i].exports);
+    connections[i].setImports(tables[i].imports);
+  }
+
+  auto list = builder.initMethods(methods.size());
+  uint pos = 0;
+  for (auto& entry: methods) {
+    auto method = list[pos++];
+    auto& stats = entry.second;
+    method.setInterfaceId(entry.first.first);
+    method.setMethodId(entry.first.second);
+    method.setCallsSent(stats.callsSent);
+    method.setErrorsReceived(stats.errorsReceived);
+    method.setCallsReceived(stats.callsReceived);
+    method.setErrorsReturned(stats.errorsReturned);
+    stats.callLatency.writeTo(method.initCallLatency());
+    stats.serviceLatency.writeTo(method.initServiceLatency());
+  }
+
+  builder.setMessagesSent(traffic.messagesSent);
+  builder.setMessagesReceived(traffic.messagesReceived);
+  builder.setBytesSent(traffic.bytesSent);
+  builder.setBytesReceived(traffic.bytesReceived);
+}
+
+class RpcMetrics::MonitorImpl final: public rpc::metrics::RpcMonitor::Server {
+public:
+  MonitorImpl(kj::Own<MonitorLink>&& link): link(kj::mv(link)) {}
+
+protected:
+  kj::Promise<void> getSnapshot(GetSnapshotContext context) override {
+    KJ_IF_MAYBE(metrics, link->metrics) {
+      metrics->getSnapshot(context.getResults().initSnapshot());
+      return kj::READY_NOW;
+    } else {
+      return KJ_EXCEPTION(DISCONNECTED, "RpcMetrics has been destroyed");
+    }
+  }
+
+private:
+  kj::Own<MonitorLink> link;
+};
+
+rpc::metrics::RpcMonitor::Client RpcMetrics::newMonitor() {
+  return kj::heap<MonitorImpl>(kj::addRef(*monitorLink));
+}
+
+}  // namespace capnp
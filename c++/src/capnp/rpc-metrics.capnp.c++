@@ -0,0 +1,876 @@
+// Generated by Cap'n Proto compiler, DO NOT EDIT
+// source: rpc-metrics.capnp
+
+#include "rpc-metrics.capnp.h"
+
+namespace capnp {
+namespace schemas {
+static const ::capnp::_::AlignedData<31> b_f3bffc456c62b58b = {
+  {   0,   0,   0,   0,   5,   0,   6,   0,
+    139, 181,  98, 108,  69, 252, 191, 243,
+     24,   0,   0,   0,   3,   0,   0,   0,
+      8, 198, 146, 225, 113, 246, 251, 154,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     21,   0,   0,   0,  26,   1,   0,   0,
+     37,   0,   0,   0,   7,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     33,   0,   0,   0,  71,   0,   0,   0,
+     77,   0,   0,   0,   7,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 112, 110, 112,  47, 114, 112,
+     99,  45, 109, 101, 116, 114, 105,  99,
+    115,  46,  99,  97, 112, 110, 112,  58,
+     82, 112,  99,  77, 111, 110, 105, 116,
+    111, 114,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   1,   0,   1,   0,
+      4,   0,   0,   0,   3,   0,   5,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     90,  39, 215, 218,  25, 172, 229, 238,
+    250, 121,  44, 227, 202,   8, 230, 133,
+     17,   0,   0,   0,  98,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   7,   0,   0,   0,
+    103, 101, 116,  83, 110,  97, 112, 115,
+    104, 111, 116,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   1,   0,
+      0,   0,   0,   0,   1,   0,   1,   0, }
+};
+::capnp::word const* const bp_f3bffc456c62b58b = b_f3bffc456c62b58b.words;
+#if !CAPNP_LITE
+static const ::capnp::_::RawSchema* const d_f3bffc456c62b58b[] = {
+  &s_85e608cae32c79fa,
+  &s_eee5ac19dad7275a,
+};
+static const uint16_t m_f3bffc456c62b58b[] = {0};
+const ::capnp::_::RawSchema s_f3bffc456c62b58b = {
+  0xf3bffc456c62b58b, b_f3bffc456c62b58b.words, 31, d_f3bffc456c62b58b, m_f3bffc456c62b58b,
+  2, 1, nullptr, nullptr, nullptr, { &s_f3bffc456c62b58b, nullptr, nullptr, 0, 0, nullptr }
+};
+#endif  // !CAPNP_LITE
+static const ::capnp::_::AlignedData<19> b_eee5ac19dad7275a = {
+  {   0,   0,   0,   0,   5,   0,   6,   0,
+     90,  39, 215, 218,  25, 172, 229, 238,
+     35,   0,   0,   0,   1,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   7,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     21,   0,   0,   0, 178,   1,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 112, 110, 112,  47, 114, 112,
+     99,  45, 109, 101, 116, 114, 105,  99,
+    115,  46,  99,  97, 112, 110, 112,  58,
+     82, 112,  99,  77, 111, 110, 105, 116,
+    111, 114,  46, 103, 101, 116,  83, 110,
+     97, 112, 115, 104, 111, 116,  36,  80,
+     97, 114,  97, 109, 115,   0,   0,   0, }
+};
+::capnp::word const* const bp_eee5ac19dad7275a = b_eee5ac19dad7275a.words;
+#if !CAPNP_LITE
+const ::capnp::_::RawSchema s_eee5ac19dad7275a = {
+  0xeee5ac19dad7275a, b_eee5ac19dad7275a.words, 19, nullptr, nullptr,
+  0, 0, nullptr, nullptr, nullptr, { &s_eee5ac19dad7275a, nullptr, nullptr, 0, 0, nullptr }
+};
+#endif  // !CAPNP_LITE
+static const ::capnp::_::AlignedData<36> b_85e608cae32c79fa = {
+  {   0,   0,   0,   0,   5,   0,   6,   0,
+    250, 121,  44, 227, 202,   8, 230, 133,
+     35,   0,   0,   0,   1,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      1,   0,   7,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     21,   0,   0,   0, 186,   1,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     37,   0,   0,   0,  63,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 112, 110, 112,  47, 114, 112,
+     99,  45, 109, 101, 116, 114, 105,  99,
+    115,  46,  99,  97, 112, 110, 112,  58,
+     82, 112,  99,  77, 111, 110, 105, 116,
+    111, 114,  46, 103, 101, 116,  83, 110,
+     97, 112, 115, 104, 111, 116,  36,  82,
+    101, 115, 117, 108, 116, 115,   0,   0,
+      4,   0,   0,   0,   3,   0,   4,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   1,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     13,   0,   0,   0,  74,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     12,   0,   0,   0,   3,   0,   1,   0,
+     24,   0,   0,   0,   2,   0,   1,   0,
+    115, 110,  97, 112, 115, 104, 111, 116,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     16,   0,   0,   0,   0,   0,   0,   0,
+     69, 149, 229,  36,  50, 242,  43, 195,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     16,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, }
+};
+::capnp::word const* const bp_85e608cae32c79fa = b_85e608cae32c79fa.words;
+#if !CAPNP_LITE
+static const ::capnp::_::RawSchema* const d_85e608cae32c79fa[] = {
+  &s_c32bf23224e59545,
+};
+static const uint16_t m_85e608cae32c79fa[] = {0};
+static const uint16_t i_85e608cae32c79fa[] = {0};
+const ::capnp::_::RawSchema s_85e608cae32c79fa = {
+  0x85e608cae32c79fa, b_85e608cae32c79fa.words, 36, d_85e608cae32c79fa, m_85e608cae32c79fa,
+  1, 1, i_85e608cae32c79fa, nullptr, nullptr, { &s_85e608cae32c79fa, nullptr, nullptr, 0, 0, nullptr }
+};
+#endif  // !CAPNP_LITE
+static const ::capnp::_::AlignedData<123> b_c32bf23224e59545 = {
+  {   0,   0,   0,   0,   5,   0,   6,   0,
+     69, 149, 229,  36,  50, 242,  43, 195,
+     24,   0,   0,   0,   1,   0,   4,   0,
+      8, 198, 146, 225, 113, 246, 251, 154,
+      2,   0,   7,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     21,   0,   0,   0,  10,   1,   0,   0,
+     37,   0,   0,   0,   7,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     33,   0,   0,   0,  87,   1,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 112, 110, 112,  47, 114, 112,
+     99,  45, 109, 101, 116, 114, 105,  99,
+    115,  46,  99,  97, 112, 110, 112,  58,
+     83, 110,  97, 112, 115, 104, 111, 116,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   1,   0,   1,   0,
+     24,   0,   0,   0,   3,   0,   4,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   1,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    153,   0,   0,   0,  98,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    152,   0,   0,   0,   3,   0,   1,   0,
+    180,   0,   0,   0,   2,   0,   1,   0,
+      1,   0,   0,   0,   1,   0,   0,   0,
+      0,   0,   1,   0,   1,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    177,   0,   0,   0,  66,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    172,   0,   0,   0,   3,   0,   1,   0,
+    200,   0,   0,   0,   2,   0,   1,   0,
+      2,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   1,   0,   2,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    197,   0,   0,   0, 106,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    196,   0,   0,   0,   3,   0,   1,   0,
+    208,   0,   0,   0,   2,   0,   1,   0,
+      3,   0,   0,   0,   1,   0,   0,   0,
+      0,   0,   1,   0,   3,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    205,   0,   0,   0, 138,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    208,   0,   0,   0,   3,   0,   1,   0,
+    220,   0,   0,   0,   2,   0,   1,   0,
+      4,   0,   0,   0,   2,   0,   0,   0,
+      0,   0,   1,   0,   4,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    217,   0,   0,   0,  82,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    216,   0,   0,   0,   3,   0,   1,   0,
+    228,   0,   0,   0,   2,   0,   1,   0,
+      5,   0,   0,   0,   3,   0,   0,   0,
+      0,   0,   1,   0,   5,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    225,   0,   0,   0, 114,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    224,   0,   0,   0,   3,   0,   1,   0,
+    236,   0,   0,   0,   2,   0,   1,   0,
+     99, 111, 110, 110, 101,  99, 116, 105,
+    111, 110, 115,   0,   0,   0,   0,   0,
+     14,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   3,   0,   1,   0,
+     16,   0,   0,   0,   0,   0,   0,   0,
+    253,  55,  75,  30, 163, 113, 207, 246,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     14,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    109, 101, 116, 104, 111, 100, 115,   0,
+     14,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   3,   0,   1,   0,
+     16,   0,   0,   0,   0,   0,   0,   0,
+    249,  23, 120, 134,  79, 148, 240, 231,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     14,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    109, 101, 115, 115,  97, 103, 101, 115,
+     83, 101, 110, 116,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    109, 101, 115, 115,  97, 103, 101, 115,
+     82, 101,  99, 101, 105, 118, 101, 100,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     98, 121, 116, 101, 115,  83, 101, 110,
+    116,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     98, 121, 116, 101, 115,  82, 101,  99,
+    101, 105, 118, 101, 100,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, }
+};
+::capnp::word const* const bp_c32bf23224e59545 = b_c32bf23224e59545.words;
+#if !CAPNP_LITE
+static const ::capnp::_::RawSchema* const d_c32bf23224e59545[] = {
+  &s_e7f0944f867817f9,
+  &s_f6cf71a31e4b37fd,
+};
+static const uint16_t m_c32bf23224e59545[] = {5, 4, 0, 3, 2, 1};
+static const uint16_t i_c32bf23224e59545[] = {0, 1, 2, 3, 4, 5};
+const ::capnp::_::RawSchema s_c32bf23224e59545 = {
+  0xc32bf23224e59545, b_c32bf23224e59545.words, 123, d_c32bf23224e59545, m_c32bf23224e59545,
+  2, 6, i_c32bf23224e59545, nullptr, nullptr, { &s_c32bf23224e59545, nullptr, nullptr, 0, 0, nullptr }
+};
+#endif  // !CAPNP_LITE
+static const ::capnp::_::AlignedData<80> b_f6cf71a31e4b37fd = {
+  {   0,   0,   0,   0,   5,   0,   6,   0,
+    253,  55,  75,  30, 163, 113, 207, 246,
+     24,   0,   0,   0,   1,   0,   2,   0,
+      8, 198, 146, 225, 113, 246, 251, 154,
+      0,   0,   7,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     21,   0,   0,   0,  26,   1,   0,   0,
+     37,   0,   0,   0,   7,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     33,   0,   0,   0, 231,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 112, 110, 112,  47, 114, 112,
+     99,  45, 109, 101, 116, 114, 105,  99,
+    115,  46,  99,  97, 112, 110, 112,  58,
+     67, 111, 110, 110, 101,  99, 116, 105,
+    111, 110,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   1,   0,   1,   0,
+     16,   0,   0,   0,   3,   0,   4,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   1,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     97,   0,   0,   0,  82,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     96,   0,   0,   0,   3,   0,   1,   0,
+    108,   0,   0,   0,   2,   0,   1,   0,
+      1,   0,   0,   0,   1,   0,   0,   0,
+      0,   0,   1,   0,   1,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    105,   0,   0,   0,  66,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    100,   0,   0,   0,   3,   0,   1,   0,
+    112,   0,   0,   0,   2,   0,   1,   0,
+      2,   0,   0,   0,   2,   0,   0,   0,
+      0,   0,   1,   0,   2,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    109,   0,   0,   0,  66,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    104,   0,   0,   0,   3,   0,   1,   0,
+    116,   0,   0,   0,   2,   0,   1,   0,
+      3,   0,   0,   0,   3,   0,   0,   0,
+      0,   0,   1,   0,   3,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    113,   0,   0,   0,  66,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    108,   0,   0,   0,   3,   0,   1,   0,
+    120,   0,   0,   0,   2,   0,   1,   0,
+    113, 117, 101, 115, 116, 105, 111, 110,
+    115,   0,   0,   0,   0,   0,   0,   0,
+      8,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      8,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     97, 110, 115, 119, 101, 114, 115,   0,
+      8,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      8,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    101, 120, 112, 111, 114, 116, 115,   0,
+      8,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      8,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    105, 109, 112, 111, 114, 116, 115,   0,
+      8,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      8,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, }
+};
+::capnp::word const* const bp_f6cf71a31e4b37fd = b_f6cf71a31e4b37fd.words;
+#if !CAPNP_LITE
+static const uint16_t m_f6cf71a31e4b37fd[] = {1, 2, 3, 0};
+static const uint16_t i_f6cf71a31e4b37fd[] = {0, 1, 2, 3};
+const ::capnp::_::RawSchema s_f6cf71a31e4b37fd = {
+  0xf6cf71a31e4b37fd, b_f6cf71a31e4b37fd.words, 80, nullptr, m_f6cf71a31e4b37fd,
+  0, 4, i_f6cf71a31e4b37fd, nullptr, nullptr, { &s_f6cf71a31e4b37fd, nullptr, nullptr, 0, 0, nullptr }
+};
+#endif  // !CAPNP_LITE
+static const ::capnp::_::AlignedData<146> b_e7f0944f867817f9 = {
+  {   0,   0,   0,   0,   5,   0,   6,   0,
+    249,  23, 120, 134,  79, 148, 240, 231,
+     24,   0,   0,   0,   1,   0,   6,   0,
+      8, 198, 146, 225, 113, 246, 251, 154,
+      2,   0,   7,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     21,   0,   0,   0, 250,   0,   0,   0,
+     33,   0,   0,   0,   7,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     29,   0,   0,   0, 199,   1,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 112, 110, 112,  47, 114, 112,
+     99,  45, 109, 101, 116, 114, 105,  99,
+    115,  46,  99,  97, 112, 110, 112,  58,
+     77, 101, 116, 104, 111, 100,   0,   0,
+      0,   0,   0,   0,   1,   0,   1,   0,
+     32,   0,   0,   0,   3,   0,   4,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   1,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    209,   0,   0,   0,  98,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    208,   0,   0,   0,   3,   0,   1,   0,
+    220,   0,   0,   0,   2,   0,   1,   0,
+      1,   0,   0,   0,   4,   0,   0,   0,
+      0,   0,   1,   0,   1,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    217,   0,   0,   0,  74,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    216,   0,   0,   0,   3,   0,   1,   0,
+    228,   0,   0,   0,   2,   0,   1,   0,
+      2,   0,   0,   0,   2,   0,   0,   0,
+      0,   0,   1,   0,   2,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    225,   0,   0,   0,  82,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    224,   0,   0,   0,   3,   0,   1,   0,
+    236,   0,   0,   0,   2,   0,   1,   0,
+      3,   0,   0,   0,   3,   0,   0,   0,
+      0,   0,   1,   0,   3,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    233,   0,   0,   0, 122,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    232,   0,   0,   0,   3,   0,   1,   0,
+    244,   0,   0,   0,   2,   0,   1,   0,
+      4,   0,   0,   0,   4,   0,   0,   0,
+      0,   0,   1,   0,   4,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    241,   0,   0,   0, 114,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    240,   0,   0,   0,   3,   0,   1,   0,
+    252,   0,   0,   0,   2,   0,   1,   0,
+      5,   0,   0,   0,   5,   0,   0,   0,
+      0,   0,   1,   0,   5,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    249,   0,   0,   0, 122,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    248,   0,   0,   0,   3,   0,   1,   0,
+      4,   1,   0,   0,   2,   0,   1,   0,
+      6,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   1,   0,   6,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      1,   1,   0,   0,  98,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   1,   0,   0,   3,   0,   1,   0,
+     12,   1,   0,   0,   2,   0,   1,   0,
+      7,   0,   0,   0,   1,   0,   0,   0,
+      0,   0,   1,   0,   7,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   1,   0,   0, 122,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      8,   1,   0,   0,   3,   0,   1,   0,
+     20,   1,   0,   0,   2,   0,   1,   0,
+    105, 110, 116, 101, 114, 102,  97,  99,
+    101,  73, 100,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    109, 101, 116, 104, 111, 100,  73, 100,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      7,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      7,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 108, 108, 115,  83, 101, 110,
+    116,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    101, 114, 114, 111, 114, 115,  82, 101,
+     99, 101, 105, 118, 101, 100,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 108, 108, 115,  82, 101,  99,
+    101, 105, 118, 101, 100,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    101, 114, 114, 111, 114, 115,  82, 101,
+    116, 117, 114, 110, 101, 100,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 108, 108,  76,  97, 116, 101,
+    110,  99, 121,   0,   0,   0,   0,   0,
+     16,   0,   0,   0,   0,   0,   0,   0,
+      8, 235, 198,  74,  94,  36,  13, 154,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     16,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    115, 101, 114, 118, 105,  99, 101,  76,
+     97, 116, 101, 110,  99, 121,   0,   0,
+     16,   0,   0,   0,   0,   0,   0,   0,
+      8, 235, 198,  74,  94,  36,  13, 154,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     16,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, }
+};
+::capnp::word const* const bp_e7f0944f867817f9 = b_e7f0944f867817f9.words;
+#if !CAPNP_LITE
+static const ::capnp::_::RawSchema* const d_e7f0944f867817f9[] = {
+  &s_9a0d245e4ac6eb08,
+};
+static const uint16_t m_e7f0944f867817f9[] = {6, 4, 2, 3, 5, 0, 1, 7};
+static const uint16_t i_e7f0944f867817f9[] = {0, 1, 2, 3, 4, 5, 6, 7};
+const ::capnp::_::RawSchema s_e7f0944f867817f9 = {
+  0xe7f0944f867817f9, b_e7f0944f867817f9.words, 146, d_e7f0944f867817f9, m_e7f0944f867817f9,
+  1, 8, i_e7f0944f867817f9, nullptr, nullptr, { &s_e7f0944f867817f9, nullptr, nullptr, 0, 0, nullptr }
+};
+#endif  // !CAPNP_LITE
+static const ::capnp::_::AlignedData<168> b_9a0d245e4ac6eb08 = {
+  {   0,   0,   0,   0,   5,   0,   6,   0,
+      8, 235, 198,  74,  94,  36,  13, 154,
+     24,   0,   0,   0,   1,   0,   8,   0,
+      8, 198, 146, 225, 113, 246, 251, 154,
+      1,   0,   7,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     21,   0,   0,   0,  18,   1,   0,   0,
+     37,   0,   0,   0,  23,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     45,   0,   0,   0, 255,   1,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 112, 110, 112,  47, 114, 112,
+     99,  45, 109, 101, 116, 114, 105,  99,
+    115,  46,  99,  97, 112, 110, 112,  58,
+     72, 105, 115, 116, 111, 103, 114,  97,
+    109,   0,   0,   0,   0,   0,   0,   0,
+      4,   0,   0,   0,   1,   0,   1,   0,
+    238,  51,  23,  26, 187, 236, 152, 138,
+      1,   0,   0,   0,  58,   0,   0,   0,
+     66, 117,  99, 107, 101, 116,   0,   0,
+     36,   0,   0,   0,   3,   0,   4,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   1,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    237,   0,   0,   0,  50,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    232,   0,   0,   0,   3,   0,   1,   0,
+    244,   0,   0,   0,   2,   0,   1,   0,
+      1,   0,   0,   0,   1,   0,   0,   0,
+      0,   0,   1,   0,   1,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    241,   0,   0,   0,  74,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    240,   0,   0,   0,   3,   0,   1,   0,
+    252,   0,   0,   0,   2,   0,   1,   0,
+      2,   0,   0,   0,   2,   0,   0,   0,
+      0,   0,   1,   0,   2,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    249,   0,   0,   0,  74,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    248,   0,   0,   0,   3,   0,   1,   0,
+      4,   1,   0,   0,   2,   0,   1,   0,
+      3,   0,   0,   0,   3,   0,   0,   0,
+      0,   0,   1,   0,   3,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      1,   1,   0,   0,  82,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   1,   0,   0,   3,   0,   1,   0,
+     12,   1,   0,   0,   2,   0,   1,   0,
+      4,   0,   0,   0,   4,   0,   0,   0,
+      0,   0,   1,   0,   4,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   1,   0,   0,  74,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      8,   1,   0,   0,   3,   0,   1,   0,
+     20,   1,   0,   0,   2,   0,   1,   0,
+      5,   0,   0,   0,   5,   0,   0,   0,
+      0,   0,   1,   0,   5,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     17,   1,   0,   0,  74,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     16,   1,   0,   0,   3,   0,   1,   0,
+     28,   1,   0,   0,   2,   0,   1,   0,
+      6,   0,   0,   0,   6,   0,   0,   0,
+      0,   0,   1,   0,   6,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     25,   1,   0,   0,  74,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     24,   1,   0,   0,   3,   0,   1,   0,
+     36,   1,   0,   0,   2,   0,   1,   0,
+      7,   0,   0,   0,   7,   0,   0,   0,
+      0,   0,   1,   0,   7,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     33,   1,   0,   0,  82,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     32,   1,   0,   0,   3,   0,   1,   0,
+     44,   1,   0,   0,   2,   0,   1,   0,
+      8,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   1,   0,   8,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     41,   1,   0,   0,  66,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     36,   1,   0,   0,   3,   0,   1,   0,
+     64,   1,   0,   0,   2,   0,   1,   0,
+     99, 111, 117, 110, 116,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    109, 105, 110,  78,  97, 110, 111, 115,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    109,  97, 120,  78,  97, 110, 111, 115,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    109, 101,  97, 110,  78,  97, 110, 111,
+    115,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    112,  53,  48,  78,  97, 110, 111, 115,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    112,  57,  48,  78,  97, 110, 111, 115,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    112,  57,  57,  78,  97, 110, 111, 115,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+    112,  57,  57,  57,  78,  97, 110, 111,
+    115,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     98, 117,  99, 107, 101, 116, 115,   0,
+     14,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   3,   0,   1,   0,
+     16,   0,   0,   0,   0,   0,   0,   0,
+    238,  51,  23,  26, 187, 236, 152, 138,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     14,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, }
+};
+::capnp::word const* const bp_9a0d245e4ac6eb08 = b_9a0d245e4ac6eb08.words;
+#if !CAPNP_LITE
+static const ::capnp::_::RawSchema* const d_9a0d245e4ac6eb08[] = {
+  &s_8a98ecbb1a1733ee,
+};
+static const uint16_t m_9a0d245e4ac6eb08[] = {8, 0, 2, 3, 1, 4, 5, 7, 6};
+static const uint16_t i_9a0d245e4ac6eb08[] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+const ::capnp::_::RawSchema s_9a0d245e4ac6eb08 = {
+  0x9a0d245e4ac6eb08, b_9a0d245e4ac6eb08.words, 168, d_9a0d245e4ac6eb08, m_9a0d245e4ac6eb08,
+  1, 9, i_9a0d245e4ac6eb08, nullptr, nullptr, { &s_9a0d245e4ac6eb08, nullptr, nullptr, 0, 0, nullptr }
+};
+#endif  // !CAPNP_LITE
+static const ::capnp::_::AlignedData<51> b_8a98ecbb1a1733ee = {
+  {   0,   0,   0,   0,   5,   0,   6,   0,
+    238,  51,  23,  26, 187, 236, 152, 138,
+     34,   0,   0,   0,   1,   0,   2,   0,
+      8, 235, 198,  74,  94,  36,  13, 154,
+      0,   0,   7,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     21,   0,   0,   0,  74,   1,   0,   0,
+     41,   0,   0,   0,   7,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     37,   0,   0,   0, 119,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99,  97, 112, 110, 112,  47, 114, 112,
+     99,  45, 109, 101, 116, 114, 105,  99,
+    115,  46,  99,  97, 112, 110, 112,  58,
+     72, 105, 115, 116, 111, 103, 114,  97,
+    109,  46,  66, 117,  99, 107, 101, 116,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   1,   0,   1,   0,
+      8,   0,   0,   0,   3,   0,   4,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   1,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     41,   0,   0,   0, 130,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     40,   0,   0,   0,   3,   0,   1,   0,
+     52,   0,   0,   0,   2,   0,   1,   0,
+      1,   0,   0,   0,   1,   0,   0,   0,
+      0,   0,   1,   0,   1,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     49,   0,   0,   0,  50,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     44,   0,   0,   0,   3,   0,   1,   0,
+     56,   0,   0,   0,   2,   0,   1,   0,
+    108, 111, 119, 101, 114,  66, 111, 117,
+    110, 100,  78,  97, 110, 111, 115,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     99, 111, 117, 110, 116,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      9,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0, }
+};
+::capnp::word const* const bp_8a98ecbb1a1733ee = b_8a98ecbb1a1733ee.words;
+#if !CAPNP_LITE
+static const uint16_t m_8a98ecbb1a1733ee[] = {1, 0};
+static const uint16_t i_8a98ecbb1a1733ee[] = {0, 1};
+const ::capnp::_::RawSchema s_8a98ecbb1a1733ee = {
+  0x8a98ecbb1a1733ee, b_8a98ecbb1a1733ee.words, 51, nullptr, m_8a98ecbb1a1733ee,
+  0, 2, i_8a98ecbb1a1733ee, nullptr, nullptr, { &s_8a98ecbb1a1733ee, nullptr, nullptr, 0, 0, nullptr }
+};
+#endif  // !CAPNP_LITE
+}  // namespace schemas
+}  // namespace capnp
+
+// =======================================================================================
+
+namespace capnp {
+namespace rpc {
+namespace metrics {
+
+#if !CAPNP_LITE
+::capnp::Request< ::capnp::rpc::metrics::RpcMonitor::GetSnapshotParams,  ::capnp::rpc::metrics::RpcMonitor::GetSnapshotResults>
+RpcMonitor::Client::getSnapshotRequest(::kj::Maybe< ::capnp::MessageSize> sizeHint) {
+  return newCall< ::capnp::rpc::metrics::RpcMonitor::GetSnapshotParams,  ::capnp::rpc::metrics::RpcMonitor::GetSnapshotResults>(
+      0xf3bffc456c62b58bull, 0, sizeHint);
+}
+::kj::Promise<void> RpcMonitor::Server::getSnapshot(GetSnapshotContext) {
+  return ::capnp::Capability::Server::internalUnimplemented(
+      "capnp/rpc-metrics.capnp:RpcMonitor", "getSnapshot",
+      0xf3bffc456c62b58bull, 0);
+}
+::kj::Promise<void> RpcMonitor::Server::dispatchCall(
+    uint64_t interfaceId, uint16_t methodId,
+    ::capnp::CallContext< ::capnp::AnyPointer, ::capnp::AnyPointer> context) {
+  switch (interfaceId) {
+    case 0xf3bffc456c62b58bull:
+      return dispatchCallInternal(methodId, context);
+    default:
+      return internalUnimplemented("capnp/rpc-metrics.capnp:RpcMonitor", interfaceId);
+  }
+}
+::kj::Promise<void> RpcMonitor::Server::dispatchCallInternal(
+    uint16_t methodId,
+    ::capnp::CallContext< ::capnp::AnyPointer, ::capnp::AnyPointer> context) {
+  switch (methodId) {
+    case 0:
+      return getSnapshot(::capnp::Capability::Server::internalGetTypedContext<
+           ::capnp::rpc::metrics::RpcMonitor::GetSnapshotParams,  ::capnp::rpc::metrics::RpcMonitor::GetSnapshotResults>(context));
+    default:
+      (void)context;
+      return ::capnp::Capability::Server::internalUnimplemented(
+          "capnp/rpc-metrics.capnp:RpcMonitor",
+          0xf3bffc456c62b58bull, methodId);
+  }
+}
+#endif  // !CAPNP_LITE
+
+// RpcMonitor
+#if !CAPNP_LITE
+constexpr ::capnp::Kind RpcMonitor::_capnpPrivate::kind;
+constexpr ::capnp::_::RawSchema const* RpcMonitor::_capnpPrivate::schema;
+#endif  // !CAPNP_LITE
+
+// RpcMonitor::GetSnapshotParams
+constexpr uint16_t RpcMonitor::GetSnapshotParams::_capnpPrivate::dataWordSize;
+constexpr uint16_t RpcMonitor::GetSnapshotParams::_capnpPrivate::pointerCount;
+#if !CAPNP_LITE
+constexpr ::capnp::Kind RpcMonitor::GetSnapshotParams::_capnpPrivate::kind;
+constexpr ::capnp::_::RawSchema const* RpcMonitor::GetSnapshotParams::_capnpPrivate::schema;
+#endif  // !CAPNP_LITE
+
+// RpcMonitor::GetSnapshotResults
+constexpr uint16_t RpcMonitor::GetSnapshotResults::_capnpPrivate::dataWordSize;
+constexpr uint16_t RpcMonitor::GetSnapshotResults::_capnpPrivate::pointerCount;
+#if !CAPNP_LITE
+constexpr ::capnp::Kind RpcMonitor::GetSnapshotResults::_capnpPrivate::kind;
+constexpr ::capnp::_::RawSchema const* RpcMonitor::GetSnapshotResults::_capnpPrivate::schema;
+#endif  // !CAPNP_LITE
+
+// Snapshot
+constexpr uint16_t Snapshot::_capnpPrivate::dataWordSize;
+constexpr uint16_t Snapshot::_capnpPrivate::pointerCount;
+#if !CAPNP_LITE
+constexpr ::capnp::Kind Snapshot::_capnpPrivate::kind;
+constexpr ::capnp::_::RawSchema const* Snapshot::_capnpPrivate::schema;
+#endif  // !CAPNP_LITE
+
+// Connection
+constexpr uint16_t Connection::_capnpPrivate::dataWordSize;
+constexpr uint16_t Connection::_capnpPrivate::pointerCount;
+#if !CAPNP_LITE
+constexpr ::capnp::Kind Connection::_capnpPrivate::kind;
+constexpr ::capnp::_::RawSchema const* Connection::_capnpPrivate::schema;
+#endif  // !CAPNP_LITE
+
+// Method
+constexpr uint16_t Method::_capnpPrivate::dataWordSize;
+constexpr uint16_t Method::_capnpPrivate::pointerCount;
+#if !CAPNP_LITE
+constexpr ::capnp::Kind Method::_capnpPrivate::kind;
+constexpr ::capnp::_::RawSchema const* Method::_capnpPrivate::schema;
+#endif  // !CAPNP_LITE
+
+// Histogram
+constexpr uint16_t Histogram::_capnpPrivate::dataWordSize;
+constexpr uint16_t Histogram::_capnpPrivate::pointerCount;
+#if !CAPNP_LITE
+constexpr ::capnp::Kind Histogram::_capnpPrivate::kind;
+constexpr ::capnp::_::RawSchema const* Histogram::_capnpPrivate::schema;
+#endif  // !CAPNP_LITE
+
+// Histogram::Bucket
+constexpr uint16_t Histogram::Bucket::_capnpPrivate::dataWordSize;
+constexpr uint16_t Histogram::Bucket::_capnpPrivate::pointerCount;
+#if !CAPNP_LITE
+constexpr ::capnp::Kind Histogram::Bucket::_capnpPrivate::kind;
+constexpr ::capnp::_::RawSchema const* Histogram::Bucket::_capnpPrivate::schema;
+#endif  // !CAPNP_LITE
+
+
+}  // namespace
+}  // namespace
+}  // namespace
+
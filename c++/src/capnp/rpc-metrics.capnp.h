@@ -0,0 +1,1479 @@
+// Generated by Cap'n Proto compiler, DO NOT EDIT
+// source: rpc-metrics.capnp
+
+#ifndef CAPNP_INCLUDED_9afbf671e192c608_
+#define CAPNP_INCLUDED_9afbf671e192c608_
+
+#include <capnp/generated-header-support.h>
+#if !CAPNP_LITE
+#include <capnp/capability.h>
+#endif  // !CAPNP_LITE
+
+#if CAPNP_VERSION != 7000
+#error "Version mismatch between generated code and library headers.  You must use the same version of the Cap'n Proto compiler and library."
+#endif
+
+
+namespace capnp {
+namespace schemas {
+
+CAPNP_DECLARE_SCHEMA(f3bffc456c62b58b);
+CAPNP_DECLARE_SCHEMA(eee5ac19dad7275a);
+CAPNP_DECLARE_SCHEMA(85e608cae32c79fa);
+CAPNP_DECLARE_SCHEMA(c32bf23224e59545);
+CAPNP_DECLARE_SCHEMA(f6cf71a31e4b37fd);
+CAPNP_DECLARE_SCHEMA(e7f0944f867817f9);
+CAPNP_DECLARE_SCHEMA(9a0d245e4ac6eb08);
+CAPNP_DECLARE_SCHEMA(8a98ecbb1a1733ee);
+
+}  // namespace schemas
+}  // namespace capnp
+
+namespace capnp {
+namespace rpc {
+namespace metrics {
+
+struct RpcMonitor {
+  RpcMonitor() = delete;
+
+#if !CAPNP_LITE
+  class Client;
+  class Server;
+#endif  // !CAPNP_LITE
+
+  struct GetSnapshotParams;
+  struct GetSnapshotResults;
+
+  #if !CAPNP_LITE
+  struct _capnpPrivate {
+    CAPNP_DECLARE_INTERFACE_HEADER(f3bffc456c62b58b)
+    static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
+  };
+  #endif  // !CAPNP_LITE
+};
+
+struct RpcMonitor::GetSnapshotParams {
+  GetSnapshotParams() = delete;
+
+  class Reader;
+  class Builder;
+  class Pipeline;
+
+  struct _capnpPrivate {
+    CAPNP_DECLARE_STRUCT_HEADER(eee5ac19dad7275a, 0, 0)
+    #if !CAPNP_LITE
+    static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
+    #endif  // !CAPNP_LITE
+  };
+};
+
+struct RpcMonitor::GetSnapshotResults {
+  GetSnapshotResults() = delete;
+
+  class Reader;
+  class Builder;
+  class Pipeline;
+
+  struct _capnpPrivate {
+    CAPNP_DECLARE_STRUCT_HEADER(85e608cae32c79fa, 0, 1)
+    #if !CAPNP_LITE
+    static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
+    #endif  // !CAPNP_LITE
+  };
+};
+
+struct Snapshot {
+  Snapshot() = delete;
+
+  class Reader;
+  class Builder;
+  class Pipeline;
+
+  struct _capnpPrivate {
+    CAPNP_DECLARE_STRUCT_HEADER(c32bf23224e59545, 4, 2)
+    #if !CAPNP_LITE
+    static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
+    #endif  // !CAPNP_LITE
+  };
+};
+
+struct Connection {
+  Connection() = delete;
+
+  class Reader;
+  class Builder;
+  class Pipeline;
+
+  struct _capnpPrivate {
+    CAPNP_DECLARE_STRUCT_HEADER(f6cf71a31e4b37fd, 2, 0)
+    #if !CAPNP_LITE
+    static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
+    #endif  // !CAPNP_LITE
+  };
+};
+
+struct Method {
+  Method() = delete;
+
+  class Reader;
+  class Builder;
+  class Pipeline;
+
+  struct _capnpPrivate {
+    CAPNP_DECLARE_STRUCT_HEADER(e7f0944f867817f9, 6, 2)
+    #if !CAPNP_LITE
+    static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
+    #endif  // !CAPNP_LITE
+  };
+};
+
+struct Histogram {
+  Histogram() = delete;
+
+  class Reader;
+  class Builder;
+  class Pipeline;
+  struct Bucket;
+
+  struct _capnpPrivate {
+    CAPNP_DECLARE_STRUCT_HEADER(9a0d245e4ac6eb08, 8, 1)
+    #if !CAPNP_LITE
+    static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
+    #endif  // !CAPNP_LITE
+  };
+};
+
+struct Histogram::Bucket {
+  Bucket() = delete;
+
+  class Reader;
+  class Builder;
+  class Pipeline;
+
+  struct _capnpPrivate {
+    CAPNP_DECLARE_STRUCT_HEADER(8a98ecbb1a1733ee, 2, 0)
+    #if !CAPNP_LITE
+    static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
+    #endif  // !CAPNP_LITE
+  };
+};
+
+// =======================================================================================
+
+#if !CAPNP_LITE
+class RpcMonitor::Client
+    : public virtual ::capnp::Capability::Client {
+public:
+  typedef RpcMonitor Calls;
+  typedef RpcMonitor Reads;
+
+  Client(decltype(nullptr));
+  explicit Client(::kj::Own< ::capnp::ClientHook>&& hook);
+  template <typename _t, typename = ::kj::EnableIf< ::kj::canConvert<_t*, Server*>()>>
+  Client(::kj::Own<_t>&& server);
+  template <typename _t, typename = ::kj::EnableIf< ::kj::canConvert<_t*, Client*>()>>
+  Client(::kj::Promise<_t>&& promise);
+  Client(::kj::Exception&& exception);
+  Client(Client&) = default;
+  Client(Client&&) = default;
+  Client& operator=(Client& other);
+  Client& operator=(Client&& other);
+
+  ::capnp::Request< ::capnp::rpc::metrics::RpcMonitor::GetSnapshotParams,  ::capnp::rpc::metrics::RpcMonitor::GetSnapshotResults> getSnapshotRequest(
+      ::kj::Maybe< ::capnp::MessageSize> sizeHint = nullptr);
+
+protected:
+  Client() = default;
+};
+
+class RpcMonitor::Server
+    : public virtual ::capnp::Capability::Server {
+public:
+  typedef RpcMonitor Serves;
+
+  ::kj::Promise<void> dispatchCall(uint64_t interfaceId, uint16_t methodId,
+      ::capnp::CallContext< ::capnp::AnyPointer, ::capnp::AnyPointer> context)
+      override;
+
+protected:
+  typedef  ::capnp::rpc::metrics::RpcMonitor::GetSnapshotParams GetSnapshotParams;
+  typedef  ::capnp::rpc::metrics::RpcMonitor::GetSnapshotResults GetSnapshotResults;
+  typedef ::capnp::CallContext<GetSnapshotParams, GetSnapshotResults> GetSnapshotContext;
+  virtual ::kj::Promise<void> getSnapshot(GetSnapshotContext context);
+
+  inline  ::capnp::rpc::metrics::RpcMonitor::Client thisCap() {
+    return ::capnp::Capability::Server::thisCap()
+        .template castAs< ::capnp::rpc::metrics::RpcMonitor>();
+  }
+
+  ::kj::Promise<void> dispatchCallInternal(uint16_t methodId,
+      ::capnp::CallContext< ::capnp::AnyPointer, ::capnp::AnyPointer> context);
+};
+#endif  // !CAPNP_LITE
+
+class RpcMonitor::GetSnapshotParams::Reader {
+public:
+  typedef GetSnapshotParams Reads;
+
+  Reader() = default;
+  inline explicit Reader(::capnp::_::StructReader base): _reader(base) {}
+
+  inline ::capnp::MessageSize totalSize() const {
+    return _reader.totalSize().asPublic();
+  }
+
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const {
+    return ::capnp::_::structString(_reader, *_capnpPrivate::brand());
+  }
+#endif  // !CAPNP_LITE
+
+private:
+  ::capnp::_::StructReader _reader;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::List;
+  friend class ::capnp::MessageBuilder;
+  friend class ::capnp::Orphanage;
+};
+
+class RpcMonitor::GetSnapshotParams::Builder {
+public:
+  typedef GetSnapshotParams Builds;
+
+  Builder() = delete;  // Deleted to discourage incorrect usage.
+                       // You can explicitly initialize to nullptr instead.
+  inline Builder(decltype(nullptr)) {}
+  inline explicit Builder(::capnp::_::StructBuilder base): _builder(base) {}
+  inline operator Reader() const { return Reader(_builder.asReader()); }
+  inline Reader asReader() const { return *this; }
+
+  inline ::capnp::MessageSize totalSize() const { return asReader().totalSize(); }
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const { return asReader().toString(); }
+#endif  // !CAPNP_LITE
+
+private:
+  ::capnp::_::StructBuilder _builder;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  friend class ::capnp::Orphanage;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+};
+
+#if !CAPNP_LITE
+class RpcMonitor::GetSnapshotParams::Pipeline {
+public:
+  typedef GetSnapshotParams Pipelines;
+
+  inline Pipeline(decltype(nullptr)): _typeless(nullptr) {}
+  inline explicit Pipeline(::capnp::AnyPointer::Pipeline&& typeless)
+      : _typeless(kj::mv(typeless)) {}
+
+private:
+  ::capnp::AnyPointer::Pipeline _typeless;
+  friend class ::capnp::PipelineHook;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+};
+#endif  // !CAPNP_LITE
+
+class RpcMonitor::GetSnapshotResults::Reader {
+public:
+  typedef GetSnapshotResults Reads;
+
+  Reader() = default;
+  inline explicit Reader(::capnp::_::StructReader base): _reader(base) {}
+
+  inline ::capnp::MessageSize totalSize() const {
+    return _reader.totalSize().asPublic();
+  }
+
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const {
+    return ::capnp::_::structString(_reader, *_capnpPrivate::brand());
+  }
+#endif  // !CAPNP_LITE
+
+  inline bool hasSnapshot() const;
+  inline  ::capnp::rpc::metrics::Snapshot::Reader getSnapshot() const;
+
+private:
+  ::capnp::_::StructReader _reader;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::List;
+  friend class ::capnp::MessageBuilder;
+  friend class ::capnp::Orphanage;
+};
+
+class RpcMonitor::GetSnapshotResults::Builder {
+public:
+  typedef GetSnapshotResults Builds;
+
+  Builder() = delete;  // Deleted to discourage incorrect usage.
+                       // You can explicitly initialize to nullptr instead.
+  inline Builder(decltype(nullptr)) {}
+  inline explicit Builder(::capnp::_::StructBuilder base): _builder(base) {}
+  inline operator Reader() const { return Reader(_builder.asReader()); }
+  inline Reader asReader() const { return *this; }
+
+  inline ::capnp::MessageSize totalSize() const { return asReader().totalSize(); }
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const { return asReader().toString(); }
+#endif  // !CAPNP_LITE
+
+  inline bool hasSnapshot();
+  inline  ::capnp::rpc::metrics::Snapshot::Builder getSnapshot();
+  inline void setSnapshot( ::capnp::rpc::metrics::Snapshot::Reader value);
+  inline  ::capnp::rpc::metrics::Snapshot::Builder initSnapshot();
+  inline void adoptSnapshot(::capnp::Orphan< ::capnp::rpc::metrics::Snapshot>&& value);
+  inline ::capnp::Orphan< ::capnp::rpc::metrics::Snapshot> disownSnapshot();
+
+private:
+  ::capnp::_::StructBuilder _builder;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  friend class ::capnp::Orphanage;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+};
+
+#if !CAPNP_LITE
+class RpcMonitor::GetSnapshotResults::Pipeline {
+public:
+  typedef GetSnapshotResults Pipelines;
+
+  inline Pipeline(decltype(nullptr)): _typeless(nullptr) {}
+  inline explicit Pipeline(::capnp::AnyPointer::Pipeline&& typeless)
+      : _typeless(kj::mv(typeless)) {}
+
+  inline  ::capnp::rpc::metrics::Snapshot::Pipeline getSnapshot();
+private:
+  ::capnp::AnyPointer::Pipeline _typeless;
+  friend class ::capnp::PipelineHook;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+};
+#endif  // !CAPNP_LITE
+
+class Snapshot::Reader {
+public:
+  typedef Snapshot Reads;
+
+  Reader() = default;
+  inline explicit Reader(::capnp::_::StructReader base): _reader(base) {}
+
+  inline ::capnp::MessageSize totalSize() const {
+    return _reader.totalSize().asPublic();
+  }
+
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const {
+    return ::capnp::_::structString(_reader, *_capnpPrivate::brand());
+  }
+#endif  // !CAPNP_LITE
+
+  inline bool hasConnections() const;
+  inline  ::capnp::List< ::capnp::rpc::metrics::Connection>::Reader getConnections() const;
+
+  inline bool hasMethods() const;
+  inline  ::capnp::List< ::capnp::rpc::metrics::Method>::Reader getMethods() const;
+
+  inline  ::uint64_t getMessagesSent() const;
+
+  inline  ::uint64_t getMessagesReceived() const;
+
+  inline  ::uint64_t getBytesSent() const;
+
+  inline  ::uint64_t getBytesReceived() const;
+
+private:
+  ::capnp::_::StructReader _reader;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::List;
+  friend class ::capnp::MessageBuilder;
+  friend class ::capnp::Orphanage;
+};
+
+class Snapshot::Builder {
+public:
+  typedef Snapshot Builds;
+
+  Builder() = delete;  // Deleted to discourage incorrect usage.
+                       // You can explicitly initialize to nullptr instead.
+  inline Builder(decltype(nullptr)) {}
+  inline explicit Builder(::capnp::_::StructBuilder base): _builder(base) {}
+  inline operator Reader() const { return Reader(_builder.asReader()); }
+  inline Reader asReader() const { return *this; }
+
+  inline ::capnp::MessageSize totalSize() const { return asReader().totalSize(); }
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const { return asReader().toString(); }
+#endif  // !CAPNP_LITE
+
+  inline bool hasConnections();
+  inline  ::capnp::List< ::capnp::rpc::metrics::Connection>::Builder getConnections();
+  inline void setConnections( ::capnp::List< ::capnp::rpc::metrics::Connection>::Reader value);
+  inline  ::capnp::List< ::capnp::rpc::metrics::Connection>::Builder initConnections(unsigned int size);
+  inline void adoptConnections(::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Connection>>&& value);
+  inline ::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Connection>> disownConnections();
+
+  inline bool hasMethods();
+  inline  ::capnp::List< ::capnp::rpc::metrics::Method>::Builder getMethods();
+  inline void setMethods( ::capnp::List< ::capnp::rpc::metrics::Method>::Reader value);
+  inline  ::capnp::List< ::capnp::rpc::metrics::Method>::Builder initMethods(unsigned int size);
+  inline void adoptMethods(::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Method>>&& value);
+  inline ::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Method>> disownMethods();
+
+  inline  ::uint64_t getMessagesSent();
+  inline void setMessagesSent( ::uint64_t value);
+
+  inline  ::uint64_t getMessagesReceived();
+  inline void setMessagesReceived( ::uint64_t value);
+
+  inline  ::uint64_t getBytesSent();
+  inline void setBytesSent( ::uint64_t value);
+
+  inline  ::uint64_t getBytesReceived();
+  inline void setBytesReceived( ::uint64_t value);
+
+private:
+  ::capnp::_::StructBuilder _builder;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  friend class ::capnp::Orphanage;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+};
+
+#if !CAPNP_LITE
+class Snapshot::Pipeline {
+public:
+  typedef Snapshot Pipelines;
+
+  inline Pipeline(decltype(nullptr)): _typeless(nullptr) {}
+  inline explicit Pipeline(::capnp::AnyPointer::Pipeline&& typeless)
+      : _typeless(kj::mv(typeless)) {}
+
+private:
+  ::capnp::AnyPointer::Pipeline _typeless;
+  friend class ::capnp::PipelineHook;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+};
+#endif  // !CAPNP_LITE
+
+class Connection::Reader {
+public:
+  typedef Connection Reads;
+
+  Reader() = default;
+  inline explicit Reader(::capnp::_::StructReader base): _reader(base) {}
+
+  inline ::capnp::MessageSize totalSize() const {
+    return _reader.totalSize().asPublic();
+  }
+
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const {
+    return ::capnp::_::structString(_reader, *_capnpPrivate::brand());
+  }
+#endif  // !CAPNP_LITE
+
+  inline  ::uint32_t getQuestions() const;
+
+  inline  ::uint32_t getAnswers() const;
+
+  inline  ::uint32_t getExports() const;
+
+  inline  ::uint32_t getImports() const;
+
+private:
+  ::capnp::_::StructReader _reader;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::List;
+  friend class ::capnp::MessageBuilder;
+  friend class ::capnp::Orphanage;
+};
+
+class Connection::Builder {
+public:
+  typedef Connection Builds;
+
+  Builder() = delete;  // Deleted to discourage incorrect usage.
+                       // You can explicitly initialize to nullptr instead.
+  inline Builder(decltype(nullptr)) {}
+  inline explicit Builder(::capnp::_::StructBuilder base): _builder(base) {}
+  inline operator Reader() const { return Reader(_builder.asReader()); }
+  inline Reader asReader() const { return *this; }
+
+  inline ::capnp::MessageSize totalSize() const { return asReader().totalSize(); }
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const { return asReader().toString(); }
+#endif  // !CAPNP_LITE
+
+  inline  ::uint32_t getQuestions();
+  inline void setQuestions( ::uint32_t value);
+
+  inline  ::uint32_t getAnswers();
+  inline void setAnswers( ::uint32_t value);
+
+  inline  ::uint32_t getExports();
+  inline void setExports( ::uint32_t value);
+
+  inline  ::uint32_t getImports();
+  inline void setImports( ::uint32_t value);
+
+private:
+  ::capnp::_::StructBuilder _builder;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  friend class ::capnp::Orphanage;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+};
+
+#if !CAPNP_LITE
+class Connection::Pipeline {
+public:
+  typedef Connection Pipelines;
+
+  inline Pipeline(decltype(nullptr)): _typeless(nullptr) {}
+  inline explicit Pipeline(::capnp::AnyPointer::Pipeline&& typeless)
+      : _typeless(kj::mv(typeless)) {}
+
+private:
+  ::capnp::AnyPointer::Pipeline _typeless;
+  friend class ::capnp::PipelineHook;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+};
+#endif  // !CAPNP_LITE
+
+class Method::Reader {
+public:
+  typedef Method Reads;
+
+  Reader() = default;
+  inline explicit Reader(::capnp::_::StructReader base): _reader(base) {}
+
+  inline ::capnp::MessageSize totalSize() const {
+    return _reader.totalSize().asPublic();
+  }
+
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const {
+    return ::capnp::_::structString(_reader, *_capnpPrivate::brand());
+  }
+#endif  // !CAPNP_LITE
+
+  inline  ::uint64_t getInterfaceId() const;
+
+  inline  ::uint16_t getMethodId() const;
+
+  inline  ::uint64_t getCallsSent() const;
+
+  inline  ::uint64_t getErrorsReceived() const;
+
+  inline  ::uint64_t getCallsReceived() const;
+
+  inline  ::uint64_t getErrorsReturned() const;
+
+  inline bool hasCallLatency() const;
+  inline  ::capnp::rpc::metrics::Histogram::Reader getCallLatency() const;
+
+  inline bool hasServiceLatency() const;
+  inline  ::capnp::rpc::metrics::Histogram::Reader getServiceLatency() const;
+
+private:
+  ::capnp::_::StructReader _reader;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::List;
+  friend class ::capnp::MessageBuilder;
+  friend class ::capnp::Orphanage;
+};
+
+class Method::Builder {
+public:
+  typedef Method Builds;
+
+  Builder() = delete;  // Deleted to discourage incorrect usage.
+                       // You can explicitly initialize to nullptr instead.
+  inline Builder(decltype(nullptr)) {}
+  inline explicit Builder(::capnp::_::StructBuilder base): _builder(base) {}
+  inline operator Reader() const { return Reader(_builder.asReader()); }
+  inline Reader asReader() const { return *this; }
+
+  inline ::capnp::MessageSize totalSize() const { return asReader().totalSize(); }
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const { return asReader().toString(); }
+#endif  // !CAPNP_LITE
+
+  inline  ::uint64_t getInterfaceId();
+  inline void setInterfaceId( ::uint64_t value);
+
+  inline  ::uint16_t getMethodId();
+  inline void setMethodId( ::uint16_t value);
+
+  inline  ::uint64_t getCallsSent();
+  inline void setCallsSent( ::uint64_t value);
+
+  inline  ::uint64_t getErrorsReceived();
+  inline void setErrorsReceived( ::uint64_t value);
+
+  inline  ::uint64_t getCallsReceived();
+  inline void setCallsReceived( ::uint64_t value);
+
+  inline  ::uint64_t getErrorsReturned();
+  inline void setErrorsReturned( ::uint64_t value);
+
+  inline bool hasCallLatency();
+  inline  ::capnp::rpc::metrics::Histogram::Builder getCallLatency();
+  inline void setCallLatency( ::capnp::rpc::metrics::Histogram::Reader value);
+  inline  ::capnp::rpc::metrics::Histogram::Builder initCallLatency();
+  inline void adoptCallLatency(::capnp::Orphan< ::capnp::rpc::metrics::Histogram>&& value);
+  inline ::capnp::Orphan< ::capnp::rpc::metrics::Histogram> disownCallLatency();
+
+  inline bool hasServiceLatency();
+  inline  ::capnp::rpc::metrics::Histogram::Builder getServiceLatency();
+  inline void setServiceLatency( ::capnp::rpc::metrics::Histogram::Reader value);
+  inline  ::capnp::rpc::metrics::Histogram::Builder initServiceLatency();
+  inline void adoptServiceLatency(::capnp::Orphan< ::capnp::rpc::metrics::Histogram>&& value);
+  inline ::capnp::Orphan< ::capnp::rpc::metrics::Histogram> disownServiceLatency();
+
+private:
+  ::capnp::_::StructBuilder _builder;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  friend class ::capnp::Orphanage;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+};
+
+#if !CAPNP_LITE
+class Method::Pipeline {
+public:
+  typedef Method Pipelines;
+
+  inline Pipeline(decltype(nullptr)): _typeless(nullptr) {}
+  inline explicit Pipeline(::capnp::AnyPointer::Pipeline&& typeless)
+      : _typeless(kj::mv(typeless)) {}
+
+  inline  ::capnp::rpc::metrics::Histogram::Pipeline getCallLatency();
+  inline  ::capnp::rpc::metrics::Histogram::Pipeline getServiceLatency();
+private:
+  ::capnp::AnyPointer::Pipeline _typeless;
+  friend class ::capnp::PipelineHook;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+};
+#endif  // !CAPNP_LITE
+
+class Histogram::Reader {
+public:
+  typedef Histogram Reads;
+
+  Reader() = default;
+  inline explicit Reader(::capnp::_::StructReader base): _reader(base) {}
+
+  inline ::capnp::MessageSize totalSize() const {
+    return _reader.totalSize().asPublic();
+  }
+
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const {
+    return ::capnp::_::structString(_reader, *_capnpPrivate::brand());
+  }
+#endif  // !CAPNP_LITE
+
+  inline  ::uint64_t getCount() const;
+
+  inline  ::uint64_t getMinNanos() const;
+
+  inline  ::uint64_t getMaxNanos() const;
+
+  inline  ::uint64_t getMeanNanos() const;
+
+  inline  ::uint64_t getP50Nanos() const;
+
+  inline  ::uint64_t getP90Nanos() const;
+
+  inline  ::uint64_t getP99Nanos() const;
+
+  inline  ::uint64_t getP999Nanos() const;
+
+  inline bool hasBuckets() const;
+  inline  ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>::Reader getBuckets() const;
+
+private:
+  ::capnp::_::StructReader _reader;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::List;
+  friend class ::capnp::MessageBuilder;
+  friend class ::capnp::Orphanage;
+};
+
+class Histogram::Builder {
+public:
+  typedef Histogram Builds;
+
+  Builder() = delete;  // Deleted to discourage incorrect usage.
+                       // You can explicitly initialize to nullptr instead.
+  inline Builder(decltype(nullptr)) {}
+  inline explicit Builder(::capnp::_::StructBuilder base): _builder(base) {}
+  inline operator Reader() const { return Reader(_builder.asReader()); }
+  inline Reader asReader() const { return *this; }
+
+  inline ::capnp::MessageSize totalSize() const { return asReader().totalSize(); }
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const { return asReader().toString(); }
+#endif  // !CAPNP_LITE
+
+  inline  ::uint64_t getCount();
+  inline void setCount( ::uint64_t value);
+
+  inline  ::uint64_t getMinNanos();
+  inline void setMinNanos( ::uint64_t value);
+
+  inline  ::uint64_t getMaxNanos();
+  inline void setMaxNanos( ::uint64_t value);
+
+  inline  ::uint64_t getMeanNanos();
+  inline void setMeanNanos( ::uint64_t value);
+
+  inline  ::uint64_t getP50Nanos();
+  inline void setP50Nanos( ::uint64_t value);
+
+  inline  ::uint64_t getP90Nanos();
+  inline void setP90Nanos( ::uint64_t value);
+
+  inline  ::uint64_t getP99Nanos();
+  inline void setP99Nanos( ::uint64_t value);
+
+  inline  ::uint64_t getP999Nanos();
+  inline void setP999Nanos( ::uint64_t value);
+
+  inline bool hasBuckets();
+  inline  ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>::Builder getBuckets();
+  inline void setBuckets( ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>::Reader value);
+  inline  ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>::Builder initBuckets(unsigned int size);
+  inline void adoptBuckets(::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>>&& value);
+  inline ::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>> disownBuckets();
+
+private:
+  ::capnp::_::StructBuilder _builder;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  friend class ::capnp::Orphanage;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+};
+
+#if !CAPNP_LITE
+class Histogram::Pipeline {
+public:
+  typedef Histogram Pipelines;
+
+  inline Pipeline(decltype(nullptr)): _typeless(nullptr) {}
+  inline explicit Pipeline(::capnp::AnyPointer::Pipeline&& typeless)
+      : _typeless(kj::mv(typeless)) {}
+
+private:
+  ::capnp::AnyPointer::Pipeline _typeless;
+  friend class ::capnp::PipelineHook;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+};
+#endif  // !CAPNP_LITE
+
+class Histogram::Bucket::Reader {
+public:
+  typedef Bucket Reads;
+
+  Reader() = default;
+  inline explicit Reader(::capnp::_::StructReader base): _reader(base) {}
+
+  inline ::capnp::MessageSize totalSize() const {
+    return _reader.totalSize().asPublic();
+  }
+
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const {
+    return ::capnp::_::structString(_reader, *_capnpPrivate::brand());
+  }
+#endif  // !CAPNP_LITE
+
+  inline  ::uint64_t getLowerBoundNanos() const;
+
+  inline  ::uint64_t getCount() const;
+
+private:
+  ::capnp::_::StructReader _reader;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::List;
+  friend class ::capnp::MessageBuilder;
+  friend class ::capnp::Orphanage;
+};
+
+class Histogram::Bucket::Builder {
+public:
+  typedef Bucket Builds;
+
+  Builder() = delete;  // Deleted to discourage incorrect usage.
+                       // You can explicitly initialize to nullptr instead.
+  inline Builder(decltype(nullptr)) {}
+  inline explicit Builder(::capnp::_::StructBuilder base): _builder(base) {}
+  inline operator Reader() const { return Reader(_builder.asReader()); }
+  inline Reader asReader() const { return *this; }
+
+  inline ::capnp::MessageSize totalSize() const { return asReader().totalSize(); }
+#if !CAPNP_LITE
+  inline ::kj::StringTree toString() const { return asReader().toString(); }
+#endif  // !CAPNP_LITE
+
+  inline  ::uint64_t getLowerBoundNanos();
+  inline void setLowerBoundNanos( ::uint64_t value);
+
+  inline  ::uint64_t getCount();
+  inline void setCount( ::uint64_t value);
+
+private:
+  ::capnp::_::StructBuilder _builder;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+  friend class ::capnp::Orphanage;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::_::PointerHelpers;
+};
+
+#if !CAPNP_LITE
+class Histogram::Bucket::Pipeline {
+public:
+  typedef Bucket Pipelines;
+
+  inline Pipeline(decltype(nullptr)): _typeless(nullptr) {}
+  inline explicit Pipeline(::capnp::AnyPointer::Pipeline&& typeless)
+      : _typeless(kj::mv(typeless)) {}
+
+private:
+  ::capnp::AnyPointer::Pipeline _typeless;
+  friend class ::capnp::PipelineHook;
+  template <typename, ::capnp::Kind>
+  friend struct ::capnp::ToDynamic_;
+};
+#endif  // !CAPNP_LITE
+
+// =======================================================================================
+
+#if !CAPNP_LITE
+inline RpcMonitor::Client::Client(decltype(nullptr))
+    : ::capnp::Capability::Client(nullptr) {}
+inline RpcMonitor::Client::Client(
+    ::kj::Own< ::capnp::ClientHook>&& hook)
+    : ::capnp::Capability::Client(::kj::mv(hook)) {}
+template <typename _t, typename>
+inline RpcMonitor::Client::Client(::kj::Own<_t>&& server)
+    : ::capnp::Capability::Client(::kj::mv(server)) {}
+template <typename _t, typename>
+inline RpcMonitor::Client::Client(::kj::Promise<_t>&& promise)
+    : ::capnp::Capability::Client(::kj::mv(promise)) {}
+inline RpcMonitor::Client::Client(::kj::Exception&& exception)
+    : ::capnp::Capability::Client(::kj::mv(exception)) {}
+inline  ::capnp::rpc::metrics::RpcMonitor::Client& RpcMonitor::Client::operator=(Client& other) {
+  ::capnp::Capability::Client::operator=(other);
+  return *this;
+}
+inline  ::capnp::rpc::metrics::RpcMonitor::Client& RpcMonitor::Client::operator=(Client&& other) {
+  ::capnp::Capability::Client::operator=(kj::mv(other));
+  return *this;
+}
+
+#endif  // !CAPNP_LITE
+inline bool RpcMonitor::GetSnapshotResults::Reader::hasSnapshot() const {
+  return !_reader.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS).isNull();
+}
+inline bool RpcMonitor::GetSnapshotResults::Builder::hasSnapshot() {
+  return !_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS).isNull();
+}
+inline  ::capnp::rpc::metrics::Snapshot::Reader RpcMonitor::GetSnapshotResults::Reader::getSnapshot() const {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Snapshot>::get(_reader.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+inline  ::capnp::rpc::metrics::Snapshot::Builder RpcMonitor::GetSnapshotResults::Builder::getSnapshot() {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Snapshot>::get(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+#if !CAPNP_LITE
+inline  ::capnp::rpc::metrics::Snapshot::Pipeline RpcMonitor::GetSnapshotResults::Pipeline::getSnapshot() {
+  return  ::capnp::rpc::metrics::Snapshot::Pipeline(_typeless.getPointerField(0));
+}
+#endif  // !CAPNP_LITE
+inline void RpcMonitor::GetSnapshotResults::Builder::setSnapshot( ::capnp::rpc::metrics::Snapshot::Reader value) {
+  ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Snapshot>::set(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), value);
+}
+inline  ::capnp::rpc::metrics::Snapshot::Builder RpcMonitor::GetSnapshotResults::Builder::initSnapshot() {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Snapshot>::init(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+inline void RpcMonitor::GetSnapshotResults::Builder::adoptSnapshot(
+    ::capnp::Orphan< ::capnp::rpc::metrics::Snapshot>&& value) {
+  ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Snapshot>::adopt(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), kj::mv(value));
+}
+inline ::capnp::Orphan< ::capnp::rpc::metrics::Snapshot> RpcMonitor::GetSnapshotResults::Builder::disownSnapshot() {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Snapshot>::disown(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+
+inline bool Snapshot::Reader::hasConnections() const {
+  return !_reader.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS).isNull();
+}
+inline bool Snapshot::Builder::hasConnections() {
+  return !_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS).isNull();
+}
+inline  ::capnp::List< ::capnp::rpc::metrics::Connection>::Reader Snapshot::Reader::getConnections() const {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Connection>>::get(_reader.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+inline  ::capnp::List< ::capnp::rpc::metrics::Connection>::Builder Snapshot::Builder::getConnections() {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Connection>>::get(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+inline void Snapshot::Builder::setConnections( ::capnp::List< ::capnp::rpc::metrics::Connection>::Reader value) {
+  ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Connection>>::set(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), value);
+}
+inline  ::capnp::List< ::capnp::rpc::metrics::Connection>::Builder Snapshot::Builder::initConnections(unsigned int size) {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Connection>>::init(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), size);
+}
+inline void Snapshot::Builder::adoptConnections(
+    ::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Connection>>&& value) {
+  ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Connection>>::adopt(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), kj::mv(value));
+}
+inline ::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Connection>> Snapshot::Builder::disownConnections() {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Connection>>::disown(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+
+inline bool Snapshot::Reader::hasMethods() const {
+  return !_reader.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS).isNull();
+}
+inline bool Snapshot::Builder::hasMethods() {
+  return !_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS).isNull();
+}
+inline  ::capnp::List< ::capnp::rpc::metrics::Method>::Reader Snapshot::Reader::getMethods() const {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Method>>::get(_reader.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS));
+}
+inline  ::capnp::List< ::capnp::rpc::metrics::Method>::Builder Snapshot::Builder::getMethods() {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Method>>::get(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS));
+}
+inline void Snapshot::Builder::setMethods( ::capnp::List< ::capnp::rpc::metrics::Method>::Reader value) {
+  ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Method>>::set(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS), value);
+}
+inline  ::capnp::List< ::capnp::rpc::metrics::Method>::Builder Snapshot::Builder::initMethods(unsigned int size) {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Method>>::init(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS), size);
+}
+inline void Snapshot::Builder::adoptMethods(
+    ::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Method>>&& value) {
+  ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Method>>::adopt(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS), kj::mv(value));
+}
+inline ::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Method>> Snapshot::Builder::disownMethods() {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Method>>::disown(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS));
+}
+
+inline  ::uint64_t Snapshot::Reader::getMessagesSent() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Snapshot::Builder::getMessagesSent() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+inline void Snapshot::Builder::setMessagesSent( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Snapshot::Reader::getMessagesReceived() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Snapshot::Builder::getMessagesReceived() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS);
+}
+inline void Snapshot::Builder::setMessagesReceived( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Snapshot::Reader::getBytesSent() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Snapshot::Builder::getBytesSent() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS);
+}
+inline void Snapshot::Builder::setBytesSent( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Snapshot::Reader::getBytesReceived() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Snapshot::Builder::getBytesReceived() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+inline void Snapshot::Builder::setBytesReceived( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint32_t Connection::Reader::getQuestions() const {
+  return _reader.getDataField< ::uint32_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint32_t Connection::Builder::getQuestions() {
+  return _builder.getDataField< ::uint32_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+inline void Connection::Builder::setQuestions( ::uint32_t value) {
+  _builder.setDataField< ::uint32_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint32_t Connection::Reader::getAnswers() const {
+  return _reader.getDataField< ::uint32_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint32_t Connection::Builder::getAnswers() {
+  return _builder.getDataField< ::uint32_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS);
+}
+inline void Connection::Builder::setAnswers( ::uint32_t value) {
+  _builder.setDataField< ::uint32_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint32_t Connection::Reader::getExports() const {
+  return _reader.getDataField< ::uint32_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint32_t Connection::Builder::getExports() {
+  return _builder.getDataField< ::uint32_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS);
+}
+inline void Connection::Builder::setExports( ::uint32_t value) {
+  _builder.setDataField< ::uint32_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint32_t Connection::Reader::getImports() const {
+  return _reader.getDataField< ::uint32_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint32_t Connection::Builder::getImports() {
+  return _builder.getDataField< ::uint32_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+inline void Connection::Builder::setImports( ::uint32_t value) {
+  _builder.setDataField< ::uint32_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Method::Reader::getInterfaceId() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Method::Builder::getInterfaceId() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+inline void Method::Builder::setInterfaceId( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint16_t Method::Reader::getMethodId() const {
+  return _reader.getDataField< ::uint16_t>(
+      ::capnp::bounded<4>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint16_t Method::Builder::getMethodId() {
+  return _builder.getDataField< ::uint16_t>(
+      ::capnp::bounded<4>() * ::capnp::ELEMENTS);
+}
+inline void Method::Builder::setMethodId( ::uint16_t value) {
+  _builder.setDataField< ::uint16_t>(
+      ::capnp::bounded<4>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Method::Reader::getCallsSent() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Method::Builder::getCallsSent() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS);
+}
+inline void Method::Builder::setCallsSent( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Method::Reader::getErrorsReceived() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Method::Builder::getErrorsReceived() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+inline void Method::Builder::setErrorsReceived( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Method::Reader::getCallsReceived() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<4>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Method::Builder::getCallsReceived() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<4>() * ::capnp::ELEMENTS);
+}
+inline void Method::Builder::setCallsReceived( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<4>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Method::Reader::getErrorsReturned() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<5>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Method::Builder::getErrorsReturned() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<5>() * ::capnp::ELEMENTS);
+}
+inline void Method::Builder::setErrorsReturned( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<5>() * ::capnp::ELEMENTS, value);
+}
+
+inline bool Method::Reader::hasCallLatency() const {
+  return !_reader.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS).isNull();
+}
+inline bool Method::Builder::hasCallLatency() {
+  return !_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS).isNull();
+}
+inline  ::capnp::rpc::metrics::Histogram::Reader Method::Reader::getCallLatency() const {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::get(_reader.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+inline  ::capnp::rpc::metrics::Histogram::Builder Method::Builder::getCallLatency() {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::get(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+#if !CAPNP_LITE
+inline  ::capnp::rpc::metrics::Histogram::Pipeline Method::Pipeline::getCallLatency() {
+  return  ::capnp::rpc::metrics::Histogram::Pipeline(_typeless.getPointerField(0));
+}
+#endif  // !CAPNP_LITE
+inline void Method::Builder::setCallLatency( ::capnp::rpc::metrics::Histogram::Reader value) {
+  ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::set(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), value);
+}
+inline  ::capnp::rpc::metrics::Histogram::Builder Method::Builder::initCallLatency() {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::init(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+inline void Method::Builder::adoptCallLatency(
+    ::capnp::Orphan< ::capnp::rpc::metrics::Histogram>&& value) {
+  ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::adopt(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), kj::mv(value));
+}
+inline ::capnp::Orphan< ::capnp::rpc::metrics::Histogram> Method::Builder::disownCallLatency() {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::disown(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+
+inline bool Method::Reader::hasServiceLatency() const {
+  return !_reader.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS).isNull();
+}
+inline bool Method::Builder::hasServiceLatency() {
+  return !_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS).isNull();
+}
+inline  ::capnp::rpc::metrics::Histogram::Reader Method::Reader::getServiceLatency() const {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::get(_reader.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS));
+}
+inline  ::capnp::rpc::metrics::Histogram::Builder Method::Builder::getServiceLatency() {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::get(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS));
+}
+#if !CAPNP_LITE
+inline  ::capnp::rpc::metrics::Histogram::Pipeline Method::Pipeline::getServiceLatency() {
+  return  ::capnp::rpc::metrics::Histogram::Pipeline(_typeless.getPointerField(1));
+}
+#endif  // !CAPNP_LITE
+inline void Method::Builder::setServiceLatency( ::capnp::rpc::metrics::Histogram::Reader value) {
+  ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::set(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS), value);
+}
+inline  ::capnp::rpc::metrics::Histogram::Builder Method::Builder::initServiceLatency() {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::init(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS));
+}
+inline void Method::Builder::adoptServiceLatency(
+    ::capnp::Orphan< ::capnp::rpc::metrics::Histogram>&& value) {
+  ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::adopt(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS), kj::mv(value));
+}
+inline ::capnp::Orphan< ::capnp::rpc::metrics::Histogram> Method::Builder::disownServiceLatency() {
+  return ::capnp::_::PointerHelpers< ::capnp::rpc::metrics::Histogram>::disown(_builder.getPointerField(
+      ::capnp::bounded<1>() * ::capnp::POINTERS));
+}
+
+inline  ::uint64_t Histogram::Reader::getCount() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Builder::getCount() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Builder::setCount( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Histogram::Reader::getMinNanos() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Builder::getMinNanos() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Builder::setMinNanos( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Histogram::Reader::getMaxNanos() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Builder::getMaxNanos() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Builder::setMaxNanos( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<2>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Histogram::Reader::getMeanNanos() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Builder::getMeanNanos() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Builder::setMeanNanos( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Histogram::Reader::getP50Nanos() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<4>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Builder::getP50Nanos() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<4>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Builder::setP50Nanos( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<4>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Histogram::Reader::getP90Nanos() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<5>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Builder::getP90Nanos() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<5>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Builder::setP90Nanos( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<5>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Histogram::Reader::getP99Nanos() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<6>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Builder::getP99Nanos() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<6>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Builder::setP99Nanos( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<6>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Histogram::Reader::getP999Nanos() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<7>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Builder::getP999Nanos() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<7>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Builder::setP999Nanos( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<7>() * ::capnp::ELEMENTS, value);
+}
+
+inline bool Histogram::Reader::hasBuckets() const {
+  return !_reader.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS).isNull();
+}
+inline bool Histogram::Builder::hasBuckets() {
+  return !_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS).isNull();
+}
+inline  ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>::Reader Histogram::Reader::getBuckets() const {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>>::get(_reader.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+inline  ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>::Builder Histogram::Builder::getBuckets() {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>>::get(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+inline void Histogram::Builder::setBuckets( ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>::Reader value) {
+  ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>>::set(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), value);
+}
+inline  ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>::Builder Histogram::Builder::initBuckets(unsigned int size) {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>>::init(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), size);
+}
+inline void Histogram::Builder::adoptBuckets(
+    ::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>>&& value) {
+  ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>>::adopt(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS), kj::mv(value));
+}
+inline ::capnp::Orphan< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>> Histogram::Builder::disownBuckets() {
+  return ::capnp::_::PointerHelpers< ::capnp::List< ::capnp::rpc::metrics::Histogram::Bucket>>::disown(_builder.getPointerField(
+      ::capnp::bounded<0>() * ::capnp::POINTERS));
+}
+
+inline  ::uint64_t Histogram::Bucket::Reader::getLowerBoundNanos() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Bucket::Builder::getLowerBoundNanos() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Bucket::Builder::setLowerBoundNanos( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<0>() * ::capnp::ELEMENTS, value);
+}
+
+inline  ::uint64_t Histogram::Bucket::Reader::getCount() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Histogram::Bucket::Builder::getCount() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS);
+}
+inline void Histogram::Bucket::Builder::setCount( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<1>() * ::capnp::ELEMENTS, value);
+}
+
+}  // namespace
+}  // namespace
+}  // namespace
+
+#endif  // CAPNP_INCLUDED_9afbf671e192c608_
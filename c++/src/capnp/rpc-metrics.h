@@ -0,0 +1,155 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef CAPNP_RPC_METRICS_H_
+#define CAPNP_RPC_METRICS_H_
+
+#if defined(__GNUC__) && !defined(CAPNP_HEADER_WARNINGS)
+#pragma GCC system_header
+#endif
+
+#include "capability.h"
+#include <kj/time.h>
+#include <kj/vector.h>
+#include <capnp/rpc-metrics.capnp.h>
+#include <map>
+
+namespace capnp {
+
+class LatencyHistogram {
+  // A histogram of durations with logarithmically-sized buckets, in the style of HdrHistogram:
+  // each power-of-two range of nanoseconds is split into 8 buckets, so any value can be recovered
+  // to within 12.5%.  Recording is a few arithmetic operations and an increment; no allocation.
+
+public:
+  LatencyHistogram();
+
+  void record(kj::Duration duration);
+  // Adds a sample.  Negative durations count as zero.
+
+  uint64_t getCount() const { return count; }
+
+  kj::Duration getPercentile(double fraction) const;
+  // Returns a duration such that approximately `fraction` (0 to 1) of the samples are no longer
+  // than it.  Returns zero if there are no samples.
+
+  void writeTo(rpc::metrics::Histogram::Builder builder) const;
+
+private:
+  static constexpr uint SUB_BUCKET_BITS = 3;
+  static constexpr uint SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  static constexpr uint BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t min = kj::maxValue;
+  uint64_t max = 0;
+  uint64_t buckets[BUCKET_COUNT];
+
+  static uint bucketFor(uint64_t nanos);
+  static uint64_t lowerBound(uint bucket);
+  uint64_t percentileNanos(double fraction) const;
+};
+
+class RpcMetrics {
+  // Collects statistics about RPC traffic:  calls made and received per method along with their
+  // latency, the sizes of each connection's tables, and the bytes and messages passing over the
+  // network.  Attach it to any number of RpcSystems with `RpcSystem::setMetrics()` and to
+  // TwoPartyVatNetworks with `TwoPartyVatNetwork::setMetrics()`; it must outlive them.
+  //
+  // Like the rest of the RPC system, an RpcMetrics belongs to the thread that created it and must
+  // only be used there, which is what lets it record with plain (non-atomic) increments.  To
+  // collect statistics from several threads, give each thread its own RpcMetrics.
+  //
+  // Latencies are measured with the given timer, so they have the timer's resolution; for the
+  // event loop's timer, that means they include the time calls spend queued in the event loop.
+
+public:
+  explicit RpcMetrics(kj::Timer& timer);
+  KJ_DISALLOW_COPY(RpcMetrics);
+  ~RpcMetrics() noexcept(false);
+
+  struct MethodStats {
+    uint64_t callsSent = 0;
+    uint64_t errorsReceived = 0;
+    uint64_t callsReceived = 0;
+    uint64_t errorsReturned = 0;
+    LatencyHistogram callLatency;
+    LatencyHistogram serviceLatency;
+    // See `rpc::metrics::Method` for the meaning of each field.
+  };
+
+  struct TrafficStats {
+    uint64_t messagesSent = 0;
+    uint64_t messagesReceived = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+  };
+
+  struct TableSizes {
+    uint questions = 0;
+    uint answers = 0;
+    uint exports = 0;
+    uint imports = 0;
+  };
+
+  class TableSource {
+    // Implemented by the RPC system to report the sizes of its connections' tables on demand,
+    // which costs nothing until a snapshot is taken.
+
+  public:
+    virtual void getTableSizes(kj::Vector<TableSizes>& output) = 0;
+    // Appends one entry per open connection.
+  };
+
+  MethodStats& getMethodStats(uint64_t interfaceId, uint16_t methodId);
+  // Returns the statistics for the given method, creating them if they don't exist yet.  The
+  // reference remains valid for the lifetime of the RpcMetrics.
+
+  TrafficStats& getTrafficStats() { return traffic; }
+
+  kj::TimePoint now() { return timer.now(); }
+
+  void addTableSource(TableSource& source);
+  void removeTableSource(TableSource& source);
+
+  void getSnapshot(rpc::metrics::Snapshot::Builder builder);
+  // Writes out the statistics collected so far.
+
+  rpc::metrics::RpcMonitor::Client newMonitor();
+  // Returns a capability which serves snapshots of these statistics.  Once the RpcMetrics is
+  // destroyed, calls to the capability fail with DISCONNECTED.
+
+private:
+  class MonitorLink;
+  class MonitorImpl;
+
+  kj::Timer& timer;
+  std::map<std::pair<uint64_t, uint16_t>, MethodStats> methods;
+  TrafficStats traffic;
+  kj::Vector<TableSource*> tableSources;
+  kj::Own<MonitorLink> monitorLink;
+  // Shared with the capabilities returned by newMonitor().
+};
+
+}  // namespace capnp
+
+#endif  // CAPNP_RPC_METRICS_H_
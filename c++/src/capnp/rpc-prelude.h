@@ -36,6 +36,8 @@ namespace capnp {
 
 class OutgoingRpcMessage;
 class IncomingRpcMessage;
+class RpcMetrics;
+class RpcTracer;
 
 template <typename SturdyRefHostId>
 class RpcSystem;
@@ -95,6 +97,9 @@ private:
   Capability::Client baseBootstrap(AnyStruct::Reader vatId);
   Capability::Client baseRestore(AnyStruct::Reader vatId, AnyPointer::Reader objectId);
   void baseSetFlowLimit(size_t words);
+  void baseSetTimer(kj::Timer& timer);
+  void baseSetMetrics(RpcMetrics& metrics);
+  void baseSetTracer(RpcTracer& tracer);
 
   template <typename>
   friend class capnp::RpcSystem;
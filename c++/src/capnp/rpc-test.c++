@@ -641,6 +641,40 @@ TEST(Rpc, TailCall) {
   EXPECT_EQ(1, context.restorer.callCount);
 }
 
+TEST(Rpc, TailCallToLocalCapability) {
+  // Like TailCall, but the callee lives in the same vat as the caller, so the tail call is
+  // forwarded to a local call whose results are built directly in the caller's Return message.
+
+  TestContext context;
+
+  auto caller = context.connect(test::TestSturdyRefObjectId::Tag::TEST_TAIL_CALLER)
+      .castAs<test::TestTailCaller>();
+  auto callee = context.connect(test::TestSturdyRefObjectId::Tag::TEST_TAIL_CALLEE)
+      .castAs<test::TestTailCallee>();
+
+  auto request = caller.fooRequest();
+  request.setI(456);
+  request.setCallee(callee);
+
+  auto promise = request.send();
+
+  auto dependentCall0 = promise.getC().getCallSequenceRequest().send();
+
+  auto response = promise.wait(context.waitScope);
+  EXPECT_EQ(456, response.getI());
+  EXPECT_EQ("from TestTailCaller", response.getT());
+
+  auto dependentCall1 = promise.getC().getCallSequenceRequest().send();
+
+  auto dependentCall2 = response.getC().getCallSequenceRequest().send();
+
+  EXPECT_EQ(0, dependentCall0.wait(context.waitScope).getN());
+  EXPECT_EQ(1, dependentCall1.wait(context.waitScope).getN());
+  EXPECT_EQ(2, dependentCall2.wait(context.waitScope).getN());
+
+  EXPECT_EQ(2, context.restorer.callCount);
+}
+
 TEST(Rpc, Cancelation) {
   // Tests allowCancellation().
 
@@ -682,6 +716,83 @@ TEST(Rpc, Cancelation) {
   EXPECT_FALSE(returned);
 }
 
+TEST(Rpc, DeadlineCancelsCall) {
+  // The server cancels a call that allows cancellation once its deadline passes, and tells the
+  // client why.  The client's own timer is never advanced, so it's the server that gives up.
+
+  TestContext context;
+  kj::TimerImpl clientTimer(kj::origin<kj::TimePoint>());
+  kj::TimerImpl serverTimer(kj::origin<kj::TimePoint>());
+  context.rpcServer.setTimer(serverTimer);
+
+  auto paf = kj::newPromiseAndFulfiller<void>();
+  bool destroyed = false;
+  auto destructionPromise = paf.promise.then([&]() { destroyed = true; }).eagerlyEvaluate(nullptr);
+
+  auto client = context.connect(test::TestSturdyRefObjectId::Tag::TEST_MORE_STUFF)
+      .castAs<test::TestMoreStuff>();
+
+  auto request = client.expectCancelRequest();
+  request.setCap(kj::heap<TestCapDestructor>(kj::mv(paf.fulfiller)));
+  request.setTimeout(clientTimer, 10 * kj::SECONDS);
+  auto promise = request.send();
+
+  kj::evalLater([]() {}).wait(context.waitScope);
+  kj::evalLater([]() {}).wait(context.waitScope);
+  EXPECT_FALSE(destroyed);
+
+  serverTimer.advanceTo(serverTimer.now() + 10 * kj::SECONDS);
+
+  KJ_IF_MAYBE(e, kj::runCatchingExceptions([&]() { promise.wait(context.waitScope); })) {
+    EXPECT_EQ(kj::Exception::Type::OVERLOADED, e->getType());
+  } else {
+    ADD_FAILURE() << "Expected call to fail.";
+  }
+  destructionPromise.wait(context.waitScope);
+  EXPECT_TRUE(destroyed);
+}
+
+TEST(Rpc, DeadlineOnClient) {
+  // Without a timer, the server ignores the deadline, but the client still gives up.
+
+  TestContext context;
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+
+  auto client = context.connect(test::TestSturdyRefObjectId::Tag::TEST_MORE_STUFF)
+      .castAs<test::TestMoreStuff>();
+
+  {
+    auto request = client.neverReturnRequest();
+    request.setCap(kj::heap<TestInterfaceImpl>(context.restorer.callCount));
+    request.setTimeout(timer, 10 * kj::SECONDS);
+    auto promise = request.send();
+
+    kj::evalLater([]() {}).wait(context.waitScope);
+    timer.advanceTo(timer.now() + 10 * kj::SECONDS);
+
+    KJ_IF_MAYBE(e, kj::runCatchingExceptions([&]() { promise.wait(context.waitScope); })) {
+      EXPECT_EQ(kj::Exception::Type::OVERLOADED, e->getType());
+    } else {
+      ADD_FAILURE() << "Expected call to fail.";
+    }
+  }
+
+  {
+    // A call that is already out of time isn't sent at all.
+    int callCountBefore = context.restorer.callCount;
+    auto request = client.getCallSequenceRequest();
+    request.setTimeout(timer, 0 * kj::SECONDS);
+    KJ_IF_MAYBE(e, kj::runCatchingExceptions([&]() {
+      request.send().wait(context.waitScope);
+    })) {
+      EXPECT_EQ(kj::Exception::Type::OVERLOADED, e->getType());
+    } else {
+      ADD_FAILURE() << "Expected call to fail.";
+    }
+    EXPECT_EQ(callCountBefore, context.restorer.callCount);
+  }
+}
+
 TEST(Rpc, PromiseResolve) {
   TestContext context;
 
@@ -862,6 +973,40 @@ RemotePromise<test::TestCallOrder::GetCallSequenceResults> getCallSequence(
   return req.send();
 }
 
+TEST(Rpc, RepeatedPipelinedCalls) {
+  // Many pipelined calls on the same path should share one capability and arrive in order, even
+  // though the pipeline resolves partway through.
+
+  TestContext context;
+
+  auto callee = context.connect(test::TestSturdyRefObjectId::Tag::TEST_TAIL_CALLEE)
+      .castAs<test::TestTailCallee>();
+
+  auto request = callee.fooRequest();
+  request.setI(123);
+  auto promise = request.send();
+
+  auto firstHook = ClientHook::from(promise.getC());
+  EXPECT_EQ(firstHook.get(), ClientHook::from(promise.getC()).get());
+
+  kj::Vector<RemotePromise<test::TestCallOrder::GetCallSequenceResults>> calls;
+  for (uint i = 0; i < 50; i++) {
+    auto cap = promise.getC();
+    calls.add(getCallSequence(cap, i));
+  }
+
+  promise.wait(context.waitScope);
+
+  for (uint i = 50; i < 100; i++) {
+    auto cap = promise.getC();
+    calls.add(getCallSequence(cap, i));
+  }
+
+  for (uint i = 0; i < calls.size(); i++) {
+    EXPECT_EQ(i, calls[i].wait(context.waitScope).getN());
+  }
+}
+
 TEST(Rpc, Embargo) {
   TestContext context;
 
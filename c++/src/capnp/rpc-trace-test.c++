@@ -0,0 +1,219 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "rpc-trace.h"
+#include "rpc-twoparty.h"
+#include "test-util.h"
+#include <kj/debug.h>
+#include <kj/test.h>
+#include <string.h>
+
+namespace capnp {
+namespace _ {  // private
+namespace {
+
+class ForwardingImpl final: public test::TestInterface::Server {
+  // Passes foo() on to another TestInterface, as a child of the incoming call.
+
+public:
+  ForwardingImpl(test::TestInterface::Client next): next(kj::mv(next)) {}
+
+protected:
+  kj::Promise<void> foo(FooContext context) override {
+    auto request = next.fooRequest();
+    request.setI(context.getParams().getI());
+    request.setJ(context.getParams().getJ());
+    request.setTraceParent(context.getTraceContext());
+    return request.send().then([context](auto&& response) mutable {
+      context.getResults().setX(response.getX());
+    });
+  }
+
+private:
+  test::TestInterface::Client next;
+};
+
+struct Vat {
+  // One end of a two-party connection, with its own RpcSystem.
+
+  TwoPartyVatNetwork network;
+  RpcSystem<rpc::twoparty::VatId> rpcSystem;
+
+  Vat(kj::AsyncIoStream& stream, Capability::Client bootstrap, RpcTracer& tracer)
+      : network(stream, rpc::twoparty::Side::SERVER),
+        rpcSystem(makeRpcServer(network, kj::mv(bootstrap))) {
+    rpcSystem.setTracer(tracer);
+  }
+
+  Vat(kj::AsyncIoStream& stream, RpcTracer& tracer)
+      : network(stream, rpc::twoparty::Side::CLIENT),
+        rpcSystem(makeRpcClient(network)) {
+    rpcSystem.setTracer(tracer);
+  }
+
+  test::TestInterface::Client connect() {
+    MallocMessageBuilder vatIdMessage(8);
+    auto vatId = vatIdMessage.initRoot<rpc::twoparty::VatId>();
+    vatId.setSide(rpc::twoparty::Side::SERVER);
+    return rpcSystem.bootstrap(vatId).castAs<test::TestInterface>();
+  }
+};
+
+kj::Vector<RpcTracer::Event> eventsOf(const RpcTraceCollector::SpanRecord& span) {
+  kj::Vector<RpcTracer::Event> result;
+  for (auto& event: span.events) {
+    result.add(event.event);
+  }
+  return result;
+}
+
+KJ_TEST("RpcTracer follows a call through a chain of vats") {
+  // Vat A calls vat B, which forwards the call to vat C.
+
+  auto ioContext = kj::setupAsyncIo();
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+  RpcTraceCollector tracerA(timer, 1);
+  RpcTraceCollector tracerB(timer, 2);
+  RpcTraceCollector tracerC(timer, 3);
+
+  auto pipeAB = ioContext.provider->newTwoWayPipe();
+  auto pipeBC = ioContext.provider->newTwoWayPipe();
+
+  int callCount = 0;
+  {
+    Vat c(*pipeBC.ends[0], kj::heap<TestInterfaceImpl>(callCount), tracerC);
+    Vat bToC(*pipeBC.ends[1], tracerB);
+    Vat b(*pipeAB.ends[0], kj::heap<ForwardingImpl>(bToC.connect()), tracerB);
+    Vat a(*pipeAB.ends[1], tracerA);
+
+    {
+      auto request = a.connect().fooRequest();
+      request.setI(123);
+      request.setJ(true);
+      auto response = request.send().wait(ioContext.waitScope);
+      KJ_EXPECT(response.getX() == "foo");
+      KJ_EXPECT(callCount == 1);
+    }
+
+    // Let the Finish messages arrive.
+    ioContext.provider->getTimer().afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+  }
+
+  // Bootstrap messages aren't calls, so each vat should see exactly the calls it made and served.
+  KJ_ASSERT(tracerA.getSpans().size() == 1);
+  KJ_ASSERT(tracerB.getSpans().size() == 2);
+  KJ_ASSERT(tracerC.getSpans().size() == 1);
+
+  auto& aOut = tracerA.getSpans()[0];
+  auto& bIn = tracerB.getSpans()[0].incoming ? tracerB.getSpans()[0] : tracerB.getSpans()[1];
+  auto& bOut = tracerB.getSpans()[0].incoming ? tracerB.getSpans()[1] : tracerB.getSpans()[0];
+  auto& cIn = tracerC.getSpans()[0];
+
+  KJ_EXPECT(!aOut.incoming);
+  KJ_EXPECT(bIn.incoming);
+  KJ_EXPECT(!bOut.incoming);
+  KJ_EXPECT(cIn.incoming);
+
+  KJ_EXPECT(aOut.interfaceId == typeId<test::TestInterface>());
+  KJ_EXPECT(aOut.methodId == 0);
+
+  // A's span starts the trace, and the rest hang off of it in turn.
+  KJ_EXPECT(aOut.parentId == 0);
+  KJ_EXPECT(aOut.traceId == aOut.spanId);
+  KJ_EXPECT(bIn.parentId == aOut.spanId);
+  KJ_EXPECT(bOut.parentId == bIn.spanId);
+  KJ_EXPECT(cIn.parentId == bOut.spanId);
+  for (auto span: {&bIn, &bOut, &cIn}) {
+    KJ_EXPECT(span->traceId == aOut.traceId);
+  }
+
+  // Span IDs are prefixed with the process ID, so they don't collide across vats.
+  KJ_EXPECT(aOut.spanId >> 32 == 1);
+  KJ_EXPECT(bIn.spanId >> 32 == 2);
+  KJ_EXPECT(cIn.spanId >> 32 == 3);
+
+  using E = RpcTracer::Event;
+  auto aEvents = eventsOf(aOut);
+  KJ_EXPECT(aEvents.asPtr() == kj::ArrayPtr<const E>({E::SEND, E::RETURN, E::FINISH}));
+  auto bEvents = eventsOf(bIn);
+  KJ_EXPECT(bEvents.asPtr() == kj::ArrayPtr<const E>({E::DISPATCH, E::RETURN, E::FINISH}));
+  auto cEvents = eventsOf(cIn);
+  KJ_EXPECT(cEvents.asPtr() == kj::ArrayPtr<const E>({E::DISPATCH, E::RETURN, E::FINISH}));
+
+  auto json = tracerB.toChromeJson();
+  KJ_EXPECT(json.startsWith("{\"traceEvents\":["), json);
+  KJ_EXPECT(json.endsWith("]}\n"), json);
+  KJ_EXPECT(strstr(json.cStr(), kj::str("\"id\":\"0x", kj::hex(bIn.spanId), "\"").cStr()) !=
+            nullptr, json);
+  KJ_EXPECT(strstr(json.cStr(), kj::str("\"parentId\":\"0x", kj::hex(aOut.spanId), "\"").cStr())
+            != nullptr, json);
+  KJ_EXPECT(strstr(json.cStr(), "\"event\":\"dispatch\"") != nullptr, json);
+
+  tracerB.clear();
+  KJ_EXPECT(tracerB.getSpans().size() == 0);
+  KJ_EXPECT(tracerB.toChromeJson() == "{\"traceEvents\":[\n\n]}\n");
+}
+
+KJ_TEST("RpcTracer ignores trace contexts it doesn't recognize") {
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+  RpcTraceCollector tracer(timer, 7);
+
+  {
+    const byte junk[3] = {1, 2, 3};
+    auto span = tracer.newIncomingSpan(123, 4, junk);
+    KJ_EXPECT(span->getContext().size() == 16);
+    timer.advanceTo(timer.now() + 1500 * kj::NANOSECONDS);
+  }
+
+  KJ_ASSERT(tracer.getSpans().size() == 1);
+  auto& span = tracer.getSpans()[0];
+  KJ_EXPECT(span.parentId == 0);
+  KJ_EXPECT(span.traceId == span.spanId);
+  KJ_EXPECT(span.end - span.start == 1500 * kj::NANOSECONDS);
+
+  auto json = tracer.toChromeJson();
+  KJ_EXPECT(strstr(json.cStr(), "\"ph\":\"e\",\"ts\":1.500") != nullptr, json);
+}
+
+KJ_TEST("RpcTraceCollector keeps only the newest spans") {
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+  RpcTraceCollector tracer(timer, 1, 3);
+
+  for (uint16_t i = 0; i < 5; i++) {
+    tracer.newOutgoingSpan(123, i, nullptr);
+  }
+
+  KJ_EXPECT(tracer.getDroppedSpans() == 2);
+  auto spans = tracer.getSpans();
+  KJ_ASSERT(spans.size() == 3);
+  KJ_EXPECT(spans[0].methodId == 2);
+  KJ_EXPECT(spans[1].methodId == 3);
+  KJ_EXPECT(spans[2].methodId == 4);
+
+  tracer.newOutgoingSpan(123, 5, nullptr);
+  KJ_EXPECT(tracer.getDroppedSpans() == 3);
+  KJ_EXPECT(tracer.getSpans()[0].methodId == 3);
+  KJ_EXPECT(tracer.getSpans()[2].methodId == 5);
+}
+
+}  // namespace
+}  // namespace _ (private)
+}  // namespace capnp
@@ -0,0 +1,183 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "rpc-trace.h"
+#include <kj/debug.h>
+#include <algorithm>
+
+namespace capnp {
+
+RpcTracer::Span::~Span() noexcept(false) {}
+
+// =======================================================================================
+
+namespace {
+
+constexpr size_t CONTEXT_SIZE = 16;
+
+void writeId(byte* out, uint64_t id) {
+  for (uint i = 0; i < 8; i++) {
+    out[i] = id >> (i * 8);
+  }
+}
+
+uint64_t readId(const byte* in) {
+  uint64_t result = 0;
+  for (uint i = 0; i < 8; i++) {
+    result |= uint64_t(in[i]) << (i * 8);
+  }
+  return result;
+}
+
+kj::StringPtr eventName(RpcTracer::Event event) {
+  switch (event) {
+    case RpcTracer::Event::SEND: return "send";
+    case RpcTracer::Event::DISPATCH: return "dispatch";
+    case RpcTracer::Event::RETURN: return "return";
+    case RpcTracer::Event::FINISH: return "finish";
+  }
+  KJ_UNREACHABLE;
+}
+
+kj::String timestamp(kj::TimePoint time) {
+  // Chrome wants microseconds.
+  int64_t nanos = (time - kj::origin<kj::TimePoint>()) / kj::NANOSECONDS;
+  auto fraction = kj::str(1000 + nanos % 1000);
+  return kj::str(nanos / 1000, '.', fraction.slice(1));
+}
+
+}  // namespace
+
+class RpcTraceCollector::SpanImpl final: public RpcTracer::Span {
+public:
+  SpanImpl(RpcTraceCollector& collector, SpanRecord&& dataParam)
+      : collector(collector), data(kj::mv(dataParam)) {
+    writeId(context, data.traceId);
+    writeId(context + 8, data.spanId);
+    ++collector.openSpans;
+  }
+
+  ~SpanImpl() noexcept(false) {
+    data.end = collector.timer.now();
+    collector.addSpan(kj::mv(data));
+    --collector.openSpans;
+  }
+
+  void record(Event event) override {
+    data.events.add(EventRecord { event, collector.timer.now() });
+  }
+
+  kj::ArrayPtr<const byte> getContext() override {
+    return context;
+  }
+
+private:
+  RpcTraceCollector& collector;
+  SpanRecord data;
+  byte context[CONTEXT_SIZE];
+};
+
+RpcTraceCollector::RpcTraceCollector(kj::Timer& timer, uint32_t processId, size_t maxSpans)
+    : timer(timer), processId(processId), nextId(uint64_t(processId) << 32),
+      maxSpans(maxSpans) {}
+
+RpcTraceCollector::~RpcTraceCollector() noexcept(false) {
+  KJ_REQUIRE(openSpans == 0, "RpcTraceCollector destroyed while RpcSystems still report to it") {
+    break;
+  }
+}
+
+void RpcTraceCollector::addSpan(SpanRecord&& span) {
+  if (spans.size() < maxSpans) {
+    spans.add(kj::mv(span));
+  } else {
+    ++droppedSpans;
+    if (maxSpans > 0) {
+      spans[oldest] = kj::mv(span);
+      oldest = (oldest + 1) % maxSpans;
+    }
+  }
+}
+
+kj::ArrayPtr<const RpcTraceCollector::SpanRecord> RpcTraceCollector::getSpans() {
+  if (oldest != 0) {
+    std::rotate(spans.begin(), spans.begin() + oldest, spans.end());
+    oldest = 0;
+  }
+  return spans.asPtr();
+}
+
+kj::Own<RpcTracer::Span> RpcTraceCollector::newOutgoingSpan(
+    uint64_t interfaceId, uint16_t methodId, kj::ArrayPtr<const byte> parent) {
+  return newSpan(false, interfaceId, methodId, parent);
+}
+
+kj::Own<RpcTracer::Span> RpcTraceCollector::newIncomingSpan(
+    uint64_t interfaceId, uint16_t methodId, kj::ArrayPtr<const byte> parent) {
+  return newSpan(true, interfaceId, methodId, parent);
+}
+
+kj::Own<RpcTracer::Span> RpcTraceCollector::newSpan(
+    bool incoming, uint64_t interfaceId, uint16_t methodId, kj::ArrayPtr<const byte> parent) {
+  SpanRecord record;
+  record.incoming = incoming;
+  record.interfaceId = interfaceId;
+  record.methodId = methodId;
+  record.spanId = ++nextId;
+  if (parent.size() == CONTEXT_SIZE) {
+    record.traceId = readId(parent.begin());
+    record.parentId = readId(parent.begin() + 8);
+  } else {
+    // No parent, or one from some other kind of tracer.  Start a new trace.
+    record.traceId = record.spanId;
+    record.parentId = 0;
+  }
+  record.start = timer.now();
+  record.end = record.start;
+  return kj::heap<SpanImpl>(*this, kj::mv(record));
+}
+
+kj::String RpcTraceCollector::toChromeJson() {
+  kj::Vector<kj::String> events(spans.size() * 4);
+
+  for (auto& span: getSpans()) {
+    auto common = kj::str(
+        "\"name\":\"", kj::hex(span.interfaceId), '.', span.methodId, "\","
+        "\"cat\":\"rpc\",\"id\":\"0x", kj::hex(span.spanId), "\","
+        "\"pid\":", processId, ",\"tid\":0");
+
+    events.add(kj::str(
+        "{", common, ",\"ph\":\"b\",\"ts\":", timestamp(span.start), ",\"args\":{"
+        "\"side\":\"", span.incoming ? "callee" : "caller", "\","
+        "\"traceId\":\"0x", kj::hex(span.traceId), "\","
+        "\"parentId\":\"0x", kj::hex(span.parentId), "\"}}"));
+    for (auto& event: span.events) {
+      events.add(kj::str(
+          "{", common, ",\"ph\":\"n\",\"ts\":", timestamp(event.time), ","
+          "\"args\":{\"event\":\"", eventName(event.event), "\"}}"));
+    }
+    events.add(kj::str("{", common, ",\"ph\":\"e\",\"ts\":", timestamp(span.end), "}"));
+  }
+
+  return kj::str("{\"traceEvents\":[\n", kj::strArray(events, ",\n"), "\n]}\n");
+}
+
+}  // namespace capnp
@@ -0,0 +1,181 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef CAPNP_RPC_TRACE_H_
+#define CAPNP_RPC_TRACE_H_
+
+#if defined(__GNUC__) && !defined(CAPNP_HEADER_WARNINGS)
+#pragma GCC system_header
+#endif
+
+#include "common.h"
+#include <kj/memory.h>
+#include <kj/string.h>
+#include <kj/time.h>
+#include <kj/vector.h>
+
+namespace capnp {
+
+class RpcTracer {
+  // Hooks through which an RpcSystem reports the progress of each call it sends or receives, for
+  // the purpose of distributed tracing.  Install one with `RpcSystem::setTracer()`.  When no tracer
+  // is installed, each hook costs the RPC system a single null check.
+  //
+  // Each call is followed by a span on each side of the connection.  The caller's span passes an
+  // opaque context to the callee in `Call.traceContext`, so that the callee's span -- and any calls
+  // made on its behalf (see `Request::setTraceParent()`) -- can be linked to it, and so on through
+  // a chain of vats.
+
+public:
+  enum class Event: uint8_t {
+    SEND,
+    // Caller:  the `Call` message was sent.
+
+    DISPATCH,
+    // Callee:  the call was delivered to its target.
+
+    RETURN,
+    // Caller:  the `Return` message was received.  Callee:  the `Return` message was sent.
+
+    FINISH
+    // Caller:  the `Finish` message was sent.  Callee:  the `Finish` message was received.
+  };
+
+  class Span {
+    // One side of one call.  The RPC system destroys the span once it is done with the call, which
+    // ends the span:  for the caller, that's when the question is removed from the question
+    // table; for the callee, when the answer is removed from the answer table.  Either way, that's
+    // after both `Return` and `Finish`, or when the connection is torn down.
+
+  public:
+    virtual ~Span() noexcept(false);
+
+    virtual void record(Event event) = 0;
+    // Reports that `event` just happened to the call.
+
+    virtual kj::ArrayPtr<const byte> getContext() = 0;
+    // Returns the context identifying this span to its children:  for the caller, the value to
+    // send in `Call.traceContext`; for the callee, the value that `CallContext::getTraceContext()`
+    // returns, so that calls made on behalf of this one are linked to it.  The RPC system copies
+    // it where needed, so it only has to remain valid as long as the span does.
+  };
+
+  virtual kj::Own<Span> newOutgoingSpan(uint64_t interfaceId, uint16_t methodId,
+                                        kj::ArrayPtr<const byte> parent) = 0;
+  // Called when a question is created for an outgoing call.  `parent` is the context passed to
+  // `Request::setTraceParent()`, or empty if there is none.
+
+  virtual kj::Own<Span> newIncomingSpan(uint64_t interfaceId, uint16_t methodId,
+                                        kj::ArrayPtr<const byte> parent) = 0;
+  // Called when a `Call` message is received.  `parent` is the call's `traceContext`, as written
+  // by the caller's tracer (which may not be of the same type as this one, so be prepared for
+  // anything).
+};
+
+class RpcTraceCollector final: public RpcTracer {
+  // An RpcTracer which keeps spans in memory and can export them in the Chrome trace event format
+  // (load the JSON into chrome://tracing or Perfetto), so that the spans collected from each vat
+  // along a chain of calls can be merged and viewed together.
+  //
+  // Spans are identified by 64-bit IDs, and each call's trace context is its trace ID followed by
+  // its span ID (16 bytes, little-endian).  IDs are allocated sequentially starting from
+  // `processId << 32`, so they are unique across vats as long as each vat's collector has a
+  // distinct `processId`.
+  //
+  // The collector keeps at most `maxSpans` ended spans.  Once it has that many, each span that
+  // ends replaces the oldest one, and is counted by `getDroppedSpans()`.
+  //
+  // Like the RpcSystem, the collector belongs to the thread that created it.  It must outlive the
+  // RpcSystems which report to it.
+
+public:
+  RpcTraceCollector(kj::Timer& timer, uint32_t processId = 1, size_t maxSpans = 65536);
+  KJ_DISALLOW_COPY(RpcTraceCollector);
+  ~RpcTraceCollector() noexcept(false);
+
+  struct EventRecord {
+    Event event;
+    kj::TimePoint time;
+  };
+
+  struct SpanRecord {
+    bool incoming;
+    // True if this is the callee's side of the call.
+
+    uint64_t interfaceId;
+    uint16_t methodId;
+
+    uint64_t traceId;
+    uint64_t spanId;
+    uint64_t parentId;
+    // `parentId` is zero for spans with no (recognized) parent, which start new traces.
+
+    kj::TimePoint start = kj::origin<kj::TimePoint>();
+    kj::TimePoint end = kj::origin<kj::TimePoint>();
+    kj::Vector<EventRecord> events;
+  };
+
+  kj::ArrayPtr<const SpanRecord> getSpans();
+  // Returns the spans which have ended so far, in the order they ended, less any which were
+  // dropped to make room for newer ones.
+
+  uint64_t getDroppedSpans() { return droppedSpans; }
+  // Returns how many spans have been dropped since the collector was created because more than
+  // `maxSpans` had ended.
+
+  void clear() { spans.clear(); oldest = 0; }
+  // Discards the spans which have ended so far.
+
+  kj::String toChromeJson();
+  // Formats the spans which have ended so far as a Chrome trace event JSON document.  Each span
+  // becomes an async event named "<interface ID>.<method ID>", with its events as instants and its
+  // trace, span, and parent IDs as arguments.  Timestamps are those of the timer passed to the
+  // constructor.
+
+  kj::Own<Span> newOutgoingSpan(uint64_t interfaceId, uint16_t methodId,
+                                kj::ArrayPtr<const byte> parent) override;
+  kj::Own<Span> newIncomingSpan(uint64_t interfaceId, uint16_t methodId,
+                                kj::ArrayPtr<const byte> parent) override;
+
+private:
+  class SpanImpl;
+
+  kj::Timer& timer;
+  uint32_t processId;
+  uint64_t nextId;
+  uint openSpans = 0;
+  size_t maxSpans;
+  uint64_t droppedSpans = 0;
+
+  kj::Vector<SpanRecord> spans;
+  size_t oldest = 0;
+  // Once `spans` is full, it's used as a ring buffer, and `oldest` is the index of the oldest span.
+  // getSpans() puts it back in order.
+
+  void addSpan(SpanRecord&& span);
+
+  kj::Own<Span> newSpan(bool incoming, uint64_t interfaceId, uint16_t methodId,
+                        kj::ArrayPtr<const byte> parent);
+};
+
+}  // namespace capnp
+
+#endif  // CAPNP_RPC_TRACE_H_
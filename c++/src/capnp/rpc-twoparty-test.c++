@@ -20,11 +20,13 @@
 // THE SOFTWARE.
 
 #include "rpc-twoparty.h"
+#include "membrane.h"
 #include "test-util.h"
 #include <capnp/rpc.capnp.h>
 #include <kj/debug.h>
 #include <kj/thread.h>
 #include <kj/compat/gtest.h>
+#include <algorithm>
 
 // TODO(cleanup): Auto-generate stringification functions for union discriminants.
 namespace capnp {
@@ -417,6 +419,604 @@ TEST(TwoPartyNetwork, BootstrapFactory) {
   EXPECT_TRUE(bootstrapFactory.called);
 }
 
+class TestLargeParamsImpl final: public test::TestMoreStuff::Server {
+  // Checks that `a` was filled in by fillLargeText() and calls `b.foo()`.
+
+protected:
+  kj::Promise<void> methodWithNullDefault(MethodWithNullDefaultContext context) override {
+    auto params = context.getParams();
+    auto a = params.getA();
+    for (auto i: kj::indices(a)) {
+      KJ_ASSERT(a[i] == 'a' + i % 26, i);
+    }
+
+    auto req = params.getB().fooRequest();
+    req.setI(123);
+    req.setJ(true);
+    return req.send().then([](Response<test::TestInterface::FooResults>&& response) {
+      EXPECT_EQ("foo", response.getX());
+    });
+  }
+};
+
+void fillLargeText(Text::Builder text) {
+  for (auto i: kj::indices(text)) {
+    text[i] = 'a' + i % 26;
+  }
+}
+
+class PassThroughPolicy final: public MembranePolicy, public kj::Refcounted {
+public:
+  kj::Maybe<Capability::Client> inboundCall(uint64_t interfaceId, uint16_t methodId,
+                                            Capability::Client target) override {
+    return nullptr;
+  }
+  kj::Maybe<Capability::Client> outboundCall(uint64_t interfaceId, uint16_t methodId,
+                                             Capability::Client target) override {
+    return nullptr;
+  }
+  kj::Own<MembranePolicy> addRef() override {
+    return kj::addRef(*this);
+  }
+};
+
+void testProxiedCalls(bool useMembrane) {
+  // Client -> proxy -> backend, where the proxy's bootstrap is just the backend's bootstrap.
+  // Calls whose params are large enough are forwarded by the proxy without copying them.
+
+  auto ioContext = kj::setupAsyncIo();
+  int callCount = 0;
+
+  auto backendPipe = ioContext.provider->newTwoWayPipe();
+  auto frontendPipe = ioContext.provider->newTwoWayPipe();
+
+  TwoPartyClient backend(*backendPipe.ends[1], kj::heap<TestLargeParamsImpl>(),
+                         rpc::twoparty::Side::SERVER);
+  TwoPartyClient proxyToBackend(*backendPipe.ends[0]);
+  Capability::Client proxied = proxyToBackend.bootstrap();
+  if (useMembrane) {
+    proxied = membrane(kj::mv(proxied), kj::refcounted<PassThroughPolicy>());
+  }
+  TwoPartyClient proxy(*frontendPipe.ends[0], kj::mv(proxied), rpc::twoparty::Side::SERVER);
+  TwoPartyClient client(*frontendPipe.ends[1]);
+
+  auto cap = client.bootstrap().castAs<test::TestMoreStuff>();
+
+  for (uint size: {16u, 100000u, 3000000u}) {
+    auto req = cap.methodWithNullDefaultRequest();
+    fillLargeText(req.initA(size));
+    req.setB(kj::heap<TestInterfaceImpl>(callCount));
+    req.send().wait(ioContext.waitScope);
+  }
+
+  EXPECT_EQ(3, callCount);
+
+  // Several large calls in flight at once, interleaved on the wire with small ones.
+  kj::Vector<kj::Promise<void>> promises;
+  for (uint i = 0; i < 8; i++) {
+    auto req = cap.methodWithNullDefaultRequest();
+    fillLargeText(req.initA(i % 2 == 0 ? 50000 : 10));
+    req.setB(kj::heap<TestInterfaceImpl>(callCount));
+    promises.add(req.send().ignoreResult());
+  }
+  kj::joinPromises(promises.releaseAsArray()).wait(ioContext.waitScope);
+
+  EXPECT_EQ(11, callCount);
+}
+
+TEST(TwoPartyNetwork, ProxyForwardsLargeParams) {
+  testProxiedCalls(false);
+}
+
+TEST(TwoPartyNetwork, ProxyForwardsLargeParamsThroughMembrane) {
+  testProxiedCalls(true);
+}
+
+class RecordingStream final: public kj::AsyncIoStream {
+  // Keeps a copy of everything written to the wrapped stream.
+
+public:
+  explicit RecordingStream(kj::AsyncIoStream& inner): inner(inner) {}
+
+  kj::Vector<byte> written;
+
+  kj::Promise<size_t> tryRead(void* buffer, size_t minBytes, size_t maxBytes) override {
+    return inner.tryRead(buffer, minBytes, maxBytes);
+  }
+  kj::Promise<void> write(const void* buffer, size_t size) override {
+    written.addAll(reinterpret_cast<const byte*>(buffer),
+                   reinterpret_cast<const byte*>(buffer) + size);
+    return inner.write(buffer, size);
+  }
+  kj::Promise<void> write(kj::ArrayPtr<const kj::ArrayPtr<const byte>> pieces) override {
+    for (auto& piece: pieces) {
+      written.addAll(piece);
+    }
+    return inner.write(pieces);
+  }
+  void shutdownWrite() override {
+    inner.shutdownWrite();
+  }
+
+private:
+  kj::AsyncIoStream& inner;
+};
+
+TEST(TwoPartyNetwork, ProxyForwardsOnlyParams) {
+  // When the proxy forwards a call without copying its params, nothing else from the message the
+  // call arrived in -- in particular the client's Call header -- reaches the backend.  The backend
+  // should see the interface ID exactly once, in the proxy's own header.
+
+  auto ioContext = kj::setupAsyncIo();
+  int callCount = 0;
+
+  auto backendPipe = ioContext.provider->newTwoWayPipe();
+  auto frontendPipe = ioContext.provider->newTwoWayPipe();
+
+  TwoPartyClient backend(*backendPipe.ends[1], kj::heap<TestLargeParamsImpl>(),
+                         rpc::twoparty::Side::SERVER);
+  RecordingStream recorder(*backendPipe.ends[0]);
+  TwoPartyClient proxyToBackend(recorder);
+  TwoPartyClient proxy(*frontendPipe.ends[0], proxyToBackend.bootstrap(),
+                       rpc::twoparty::Side::SERVER);
+  TwoPartyClient client(*frontendPipe.ends[1]);
+
+  auto cap = client.bootstrap().castAs<test::TestMoreStuff>();
+  auto req = cap.methodWithNullDefaultRequest();
+  fillLargeText(req.initA(100000));
+  req.setB(kj::heap<TestInterfaceImpl>(callCount));
+  req.send().wait(ioContext.waitScope);
+  EXPECT_EQ(1, callCount);
+
+  _::WireValue<uint64_t> interfaceId;
+  interfaceId.set(typeId<test::TestMoreStuff>());
+  auto needle = kj::arrayPtr(&interfaceId, 1).asBytes();
+  auto written = recorder.written.asPtr();
+  EXPECT_GT(written.size(), 100000);
+
+  uint occurrences = 0;
+  for (auto pos = written.begin();
+       (pos = std::search(pos, written.end(), needle.begin(), needle.end())) != written.end();
+       ++pos) {
+    ++occurrences;
+  }
+  EXPECT_EQ(1, occurrences);
+}
+
+class TestCompressibleParamsImpl final: public test::TestInterface::Server {
+  // Checks the list filled in by testCompression().
+
+public:
+  int callCount = 0;
+
+protected:
+  kj::Promise<void> baz(BazContext context) override {
+    auto list = context.getParams().getS().getInt64List();
+    for (auto i: kj::indices(list)) {
+      KJ_ASSERT(list[i] == i % 7, i);
+    }
+    ++callCount;
+    return kj::READY_NOW;
+  }
+};
+
+void testCompression(bool clientCompresses, bool serverCompresses) {
+  auto ioContext = kj::setupAsyncIo();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+
+  TwoPartyCompressionOptions clientOptions;
+  clientOptions.enabled = clientCompresses;
+  TwoPartyCompressionOptions serverOptions;
+  serverOptions.enabled = serverCompresses;
+
+  auto serverImpl = kj::heap<TestCompressibleParamsImpl>();
+  auto& server = *serverImpl;
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[0], rpc::twoparty::Side::SERVER,
+                                   ReaderOptions(), serverOptions);
+  auto rpcServer = makeRpcServer(serverNetwork, kj::mv(serverImpl));
+
+  TwoPartyVatNetwork clientNetwork(*pipe.ends[1], rpc::twoparty::Side::CLIENT,
+                                   ReaderOptions(), clientOptions);
+  auto rpcClient = makeRpcClient(clientNetwork);
+
+  MallocMessageBuilder vatIdMessage(8);
+  auto vatId = vatIdMessage.initRoot<rpc::twoparty::VatId>();
+  vatId.setSide(rpc::twoparty::Side::SERVER);
+  auto cap = rpcClient.bootstrap(vatId).castAs<test::TestInterface>();
+
+  for (uint size: {4u, 10000u, 10000u}) {
+    auto req = cap.bazRequest();
+    auto list = req.initS().initInt64List(size);
+    for (auto i: kj::indices(list)) {
+      list.set(i, i % 7);
+    }
+    req.send().wait(ioContext.waitScope);
+  }
+  EXPECT_EQ(3, server.callCount);
+
+  auto& sent = clientNetwork.getCompressionStats();
+  auto& received = serverNetwork.getCompressionStats();
+  if (clientCompresses && serverCompresses) {
+    // The first call may have been sent before the server's announcement arrived, but by the time
+    // its response came back, the announcement had.  Small calls are never compressed.
+    EXPECT_GE(sent.uncompressedBytesSent, 10000 * sizeof(word));
+    EXPECT_LT(sent.compressedBytesSent * 2, sent.uncompressedBytesSent);
+  } else {
+    EXPECT_EQ(0, sent.uncompressedBytesSent);
+    EXPECT_EQ(0, sent.compressedBytesSent);
+  }
+  EXPECT_EQ(sent.uncompressedBytesSent, received.uncompressedBytesReceived);
+  EXPECT_EQ(sent.compressedBytesSent, received.compressedBytesReceived);
+}
+
+TEST(TwoPartyNetwork, Compression) {
+  testCompression(true, true);
+}
+
+TEST(TwoPartyNetwork, CompressionNotNegotiated) {
+  testCompression(true, false);
+  testCompression(false, true);
+}
+
+class TestDeadlineImpl final: public test::TestInterface::Server {
+public:
+  kj::Maybe<kj::TimePoint> deadline;
+
+protected:
+  kj::Promise<void> foo(FooContext context) override {
+    deadline = context.getDeadline();
+    return kj::READY_NOW;
+  }
+};
+
+TEST(TwoPartyNetwork, Deadline) {
+  // The timeout travels with the call and becomes a deadline on the server's timer.
+
+  auto ioContext = kj::setupAsyncIo();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+  kj::TimerImpl clientTimer(kj::origin<kj::TimePoint>());
+  kj::TimerImpl serverTimer(kj::origin<kj::TimePoint>() + 1000 * kj::SECONDS);
+
+  auto serverImpl = kj::heap<TestDeadlineImpl>();
+  auto& server = *serverImpl;
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[0], rpc::twoparty::Side::SERVER);
+  auto rpcServer = makeRpcServer(serverNetwork, kj::mv(serverImpl));
+  rpcServer.setTimer(serverTimer);
+
+  TwoPartyClient client(*pipe.ends[1]);
+  auto cap = client.bootstrap().castAs<test::TestInterface>();
+
+  auto request = cap.fooRequest();
+  request.setTimeout(clientTimer, 3 * kj::SECONDS);
+  request.send().wait(ioContext.waitScope);
+
+  EXPECT_TRUE(KJ_ASSERT_NONNULL(server.deadline) == serverTimer.now() + 3 * kj::SECONDS);
+
+  cap.fooRequest().send().wait(ioContext.waitScope);
+  EXPECT_TRUE(server.deadline == nullptr);
+}
+
+TEST(TwoPartyNetwork, DeadlineThroughProxy) {
+  // A proxy passes along what remains of the call's timeout.
+
+  auto ioContext = kj::setupAsyncIo();
+  auto backendPipe = ioContext.provider->newTwoWayPipe();
+  auto frontendPipe = ioContext.provider->newTwoWayPipe();
+  kj::TimerImpl clientTimer(kj::origin<kj::TimePoint>());
+  kj::TimerImpl proxyTimer(kj::origin<kj::TimePoint>() + 1000 * kj::SECONDS);
+  kj::TimerImpl backendTimer(kj::origin<kj::TimePoint>() + 2000 * kj::SECONDS);
+
+  auto backendImpl = kj::heap<TestDeadlineImpl>();
+  auto& backend = *backendImpl;
+  TwoPartyVatNetwork backendNetwork(*backendPipe.ends[1], rpc::twoparty::Side::SERVER);
+  auto backendServer = makeRpcServer(backendNetwork, kj::mv(backendImpl));
+  backendServer.setTimer(backendTimer);
+
+  TwoPartyVatNetwork proxyToBackendNetwork(*backendPipe.ends[0], rpc::twoparty::Side::CLIENT);
+  auto proxyToBackend = makeRpcClient(proxyToBackendNetwork);
+  proxyToBackend.setTimer(proxyTimer);
+  MallocMessageBuilder vatIdMessage(8);
+  auto vatId = vatIdMessage.initRoot<rpc::twoparty::VatId>();
+  vatId.setSide(rpc::twoparty::Side::SERVER);
+
+  TwoPartyVatNetwork proxyNetwork(*frontendPipe.ends[0], rpc::twoparty::Side::SERVER);
+  auto proxyServer = makeRpcServer(proxyNetwork, proxyToBackend.bootstrap(vatId));
+  proxyServer.setTimer(proxyTimer);
+
+  TwoPartyClient client(*frontendPipe.ends[1]);
+  auto cap = client.bootstrap().castAs<test::TestInterface>();
+
+  auto request = cap.fooRequest();
+  request.setTimeout(clientTimer, 3 * kj::SECONDS);
+  request.send().wait(ioContext.waitScope);
+
+  EXPECT_TRUE(KJ_ASSERT_NONNULL(backend.deadline) == backendTimer.now() + 3 * kj::SECONDS);
+
+  cap.fooRequest().send().wait(ioContext.waitScope);
+  EXPECT_TRUE(backend.deadline == nullptr);
+}
+
+kj::Promise<void> callFoo(test::TestInterface::Client& cap) {
+  auto request = cap.fooRequest();
+  request.setI(123);
+  request.setJ(true);
+  return request.send().ignoreResult();
+}
+
+TEST(TwoPartyNetwork, KeepalivePing) {
+  auto ioContext = kj::setupAsyncIo();
+  auto& realTimer = ioContext.provider->getTimer();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+
+  int callCount = 0;
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[0], rpc::twoparty::Side::SERVER);
+  TwoPartyKeepaliveOptions options;
+  options.pingInterval = 10 * kj::SECONDS;
+  serverNetwork.setKeepalive(timer, options);
+  auto rpcServer = makeRpcServer(serverNetwork, kj::heap<TestInterfaceImpl>(callCount));
+
+  // The client doesn't enable keepalive, but answers pings anyway.
+  TwoPartyClient client(*pipe.ends[1]);
+  auto cap = client.bootstrap().castAs<test::TestInterface>();
+  callFoo(cap).wait(ioContext.waitScope);
+  realTimer.afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);  // let Finish arrive
+  EXPECT_TRUE(serverNetwork.getActivity().lastMessage == timer.now());
+
+  for (uint i = 1; i <= 3; i++) {
+    timer.advanceTo(kj::origin<kj::TimePoint>() + i * 10 * kj::SECONDS);
+    realTimer.afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+    EXPECT_TRUE(serverNetwork.getActivity().lastReceived == timer.now());
+  }
+
+  // Pings don't count as messages.
+  EXPECT_TRUE(serverNetwork.getActivity().lastMessage == kj::origin<kj::TimePoint>());
+  callFoo(cap).wait(ioContext.waitScope);
+  EXPECT_EQ(2, callCount);
+}
+
+TEST(TwoPartyNetwork, KeepaliveDeadPeer) {
+  auto ioContext = kj::setupAsyncIo();
+  auto& realTimer = ioContext.provider->getTimer();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+
+  int callCount = 0;
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[0], rpc::twoparty::Side::SERVER);
+  TwoPartyKeepaliveOptions options;
+  options.pingInterval = 10 * kj::SECONDS;
+  options.pingTimeout = 5 * kj::SECONDS;
+  serverNetwork.setKeepalive(timer, options);
+  auto rpcServer = makeRpcServer(serverNetwork, kj::heap<TestInterfaceImpl>(callCount));
+
+  // Nothing reads the other end of the pipe, so pings go unanswered.
+  bool disconnected = false;
+  auto promise = serverNetwork.onDisconnect().then([&]() { disconnected = true; });
+
+  timer.advanceTo(kj::origin<kj::TimePoint>() + 10 * kj::SECONDS);
+  realTimer.afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+  EXPECT_FALSE(disconnected);
+
+  timer.advanceTo(kj::origin<kj::TimePoint>() + 15 * kj::SECONDS);
+  promise.wait(ioContext.waitScope);
+  EXPECT_TRUE(disconnected);
+}
+
+TEST(TwoPartyNetwork, KeepaliveSlowMessage) {
+  // A large message arriving slowly keeps the connection alive, even though no complete frame (let
+  // alone an answer to a ping) is received for a while.
+
+  auto ioContext = kj::setupAsyncIo();
+  auto& realTimer = ioContext.provider->getTimer();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+
+  int callCount = 0;
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[0], rpc::twoparty::Side::SERVER);
+  TwoPartyKeepaliveOptions options;
+  options.pingInterval = 10 * kj::SECONDS;
+  options.pingTimeout = 5 * kj::SECONDS;
+  serverNetwork.setKeepalive(timer, options);
+  auto rpcServer = makeRpcServer(serverNetwork, kj::heap<TestInterfaceImpl>(callCount));
+
+  bool disconnected = false;
+  auto promise = serverNetwork.onDisconnect().then([&]() { disconnected = true; });
+
+  // The start of a one-segment message of 1000 words.
+  uint64_t chunk[100];
+  memset(chunk, 0, sizeof(chunk));
+  auto table = reinterpret_cast<_::WireValue<uint32_t>*>(chunk);
+  table[0].set(0);
+  table[1].set(1000);
+  pipe.ends[1]->write(chunk, sizeof(chunk)).wait(ioContext.waitScope);
+  realTimer.afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+  EXPECT_TRUE(serverNetwork.getActivity().lastReceived == kj::origin<kj::TimePoint>());
+
+  // More of it arrives after the ping is sent, but the ping itself is never answered.
+  timer.advanceTo(kj::origin<kj::TimePoint>() + 10 * kj::SECONDS);
+  realTimer.afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+  memset(chunk, 0, sizeof(chunk));
+  pipe.ends[1]->write(chunk, sizeof(chunk)).wait(ioContext.waitScope);
+  realTimer.afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+  EXPECT_TRUE(serverNetwork.getActivity().lastReceived == timer.now());
+
+  timer.advanceTo(kj::origin<kj::TimePoint>() + 15 * kj::SECONDS);
+  realTimer.afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+  EXPECT_FALSE(disconnected);
+
+  // Once it stops, the connection is reaped as usual.
+  timer.advanceTo(kj::origin<kj::TimePoint>() + 20 * kj::SECONDS);
+  realTimer.afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+  EXPECT_FALSE(disconnected);
+  timer.advanceTo(kj::origin<kj::TimePoint>() + 25 * kj::SECONDS);
+  promise.wait(ioContext.waitScope);
+  EXPECT_TRUE(disconnected);
+}
+
+TEST(TwoPartyNetwork, KeepaliveIdleTimeout) {
+  auto ioContext = kj::setupAsyncIo();
+  auto& realTimer = ioContext.provider->getTimer();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+  kj::TimerImpl timer(kj::origin<kj::TimePoint>());
+
+  int callCount = 0;
+  TwoPartyServer server(kj::heap<TestInterfaceImpl>(callCount));
+  TwoPartyKeepaliveOptions options;
+  options.idleTimeout = 60 * kj::SECONDS;
+  options.maxConnectionAge = 1000 * kj::SECONDS;
+  server.setKeepalive(timer, options);
+  server.accept(kj::mv(pipe.ends[0]));
+
+  TwoPartyClient client(*pipe.ends[1]);
+  auto cap = client.bootstrap().castAs<test::TestInterface>();
+
+  // Each call pushes the idle deadline back.
+  for (uint i = 1; i <= 3; i++) {
+    timer.advanceTo(kj::origin<kj::TimePoint>() + i * 50 * kj::SECONDS);
+    callFoo(cap).wait(ioContext.waitScope);
+  }
+
+  timer.advanceTo(kj::origin<kj::TimePoint>() + 210 * kj::SECONDS);
+  client.onDisconnect().wait(ioContext.waitScope);
+
+  EXPECT_ANY_THROW(callFoo(cap).wait(ioContext.waitScope));
+  EXPECT_EQ(3, callCount);
+  realTimer.afterDelay(10 * kj::MILLISECONDS).wait(ioContext.waitScope);
+}
+
+class CountingStream final: public kj::AsyncIoStream {
+  // Counts the writes made to the wrapped stream.
+
+public:
+  explicit CountingStream(kj::AsyncIoStream& inner): inner(inner) {}
+
+  uint writeCount = 0;
+
+  kj::Promise<size_t> tryRead(void* buffer, size_t minBytes, size_t maxBytes) override {
+    return inner.tryRead(buffer, minBytes, maxBytes);
+  }
+  kj::Promise<void> write(const void* buffer, size_t size) override {
+    ++writeCount;
+    return inner.write(buffer, size);
+  }
+  kj::Promise<void> write(kj::ArrayPtr<const kj::ArrayPtr<const byte>> pieces) override {
+    ++writeCount;
+    return inner.write(pieces);
+  }
+  void shutdownWrite() override {
+    inner.shutdownWrite();
+  }
+
+private:
+  kj::AsyncIoStream& inner;
+};
+
+TEST(TwoPartyNetwork, BatchSmallMessages) {
+  auto ioContext = kj::setupAsyncIo();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+
+  int callCount = 0;
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[0], rpc::twoparty::Side::SERVER);
+  auto rpcServer = makeRpcServer(serverNetwork, kj::heap<TestInterfaceImpl>(callCount));
+
+  CountingStream stream(*pipe.ends[1]);
+  TwoPartyClient client(stream);
+  auto cap = client.bootstrap().castAs<test::TestInterface>();
+  callFoo(cap).wait(ioContext.waitScope);
+
+  // Calls sent in one turn go out in one write.
+  stream.writeCount = 0;
+  kj::Vector<kj::Promise<void>> promises;
+  for (uint i = 0; i < 50; i++) {
+    promises.add(callFoo(cap));
+  }
+  kj::evalLater([]() {}).wait(ioContext.waitScope);
+  EXPECT_EQ(1, stream.writeCount);
+
+  // So do their Finish messages, unless the responses happen to trickle in.
+  kj::joinPromises(promises.releaseAsArray()).wait(ioContext.waitScope);
+  kj::evalLater([]() {}).wait(ioContext.waitScope);
+  EXPECT_LT(stream.writeCount, 10);
+  EXPECT_EQ(51, callCount);
+}
+
+class TestPriorityOtherImpl final: public test::TestInterface::Server {
+public:
+  TestPriorityOtherImpl(kj::Vector<uint>& log): log(log) {}
+
+protected:
+  kj::Promise<void> foo(FooContext context) override {
+    log.add(context.getParams().getI());
+    return kj::READY_NOW;
+  }
+
+private:
+  kj::Vector<uint>& log;
+};
+
+class TestPriorityImpl final: public test::TestMoreStuff::Server {
+  // Records the order in which calls arrive:  `methodWithDefaults()` logs `b` and calls to the
+  // capability returned by `getHeld()` log `i`.
+
+public:
+  kj::Vector<uint> log;
+
+protected:
+  kj::Promise<void> methodWithDefaults(MethodWithDefaultsContext context) override {
+    log.add(context.getParams().getB());
+    return kj::READY_NOW;
+  }
+
+  kj::Promise<void> getHeld(GetHeldContext context) override {
+    context.getResults().setCap(kj::heap<TestPriorityOtherImpl>(log));
+    return kj::READY_NOW;
+  }
+};
+
+TEST(TwoPartyNetwork, Priority) {
+  auto ioContext = kj::setupAsyncIo();
+  auto pipe = ioContext.provider->newTwoWayPipe();
+
+  auto serverImpl = kj::heap<TestPriorityImpl>();
+  auto& server = *serverImpl;
+  TwoPartyVatNetwork serverNetwork(*pipe.ends[0], rpc::twoparty::Side::SERVER);
+  auto rpcServer = makeRpcServer(serverNetwork, kj::mv(serverImpl));
+
+  TwoPartyClient client(*pipe.ends[1]);
+  auto cap = client.bootstrap().castAs<test::TestMoreStuff>();
+  auto other = cap.getHeldRequest().send().wait(ioContext.waitScope).getCap();
+  server.log.clear();
+
+  // Queue up some bulk calls, then latency-sensitive ones on each capability.  All are sent before
+  // the first one is written.
+  kj::Vector<kj::Promise<void>> promises;
+  for (uint i = 0; i < 10; i++) {
+    auto req = cap.methodWithDefaultsRequest();
+    req.setPriority(CallPriority::LOW);
+    fillLargeText(req.initA(100000));
+    req.setB(i);
+    promises.add(req.send().ignoreResult());
+  }
+  {
+    auto req = cap.methodWithDefaultsRequest();
+    req.setPriority(CallPriority::HIGH);
+    req.setB(10);
+    promises.add(req.send().ignoreResult());
+  }
+  {
+    auto req = other.fooRequest();
+    req.setPriority(CallPriority::HIGH);
+    req.setI(100);
+    promises.add(req.send().ignoreResult());
+  }
+  kj::joinPromises(promises.releaseAsArray()).wait(ioContext.waitScope);
+
+  // The call on the other capability jumped the queue, but calls on the same capability stayed in
+  // order.
+  KJ_EXPECT(server.log.asPtr() == kj::ArrayPtr<const uint>({100, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10}),
+            server.log);
+}
+
 }  // namespace
 }  // namespace _
 }  // namespace capnp
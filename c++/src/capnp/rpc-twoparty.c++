@@ -20,15 +20,149 @@
 // THE SOFTWARE.
 
 #include "rpc-twoparty.h"
+#include "rpc-metrics.h"
 #include "serialize-async.h"
+#include "serialize-packed.h"
 #include <kj/debug.h>
+#include <string.h>
+#include <algorithm>
 
 namespace capnp {
 
+namespace {
+
+// Besides plain messages, the stream may carry control frames.  A control frame starts with a
+// word whose first half would be a message's segment count (minus one) of 0xffffffff, which no
+// reader accepts, so a control frame can never be mistaken for a message.  The second half holds
+// the frame type in its low byte and a type-specific argument in the rest.
+//
+// HELLO:   Announces the codecs the sender accepts, as a bitmask in the argument.
+// PACKED:  Followed by a word holding the packed size in bytes and the unpacked size in words,
+//          followed by a message (segment table included) in packed format.
+// PING:    Asks the receiver to send a PONG right away.  Used to detect dead peers.
+// PONG:    Answers a PING.
+//
+// A side which may send PACKED or PING frames sends a HELLO before anything else, and the others
+// are only ever sent in reply to a HELLO or a PING.  So if neither side starts with a HELLO, the
+// connection carries nothing but plain messages, and we can read them without first checking
+// each one's header.
+
+constexpr uint32_t CONTROL_FRAME = 0xffffffffu;
+constexpr uint32_t FRAME_HELLO = 0;
+constexpr uint32_t FRAME_PACKED = 1;
+constexpr uint32_t FRAME_PING = 2;
+constexpr uint32_t FRAME_PONG = 3;
+
+constexpr uint32_t CODEC_PACKED = 1 << 0;
+
+constexpr size_t REORDER_WINDOW = 64;
+// How far past the head of the send queue we look for a message of higher priority.  Bounds the
+// work done per write when a long backlog builds up.
+
+constexpr size_t BATCH_MESSAGE_WORDS = 64;
+constexpr size_t BATCH_LIMIT_WORDS = 8192;
+// Messages up to BATCH_MESSAGE_WORDS in size which are queued back to back are written together,
+// up to BATCH_LIMIT_WORDS at a time, to save a system call (and often a packet) per message.
+
+constexpr uint MAX_FORWARDED_RANGES = 64;
+// Forwarded params scattered over more runs of words than this are copied instead.  Params built
+// in the usual way occupy only a few runs.
+
+void initControlFrame(word& frame, uint32_t type, uint32_t argument = 0) {
+  auto header = reinterpret_cast<_::WireValue<uint32_t>*>(&frame);
+  header[0].set(CONTROL_FRAME);
+  header[1].set(type | (argument << 8));
+}
+
+class PrefixedInputStream final: public kj::AsyncInputStream {
+  // Reads `prefix`, which was already consumed from `inner`, followed by the rest of `inner`.
+
+public:
+  PrefixedInputStream(kj::ArrayPtr<const byte> prefix, kj::AsyncInputStream& inner)
+      : prefix(prefix), inner(inner) {}
+
+  size_t getBytesRead() { return bytesRead; }
+
+  kj::Promise<size_t> tryRead(void* buffer, size_t minBytes, size_t maxBytes) override {
+    if (prefix.size() == 0) {
+      return inner.tryRead(buffer, minBytes, maxBytes).then([this](size_t m) {
+        bytesRead += m;
+        return m;
+      });
+    }
+
+    size_t n = kj::min(prefix.size(), maxBytes);
+    memcpy(buffer, prefix.begin(), n);
+    prefix = prefix.slice(n, prefix.size());
+    bytesRead += n;
+    if (n >= minBytes) {
+      return n;
+    }
+    return inner.tryRead(reinterpret_cast<byte*>(buffer) + n, minBytes - n, maxBytes - n)
+        .then([this,n](size_t m) {
+      bytesRead += m;
+      return n + m;
+    });
+  }
+
+private:
+  kj::ArrayPtr<const byte> prefix;
+  kj::AsyncInputStream& inner;
+  size_t bytesRead = 0;
+};
+
+class ActivityInputStream final: public kj::AsyncInputStream {
+  // Reads from `inner`, setting `lastReceived` to the current time whenever any bytes arrive, so
+  // that a large message trickling in over a slow link counts as activity throughout, rather than
+  // only once it is complete.
+
+public:
+  ActivityInputStream(kj::AsyncInputStream& inner, kj::Timer& timer, kj::TimePoint& lastReceived)
+      : inner(inner), timer(timer), lastReceived(lastReceived) {}
+
+  kj::Promise<size_t> tryRead(void* buffer, size_t minBytes, size_t maxBytes) override {
+    return readSome(reinterpret_cast<byte*>(buffer), minBytes, maxBytes, 0);
+  }
+
+private:
+  kj::AsyncInputStream& inner;
+  kj::Timer& timer;
+  kj::TimePoint& lastReceived;
+
+  kj::Promise<size_t> readSome(byte* buffer, size_t minBytes, size_t maxBytes,
+                               size_t alreadyRead) {
+    // Ask for one byte at a time at least, so that we hear about partial progress.
+    return inner.tryRead(buffer, kj::min(minBytes, size_t(1)), maxBytes)
+        .then([this,buffer,minBytes,maxBytes,alreadyRead](size_t n) -> kj::Promise<size_t> {
+      if (n > 0) {
+        lastReceived = timer.now();
+      }
+      if (n == 0 || n >= minBytes) {
+        return alreadyRead + n;
+      }
+      return readSome(buffer + n, minBytes - n, maxBytes - n, alreadyRead + n);
+    });
+  }
+};
+
+class UnpackedMessageReader final: public FlatArrayMessageReader {
+  // A FlatArrayMessageReader that owns the array it reads.
+
+public:
+  UnpackedMessageReader(kj::Array<word> words, ReaderOptions options)
+      : FlatArrayMessageReader(words, options), words(kj::mv(words)) {}
+
+private:
+  kj::Array<word> words;
+};
+
+}  // namespace
+
 TwoPartyVatNetwork::TwoPartyVatNetwork(kj::AsyncIoStream& stream, rpc::twoparty::Side side,
-                                       ReaderOptions receiveOptions)
+                                       ReaderOptions receiveOptions,
+                                       TwoPartyCompressionOptions compression)
     : stream(stream), side(side), peerVatId(4),
-      receiveOptions(receiveOptions), previousWrite(kj::READY_NOW) {
+      receiveOptions(receiveOptions), compression(compression), previousWrite(kj::READY_NOW) {
   peerVatId.initRoot<rpc::twoparty::VatId>().setSide(
       side == rpc::twoparty::Side::CLIENT ? rpc::twoparty::Side::SERVER
                                           : rpc::twoparty::Side::CLIENT);
@@ -36,6 +170,140 @@ TwoPartyVatNetwork::TwoPartyVatNetwork(kj::AsyncIoStream& stream, rpc::twoparty:
   auto paf = kj::newPromiseAndFulfiller<void>();
   disconnectPromise = paf.promise.fork();
   disconnectFulfiller.fulfiller = kj::mv(paf.fulfiller);
+
+  initControlFrame(pingFrame, FRAME_PING);
+  initControlFrame(pongFrame, FRAME_PONG);
+
+  if (compression.enabled) {
+    sendHello(CODEC_PACKED);
+  }
+}
+
+void TwoPartyVatNetwork::sendHello(uint32_t codecs) {
+  initControlFrame(helloFrame, FRAME_HELLO, codecs);
+  writeControlFrame(helloFrame);
+  sentHello = true;
+}
+
+TwoPartyVatNetwork::Keepalive::Keepalive(kj::Timer& timer, TwoPartyKeepaliveOptions options)
+    : timer(timer), options(options), reaped(nullptr), watchdog(nullptr) {
+  if (this->options.pingInterval > 0 * kj::SECONDS &&
+      this->options.pingTimeout == 0 * kj::SECONDS) {
+    this->options.pingTimeout = this->options.pingInterval;
+  }
+
+  auto now = timer.now();
+  activity.connected = now;
+  activity.lastReceived = now;
+  activity.lastMessage = now;
+
+  auto paf = kj::newPromiseAndFulfiller<void>();
+  reaper = kj::mv(paf.fulfiller);
+  reaped = paf.promise.fork();
+}
+
+void TwoPartyVatNetwork::setKeepalive(kj::Timer& timer, TwoPartyKeepaliveOptions options) {
+  KJ_REQUIRE(keepalive == nullptr, "setKeepalive() can only be called once.");
+  auto& k = keepalive.emplace(timer, options);
+  if (k.options.pingInterval > 0 * kj::SECONDS) {
+    // Pings time out based on `lastReceived`, so it has to notice partial progress on a large
+    // message.  Without pings, noting each frame as it arrives is enough.
+    k.input = kj::heap<ActivityInputStream>(stream, timer, k.activity.lastReceived);
+    if (!sentHello) {
+      // Let the peer know to expect pings.
+      sendHello(0);
+    }
+  }
+  k.watchdog = watchActivity().eagerlyEvaluate(nullptr);
+}
+
+TwoPartyConnectionActivity TwoPartyVatNetwork::getActivity() {
+  return KJ_REQUIRE_NONNULL(keepalive, "Need to call setKeepalive() first.").activity;
+}
+
+void TwoPartyVatNetwork::noteMessage() {
+  KJ_IF_MAYBE(k, keepalive) {
+    k->activity.lastMessage = k->timer.now();
+  }
+}
+
+void TwoPartyVatNetwork::noteReceived() {
+  KJ_IF_MAYBE(k, keepalive) {
+    if (k->input.get() == nullptr) {
+      k->activity.lastReceived = k->timer.now();
+    }
+  }
+}
+
+kj::Promise<void> TwoPartyVatNetwork::watchActivity() {
+  auto& k = KJ_ASSERT_NONNULL(keepalive);
+  auto& options = k.options;
+  auto& activity = k.activity;
+  auto now = k.timer.now();
+  kj::Maybe<kj::TimePoint> next;
+  auto wakeAt = [&](kj::TimePoint time) {
+    KJ_IF_MAYBE(n, next) {
+      if (time < *n) next = time;
+    } else {
+      next = time;
+    }
+  };
+
+  auto reap = [&](kj::StringPtr reason) -> kj::Promise<void> {
+    k.isReaped = true;
+    k.reaper->reject(kj::Exception(kj::Exception::Type::DISCONNECTED, __FILE__, __LINE__,
+                                   kj::heapString(reason)));
+    return kj::READY_NOW;
+  };
+
+  if (options.maxConnectionAge > 0 * kj::SECONDS) {
+    auto deadline = activity.connected + options.maxConnectionAge;
+    if (now >= deadline) return reap("Connection reached its maximum age.");
+    wakeAt(deadline);
+  }
+
+  if (options.idleTimeout > 0 * kj::SECONDS) {
+    auto deadline = activity.lastMessage + options.idleTimeout;
+    if (now >= deadline) return reap("Connection was idle for too long.");
+    wakeAt(deadline);
+  }
+
+  if (options.pingInterval > 0 * kj::SECONDS) {
+    KJ_IF_MAYBE(sent, k.pingSent) {
+      if (activity.lastReceived >= *sent) {
+        k.pingSent = nullptr;
+      } else {
+        auto deadline = *sent + options.pingTimeout;
+        if (now >= deadline) return reap("Peer did not answer keepalive ping.");
+        wakeAt(deadline);
+      }
+    }
+    if (k.pingSent == nullptr) {
+      auto pingTime = activity.lastReceived + options.pingInterval;
+      if (now >= pingTime) {
+        writeControlFrame(pingFrame);
+        k.pingSent = now;
+        wakeAt(now + options.pingTimeout);
+      } else {
+        wakeAt(pingTime);
+      }
+    }
+  }
+
+  KJ_IF_MAYBE(n, next) {
+    return k.timer.atTime(*n).then([this]() { return watchActivity(); });
+  } else {
+    // Nothing to enforce; we're only tracking activity.
+    return kj::READY_NOW;
+  }
+}
+
+void TwoPartyVatNetwork::writeControlFrame(word& frame) {
+  KJ_IF_MAYBE(previous, previousWrite) {
+    previousWrite = previous->then([this,&frame]() {
+      return stream.write(&frame, sizeof(frame));
+    }).eagerlyEvaluate(nullptr);
+  }
 }
 
 void TwoPartyVatNetwork::FulfillerDisposer::disposeImpl(void* pointer) const {
@@ -81,11 +349,83 @@ public:
     return message.getRoot<AnyPointer>();
   }
 
+  bool forwardContent(AnyPointer::Builder slot, RawCallParams& params) override {
+    auto segments = params.getSegments();
+    if (segments.size() == 0 || segments[0].size() == 0 || segments.size() + 1 >= 512 ||
+        message.getSegmentsForOutput().size() != 1) {
+      // We can only append a single segment of our own to the original message, and the reader
+      // rejects messages with too many segments.
+      return false;
+    }
+
+    // The original message holds more than the params: at least the Call they arrived in, with
+    // the original connection's question and export IDs, and possibly anything else its sender
+    // chose to put there.  None of that may reach our peer, so work out exactly which words belong
+    // to the params; everything else will be sent as zeros.
+    auto content = _::PointerHelpers<AnyPointer>::getInternalReader(params.getContent());
+    auto ranges = kj::heapArray<_::WordRange>(MAX_FORWARDED_RANGES);
+    uint rangeCount;
+    KJ_IF_MAYBE(n, content.getTargetRanges(ranges)) {
+      rangeCount = *n;
+    } else {
+      return false;
+    }
+
+    std::sort(ranges.begin(), ranges.begin() + rangeCount,
+        [](const _::WordRange& a, const _::WordRange& b) {
+      return a.segmentId < b.segmentId ||
+             (a.segmentId == b.segmentId && a.offset < b.offset);
+    });
+
+    // Merge overlapping ranges and add up how much must be blanked.
+    kj::Vector<_::WordRange> merged(rangeCount);
+    size_t keptWords = 0;
+    for (auto& range: ranges.slice(0, rangeCount)) {
+      if (range.segmentId >= segments.size() ||
+          range.offset + uint64_t(range.size) > segments[range.segmentId].size()) {
+        return false;
+      }
+      if (merged.size() > 0 && merged.back().segmentId == range.segmentId &&
+          merged.back().offset + merged.back().size >= range.offset) {
+        auto& last = merged.back();
+        uint end = kj::max(last.offset + last.size, range.offset + range.size);
+        keptWords += end - (last.offset + last.size);
+        last.size = end - last.offset;
+      } else {
+        merged.add(range);
+        keptWords += range.size;
+      }
+    }
+
+    size_t totalWords = 0;
+    for (auto& segment: segments) {
+      totalWords += segment.size();
+    }
+    if (totalWords - keptWords > keptWords) {
+      // Mostly not params.  Sending that many zeros costs more than copying would.
+      return false;
+    }
+
+    if (!_::PointerHelpers<AnyPointer>::getInternalBuilder(kj::mv(slot))
+            .referTo(content, segments, segments.size())) {
+      return false;
+    }
+
+    forwarded = params.addRef();
+    forwardedRanges = merged.releaseAsArray();
+    return true;
+  }
+
   void send() override {
     size_t size = 0;
     for (auto& segment: message.getSegmentsForOutput()) {
       size += segment.size();
     }
+    KJ_IF_MAYBE(f, forwarded) {
+      for (auto& segment: f->get()->getSegments()) {
+        size += segment.size();
+      }
+    }
     KJ_REQUIRE(size < ReaderOptions().traversalLimitInWords, size,
                "Trying to send Cap'n Proto message larger than the single-message size limit. The "
                "other side probably won't accept it and would abort the connection, so I won't "
@@ -93,24 +433,334 @@ public:
       return;
     }
 
-    network.previousWrite = KJ_ASSERT_NONNULL(network.previousWrite, "already shut down")
-        .then([&]() {
+    this->size = size;
+    auto& network = this->network;
+    network.noteMessage();
+    auto previous = kj::mv(KJ_ASSERT_NONNULL(network.previousWrite, "already shut down"));
+    network.sendQueue.add(kj::addRef(*this));
+    network.previousWrite = previous.then([&network]() {
+      return network.writeNextMessage();
+    }, [&network](kj::Exception&& e) -> kj::Promise<void> {
       // Note that if the write fails, all further writes will be skipped due to the exception.
       // We never actually handle this exception because we assume the read end will fail as well
-      // and it's cleaner to handle the failure there.
+      // and it's cleaner to handle the failure there.  Drop the messages that will never be
+      // written, though, so they don't hold on to anything.
+      network.sendQueue.clear();
+      network.sendQueueHead = 0;
+      return kj::mv(e);
+    }).eagerlyEvaluate(nullptr);
+  }
+
+  void setPriority(CallPriority priority, kj::ArrayPtr<const uint64_t> orderingKeys) override {
+    reorderable = true;
+    this->priority = priority;
+    this->orderingKeys = kj::heapArray(orderingKeys);
+  }
+
+  kj::Promise<void> write() {
+    KJ_IF_MAYBE(f, forwarded) {
+      // Compressing would defeat the point of forwarding the params without copying them.
+      return writeForwarded(**f);
+    } else if (shouldPack()) {
+      return writePacked();
+    } else {
+      network.countSent(computeSerializedSizeInWords(message.getSegmentsForOutput()) *
+                        sizeof(word));
       return writeMessage(network.stream, message);
-    }).attach(kj::addRef(*this))
-      // Note that it's important that the eagerlyEvaluate() come *after* the attach() because
-      // otherwise the message (and any capabilities in it) will not be released until a new
-      // message is written! (Kenton once spent all afternoon tracking this down...)
-      .eagerlyEvaluate(nullptr);
+    }
+  }
+
+  bool isBatchable() {
+    // Can this message be written as part of a batch?  Only small messages which are written as-is
+    // qualify.
+    return forwarded == nullptr && size <= BATCH_MESSAGE_WORDS && !shouldPack();
+  }
+
+  size_t getSize() { return size; }
+
+  kj::Array<word> flatten() {
+    network.countSent(computeSerializedSizeInWords(message.getSegmentsForOutput()) *
+                      sizeof(word));
+    return messageToFlatArray(message);
+  }
+
+  bool isReorderable() { return reorderable; }
+
+  CallPriority getPriority() { return priority; }
+
+  bool mayOvertake(OutgoingMessageImpl& other) {
+    // Can this message be written before `other`, which was sent earlier?
+
+    if (!reorderable || !other.reorderable) {
+      return false;
+    }
+    for (auto key: orderingKeys) {
+      for (auto otherKey: other.orderingKeys) {
+        if (key == otherKey) return false;
+      }
+    }
+    return true;
   }
 
 private:
   TwoPartyVatNetwork& network;
   MallocMessageBuilder message;
+  size_t size = 0;
+  // Total size of the message in words, computed by send().
+
+  bool reorderable = false;
+  CallPriority priority = CallPriority::NORMAL;
+  kj::Array<uint64_t> orderingKeys;
+  // Set by setPriority().
+
+  kj::Maybe<kj::Own<RawCallParams>> forwarded;
+  kj::Array<_::WordRange> forwardedRanges;
+  // If forwardContent() succeeded, the params whose message we're sending along with ours, and
+  // the words of that message that make up the params, sorted by position.
+
+  kj::Array<_::WireValue<uint32_t>> forwardedTable;
+  word forwardedRoot;
+  kj::Array<uint64_t> forwardedZeros;
+  kj::Array<kj::ArrayPtr<const byte>> forwardedPieces;
+  // Segment table, substitute root pointer, blanking, and write pieces for the forwarded form.
+
+  word packedHeader[2];
+  kj::Own<kj::VectorOutputStream> packed;
+  kj::ArrayPtr<const byte> packedPieces[2];
+  // Frame header, body, and write pieces for the packed form.
+
+  bool shouldPack() {
+    return network.compression.enabled && (network.peerCodecs & CODEC_PACKED) &&
+           size >= network.compression.thresholdWords;
+  }
+
+  kj::Promise<void> writePacked() {
+    auto segments = message.getSegmentsForOutput();
+    size_t unpackedWords = computeSerializedSizeInWords(segments);
+
+    packed = kj::heap<kj::VectorOutputStream>(unpackedWords * sizeof(word));
+    writePackedMessage(*packed, segments);
+    auto body = packed->getArray();
+
+    if (body.size() + sizeof(packedHeader) >= unpackedWords * sizeof(word)) {
+      // Packing didn't help.
+      packed = nullptr;
+      network.countSent(unpackedWords * sizeof(word));
+      return writeMessage(network.stream, message);
+    }
+
+    auto header = reinterpret_cast<_::WireValue<uint32_t>*>(packedHeader);
+    header[0].set(CONTROL_FRAME);
+    header[1].set(FRAME_PACKED);
+    header[2].set(body.size());
+    header[3].set(unpackedWords);
+
+    network.compressionStats.uncompressedBytesSent += unpackedWords * sizeof(word);
+    network.compressionStats.compressedBytesSent += sizeof(packedHeader) + body.size();
+    network.countSent(sizeof(packedHeader) + body.size());
+
+    packedPieces[0] = kj::arrayPtr(packedHeader, 2).asBytes();
+    packedPieces[1] = body;
+    return network.stream.write(packedPieces);
+  }
+
+  kj::Promise<void> writeForwarded(RawCallParams& params) {
+    // Write the original message's segments under their original IDs, followed by our own single
+    // segment.  The original root pointer is replaced by a far pointer to our root pointer, which
+    // in turn points at our body.  The params are written straight out of the buffer in which they
+    // were received; every other word of the original message is written as zero.
+
+    auto segments = params.getSegments();
+    auto ours = message.getSegmentsForOutput();
+    KJ_ASSERT(ours.size() == 1, "forwarded message header overflowed its segment");
+
+    uint count = segments.size() + 1;
+    forwardedTable = kj::heapArray<_::WireValue<uint32_t>>((count + 2) & ~1u);
+    forwardedTable[0].set(count - 1);
+    for (uint i = 0; i < segments.size(); i++) {
+      forwardedTable[i + 1].set(segments[i].size());
+    }
+    forwardedTable[count].set(ours[0].size());
+    if (count % 2 == 0) {
+      forwardedTable[count + 1].set(0);
+    }
+
+    // A single-far pointer to offset 0 of segment `segments.size()`.
+    _::WireValue<uint32_t>* root = reinterpret_cast<_::WireValue<uint32_t>*>(&forwardedRoot);
+    root[0].set(2);
+    root[1].set(segments.size());
+
+    // Find the largest gap between params ranges, so one zeroed buffer can fill them all.
+    size_t maxGap = 0;
+    {
+      auto range = forwardedRanges.begin();
+      for (uint i = 0; i < segments.size(); i++) {
+        size_t pos = i == 0 ? 1 : 0;
+        for (; range != forwardedRanges.end() && range->segmentId == i; ++range) {
+          if (range->offset > pos) maxGap = kj::max(maxGap, range->offset - pos);
+          pos = kj::max(pos, size_t(range->offset + range->size));
+        }
+        maxGap = kj::max(maxGap, segments[i].size() - kj::min(pos, segments[i].size()));
+      }
+    }
+    forwardedZeros = kj::heapArray<uint64_t>(maxGap);
+    std::fill(forwardedZeros.begin(), forwardedZeros.end(), 0);
+
+    kj::Vector<kj::ArrayPtr<const byte>> pieces(forwardedRanges.size() * 2 + segments.size() + 3);
+    pieces.add(forwardedTable.asBytes());
+    pieces.add(kj::arrayPtr(&forwardedRoot, 1).asBytes());
+    auto range = forwardedRanges.begin();
+    for (uint i = 0; i < segments.size(); i++) {
+      auto segment = segments[i];
+      size_t pos = i == 0 ? 1 : 0;
+      for (; range != forwardedRanges.end() && range->segmentId == i; ++range) {
+        size_t start = kj::max(pos, size_t(range->offset));
+        size_t end = range->offset + range->size;
+        if (start > pos) {
+          pieces.add(forwardedZeros.slice(0, start - pos).asBytes());
+        }
+        if (end > start) {
+          pieces.add(segment.slice(start, end).asBytes());
+          pos = end;
+        }
+      }
+      if (segment.size() > pos) {
+        pieces.add(forwardedZeros.slice(0, segment.size() - pos).asBytes());
+      }
+    }
+    pieces.add(ours[0].asBytes());
+    forwardedPieces = pieces.releaseAsArray();
+
+    size_t bytes = 0;
+    for (auto& piece: forwardedPieces) {
+      bytes += piece.size();
+    }
+    network.countSent(bytes);
+
+    return network.stream.write(forwardedPieces);
+  }
 };
 
+TwoPartyVatNetwork::~TwoPartyVatNetwork() noexcept(false) {}
+
+void TwoPartyVatNetwork::countSent(size_t bytes) {
+  KJ_IF_MAYBE(m, metrics) {
+    auto& traffic = m->getTrafficStats();
+    ++traffic.messagesSent;
+    traffic.bytesSent += bytes;
+  }
+}
+
+void TwoPartyVatNetwork::countReceived(size_t bytes) {
+  KJ_IF_MAYBE(m, metrics) {
+    auto& traffic = m->getTrafficStats();
+    ++traffic.messagesReceived;
+    traffic.bytesReceived += bytes;
+  }
+}
+
+kj::Promise<void> TwoPartyVatNetwork::writeNextMessage() {
+  // Called once per message sent, each time after the previous write completes.  The message may
+  // already have been written as part of an earlier batch, in which case there's nothing to do.
+
+  if (sendQueueHead == sendQueue.size()) {
+    return kj::READY_NOW;
+  }
+
+  auto message = popMessage(sendQueueHead + chooseNextMessage());
+
+  if (message->isBatchable()) {
+    kj::Vector<kj::Own<OutgoingMessageImpl>> batch;
+    size_t words = message->getSize();
+    batch.add(kj::mv(message));
+
+    // Extend the batch with the messages that would be written next anyway.
+    while (sendQueueHead < sendQueue.size()) {
+      auto& next = *sendQueue[sendQueueHead];
+      if (!next.isBatchable() || words + next.getSize() > BATCH_LIMIT_WORDS ||
+          chooseNextMessage() != 0) {
+        break;
+      }
+      words += next.getSize();
+      batch.add(popMessage(sendQueueHead));
+    }
+
+    if (batch.size() > 1) {
+      return writeBatch(kj::mv(batch));
+    }
+    message = kj::mv(batch[0]);
+  }
+
+  auto promise = message->write();
+  // Note that the message (and any capabilities in it) is released as soon as the write
+  // completes, not when the next message is written.
+  return promise.attach(kj::mv(message));
+}
+
+kj::Own<TwoPartyVatNetwork::OutgoingMessageImpl> TwoPartyVatNetwork::popMessage(size_t index) {
+  // Removes the message at `index` (not relative to the head) from the send queue.
+
+  auto message = kj::mv(sendQueue[index]);
+  for (size_t i = index; i > sendQueueHead; i--) {
+    sendQueue[i] = kj::mv(sendQueue[i - 1]);
+  }
+  ++sendQueueHead;
+
+  if (sendQueueHead == sendQueue.size()) {
+    sendQueue.clear();
+    sendQueueHead = 0;
+  } else if (sendQueueHead >= REORDER_WINDOW && sendQueueHead * 2 >= sendQueue.size()) {
+    // Reclaim the space at the front.
+    for (size_t i = sendQueueHead; i < sendQueue.size(); i++) {
+      sendQueue[i - sendQueueHead] = kj::mv(sendQueue[i]);
+    }
+    sendQueue.truncate(sendQueue.size() - sendQueueHead);
+    sendQueueHead = 0;
+  }
+
+  return kj::mv(message);
+}
+
+kj::Promise<void> TwoPartyVatNetwork::writeBatch(
+    kj::Vector<kj::Own<OutgoingMessageImpl>>&& batch) {
+  auto flat = KJ_MAP(message, batch) { return message->flatten(); };
+  auto pieces = KJ_MAP(words, flat) { return kj::ArrayPtr<const byte>(words.asBytes()); };
+
+  auto promise = stream.write(pieces);
+  return promise.attach(kj::mv(pieces), kj::mv(flat), kj::mv(batch));
+}
+
+size_t TwoPartyVatNetwork::chooseNextMessage() {
+  // Returns the position, relative to the head of the queue, of the message to write next:  the
+  // highest-priority message within the window which may overtake every message ahead of it, or
+  // the earliest such message if there's a tie.
+
+  auto queue = sendQueue.slice(sendQueueHead, sendQueue.size());
+  size_t window = kj::min(queue.size(), REORDER_WINDOW);
+  size_t result = 0;
+  if (!queue[0]->isReorderable()) return 0;
+
+  for (size_t i = 1; i < window; i++) {
+    auto& candidate = *queue[i];
+    if (!candidate.isReorderable()) {
+      // Nothing may overtake this message, so there's no point looking further.
+      break;
+    }
+    if (candidate.getPriority() <= queue[result]->getPriority()) continue;
+
+    bool ok = true;
+    for (size_t j = 0; j < i; j++) {
+      if (!candidate.mayOvertake(*queue[j])) {
+        ok = false;
+        break;
+      }
+    }
+    if (ok) result = i;
+  }
+
+  return result;
+}
+
 class TwoPartyVatNetwork::IncomingMessageImpl final: public IncomingRpcMessage {
 public:
   IncomingMessageImpl(kj::Own<MessageReader> message): message(kj::mv(message)) {}
@@ -119,8 +769,23 @@ public:
     return message->getRoot<AnyPointer>();
   }
 
+  kj::ArrayPtr<const kj::ArrayPtr<const word>> getRawSegments() override {
+    if (segments == nullptr) {
+      // The reader returns a null array (as opposed to an empty one) past the last segment.
+      kj::Vector<kj::ArrayPtr<const word>> result;
+      for (;;) {
+        auto segment = message->getSegment(result.size());
+        if (segment.begin() == nullptr) break;
+        result.add(segment);
+      }
+      segments = result.releaseAsArray();
+    }
+    return segments;
+  }
+
 private:
   kj::Own<MessageReader> message;
+  kj::Array<kj::ArrayPtr<const word>> segments;
 };
 
 rpc::twoparty::VatId::Reader TwoPartyVatNetwork::getPeerVatId() {
@@ -132,20 +797,164 @@ kj::Own<OutgoingRpcMessage> TwoPartyVatNetwork::newOutgoingMessage(uint firstSeg
 }
 
 kj::Promise<kj::Maybe<kj::Own<IncomingRpcMessage>>> TwoPartyVatNetwork::receiveIncomingMessage() {
+  KJ_IF_MAYBE(k, keepalive) {
+    return receiveFrame().exclusiveJoin(k->reaped.addBranch().then(
+        []() -> kj::Maybe<kj::Own<IncomingRpcMessage>> {
+      KJ_UNREACHABLE;  // only ever rejected
+    }));
+  } else {
+    return receiveFrame();
+  }
+}
+
+kj::AsyncInputStream& TwoPartyVatNetwork::getInput() {
+  KJ_IF_MAYBE(k, keepalive) {
+    if (k->input.get() != nullptr) {
+      return *k->input;
+    }
+  }
+  return stream;
+}
+
+kj::Promise<kj::Maybe<kj::Own<IncomingRpcMessage>>> TwoPartyVatNetwork::receiveFrame() {
+  if (plainPeer && !sentHello) {
+    // Neither side sends control frames, so every frame is a message.
+    return kj::evalLater([&]() {
+      return tryReadMessage(getInput(), receiveOptions)
+          .then([&](kj::Maybe<kj::Own<MessageReader>>&& message)
+                -> kj::Maybe<kj::Own<IncomingRpcMessage>> {
+        KJ_IF_MAYBE(m, message) {
+          auto incoming = kj::heap<IncomingMessageImpl>(kj::mv(*m));
+          if (metrics != nullptr) {
+            countReceived(computeSerializedSizeInWords(incoming->getRawSegments()) * sizeof(word));
+          }
+          noteReceived();
+          noteMessage();
+          return kj::Own<IncomingRpcMessage>(kj::mv(incoming));
+        } else {
+          return nullptr;
+        }
+      });
+    });
+  }
+
   return kj::evalLater([&]() {
-    return tryReadMessage(stream, receiveOptions)
-        .then([&](kj::Maybe<kj::Own<MessageReader>>&& message)
-              -> kj::Maybe<kj::Own<IncomingRpcMessage>> {
-      KJ_IF_MAYBE(m, message) {
-        return kj::Own<IncomingRpcMessage>(kj::heap<IncomingMessageImpl>(kj::mv(*m)));
-      } else {
-        return nullptr;
+    // Read the first word ourselves so that we can tell control frames apart from messages.
+    return getInput().tryRead(&frameHeader[0], sizeof(word), sizeof(word))
+        .then([&](size_t n) -> kj::Promise<kj::Maybe<kj::Own<IncomingRpcMessage>>> {
+      if (n == 0) {
+        return kj::Maybe<kj::Own<IncomingRpcMessage>>(nullptr);
       }
+      KJ_REQUIRE(n == sizeof(word), "Premature EOF.") {
+        return kj::Maybe<kj::Own<IncomingRpcMessage>>(nullptr);
+      }
+      noteReceived();
+
+      auto header = reinterpret_cast<_::WireValue<uint32_t>*>(frameHeader);
+      if (header[0].get() == CONTROL_FRAME) {
+        receivedControlFrame = true;
+        return receiveControlFrame(header[1].get() & 0xff, header[1].get() >> 8);
+      }
+      if (!receivedControlFrame) {
+        // The peer's first frame is a message, so it didn't say hello.
+        plainPeer = true;
+      }
+
+      auto prefixed = kj::heap<PrefixedInputStream>(
+          kj::arrayPtr(&frameHeader[0], 1).asBytes(), getInput());
+      auto promise = tryReadMessage(*prefixed, receiveOptions);
+      auto& prefixedRef = *prefixed;
+      return promise
+          .then([this,&prefixedRef](kj::Maybe<kj::Own<MessageReader>>&& message)
+                -> kj::Maybe<kj::Own<IncomingRpcMessage>> {
+        KJ_IF_MAYBE(m, message) {
+          countReceived(prefixedRef.getBytesRead());
+          noteMessage();
+          return kj::Own<IncomingRpcMessage>(kj::heap<IncomingMessageImpl>(kj::mv(*m)));
+        } else {
+          return nullptr;
+        }
+      }).attach(kj::mv(prefixed));
     });
   });
 }
 
+kj::Promise<kj::Maybe<kj::Own<IncomingRpcMessage>>> TwoPartyVatNetwork::receiveControlFrame(
+    uint32_t type, uint32_t argument) {
+  switch (type) {
+    case FRAME_HELLO:
+      peerCodecs = argument;
+      return receiveFrame();
+
+    case FRAME_PING:
+      writeControlFrame(pongFrame);
+      return receiveFrame();
+
+    case FRAME_PONG:
+      // Receiving it was the point.
+      return receiveFrame();
+
+    case FRAME_PACKED:
+      KJ_REQUIRE(compression.enabled, "Peer sent a compressed message without negotiation.") {
+        return kj::Maybe<kj::Own<IncomingRpcMessage>>(nullptr);
+      }
+      return getInput().read(&frameHeader[1], sizeof(word))
+          .then([this]() -> kj::Promise<kj::Maybe<kj::Own<IncomingRpcMessage>>> {
+        auto sizes = reinterpret_cast<_::WireValue<uint32_t>*>(&frameHeader[1]);
+        size_t packedBytes = sizes[0].get();
+        size_t unpackedWords = sizes[1].get();
+
+        KJ_REQUIRE(unpackedWords <= receiveOptions.traversalLimitInWords,
+                   "Message is too large.  To increase the limit on the receiving end, see "
+                   "capnp::ReaderOptions.") {
+          return kj::Maybe<kj::Own<IncomingRpcMessage>>(nullptr);
+        }
+        // Packing never more than doubles the size of a word, plus a little for run lengths.
+        KJ_REQUIRE(packedBytes <= unpackedWords * sizeof(word) * 2,
+                   "Compressed message is larger than its uncompressed size allows.") {
+          return kj::Maybe<kj::Own<IncomingRpcMessage>>(nullptr);
+        }
+
+        compressionStats.uncompressedBytesReceived += unpackedWords * sizeof(word);
+        compressionStats.compressedBytesReceived += sizeof(frameHeader) + packedBytes;
+        countReceived(sizeof(frameHeader) + packedBytes);
+
+        auto body = kj::heapArray<byte>(packedBytes);
+        auto promise = getInput().read(body.begin(), body.size());
+        return promise.then(kj::mvCapture(body,
+            [this,unpackedWords](kj::Array<byte>&& body)
+            -> kj::Maybe<kj::Own<IncomingRpcMessage>> {
+          auto words = kj::heapArray<word>(unpackedWords);
+          kj::ArrayInputStream input(body);
+          _::PackedInputStream unpacker(input);
+          unpacker.read(words.begin(), words.size() * sizeof(word));
+
+          noteMessage();
+          return kj::Own<IncomingRpcMessage>(kj::heap<IncomingMessageImpl>(
+              kj::heap<UnpackedMessageReader>(kj::mv(words), receiveOptions)));
+        }));
+      });
+
+    default:
+      KJ_FAIL_REQUIRE("Unknown frame type; peer may be newer than us.", type) {
+        return kj::Maybe<kj::Own<IncomingRpcMessage>>(nullptr);
+      }
+  }
+}
+
 kj::Promise<void> TwoPartyVatNetwork::shutdown() {
+  KJ_IF_MAYBE(k, keepalive) {
+    if (k->isReaped) {
+      // The peer may be unreachable, so don't wait for queued writes, which may never complete.
+      KJ_ASSERT(previousWrite != nullptr, "already shut down");
+      previousWrite = nullptr;
+      sendQueue.clear();
+      sendQueueHead = 0;
+      stream.shutdownWrite();
+      return kj::READY_NOW;
+    }
+  }
+
   kj::Promise<void> result = KJ_ASSERT_NONNULL(previousWrite, "already shut down").then([this]() {
     stream.shutdownWrite();
   });
@@ -158,6 +967,11 @@ kj::Promise<void> TwoPartyVatNetwork::shutdown() {
 TwoPartyServer::TwoPartyServer(Capability::Client bootstrapInterface)
     : bootstrapInterface(kj::mv(bootstrapInterface)), tasks(*this) {}
 
+void TwoPartyServer::setKeepalive(kj::Timer& timer, TwoPartyKeepaliveOptions options) {
+  this->timer = timer;
+  keepaliveOptions = options;
+}
+
 struct TwoPartyServer::AcceptedConnection {
   kj::Own<kj::AsyncIoStream> connection;
   TwoPartyVatNetwork network;
@@ -172,6 +986,9 @@ struct TwoPartyServer::AcceptedConnection {
 
 void TwoPartyServer::accept(kj::Own<kj::AsyncIoStream>&& connection) {
   auto connectionState = kj::heap<AcceptedConnection>(bootstrapInterface, kj::mv(connection));
+  KJ_IF_MAYBE(t, timer) {
+    connectionState->network.setKeepalive(*t, keepaliveOptions);
+  }
 
   // Run the connection until disconnect.
   auto promise = connectionState->network.onDisconnect();
@@ -39,6 +39,80 @@ namespace rpc {
   }
 }
 
+struct TwoPartyCompressionOptions {
+  // Options controlling compression of messages sent by a `TwoPartyVatNetwork`.
+
+  bool enabled = false;
+  // If true, the network announces to the peer (with a small control frame written before any
+  // message) that it accepts compressed messages, and compresses its own messages once the peer has
+  // made the same announcement.  Compression is thus negotiated per connection:  a side that does
+  // not enable it never sends compressed messages and is never sent any.
+  //
+  // The announcement is not understood by implementations that predate this option, so only
+  // enable it when the peer is known to be built from a version that has it (whether or not the
+  // peer enables it too).
+  //
+  // The only codec currently offered is Cap'n Proto's own packing (see serialize-packed.h), which
+  // is cheap and does well on messages dominated by zero bytes (small integers, unset fields,
+  // default-valued pointers).  Messages which packing fails to shrink are sent raw.
+
+  uint thresholdWords = 128;
+  // Messages smaller than this many words are always sent raw, since the bandwidth saved would
+  // not pay for the CPU spent compressing them.
+};
+
+struct TwoPartyCompressionStats {
+  // Byte counters for messages that were sent or received compressed.  Messages sent raw are not
+  // counted.
+
+  uint64_t uncompressedBytesSent = 0;
+  uint64_t compressedBytesSent = 0;
+  // Size of the compressed messages we sent, before and after compression.  The latter includes
+  // framing.
+
+  uint64_t uncompressedBytesReceived = 0;
+  uint64_t compressedBytesReceived = 0;
+  // Likewise for messages received from the peer.
+};
+
+struct TwoPartyKeepaliveOptions {
+  // Options for detecting dead peers and reaping idle connections.  See
+  // `TwoPartyVatNetwork::setKeepalive()`.  A zero duration disables the corresponding check.
+
+  kj::Duration pingInterval = 0 * kj::SECONDS;
+  // If nothing has been received from the peer for this long, send it a ping, which it answers
+  // right away whether or not it has pings enabled itself.  Pings are sent as control frames (see
+  // `TwoPartyCompressionOptions`), announced by a HELLO frame at the start of the connection, so
+  // only enable them when the peer is known to be built from a version that has them.
+
+  kj::Duration pingTimeout = 0 * kj::SECONDS;
+  // Disconnect if nothing at all is received within this long after sending a ping.  Defaults to
+  // `pingInterval` when pings are enabled.
+
+  kj::Duration idleTimeout = 0 * kj::SECONDS;
+  // Disconnect if no RPC message has been sent or received for this long.  Pings and other
+  // control frames don't count, so a connection that is merely being kept alive still times out.
+
+  kj::Duration maxConnectionAge = 0 * kj::SECONDS;
+  // Disconnect once the connection has been open this long, however busy it is.  Useful to make
+  // clients reconnect now and then, e.g. so that load balancers can rebalance.
+};
+
+struct TwoPartyConnectionActivity {
+  // Timestamps describing when a connection was last used, in terms of the timer given to
+  // `TwoPartyVatNetwork::setKeepalive()`.
+
+  kj::TimePoint connected = kj::origin<kj::TimePoint>();
+  // When setKeepalive() was called, which is normally right after connecting.
+
+  kj::TimePoint lastReceived = kj::origin<kj::TimePoint>();
+  // When anything -- a message, a ping, or an answer to one -- was last received.  When pings are
+  // enabled, this also advances while a large message is still arriving.
+
+  kj::TimePoint lastMessage = kj::origin<kj::TimePoint>();
+  // When the last RPC message was sent or received.
+};
+
 typedef VatNetwork<rpc::twoparty::VatId, rpc::twoparty::ProvisionId,
     rpc::twoparty::RecipientId, rpc::twoparty::ThirdPartyCapId, rpc::twoparty::JoinResult>
     TwoPartyVatNetworkBase;
@@ -53,7 +127,9 @@ class TwoPartyVatNetwork: public TwoPartyVatNetworkBase,
 
 public:
   TwoPartyVatNetwork(kj::AsyncIoStream& stream, rpc::twoparty::Side side,
-                     ReaderOptions receiveOptions = ReaderOptions());
+                     ReaderOptions receiveOptions = ReaderOptions(),
+                     TwoPartyCompressionOptions compression = TwoPartyCompressionOptions());
+  ~TwoPartyVatNetwork() noexcept(false);
   KJ_DISALLOW_COPY(TwoPartyVatNetwork);
 
   kj::Promise<void> onDisconnect() { return disconnectPromise.addBranch(); }
@@ -61,6 +137,23 @@ public:
 
   rpc::twoparty::Side getSide() { return side; }
 
+  const TwoPartyCompressionStats& getCompressionStats() { return compressionStats; }
+  // Returns counters describing how much compression has saved on this connection so far.
+
+  void setMetrics(RpcMetrics& metrics) { this->metrics = metrics; }
+  // Counts the messages and bytes sent and received from now on in `metrics`, which must outlive
+  // the network.  See rpc-metrics.h.
+
+  void setKeepalive(kj::Timer& timer, TwoPartyKeepaliveOptions options);
+  // Starts tracking the connection's activity with `timer`, and enforces the given options.  When
+  // the peer stops answering pings or the connection outlives its idle timeout or maximum age, the
+  // RPC system sees the connection fail with a DISCONNECTED exception, and anything queued for
+  // writing to the peer is dropped, so that the connection's resources are released even if the
+  // peer is unreachable.  Call at most once, before the RpcSystem starts using the network.
+
+  TwoPartyConnectionActivity getActivity();
+  // Returns when the connection was last used.  Requires setKeepalive() to have been called.
+
   // implements VatNetwork -----------------------------------------------------
 
   kj::Maybe<kj::Own<TwoPartyVatNetworkBase::Connection>> connect(
@@ -77,9 +170,61 @@ private:
   ReaderOptions receiveOptions;
   bool accepted = false;
 
+  kj::Maybe<RpcMetrics&> metrics;
+
+  TwoPartyCompressionOptions compression;
+  TwoPartyCompressionStats compressionStats;
+  uint32_t peerCodecs = 0;
+  // Set of codecs which the peer announced it accepts.  Zero until (unless) its announcement
+  // arrives.
+
+  bool sentHello = false;
+  bool receivedControlFrame = false;
+  bool plainPeer = false;
+  // Whether we started with a HELLO frame, whether the peer has sent any control frame, and
+  // whether its first frame was a message instead, meaning that it won't send any.  Unless one of
+  // us sent a HELLO, we skip looking for control frames.
+
+  word helloFrame;
+  word pingFrame;
+  word pongFrame;
+  word frameHeader[2];
+  // Buffers for the control frames we send and for the header of the frame being received.
+
+  struct Keepalive {
+    kj::Timer& timer;
+    TwoPartyKeepaliveOptions options;
+    TwoPartyConnectionActivity activity;
+    kj::Maybe<kj::TimePoint> pingSent;
+    // When we sent a ping that hasn't been followed by anything received yet.
+
+    kj::Own<kj::AsyncInputStream> input;
+    // Wraps `stream` to keep `activity.lastReceived` up to date as bytes arrive.  Only set when
+    // pings are enabled; otherwise `stream` is read directly and `lastReceived` is updated per
+    // frame.
+
+    kj::Own<kj::PromiseFulfiller<void>> reaper;
+    kj::ForkedPromise<void> reaped;
+    // Rejected when the connection is reaped, to abort reading.
+
+    kj::Promise<void> watchdog;
+    bool isReaped = false;
+
+    Keepalive(kj::Timer& timer, TwoPartyKeepaliveOptions options);
+  };
+  kj::Maybe<Keepalive> keepalive;
+
+  kj::Vector<kj::Own<OutgoingMessageImpl>> sendQueue;
+  size_t sendQueueHead = 0;
+  // Messages which have been sent but not yet written, starting at `sendQueueHead`.  Usually they
+  // are written in order, but a message given a priority by the RPC system may be written ahead of
+  // lower-priority ones which it doesn't need to follow.  Runs of small messages (typically the
+  // Finish and Release messages sent when many calls complete or many capabilities are dropped at
+  // once) are coalesced into a single write.
+
   kj::Maybe<kj::Promise<void>> previousWrite;
-  // Resolves when the previous write completes.  This effectively serves as the write queue.
-  // Becomes null when shutdown() is called.
+  // Resolves when the previous write completes.  Each message sent appends one link to this chain,
+  // which writes the next message chosen from `sendQueue`.  Becomes null when shutdown() is called.
 
   kj::Own<kj::PromiseFulfiller<kj::Own<TwoPartyVatNetworkBase::Connection>>> acceptFulfiller;
   // Fulfiller for the promise returned by acceptConnectionAsRefHost() on the client side, or the
@@ -111,6 +256,23 @@ private:
   kj::Own<OutgoingRpcMessage> newOutgoingMessage(uint firstSegmentWordSize) override;
   kj::Promise<kj::Maybe<kj::Own<IncomingRpcMessage>>> receiveIncomingMessage() override;
   kj::Promise<void> shutdown() override;
+
+  kj::AsyncInputStream& getInput();
+  kj::Promise<kj::Maybe<kj::Own<IncomingRpcMessage>>> receiveFrame();
+  kj::Promise<kj::Maybe<kj::Own<IncomingRpcMessage>>> receiveControlFrame(
+      uint32_t type, uint32_t argument);
+
+  kj::Promise<void> writeNextMessage();
+  size_t chooseNextMessage();
+  kj::Own<OutgoingMessageImpl> popMessage(size_t index);
+  kj::Promise<void> writeBatch(kj::Vector<kj::Own<OutgoingMessageImpl>>&& batch);
+  void countSent(size_t bytes);
+  void countReceived(size_t bytes);
+  void writeControlFrame(word& frame);
+  void sendHello(uint32_t codecs);
+  void noteMessage();
+  void noteReceived();
+  kj::Promise<void> watchActivity();
 };
 
 class TwoPartyServer: private kj::TaskSet::ErrorHandler {
@@ -128,10 +290,17 @@ public:
   // exception is thrown while trying to accept. You may discard the returned promise to cancel
   // listening.
 
+  void setKeepalive(kj::Timer& timer, TwoPartyKeepaliveOptions options);
+  // Applies the given keepalive options to each connection accepted from now on.  See
+  // `TwoPartyVatNetwork::setKeepalive()`.
+
 private:
   Capability::Client bootstrapInterface;
   kj::TaskSet tasks;
 
+  kj::Maybe<kj::Timer&> timer;
+  TwoPartyKeepaliveOptions keepaliveOptions;
+
   struct AcceptedConnection;
 
   void taskFailed(kj::Exception&& exception) override;
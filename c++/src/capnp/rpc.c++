@@ -20,6 +20,8 @@
 // THE SOFTWARE.
 
 #include "rpc.h"
+#include "rpc-metrics.h"
+#include "rpc-trace.h"
 #include "message.h"
 #include <kj/debug.h>
 #include <kj/vector.h>
@@ -54,6 +56,20 @@ constexpr const uint CAP_DESCRIPTOR_SIZE_HINT = sizeInWords<rpc::CapDescriptor>(
 
 constexpr const uint64_t MAX_SIZE_HINT = 1 << 20;
 
+constexpr const uint FORWARD_IN_PLACE_THRESHOLD = 1024;
+// When a call received over one connection is forwarded over another, and the message carrying it
+// is at least this many words, we try to send the original message's segments along in-place
+// rather than copying the params.  For small messages the copy is cheap anyway.
+
+inline constexpr uint64_t importOrderingKey(uint32_t importId) {
+  return (uint64_t(1) << 32) | importId;
+}
+inline constexpr uint64_t questionOrderingKey(uint32_t questionId) {
+  return (uint64_t(2) << 32) | questionId;
+}
+// Keys passed to `OutgoingRpcMessage::setPriority()`.  Two messages which mention the same import
+// or question must stay in order; messages which mention disjoint sets may be reordered.
+
 uint copySizeHint(MessageSize size) {
   uint64_t sizeHint = size.wordCount + size.capCount * CAP_DESCRIPTOR_SIZE_HINT;
   return kj::min(MAX_SIZE_HINT, sizeHint);
@@ -186,6 +202,10 @@ public:
     }
   }
 
+  size_t size() {
+    return slots.size() - freeIds.size();
+  }
+
   template <typename Func>
   void forEach(Func&& func) {
     for (Id i = 0; i < slots.size(); i++) {
@@ -240,6 +260,16 @@ public:
     }
   }
 
+  template <typename Func>
+  size_t count(Func&& isInUse) {
+    // Counts the entries for which `isInUse` returns true.  Entries in `high` are always in use.
+    size_t result = high.size();
+    for (auto& entry: low) {
+      if (isInUse(entry)) ++result;
+    }
+    return result;
+  }
+
   template <typename Func>
   void forEach(Func&& func) {
     for (Id i: kj::indices(low)) {
@@ -405,6 +435,29 @@ public:
     maybeUnblockFlow();
   }
 
+  void setTimer(kj::Timer& timer) {
+    this->timer = timer;
+  }
+
+  void setMetrics(RpcMetrics& metrics) {
+    this->metrics = metrics;
+  }
+
+  void setTracer(RpcTracer& tracer) {
+    this->tracer = tracer;
+  }
+
+  RpcMetrics::TableSizes getTableSizes() {
+    RpcMetrics::TableSizes result;
+    result.questions = questions.size();
+    result.answers = answers.count([](Answer& answer) { return answer.active; });
+    result.exports = exports.size();
+    result.imports = imports.count([](Import& import) {
+      return import.importClient != nullptr || import.appClient != nullptr;
+    });
+    return result;
+  }
+
 private:
   class RpcClient;
   class ImportClient;
@@ -451,6 +504,13 @@ private:
     bool skipFinish = false;
     // If true, don't send a Finish message.
 
+    kj::Maybe<RpcMetrics::MethodStats&> methodStats;
+    kj::TimePoint sendTime = kj::origin<kj::TimePoint>();
+    // If metrics are enabled, where to record the call's latency, and when it was sent.
+
+    kj::Maybe<kj::Own<RpcTracer::Span>> trace;
+    // If tracing is enabled, the caller's span for this call.
+
     inline bool operator==(decltype(nullptr)) const {
       return !isAwaitingReturn && selfRef == nullptr;
     }
@@ -482,6 +542,10 @@ private:
     kj::Array<ExportId> resultExports;
     // List of exports that were sent in the results.  If the finish has `releaseResultCaps` these
     // will need to be released.
+
+    kj::Maybe<kj::Own<RpcTracer::Span>> trace;
+    // If tracing is enabled, the callee's span for this call.  `callContext` holds a reference to
+    // it, so it mustn't be replaced while the call is active.
   };
 
   struct Export {
@@ -561,6 +625,15 @@ private:
   size_t flowLimit;
   size_t callWordsInFlight = 0;
 
+  kj::Maybe<kj::Timer&> timer;
+  // Used to enforce the timeouts of incoming calls.  See RpcSystem::setTimer().
+
+  kj::Maybe<RpcMetrics&> metrics;
+  // See RpcSystem::setMetrics().
+
+  kj::Maybe<RpcTracer&> tracer;
+  // See RpcSystem::setTracer().
+
   kj::Maybe<kj::Own<kj::PromiseFulfiller<void>>> flowWaiter;
   // If non-null, we're currently blocking incoming messages waiting for callWordsInFlight to drop
   // below flowLimit. Fulfill this to un-block.
@@ -598,6 +671,11 @@ private:
     // that other client -- return a reference to the other client, transitively.  Otherwise,
     // return a new reference to *this.
 
+    virtual bool isSettledImport() { return false; }
+    // Returns true if every call made on this client will be addressed to the same import table
+    // entry.  Only calls on such clients may be reordered relative to calls on other capabilities,
+    // since calls on a promise must keep their order across its resolution.
+
     // implements ClientHook -----------------------------------------
 
     Request<AnyPointer, AnyPointer> newCall(
@@ -639,13 +717,21 @@ private:
 
     Request<AnyPointer, AnyPointer> newCallNoIntercept(
         uint64_t interfaceId, uint16_t methodId, kj::Maybe<MessageSize> sizeHint) {
+      return newCallNoIntercept(kj::addRef(*this), interfaceId, methodId, sizeHint);
+    }
+
+    Request<AnyPointer, AnyPointer> newCallNoIntercept(
+        kj::Own<RpcClient>&& self, uint64_t interfaceId, uint16_t methodId,
+        kj::Maybe<MessageSize> sizeHint) {
+      // `self` is the reference to this client which the request will hold.
+
       if (!connectionState->connection.is<Connected>()) {
         return newBrokenRequest(kj::cp(connectionState->connection.get<Disconnected>()), sizeHint);
       }
 
       auto request = kj::heap<RpcRequest>(
           *connectionState, *connectionState->connection.get<Connected>(),
-          sizeHint, kj::addRef(*this));
+          sizeHint, kj::mv(self));
       auto callBuilder = request->getCall();
 
       callBuilder.setInterfaceId(interfaceId);
@@ -684,16 +770,44 @@ private:
                                            kj::Own<CallContextHook>&& context) {
       // Implement call() by copying params and results messages.
 
-      auto params = context->getParams();
-      auto request = newCallNoIntercept(interfaceId, methodId, params.targetSize());
+      kj::Own<RequestHook> request;
+
+      KJ_IF_MAYBE(raw, connectionState->connection.is<Connected>()
+                       ? context->detachRawParams() : nullptr) {
+        // The params are still sitting in the message they arrived in (we're probably proxying a
+        // call from another connection), so try to send that along instead of copying.
+        auto forwarded = kj::heap<RpcRequest>(
+            *connectionState, *connectionState->connection.get<Connected>(),
+            kj::mv(*raw), kj::addRef(*this));
+        auto callBuilder = forwarded->getCall();
+        callBuilder.setInterfaceId(interfaceId);
+        callBuilder.setMethodId(methodId);
+        request = kj::mv(forwarded);
+      } else {
+        auto params = context->getParams();
+        auto copy = newCallNoIntercept(interfaceId, methodId, params.targetSize());
 
-      request.set(params);
-      context->releaseParams();
+        copy.set(params);
+        context->releaseParams();
+        request = RequestHook::from(kj::mv(copy));
+      }
+
+      if (connectionState->tracer != nullptr) {
+        // The call we're forwarding is the parent of the one we're about to make.
+        request->setTraceParent(context->getTraceContext());
+      }
+
+      KJ_IF_MAYBE(deadline, context->getDeadline()) {
+        KJ_IF_MAYBE(t, connectionState->timer) {
+          // Whoever is waiting on the call we're forwarding gives up at the same time.
+          request->setTimeout(*t, *deadline - t->now());
+        }
+      }
 
       // We can and should propagate cancellation.
       context->allowCancellation();
 
-      return context->directTailCall(RequestHook::from(kj::mv(request)));
+      return context->directTailCall(kj::mv(request));
     }
 
     kj::Own<ClientHook> addRef() override {
@@ -731,6 +845,8 @@ private:
           rpc::Release::Builder builder = message->getBody().initAs<rpc::Message>().initRelease();
           builder.setId(importId);
           builder.setReferenceCount(remoteRefcount);
+          uint64_t key = importOrderingKey(importId);
+          message->setPriority(CallPriority::HIGH, kj::arrayPtr(&key, 1));
           message->send();
         }
       });
@@ -741,6 +857,12 @@ private:
       ++remoteRefcount;
     }
 
+    void setIsPromise() {
+      // Indicates that the import is a promise, so the PromiseClient wrapping it may start
+      // directing calls elsewhere at any time.
+      isPromise = true;
+    }
+
     kj::Maybe<ExportId> writeDescriptor(rpc::CapDescriptor::Builder descriptor) override {
       descriptor.setReceiverHosted(importId);
       return nullptr;
@@ -756,8 +878,25 @@ private:
       return kj::addRef(*this);
     }
 
+    bool isSettledImport() override {
+      return !isPromise;
+    }
+
     // implements ClientHook -----------------------------------------
 
+    Request<AnyPointer, AnyPointer> newCallWithRef(
+        kj::Own<ClientHook>&& self, uint64_t interfaceId, uint16_t methodId,
+        kj::Maybe<MessageSize> sizeHint) override {
+      if (interfaceId == typeId<Persistent<>>() && methodId == 0 &&
+          connectionState->gateway != nullptr) {
+        // Needs translating through the gateway; see RpcClient::newCall().
+        return ClientHook::newCallWithRef(kj::mv(self), interfaceId, methodId, sizeHint);
+      }
+
+      KJ_DASSERT(self.get() == this);
+      return newCallNoIntercept(self.downcast<RpcClient>(), interfaceId, methodId, sizeHint);
+    }
+
     kj::Maybe<ClientHook&> getResolved() override {
       return nullptr;
     }
@@ -768,6 +907,7 @@ private:
 
   private:
     ImportId importId;
+    bool isPromise = false;
 
     uint remoteRefcount = 0;
     // Number of times we've received this import from the peer.
@@ -1028,6 +1168,10 @@ private:
       return inner->getInnermostClient();
     }
 
+    bool isSettledImport() override {
+      return inner->isSettledImport();
+    }
+
     Request<AnyPointer, AnyPointer> newCall(
         uint64_t interfaceId, uint16_t methodId, kj::Maybe<MessageSize> sizeHint) override {
       return inner->newCallNoIntercept(interfaceId, methodId, sizeHint);
@@ -1238,6 +1382,8 @@ private:
     importClient->addRemoteRef();
 
     if (isPromise) {
+      importClient->setIsPromise();
+
       // We need to construct a PromiseClient around this import, if we haven't already.
       KJ_IF_MAYBE(c, import.appClient) {
         // Use the existing one.
@@ -1344,7 +1490,13 @@ private:
           // already received the return, then we've already built local proxies for the caps and
           // will send Release messages when those are destroyed.
           builder.setReleaseResultCaps(question.isAwaitingReturn);
+          uint64_t key = questionOrderingKey(id);
+          message->setPriority(CallPriority::HIGH, kj::arrayPtr(&key, 1));
           message->send();
+
+          KJ_IF_MAYBE(t, question.trace) {
+            t->get()->record(RpcTracer::Event::FINISH);
+          }
         }
 
         // Check if the question has returned and, if so, remove it from the table.
@@ -1393,6 +1545,20 @@ private:
           callBuilder(message->getBody().getAs<rpc::Message>().initCall()),
           paramsBuilder(capTable.imbue(callBuilder.getParams().getContent())) {}
 
+    RpcRequest(RpcConnectionState& connectionState, VatNetworkBase::Connection& connection,
+               kj::Own<RawCallParams>&& params, kj::Own<RpcClient>&& target)
+        : connectionState(kj::addRef(connectionState)),
+          target(kj::mv(target)),
+          message(connection.newOutgoingMessage(
+              firstSegmentSize(MessageSize { 0, uint(params->getCapTable().size()) },
+                  messageSizeHint<rpc::Call>() + sizeInWords<rpc::Payload>() +
+                  MESSAGE_TARGET_SIZE_HINT + 2))),  // +2 for a landing pad
+          callBuilder(message->getBody().getAs<rpc::Message>().initCall()),
+          paramsBuilder(capTable.imbue(callBuilder.getParams().getContent())),
+          forwardedParams(kj::mv(params)) {}
+    // Constructs a request whose params are `params`, which will be sent in-place if the network
+    // supports it, or else copied at send time.  The caller must not use getRoot().
+
     inline AnyPointer::Builder getRoot() {
       return paramsBuilder;
     }
@@ -1409,13 +1575,28 @@ private:
             AnyPointer::Pipeline(newBrokenPipeline(kj::cp(e))));
       }
 
+      if (timer != nullptr && timeout <= 0 * kj::NANOSECONDS) {
+        // Don't bother the callee with a call nobody is waiting for.
+        auto e = KJ_EXCEPTION(OVERLOADED, "Call's deadline passed before it was sent.",
+                              callBuilder.getInterfaceId(), callBuilder.getMethodId());
+        return RemotePromise<AnyPointer>(
+            kj::Promise<Response<AnyPointer>>(kj::cp(e)),
+            AnyPointer::Pipeline(newBrokenPipeline(kj::mv(e))));
+      }
+
       KJ_IF_MAYBE(redirect, target->writeTarget(callBuilder.getTarget())) {
         // Whoops, this capability has been redirected while we were building the request!
         // We'll have to make a new request and do a copy.  Ick.
 
+        copyForwardedParams();
         auto replacement = redirect->get()->newCall(
             callBuilder.getInterfaceId(), callBuilder.getMethodId(), paramsBuilder.targetSize());
         replacement.set(paramsBuilder);
+        KJ_IF_MAYBE(t, timer) {
+          replacement.setTimeout(*t, timeout);
+        }
+        replacement.setPriority(priority);
+        replacement.setTraceParent(traceParent);
         return replacement.send();
       } else {
         auto sendResult = sendInternal(false);
@@ -1432,6 +1613,10 @@ private:
               return Response<AnyPointer>(reader, kj::mv(response));
             });
 
+        KJ_IF_MAYBE(t, timer) {
+          appPromise = t->timeoutAfter(timeout, kj::mv(appPromise));
+        }
+
         return RemotePromise<AnyPointer>(
             kj::mv(appPromise),
             AnyPointer::Pipeline(kj::mv(pipeline)));
@@ -1477,6 +1662,24 @@ private:
       return TailInfo { questionId, kj::mv(promise), kj::mv(pipeline) };
     }
 
+    void setTimeout(kj::Timer& timer, kj::Duration timeout) override {
+      this->timer = timer;
+      this->timeout = timeout;
+      if (timeout > 0 * kj::NANOSECONDS) {
+        callBuilder.setTimeout(timeout / kj::NANOSECONDS);
+      }
+    }
+
+    void setPriority(CallPriority priority) override {
+      this->priority = priority;
+    }
+
+    void setTraceParent(kj::ArrayPtr<const byte> context) override {
+      if (context.size() > 0) {
+        traceParent = kj::heapArray(context);
+      }
+    }
+
     const void* getBrand() override {
       return connectionState.get();
     }
@@ -1484,21 +1687,96 @@ private:
   private:
     kj::Own<RpcConnectionState> connectionState;
 
+    kj::Maybe<kj::Timer&> timer;
+    kj::Duration timeout = 0 * kj::NANOSECONDS;
+    // Set by setTimeout().
+
+    CallPriority priority = CallPriority::NORMAL;
+
+    kj::Array<byte> traceParent;
+    // Set by setTraceParent().
+
     kj::Own<RpcClient> target;
     kj::Own<OutgoingRpcMessage> message;
     BuilderCapabilityTable capTable;
     rpc::Call::Builder callBuilder;
     AnyPointer::Builder paramsBuilder;
 
+    kj::Maybe<kj::Own<RawCallParams>> forwardedParams;
+    // If non-null, the params to send in place of `paramsBuilder`.
+
+    void copyForwardedParams() {
+      // Fall back to copying the forwarded params into `paramsBuilder`.
+      KJ_IF_MAYBE(f, forwardedParams) {
+        paramsBuilder.set(f->get()->getContent());
+        forwardedParams = nullptr;
+      }
+    }
+
     struct SendInternalResult {
       kj::Own<QuestionRef> questionRef;
       kj::Promise<kj::Own<RpcResponse>> promise = nullptr;
     };
 
+    void setMessagePriority(QuestionId questionId) {
+      // Let the network reorder the call with respect to calls on other capabilities, if that's
+      // safe.  The call must target an import that isn't a promise, and each capability it passes
+      // back to the callee must stay ordered relative to Release/Finish messages mentioning it.
+
+      if (!target->isSettledImport()) return;
+
+      auto descriptors = callBuilder.getParams().getCapTable();
+      auto keys = kj::heapArrayBuilder<uint64_t>(descriptors.size() + 2);
+      keys.add(importOrderingKey(callBuilder.getTarget().getImportedCap()));
+      keys.add(questionOrderingKey(questionId));
+      for (auto descriptor: descriptors) {
+        switch (descriptor.which()) {
+          case rpc::CapDescriptor::NONE:
+          case rpc::CapDescriptor::SENDER_HOSTED:
+          case rpc::CapDescriptor::SENDER_PROMISE:
+            break;
+          case rpc::CapDescriptor::RECEIVER_HOSTED:
+            keys.add(importOrderingKey(descriptor.getReceiverHosted()));
+            break;
+          default:
+            // Refers to an answer whose pipeline may not settle in the expected order.
+            return;
+        }
+      }
+      message->setPriority(priority, keys.asPtr());
+    }
+
     SendInternalResult sendInternal(bool isTailCall) {
+      // Start tracing.  The trace context has to be written before the params are forwarded,
+      // since forwarding requires that nothing else be allocated in the message afterwards.
+      kj::Maybe<kj::Own<RpcTracer::Span>> trace;
+      KJ_IF_MAYBE(t, connectionState->tracer) {
+        auto span = t->newOutgoingSpan(
+            callBuilder.getInterfaceId(), callBuilder.getMethodId(), traceParent);
+        auto context = span->getContext();
+        if (context.size() > 0) {
+          callBuilder.setTraceContext(context);
+        }
+        trace = kj::mv(span);
+      }
+
       // Build the cap table.
-      auto exports = connectionState->writeDescriptors(
-          capTable.getTable(), callBuilder.getParams());
+      kj::Array<ExportId> exports;
+      KJ_IF_MAYBE(f, forwardedParams) {
+        auto payload = callBuilder.getParams();
+        exports = connectionState->writeDescriptors(f->get()->getCapTable(), payload);
+        if (message->forwardContent(payload.getContent(), **f)) {
+          forwardedParams = nullptr;
+        } else {
+          // The network can't send the original message along, so copy after all.  The copy
+          // assigns its own cap table indexes, so the descriptors have to be rewritten.
+          connectionState->releaseExports(exports);
+          copyForwardedParams();
+          exports = connectionState->writeDescriptors(capTable.getTable(), payload);
+        }
+      } else {
+        exports = connectionState->writeDescriptors(capTable.getTable(), callBuilder.getParams());
+      }
 
       // Init the question table.  Do this after writing descriptors to avoid interference.
       QuestionId questionId;
@@ -1506,6 +1784,14 @@ private:
       question.isAwaitingReturn = true;
       question.paramExports = kj::mv(exports);
       question.isTailCall = isTailCall;
+      question.trace = kj::mv(trace);
+
+      KJ_IF_MAYBE(m, connectionState->metrics) {
+        auto& stats = m->getMethodStats(callBuilder.getInterfaceId(), callBuilder.getMethodId());
+        ++stats.callsSent;
+        question.methodStats = stats;
+        question.sendTime = m->now();
+      }
 
       // Make the QuentionRef and result promise.
       SendInternalResult result;
@@ -1519,11 +1805,16 @@ private:
       callBuilder.setQuestionId(questionId);
       if (isTailCall) {
         callBuilder.getSendResultsTo().setYourself();
+      } else {
+        setMessagePriority(questionId);
       }
       KJ_IF_MAYBE(exception, kj::runCatchingExceptions([&]() {
         KJ_CONTEXT("sending RPC call",
            callBuilder.getInterfaceId(), callBuilder.getMethodId());
         message->send();
+        KJ_IF_MAYBE(t, question.trace) {
+          t->get()->record(RpcTracer::Event::SEND);
+        }
       })) {
         // We can't safely throw the exception from here since we've already modified the question
         // table state. We'll have to reject the promise instead.
@@ -1573,30 +1864,35 @@ private:
     }
 
     kj::Own<ClientHook> getPipelinedCap(kj::ArrayPtr<const PipelineOp> ops) override {
-      auto copy = kj::heapArrayBuilder<PipelineOp>(ops.size());
-      for (auto& op: ops) {
-        copy.add(op);
+      if (state.is<Waiting>()) {
+        KJ_IF_MAYBE(cap, caps.find(ops)) {
+          return kj::mv(*cap);
+        }
       }
-      return getPipelinedCap(copy.finish());
+      return getPipelinedCap(kj::heapArray(ops));
     }
 
     kj::Own<ClientHook> getPipelinedCap(kj::Array<PipelineOp>&& ops) override {
       if (state.is<Waiting>()) {
+        KJ_IF_MAYBE(cap, caps.find(ops)) {
+          return kj::mv(*cap);
+        }
+
         // Wrap a PipelineClient in a PromiseClient.
         auto pipelineClient = kj::refcounted<PipelineClient>(
             *connectionState, kj::addRef(*state.get<Waiting>()), kj::heapArray(ops.asPtr()));
 
         KJ_IF_MAYBE(r, redirectLater) {
-          auto resolutionPromise = r->addBranch().then(kj::mvCapture(ops,
+          auto resolutionPromise = r->addBranch().then(kj::mvCapture(kj::heapArray(ops.asPtr()),
               [](kj::Array<PipelineOp> ops, kj::Own<RpcResponse>&& response) {
                 return response->getResults().getPipelinedCap(ops);
               }));
 
-          return kj::refcounted<PromiseClient>(
-              *connectionState, kj::mv(pipelineClient), kj::mv(resolutionPromise), nullptr);
+          return caps.add(kj::mv(ops), kj::refcounted<PromiseClient>(
+              *connectionState, kj::mv(pipelineClient), kj::mv(resolutionPromise), nullptr));
         } else {
           // Oh, this pipeline will never get redirected, so just return the PipelineClient.
-          return kj::mv(pipelineClient);
+          return caps.add(kj::mv(ops), kj::mv(pipelineClient));
         }
       } else if (state.is<Resolved>()) {
         return state.get<Resolved>()->getResults().getPipelinedCap(ops);
@@ -1614,6 +1910,11 @@ private:
     typedef kj::Exception Broken;
     kj::OneOf<Waiting, Resolved, Broken> state;
 
+    PipelinedCapCache caps;
+    // The capabilities we've handed out while waiting.  Each pipelined call on the same path goes
+    // to the same PromiseClient, rather than building a new client and promise branch per call.
+    // Cleared on resolution, after which we hand out the results' capabilities directly.
+
     // Keep this last, because the continuation uses *this, so it should be destroyed first to
     // ensure the continuation is not still running.
     kj::Promise<void> resolveSelfPromise;
@@ -1621,11 +1922,13 @@ private:
     void resolve(kj::Own<RpcResponse>&& response) {
       KJ_ASSERT(state.is<Waiting>(), "Already resolved?");
       state.init<Resolved>(kj::mv(response));
+      caps.clear();
     }
 
     void resolve(const kj::Exception&& exception) {
       KJ_ASSERT(state.is<Waiting>(), "Already resolved?");
       state.init<Broken>(kj::mv(exception));
+      caps.clear();
     }
   };
 
@@ -1742,6 +2045,35 @@ private:
     MallocMessageBuilder message;
   };
 
+  class RpcRawCallParams final: public RawCallParams, public kj::Refcounted {
+  public:
+    RpcRawCallParams(kj::Own<IncomingRpcMessage>&& message, AnyPointer::Reader content,
+                     kj::ArrayPtr<kj::Maybe<kj::Own<ClientHook>>> caps)
+        : message(kj::mv(message)),
+          capTable(KJ_MAP(cap, caps) -> kj::Maybe<kj::Own<ClientHook>> {
+            return cap.map([](kj::Own<ClientHook>& c) { return c->addRef(); });
+          }),
+          content(capTable.imbue(content)) {}
+
+    AnyPointer::Reader getContent() override {
+      return content;
+    }
+    kj::ArrayPtr<kj::Maybe<kj::Own<ClientHook>>> getCapTable() override {
+      return capTable.getTable();
+    }
+    kj::ArrayPtr<const kj::ArrayPtr<const word>> getSegments() override {
+      return message->getRawSegments();
+    }
+    kj::Own<RawCallParams> addRef() override {
+      return kj::addRef(*this);
+    }
+
+  private:
+    kj::Own<IncomingRpcMessage> message;
+    ReaderCapabilityTable capTable;
+    AnyPointer::Reader content;
+  };
+
   class RpcCallContext final: public CallContextHook, public kj::Refcounted {
   public:
     RpcCallContext(RpcConnectionState& connectionState, AnswerId answerId,
@@ -1830,6 +2162,11 @@ private:
           return;
         }
 
+        recordServiceTime(false);
+        KJ_IF_MAYBE(t, traceSpan) {
+          t->record(RpcTracer::Event::RETURN);
+        }
+
         KJ_IF_MAYBE(e, exports) {
           // Caps were returned, so we can't free the pipeline yet.
           cleanupAnswerTable(kj::mv(*e), false);
@@ -1854,12 +2191,40 @@ private:
           message->send();
         }
 
+        recordServiceTime(true);
+        KJ_IF_MAYBE(t, traceSpan) {
+          t->record(RpcTracer::Event::RETURN);
+        }
+
         // Do not allow releasing the pipeline because we want pipelined calls to propagate the
         // exception rather than fail with a "no such field" exception.
         cleanupAnswerTable(nullptr, false);
       }
     }
 
+    void setMethodStats(RpcMetrics::MethodStats& stats, kj::TimePoint receiveTime) {
+      methodStats = stats;
+      this->receiveTime = receiveTime;
+    }
+
+    void setTraceSpan(RpcTracer::Span& span) {
+      traceSpan = span;
+    }
+
+    void setDeadline(kj::Timer& timer, kj::TimePoint deadline) {
+      // Enforces the timeout the caller attached to the call.
+
+      this->timer = timer;
+      this->deadline = deadline;
+      deadlineTask = timer.atTime(deadline).then([this]() {
+        if (cancellationFlags & CANCEL_ALLOWED) {
+          cancelForDeadline();
+        }
+      }).eagerlyEvaluate([](kj::Exception&& exception) {
+        KJ_LOG(ERROR, exception);
+      });
+    }
+
     void requestCancel() {
       // Hints that the caller wishes to cancel this call.  At the next time when cancellation is
       // deemed safe, the RpcCallContext shall send a canceled Return -- or if it never becomes
@@ -1886,6 +2251,19 @@ private:
     void releaseParams() override {
       request = nullptr;
     }
+    kj::Maybe<kj::Own<RawCallParams>> detachRawParams() override {
+      KJ_IF_MAYBE(r, request) {
+        if (requestSize < FORWARD_IN_PLACE_THRESHOLD || r->get()->getRawSegments().size() == 0) {
+          return nullptr;
+        }
+        kj::Own<RawCallParams> result = kj::refcounted<RpcRawCallParams>(
+            kj::mv(*r), params, paramsCapTable.getTable());
+        request = nullptr;
+        return kj::mv(result);
+      } else {
+        KJ_FAIL_REQUIRE("Can't call detachRawParams() after releaseParams().");
+      }
+    }
     AnyPointer::Builder getResults(kj::Maybe<MessageSize> sizeHint) override {
       KJ_IF_MAYBE(r, response) {
         return r->get()->getResultsBuilder();
@@ -1946,13 +2324,17 @@ private:
       }
 
       // Just forwarding to another local call.
+      KJ_IF_MAYBE(promise, request->sendWithResultsIn(*this)) {
+        // The callee builds its results directly in our response, so there's nothing to copy.
+        auto voidPromise = promise->ignoreResult();
+        return { kj::mv(voidPromise), PipelineHook::from(kj::mv(*promise)) };
+      }
+
       auto promise = request->send();
 
       // Wait for response.
       auto voidPromise = promise.then([this](Response<AnyPointer>&& tailResponse) {
         // Copy the response.
-        // TODO(perf):  It would be nice if we could somehow make the response get built in-place
-        //   but requires some refactoring.
         getResults(tailResponse.targetSize()).set(tailResponse);
       });
 
@@ -1971,11 +2353,29 @@ private:
         // We just set CANCEL_ALLOWED, and CANCEL_REQUESTED was already set previously.  Initiate
         // the cancellation.
         cancelFulfiller->fulfill();
+      } else if (isPastDeadline()) {
+        cancelForDeadline();
       }
     }
     kj::Own<CallContextHook> addRef() override {
       return kj::addRef(*this);
     }
+    kj::Maybe<kj::TimePoint> getDeadline() override {
+      return deadline;
+    }
+    kj::ArrayPtr<const byte> getTraceContext() override {
+      KJ_IF_MAYBE(t, traceSpan) {
+        return t->getContext();
+      } else {
+        return nullptr;
+      }
+    }
+    bool isPastDeadline() override {
+      KJ_IF_MAYBE(t, timer) {
+        return t->now() >= KJ_ASSERT_NONNULL(deadline);
+      }
+      return false;
+    }
 
   private:
     kj::Own<RpcConnectionState> connectionState;
@@ -2015,10 +2415,47 @@ private:
     // exclusive-joined with the outermost promise waiting on the call return, so fulfilling it
     // cancels that promise.
 
+    // Deadline ---------------------------------------------
+
+    kj::Maybe<kj::Timer&> timer;
+    kj::Maybe<kj::TimePoint> deadline;
+    kj::Promise<void> deadlineTask = nullptr;
+    // Set by setDeadline().  `deadlineTask` cancels the call when the deadline passes, if allowed.
+
+    kj::Maybe<RpcMetrics::MethodStats&> methodStats;
+    kj::TimePoint receiveTime = kj::origin<kj::TimePoint>();
+    // Set by setMethodStats().
+
+    kj::Maybe<RpcTracer::Span&> traceSpan;
+    // Set by setTraceSpan().  The span is owned by our answer table entry, which outlives our use
+    // of it:  the entry isn't removed until we've sent our return and cleaned up the table.
+
     kj::UnwindDetector unwindDetector;
 
     // -----------------------------------------------------
 
+    void recordServiceTime(bool isError) {
+      KJ_IF_MAYBE(stats, methodStats) {
+        stats->serviceLatency.record(
+            KJ_ASSERT_NONNULL(connectionState->metrics).now() - receiveTime);
+        if (isError) ++stats->errorsReturned;
+      }
+    }
+
+    void cancelForDeadline() {
+      // The caller has stopped waiting and the callee has allowed cancellation, so tell the
+      // caller why and stop working on the call.  Unlike cancellation by `Finish`, the caller still
+      // expects a `Return`.
+
+      if (cancellationFlags & CANCEL_REQUESTED) {
+        // Already being canceled by `Finish`.
+        return;
+      }
+
+      sendErrorReturn(KJ_EXCEPTION(OVERLOADED, "Call's deadline passed.", interfaceId, methodId));
+      cancelFulfiller->fulfill();
+    }
+
     bool isFirstResponder() {
       if (responseSent) {
         return false;
@@ -2311,12 +2748,33 @@ private:
     auto cancelPaf = kj::newPromiseAndFulfiller<void>();
 
     AnswerId answerId = call.getQuestionId();
+    uint64_t timeoutNanos = call.getTimeout();
 
     auto context = kj::refcounted<RpcCallContext>(
         *this, answerId, kj::mv(message), kj::mv(capTableArray), payload.getContent(),
         redirectResults, kj::mv(cancelPaf.fulfiller),
         call.getInterfaceId(), call.getMethodId());
 
+    KJ_IF_MAYBE(m, metrics) {
+      auto& stats = m->getMethodStats(call.getInterfaceId(), call.getMethodId());
+      ++stats.callsReceived;
+      context->setMethodStats(stats, m->now());
+    }
+
+    kj::Maybe<kj::Own<RpcTracer::Span>> trace;
+    KJ_IF_MAYBE(t, tracer) {
+      trace = t->newIncomingSpan(
+          call.getInterfaceId(), call.getMethodId(), call.getTraceContext());
+    }
+
+    KJ_IF_MAYBE(t, timer) {
+      // Timeouts too large to represent are as good as none.  We don't enforce timeouts on calls
+      // whose results are redirected, as those are only ever waited on by another call.
+      if (timeoutNanos != 0 && timeoutNanos < (uint64_t(1) << 62) && !redirectResults) {
+        context->setDeadline(*t, t->now() + int64_t(timeoutNanos) * kj::NANOSECONDS);
+      }
+    }
+
     // No more using `call` after this point, as it now belongs to the context.
 
     {
@@ -2328,6 +2786,12 @@ private:
 
       answer.active = true;
       answer.callContext = *context;
+      answer.trace = kj::mv(trace);
+
+      KJ_IF_MAYBE(t, answer.trace) {
+        context->setTraceSpan(**t);
+        t->get()->record(RpcTracer::Event::DISPATCH);
+      }
     }
 
     auto promiseAndPipeline = startCall(
@@ -2485,6 +2949,15 @@ private:
       KJ_REQUIRE(question->isAwaitingReturn, "Duplicate Return.") { return; }
       question->isAwaitingReturn = false;
 
+      KJ_IF_MAYBE(stats, question->methodStats) {
+        stats->callLatency.record(KJ_ASSERT_NONNULL(metrics).now() - question->sendTime);
+        if (ret.isException()) ++stats->errorsReceived;
+      }
+
+      KJ_IF_MAYBE(t, question->trace) {
+        t->get()->record(RpcTracer::Event::RETURN);
+      }
+
       if (ret.getReleaseParamCaps()) {
         exportsToRelease = kj::mv(question->paramExports);
       } else {
@@ -2577,6 +3050,10 @@ private:
     KJ_IF_MAYBE(answer, answers.find(finish.getQuestionId())) {
       KJ_REQUIRE(answer->active, "'Finish' for invalid question ID.") { return; }
 
+      KJ_IF_MAYBE(t, answer->trace) {
+        t->get()->record(RpcTracer::Event::FINISH);
+      }
+
       if (finish.getReleaseResultCaps()) {
         exportsToRelease = kj::mv(answer->resultExports);
       } else {
@@ -2759,7 +3236,8 @@ private:
 
 }  // namespace
 
-class RpcSystemBase::Impl final: private BootstrapFactoryBase, private kj::TaskSet::ErrorHandler {
+class RpcSystemBase::Impl final: private BootstrapFactoryBase, private kj::TaskSet::ErrorHandler,
+                                 private RpcMetrics::TableSource {
 public:
   Impl(VatNetworkBase& network, kj::Maybe<Capability::Client> bootstrapInterface,
        kj::Maybe<RealmGateway<>::Client> gateway)
@@ -2779,6 +3257,10 @@ public:
   }
 
   ~Impl() noexcept(false) {
+    KJ_IF_MAYBE(m, metrics) {
+      m->removeTableSource(*this);
+    }
+
     unwindDetector.catchExceptionsIfUnwinding([&]() {
       // std::unordered_map doesn't like it when elements' destructors throw, so carefully
       // disassemble it.
@@ -2819,6 +3301,34 @@ public:
     }
   }
 
+  void setTimer(kj::Timer& timer) {
+    this->timer = timer;
+
+    for (auto& conn: connections) {
+      conn.second->setTimer(timer);
+    }
+  }
+
+  void setMetrics(RpcMetrics& metrics) {
+    KJ_IF_MAYBE(m, this->metrics) {
+      m->removeTableSource(*this);
+    }
+    this->metrics = metrics;
+    metrics.addTableSource(*this);
+
+    for (auto& conn: connections) {
+      conn.second->setMetrics(metrics);
+    }
+  }
+
+  void setTracer(RpcTracer& tracer) {
+    this->tracer = tracer;
+
+    for (auto& conn: connections) {
+      conn.second->setTracer(tracer);
+    }
+  }
+
 private:
   VatNetworkBase& network;
   kj::Maybe<Capability::Client> bootstrapInterface;
@@ -2826,6 +3336,9 @@ private:
   kj::Maybe<RealmGateway<>::Client> gateway;
   kj::Maybe<SturdyRefRestorerBase&> restorer;
   size_t flowLimit = kj::maxValue;
+  kj::Maybe<kj::Timer&> timer;
+  kj::Maybe<RpcMetrics&> metrics;
+  kj::Maybe<RpcTracer&> tracer;
   kj::TaskSet tasks;
 
   typedef std::unordered_map<VatNetworkBase::Connection*, kj::Own<RpcConnectionState>>
@@ -2847,6 +3360,15 @@ private:
       auto newState = kj::refcounted<RpcConnectionState>(
           bootstrapFactory, gateway, restorer, kj::mv(connection),
           kj::mv(onDisconnect.fulfiller), flowLimit);
+      KJ_IF_MAYBE(t, timer) {
+        newState->setTimer(*t);
+      }
+      KJ_IF_MAYBE(m, metrics) {
+        newState->setMetrics(*m);
+      }
+      KJ_IF_MAYBE(t, tracer) {
+        newState->setTracer(*t);
+      }
       RpcConnectionState& result = *newState;
       connections.insert(std::make_pair(connectionPtr, kj::mv(newState)));
       return result;
@@ -2885,6 +3407,12 @@ private:
   void taskFailed(kj::Exception&& exception) override {
     KJ_LOG(ERROR, exception);
   }
+
+  void getTableSizes(kj::Vector<RpcMetrics::TableSizes>& output) override {
+    for (auto& conn: connections) {
+      output.add(conn.second->getTableSizes());
+    }
+  }
 };
 
 RpcSystemBase::RpcSystemBase(VatNetworkBase& network,
@@ -2913,5 +3441,16 @@ void RpcSystemBase::baseSetFlowLimit(size_t words) {
   return impl->setFlowLimit(words);
 }
 
+void RpcSystemBase::baseSetTimer(kj::Timer& timer) {
+  return impl->setTimer(timer);
+}
+
+void RpcSystemBase::baseSetMetrics(RpcMetrics& metrics) {
+  return impl->setMetrics(metrics);
+}
+void RpcSystemBase::baseSetTracer(RpcTracer& tracer) {
+  return impl->setTracer(tracer);
+}
+
 }  // namespace _ (private)
 }  // namespace capnp
@@ -104,7 +104,7 @@ struct Call {
   struct SendResultsTo;
 
   struct _capnpPrivate {
-    CAPNP_DECLARE_STRUCT_HEADER(836a53ce789d4cd4, 3, 3)
+    CAPNP_DECLARE_STRUCT_HEADER(836a53ce789d4cd4, 4, 4)
     #if !CAPNP_LITE
     static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
     #endif  // !CAPNP_LITE
@@ -124,7 +124,7 @@ struct Call::SendResultsTo {
   };
 
   struct _capnpPrivate {
-    CAPNP_DECLARE_STRUCT_HEADER(dae8b0f61aab5f99, 3, 3)
+    CAPNP_DECLARE_STRUCT_HEADER(dae8b0f61aab5f99, 4, 4)
     #if !CAPNP_LITE
     static constexpr ::capnp::_::RawBrandedSchema const* brand() { return &schema->defaultBrand; }
     #endif  // !CAPNP_LITE
@@ -762,6 +762,11 @@ public:
 
   inline bool getAllowThirdPartyTailCall() const;
 
+  inline  ::uint64_t getTimeout() const;
+
+  inline bool hasTraceContext() const;
+  inline  ::capnp::Data::Reader getTraceContext() const;
+
 private:
   ::capnp::_::StructReader _reader;
   template <typename, ::capnp::Kind>
@@ -819,6 +824,16 @@ public:
   inline bool getAllowThirdPartyTailCall();
   inline void setAllowThirdPartyTailCall(bool value);
 
+  inline  ::uint64_t getTimeout();
+  inline void setTimeout( ::uint64_t value);
+
+  inline bool hasTraceContext();
+  inline  ::capnp::Data::Builder getTraceContext();
+  inline void setTraceContext( ::capnp::Data::Reader value);
+  inline  ::capnp::Data::Builder initTraceContext(unsigned int size);
+  inline void adoptTraceContext(::capnp::Orphan< ::capnp::Data>&& value);
+  inline ::capnp::Orphan< ::capnp::Data> disownTraceContext();
+
 private:
   ::capnp::_::StructBuilder _builder;
   template <typename, ::capnp::Kind>
@@ -3387,6 +3402,54 @@ inline void Call::Builder::setAllowThirdPartyTailCall(bool value) {
       ::capnp::bounded<128>() * ::capnp::ELEMENTS, value);
 }
 
+inline  ::uint64_t Call::Reader::getTimeout() const {
+  return _reader.getDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+
+inline  ::uint64_t Call::Builder::getTimeout() {
+  return _builder.getDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS);
+}
+inline void Call::Builder::setTimeout( ::uint64_t value) {
+  _builder.setDataField< ::uint64_t>(
+      ::capnp::bounded<3>() * ::capnp::ELEMENTS, value);
+}
+
+inline bool Call::Reader::hasTraceContext() const {
+  return !_reader.getPointerField(
+      ::capnp::bounded<3>() * ::capnp::POINTERS).isNull();
+}
+inline bool Call::Builder::hasTraceContext() {
+  return !_builder.getPointerField(
+      ::capnp::bounded<3>() * ::capnp::POINTERS).isNull();
+}
+inline  ::capnp::Data::Reader Call::Reader::getTraceContext() const {
+  return ::capnp::_::PointerHelpers< ::capnp::Data>::get(_reader.getPointerField(
+      ::capnp::bounded<3>() * ::capnp::POINTERS));
+}
+inline  ::capnp::Data::Builder Call::Builder::getTraceContext() {
+  return ::capnp::_::PointerHelpers< ::capnp::Data>::get(_builder.getPointerField(
+      ::capnp::bounded<3>() * ::capnp::POINTERS));
+}
+inline void Call::Builder::setTraceContext( ::capnp::Data::Reader value) {
+  ::capnp::_::PointerHelpers< ::capnp::Data>::set(_builder.getPointerField(
+      ::capnp::bounded<3>() * ::capnp::POINTERS), value);
+}
+inline  ::capnp::Data::Builder Call::Builder::initTraceContext(unsigned int size) {
+  return ::capnp::_::PointerHelpers< ::capnp::Data>::init(_builder.getPointerField(
+      ::capnp::bounded<3>() * ::capnp::POINTERS), size);
+}
+inline void Call::Builder::adoptTraceContext(
+    ::capnp::Orphan< ::capnp::Data>&& value) {
+  ::capnp::_::PointerHelpers< ::capnp::Data>::adopt(_builder.getPointerField(
+      ::capnp::bounded<3>() * ::capnp::POINTERS), kj::mv(value));
+}
+inline ::capnp::Orphan< ::capnp::Data> Call::Builder::disownTraceContext() {
+  return ::capnp::_::PointerHelpers< ::capnp::Data>::disown(_builder.getPointerField(
+      ::capnp::bounded<3>() * ::capnp::POINTERS));
+}
+
 inline  ::capnp::rpc::Call::SendResultsTo::Which Call::SendResultsTo::Reader::which() const {
   return _reader.getDataField<Which>(
       ::capnp::bounded<3>() * ::capnp::ELEMENTS);
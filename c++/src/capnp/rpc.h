@@ -142,6 +142,24 @@ public:
   // order to prevent a grain from inundating the system with in-flight calls. In practice, the
   // main time this happens is when a grain is pushing a large file download and doesn't implement
   // proper cooperative flow control.
+
+  void setTimer(kj::Timer& timer);
+  // Gives the RpcSystem a timer with which to enforce the timeouts that callers attach to their
+  // calls (see `Request::setTimeout()`).  An incoming call's deadline is its timeout counted from
+  // when the call arrived; `CallContext::getDeadline()` reports it in terms of this timer.  Once it
+  // passes, a call that is still queued is failed rather than delivered, and a call that has
+  // called `allowCancellation()` is canceled, with an OVERLOADED exception returned to the caller.
+  //
+  // Without a timer, incoming timeouts are ignored.  Outgoing timeouts are always enforced, using
+  // the timer passed to setTimeout().
+
+  void setMetrics(RpcMetrics& metrics);
+  // Starts recording statistics about this RpcSystem's calls and connections in `metrics`, which
+  // must outlive the RpcSystem.  See rpc-metrics.h.
+
+  void setTracer(RpcTracer& tracer);
+  // Starts reporting the progress of calls sent and received on this RpcSystem's connections to
+  // `tracer`, which must outlive the RpcSystem.  See rpc-trace.h.
 };
 
 template <typename VatId, typename ProvisionId, typename RecipientId,
@@ -277,6 +295,24 @@ public:
   virtual void send() = 0;
   // Send the message, or at least put it in a queue to be sent later.  Note that the builder
   // returned by `getBody()` remains valid at least until the `OutgoingRpcMessage` is destroyed.
+
+  virtual bool forwardContent(AnyPointer::Builder slot, RawCallParams& params) { return false; }
+  // Optionally, make the null pointer `slot` (somewhere in the body) refer to `params.getContent()`
+  // by transmitting the segments of the message in which the params were received along with this
+  // one, rather than copying the params.  The caller must write `params.getCapTable()` as the
+  // message's cap table, index-for-index, and must not allocate any further objects in the body
+  // before calling `send()` (setting fields of existing structs is fine).  Returns false if this
+  // isn't possible, in which case the caller should copy instead.  The default implementation
+  // always returns false.
+
+  virtual void setPriority(CallPriority priority, kj::ArrayPtr<const uint64_t> orderingKeys) {}
+  // Declares that the network may write this message ahead of messages queued before it, as long
+  // as each of those was also given a priority and none of them shares a key with
+  // `orderingKeys`.  The network should only do so in favor of messages of higher priority.  The
+  // RPC system only calls this on messages whose relative order with respect to others is fully
+  // captured by their keys (e.g. the capability a call targets); messages on which it is never
+  // called must be sent strictly in order.  Must be called before `send()`.  The default
+  // implementation ignores the hint, which is always correct.
 };
 
 class IncomingRpcMessage {
@@ -286,6 +322,11 @@ public:
   virtual AnyPointer::Reader getBody() = 0;
   // Get the message body, to be interpreted by the caller.  (The standard RPC implementation
   // interprets it as a Message as defined in rpc.capnp.)
+
+  virtual kj::ArrayPtr<const kj::ArrayPtr<const word>> getRawSegments() { return nullptr; }
+  // Get the raw segments of the message, if available, so that content from it can be forwarded
+  // to another vat without copying (see `OutgoingRpcMessage::forwardContent()`).  Returns an empty
+  // array if the network doesn't support this.
 };
 
 template <typename VatId, typename ProvisionId, typename RecipientId,
@@ -473,6 +514,21 @@ inline void RpcSystem<VatId>::setFlowLimit(size_t words) {
   baseSetFlowLimit(words);
 }
 
+template <typename VatId>
+inline void RpcSystem<VatId>::setTimer(kj::Timer& timer) {
+  baseSetTimer(timer);
+}
+
+template <typename VatId>
+inline void RpcSystem<VatId>::setMetrics(RpcMetrics& metrics) {
+  baseSetMetrics(metrics);
+}
+
+template <typename VatId>
+inline void RpcSystem<VatId>::setTracer(RpcTracer& tracer) {
+  baseSetTracer(tracer);
+}
+
 template <typename VatId, typename ProvisionId, typename RecipientId,
           typename ThirdPartyCapId, typename JoinResult>
 RpcSystem<VatId> makeRpcServer(
@@ -154,6 +154,11 @@ public:
   // If this node wraps some other PromiseNode, get the wrapped node.  Used for debug tracing.
   // Default implementation returns nullptr.
 
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+  // Nodes are small and short-lived, so they are recycled through per-EventLoop free lists, one per
+  // size class, rather than going to malloc every time.  See NodeFreeList in async.c++.
+
 protected:
   class OnReadyEvent {
     // Helper class for implementing onReady().
@@ -787,6 +792,171 @@ private:
   }
 };
 
+// -------------------------------------------------------------------
+
+class CrossThreadPromiseStateBase {
+  // State shared between a cross-thread promise, which lives on its EventLoop's thread, and the
+  // corresponding fulfiller, which may be used and destroyed on any thread.  The promise node,
+  // the fulfiller, and the EventLoop's cross-thread queue each hold a reference; the last one to
+  // let go deletes the state.
+
+public:
+  void addRef() const;
+  void removeRef() const;
+
+protected:
+  CrossThreadPromiseStateBase();
+  virtual ~CrossThreadPromiseStateBase() noexcept(false);
+
+  bool isWaiting() const;
+
+  void complete();
+  // Called by the fulfiller after storing the result.  Queues the promise's event to its loop and
+  // wakes the loop's thread.
+
+  bool completed = false;
+  // Only accessed from the fulfiller's side.
+
+private:
+  EventLoop& loop;
+
+  struct Shared {
+    uint refcount = 1;
+    CrossThreadPromiseNodeBase* node = nullptr;
+    // Only modified by the loop's thread.
+  };
+  MutexGuarded<Shared> shared;
+
+  friend class CrossThreadPromiseNodeBase;
+  friend class kj::EventLoop;
+};
+
+class CrossThreadPromiseNodeBase: public PromiseNode {
+public:
+  void onReady(Event& event) noexcept override;
+
+protected:
+  explicit CrossThreadPromiseNodeBase(CrossThreadPromiseStateBase& state);
+  ~CrossThreadPromiseNodeBase() noexcept(false);
+
+private:
+  CrossThreadPromiseStateBase& state;
+  OnReadyEvent onReadyEvent;
+
+  friend class kj::EventLoop;
+};
+
+template <typename T>
+class CrossThreadPromiseState final: public CrossThreadPromiseStateBase,
+                                     public PromiseFulfiller<UnfixVoid<T>>,
+                                     private kj::Disposer {
+  // The fulfiller is the state itself, acting as its own Disposer (like WeakFulfiller).
+
+public:
+  ExceptionOr<T> result;
+  // Written by the fulfiller before complete(), read by the node after its event fires.
+
+  Own<PromiseFulfiller<UnfixVoid<T>>> makeFulfiller() {
+    return Own<PromiseFulfiller<UnfixVoid<T>>>(this, *this);
+  }
+
+  void fulfill(T&& value) override {
+    if (!completed) {
+      result = ExceptionOr<T>(kj::mv(value));
+      complete();
+    }
+  }
+
+  void reject(Exception&& exception) override {
+    if (!completed) {
+      result = ExceptionOr<T>(false, kj::mv(exception));
+      complete();
+    }
+  }
+
+  bool isWaiting() override {
+    return CrossThreadPromiseStateBase::isWaiting();
+  }
+
+private:
+  void disposeImpl(void* pointer) const override {
+    auto& self = const_cast<CrossThreadPromiseState&>(*this);
+    if (!self.completed) {
+      self.reject(kj::Exception(kj::Exception::Type::FAILED, __FILE__, __LINE__,
+          kj::heapString("PromiseFulfiller was destroyed without fulfilling the promise.")));
+    }
+    removeRef();
+  }
+};
+
+template <typename T>
+class CrossThreadPromiseNode final: public CrossThreadPromiseNodeBase {
+public:
+  explicit CrossThreadPromiseNode(CrossThreadPromiseState<T>& state)
+      : CrossThreadPromiseNodeBase(state), state(state) {}
+
+  void get(ExceptionOrValue& output) noexcept override {
+    output.as<T>() = kj::mv(state.result);
+  }
+
+private:
+  CrossThreadPromiseState<T>& state;
+};
+
+// -------------------------------------------------------------------
+
+class ExecutorWork {
+  // A function queued to an `Executor`, along with the fulfiller for its caller's promise.
+
+public:
+  virtual ~ExecutorWork() noexcept(false);
+
+  virtual Promise<void> run() = 0;
+  // Called on the executor's thread.  Schedules the function and forwards its result to the
+  // caller.
+
+  virtual void reject(Exception&& exception) = 0;
+  // Called instead of `run()` if the executor's loop goes away first.
+
+  ExecutorWork* next = nullptr;
+};
+
+template <typename T>
+struct ExecutorFulfill {
+  PromiseFulfiller<T>& fulfiller;
+  void operator()(T&& value) { fulfiller.fulfill(kj::mv(value)); }
+};
+template <>
+struct ExecutorFulfill<void> {
+  PromiseFulfiller<void>& fulfiller;
+  void operator()() { fulfiller.fulfill(); }
+};
+
+template <typename Func>
+class ExecutorWorkImpl final: public ExecutorWork {
+public:
+  typedef JoinPromises<ReturnType<Func, void>> T;
+
+  ExecutorWorkImpl(Func&& func, Own<PromiseFulfiller<T>>&& fulfiller)
+      : func(kj::fwd<Func>(func)), fulfiller(kj::mv(fulfiller)) {}
+
+  Promise<void> run() override {
+    auto& fulfillerRef = *fulfiller;
+    return kj::evalLater(kj::mv(func)).then(ExecutorFulfill<T> { fulfillerRef },
+        [&fulfillerRef](Exception&& exception) {
+      fulfillerRef.reject(kj::mv(exception));
+    });
+  }
+
+  void reject(Exception&& exception) override {
+    fulfiller->reject(kj::mv(exception));
+  }
+
+private:
+  Decay<Func> func;
+  Own<PromiseFulfiller<T>> fulfiller;
+};
+
 }  // namespace _ (private)
 
 // =======================================================================================
@@ -1107,6 +1277,200 @@ PromiseFulfillerPair<T> newPromiseAndFulfiller() {
   return PromiseFulfillerPair<T> { kj::mv(promise), kj::mv(wrapper) };
 }
 
+template <typename T>
+PromiseFulfillerPair<T> newCrossThreadPromiseAndFulfiller() {
+  static_assert(isSameType<_::JoinPromises<T>, T>(),
+                "a promise cannot be passed between threads");
+
+  auto state = new _::CrossThreadPromiseState<_::FixVoid<T>>;
+  auto fulfiller = state->makeFulfiller();
+  Own<_::PromiseNode> node = heap<_::CrossThreadPromiseNode<_::FixVoid<T>>>(*state);
+
+  return PromiseFulfillerPair<T> { Promise<T>(false, kj::mv(node)), kj::mv(fulfiller) };
+}
+
+#if KJ_HAS_COROUTINE
+// =======================================================================================
+// Coroutines
+//
+// Everything here is inline: the library itself may well have been compiled as C++11.
+
+namespace _ {  // private
+
+class CoroutineBase: public PromiseNode, public Event, private Disposer {
+  // The promise_type of a coroutine returning `Promise<T>`, living in the coroutine frame.  It is
+  // both the PromiseNode of the returned promise and the Event which resumes the coroutine once
+  // the promise it is awaiting becomes ready.  The frame is allocated with PromiseNode's
+  // operator new, so small frames are recycled like any other node.
+
+public:
+  std::suspend_never initial_suspend() noexcept { return {}; }
+
+  std::suspend_always final_suspend() noexcept {
+    // Stay suspended: the frame holds the result, and is destroyed along with the promise.
+    onReadyEvent.arm();
+    return {};
+  }
+
+  void unhandled_exception() {
+    KJ_IF_MAYBE(exception, kj::runCatchingExceptions([]() { throw; })) {
+      result.addException(kj::mv(*exception));
+    }
+  }
+
+  void onReady(Event& event) noexcept override {
+    onReadyEvent.init(event);
+  }
+
+  PromiseNode* getInnerForTrace() override {
+    return awaiting;
+  }
+
+protected:
+  CoroutineBase(std::coroutine_handle<> coroutine, ExceptionOrValue& result)
+      : coroutine(coroutine), result(result) {}
+
+  Own<PromiseNode> ownFrame() {
+    return Own<PromiseNode>(this, *this);
+  }
+
+  Maybe<Own<Event>> fire() override {
+    coroutine.resume();
+    return nullptr;
+  }
+
+private:
+  std::coroutine_handle<> coroutine;
+  ExceptionOrValue& result;
+  OnReadyEvent onReadyEvent;
+
+  PromiseNode* awaiting = nullptr;
+  // The node we're currently suspended on, for trace().
+
+  void disposeImpl(void* pointer) const override {
+    coroutine.destroy();
+  }
+
+  template <typename>
+  friend class PromiseAwaiter;
+};
+
+template <typename T>
+class Coroutine final: public CoroutineBase {
+public:
+  Coroutine(): CoroutineBase(std::coroutine_handle<Coroutine>::from_promise(*this), result) {}
+
+  Promise<T> get_return_object() {
+    return Promise<T>(false, ownFrame());
+  }
+
+  void return_value(T value) {
+    result = ExceptionOr<T>(kj::mv(value));
+  }
+
+  void get(ExceptionOrValue& output) noexcept override {
+    output.as<T>() = kj::mv(result);
+  }
+
+private:
+  ExceptionOr<T> result;
+};
+
+template <>
+class Coroutine<void> final: public CoroutineBase {
+public:
+  Coroutine(): CoroutineBase(std::coroutine_handle<Coroutine>::from_promise(*this), result) {}
+
+  Promise<void> get_return_object() {
+    return Promise<void>(false, ownFrame());
+  }
+
+  void return_void() {
+    result = ExceptionOr<Void>(Void());
+  }
+
+  void get(ExceptionOrValue& output) noexcept override {
+    output.as<Void>() = kj::mv(result);
+  }
+
+private:
+  ExceptionOr<Void> result;
+};
+
+template <typename T>
+class PromiseAwaiter {
+public:
+  explicit PromiseAwaiter(Promise<T>&& promise): node(kj::mv(promise.node)) {}
+
+  bool await_ready() { return false; }
+
+  template <typename U>
+  void await_suspend(std::coroutine_handle<Coroutine<U>> handle) {
+    coroutine = &handle.promise();
+    node->setSelfPointer(&node);
+    node->onReady(*coroutine);
+    coroutine->awaiting = node.get();
+  }
+
+  T await_resume() {
+    coroutine->awaiting = nullptr;
+
+    ExceptionOr<FixVoid<T>> result;
+    node->get(result);
+    node = nullptr;
+
+    // Same as Promise::wait().
+    KJ_IF_MAYBE(value, result.value) {
+      KJ_IF_MAYBE(exception, result.exception) {
+        throwRecoverableException(kj::mv(*exception));
+      }
+      return returnMaybeVoid(kj::mv(*value));
+    } else KJ_IF_MAYBE(exception, result.exception) {
+      throwFatalException(kj::mv(*exception));
+    } else {
+      KJ_UNREACHABLE;
+    }
+  }
+
+private:
+  Own<PromiseNode> node;
+  CoroutineBase* coroutine = nullptr;
+};
+
+}  // namespace _ (private)
+
+template <typename T>
+inline _::PromiseAwaiter<T> operator co_await(Promise<T>&& promise) {
+  return _::PromiseAwaiter<T>(kj::mv(promise));
+}
+
+template <typename T>
+inline _::PromiseAwaiter<T> operator co_await(Promise<T>& promise) {
+  return _::PromiseAwaiter<T>(kj::mv(promise));
+}
+
+#endif  // KJ_HAS_COROUTINE
+
+template <typename Func>
+PromiseForResult<Func, void> Executor::executeAsync(Func&& func) const {
+  typedef _::JoinPromises<_::ReturnType<Func, void>> T;
+  auto paf = newCrossThreadPromiseAndFulfiller<T>();
+  send(new _::ExecutorWorkImpl<Func>(kj::fwd<Func>(func), kj::mv(paf.fulfiller)));
+  return kj::mv(paf.promise);
+}
+
 }  // namespace kj
 
+#if KJ_HAS_COROUTINE
+namespace std {
+
+template <typename T, typename... Args>
+struct coroutine_traits<kj::Promise<T>, Args...> {
+  // Makes any function returning kj::Promise<T> eligible to be a coroutine.
+  typedef kj::_::Coroutine<T> promise_type;
+};
+
+}  // namespace std
+#endif  // KJ_HAS_COROUTINE
+
 #endif  // KJ_ASYNC_INL_H_
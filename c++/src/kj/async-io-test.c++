@@ -21,6 +21,9 @@
 
 #include "async-io.h"
 #include "debug.h"
+#if !_WIN32
+#include "async-unix.h"
+#endif
 #include <kj/compat/gtest.h>
 #include <sys/types.h>
 #if _WIN32
@@ -412,5 +415,128 @@ TEST(AsyncIo, AbstractUnixSocket) {
 
 #endif  // __linux__
 
+#if KJ_USE_IO_URING
+
+Promise<void> echo(AsyncIoStream& stream, ArrayPtr<byte> buffer) {
+  return stream.tryRead(buffer.begin(), 1, buffer.size()).then([&stream, buffer](size_t n) {
+    if (n == 0) return kj::Promise<void>(kj::READY_NOW);
+    return stream.write(buffer.begin(), n).then([&stream, buffer]() {
+      return echo(stream, buffer);
+    });
+  });
+}
+
+void echoOverTcp(UnixEventPort::Backend backend) {
+  // Runs the same echo workload -- many small round trips, then one large multi-piece write --
+  // through accept(), read() and write() on the given backend.
+
+  UnixEventPort::setDefaultBackend(backend);
+  auto ioContext = setupAsyncIo();
+  UnixEventPort::setDefaultBackend(UnixEventPort::Backend::EPOLL);
+  KJ_EXPECT(ioContext.unixEventPort.getBackend() == backend);
+  auto& waitScope = ioContext.waitScope;
+  auto& network = ioContext.provider->getNetwork();
+
+  auto listener = network.parseAddress("127.0.0.1").wait(waitScope)->listen();
+  auto serverPromise = listener->accept();
+  auto client = network.parseAddress("127.0.0.1", listener->getPort()).wait(waitScope)
+      ->connect().wait(waitScope);
+  auto server = serverPromise.wait(waitScope);
+
+  byte echoBuffer[4096];
+  auto echoTask = echo(*server, echoBuffer).then([&]() { server->shutdownWrite(); })
+      .eagerlyEvaluate(nullptr);
+
+  for (uint i = 0; i < 100; i++) {
+    auto message = kj::str("ping ", i);
+    client->write(message.begin(), message.size()).wait(waitScope);
+    char reply[16];
+    client->read(reply, message.size()).wait(waitScope);
+    KJ_EXPECT(kj::heapString(reply, message.size()) == message);
+  }
+
+  auto data = kj::heapArray<byte>(1 << 20);
+  for (size_t i = 0; i < data.size(); i++) data[i] = i * 7;
+  ArrayPtr<const byte> pieces[4] = {
+    data.slice(0, 1), data.slice(1, 4096), data.slice(4096, 500000), data.slice(500000, data.size())
+  };
+  auto writePromise = client->write(pieces);
+  auto received = kj::heapArray<byte>(data.size());
+  client->read(received.begin(), received.size()).wait(waitScope);
+  writePromise.wait(waitScope);
+  KJ_EXPECT(received == data);
+
+  client->shutdownWrite();
+  echoTask.wait(waitScope);
+  byte dummy;
+  KJ_EXPECT(client->tryRead(&dummy, 1, 1).wait(waitScope) == 0);
+}
+
+TEST(AsyncIo, EchoEpoll) {
+  echoOverTcp(UnixEventPort::Backend::EPOLL);
+}
+
+TEST(AsyncIo, EchoIoUring) {
+  {
+    UnixEventPort probe(UnixEventPort::Backend::IO_URING);
+    if (probe.getBackend() != UnixEventPort::Backend::IO_URING) {
+      KJ_LOG(WARNING, "io_uring not available; skipping test");
+      return;
+    }
+  }
+  echoOverTcp(UnixEventPort::Backend::IO_URING);
+}
+
+#endif  // KJ_USE_IO_URING
+
+#if KJ_HAS_COROUTINE
+
+Promise<uint> countLinesThen(AsyncInputStream& input, ArrayPtr<byte> buffer, uint count = 0) {
+  return input.tryRead(buffer.begin(), 1, buffer.size())
+      .then([&input, buffer, count](size_t n) mutable -> Promise<uint> {
+    if (n == 0) return count;
+    for (byte b: buffer.slice(0, n)) {
+      if (b == '\n') ++count;
+    }
+    return countLinesThen(input, buffer, count);
+  });
+}
+
+Promise<uint> countLinesCoroutine(AsyncInputStream& input, ArrayPtr<byte> buffer) {
+  uint count = 0;
+  for (;;) {
+    size_t n = co_await input.tryRead(buffer.begin(), 1, buffer.size());
+    if (n == 0) co_return count;
+    for (byte b: buffer.slice(0, n)) {
+      if (b == '\n') ++count;
+    }
+  }
+}
+
+TEST(AsyncIo, ReadLoopThenVsCoroutine) {
+  // The same HTTP-style read loop written both ways.  The then() version allocates a node per
+  // read; the coroutine reuses its frame.
+
+  auto ioContext = setupAsyncIo();
+
+  const uint LINES = 20000;
+  kj::Vector<kj::StringPtr> lines;
+  for (uint i = 0; i < LINES; i++) lines.add("header: value");
+  auto text = kj::strArray(lines, "\n");
+  byte buffer[37];  // Deliberately misaligned with the lines.
+
+  for (bool coroutine: {false, true}) {
+    auto pipe = ioContext.provider->newOneWayPipe();
+    auto write = pipe.out->write(text.begin(), text.size())
+        .then([&]() { pipe.out = nullptr; }).eagerlyEvaluate(nullptr);
+    auto count = coroutine ? countLinesCoroutine(*pipe.in, buffer)
+                           : countLinesThen(*pipe.in, buffer);
+    EXPECT_EQ(LINES - 1, count.wait(ioContext.waitScope));
+    write.wait(ioContext.waitScope);
+  }
+}
+
+#endif  // KJ_HAS_COROUTINE
+
 }  // namespace
 }  // namespace kj
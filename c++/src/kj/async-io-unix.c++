@@ -26,6 +26,7 @@
 #include "async-unix.h"
 #include "debug.h"
 #include "thread.h"
+#include "thread-pool.h"
 #include "io.h"
 #include "miniposix.h"
 #include <unistd.h>
@@ -114,15 +115,29 @@ private:
 class AsyncStreamFd: public OwnedFileDescriptor, public AsyncIoStream {
 public:
   AsyncStreamFd(UnixEventPort& eventPort, int fd, uint flags)
-      : OwnedFileDescriptor(fd, flags),
-        observer(eventPort, fd, UnixEventPort::FdObserver::OBSERVE_READ_WRITE) {}
+      : OwnedFileDescriptor(fd, flags), eventPort(eventPort) {
+    if (!isCompletionBased()) {
+      getObserver();
+    }
+  }
   virtual ~AsyncStreamFd() noexcept(false) {}
 
   Promise<size_t> tryRead(void* buffer, size_t minBytes, size_t maxBytes) override {
+#if KJ_USE_IO_URING
+    if (isCompletionBased()) {
+      return tryReadCompletion(buffer, minBytes, maxBytes, 0);
+    }
+#endif
     return tryReadInternal(buffer, minBytes, maxBytes, 0);
   }
 
   Promise<void> write(const void* buffer, size_t size) override {
+#if KJ_USE_IO_URING
+    if (isCompletionBased()) {
+      return writeCompletion(buffer, size);
+    }
+#endif
+
     ssize_t writeResult;
     KJ_NONBLOCKING_SYSCALL(writeResult = ::write(fd, buffer, size)) {
       // Error.
@@ -150,12 +165,22 @@ public:
     buffer = reinterpret_cast<const byte*>(buffer) + n;
     size -= n;
 
-    return observer.whenBecomesWritable().then([=]() {
+    return getObserver().whenBecomesWritable().then([=]() {
       return write(buffer, size);
     });
   }
 
   Promise<void> write(ArrayPtr<const ArrayPtr<const byte>> pieces) override {
+#if KJ_USE_IO_URING
+    if (isCompletionBased()) {
+      if (pieces.size() == 0) {
+        return writevCompletion(nullptr, nullptr);
+      } else {
+        return writevCompletion(pieces[0], pieces.slice(1, pieces.size()));
+      }
+    }
+#endif
+
     if (pieces.size() == 0) {
       return writeInternal(nullptr, nullptr);
     } else {
@@ -213,7 +238,7 @@ public:
 
     if (pollResult == 0) {
       // Not ready yet. We can safely use the edge-triggered observer.
-      return observer.whenBecomesWritable();
+      return getObserver().whenBecomesWritable();
     } else {
       // Ready now.
       return kj::READY_NOW;
@@ -221,7 +246,24 @@ public:
   }
 
 private:
-  UnixEventPort::FdObserver observer;
+  UnixEventPort& eventPort;
+
+  Maybe<UnixEventPort::FdObserver> observer;
+  // With the epoll backend this is created up front. With io_uring, reads and writes normally
+  // complete in the ring, so we only register with epoll once something actually needs to wait
+  // for readiness; otherwise every byte that arrived would wake the loop twice.
+
+  UnixEventPort::FdObserver& getObserver() {
+    KJ_IF_MAYBE(o, observer) {
+      return *o;
+    } else {
+      return observer.emplace(eventPort, fd, UnixEventPort::FdObserver::OBSERVE_READ_WRITE);
+    }
+  }
+
+  inline bool isCompletionBased() {
+    return eventPort.getBackend() == UnixEventPort::Backend::IO_URING;
+  }
 
   Promise<size_t> tryReadInternal(void* buffer, size_t minBytes, size_t maxBytes,
                                   size_t alreadyRead) {
@@ -246,7 +288,7 @@ private:
 
     if (n < 0) {
       // Read would block.
-      return observer.whenBecomesReadable().then([=]() {
+      return getObserver().whenBecomesReadable().then([=]() {
         return tryReadInternal(buffer, minBytes, maxBytes, alreadyRead);
       });
     } else if (n == 0) {
@@ -263,7 +305,7 @@ private:
       maxBytes -= n;
       alreadyRead += n;
 
-      KJ_IF_MAYBE(atEnd, observer.atEndHint()) {
+      KJ_IF_MAYBE(atEnd, getObserver().atEndHint()) {
         if (*atEnd) {
           // We've already received an indication that the next read() will return EOF, so there's
           // nothing to wait for.
@@ -276,7 +318,7 @@ private:
           // that even if it was received since then, whenBecomesReadable() will catch that. So,
           // let's go ahead and skip calling read() here and instead go straight to waiting for
           // more input.
-          return observer.whenBecomesReadable().then([=]() {
+          return getObserver().whenBecomesReadable().then([=]() {
             return tryReadInternal(buffer, minBytes, maxBytes, alreadyRead);
           });
         }
@@ -337,7 +379,7 @@ private:
           return writeInternal(firstPiece, morePieces);
         }
 
-        return observer.whenBecomesWritable().then([=]() {
+        return getObserver().whenBecomesWritable().then([=]() {
           return writeInternal(firstPiece, morePieces);
         });
       } else if (morePieces.size() == 0) {
@@ -353,6 +395,111 @@ private:
       }
     }
   }
+
+#if KJ_USE_IO_URING
+  // Completion-based counterparts of the above, used with the io_uring backend. The kernel waits
+  // for readiness itself, so there's no EAGAIN dance -- except on kernels that complete
+  // operations on non-blocking FDs with EAGAIN anyway, where we fall back to the observer.
+
+  Promise<size_t> tryReadCompletion(void* buffer, size_t minBytes, size_t maxBytes,
+                                    size_t alreadyRead) {
+    return eventPort.submitRead(fd, buffer, maxBytes)
+        .then([=](int n) -> Promise<size_t> {
+      if (n < 0) {
+        int error = -n;
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+          return getObserver().whenBecomesReadable().then([=]() {
+            return tryReadCompletion(buffer, minBytes, maxBytes, alreadyRead);
+          });
+        } else if (error == EINTR) {
+          return tryReadCompletion(buffer, minBytes, maxBytes, alreadyRead);
+        } else {
+          KJ_FAIL_SYSCALL("read", error) { break; }
+          return alreadyRead;
+        }
+      } else if (n == 0) {
+        // EOF -OR- maxBytes == 0.
+        return alreadyRead;
+      } else if (implicitCast<size_t>(n) >= minBytes) {
+        return alreadyRead + n;
+      } else {
+        return tryReadCompletion(reinterpret_cast<byte*>(buffer) + n,
+                                 minBytes - n, maxBytes - n, alreadyRead + n);
+      }
+    });
+  }
+
+  Promise<void> writeCompletion(const void* buffer, size_t size) {
+    return eventPort.submitWrite(fd, buffer, size)
+        .then([=](int n) -> Promise<void> {
+      if (n < 0) {
+        int error = -n;
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+          return getObserver().whenBecomesWritable().then([=]() {
+            return writeCompletion(buffer, size);
+          });
+        } else if (error == EINTR) {
+          return writeCompletion(buffer, size);
+        } else {
+          KJ_FAIL_SYSCALL("write", error) { break; }
+          return kj::READY_NOW;
+        }
+      } else if (implicitCast<size_t>(n) == size) {
+        return kj::READY_NOW;
+      } else {
+        return writeCompletion(reinterpret_cast<const byte*>(buffer) + n, size - n);
+      }
+    });
+  }
+
+  Promise<void> writevCompletion(ArrayPtr<const byte> firstPiece,
+                                 ArrayPtr<const ArrayPtr<const byte>> morePieces) {
+    // The iovec array must outlive the operation, so unlike writeInternal() it goes on the heap.
+    const size_t iovmax = kj::miniposix::iovMax(1 + morePieces.size());
+    auto iov = heapArray<struct iovec>(kj::min(1 + morePieces.size(), iovmax));
+
+    iov[0].iov_base = const_cast<byte*>(firstPiece.begin());
+    iov[0].iov_len = firstPiece.size();
+    for (uint i = 1; i < iov.size(); i++) {
+      iov[i].iov_base = const_cast<byte*>(morePieces[i - 1].begin());
+      iov[i].iov_len = morePieces[i - 1].size();
+    }
+
+    auto promise = eventPort.submitWritev(fd, iov.begin(), iov.size());
+    return promise.attach(kj::mv(iov)).then([=](int result) -> Promise<void> {
+      if (result < 0) {
+        int error = -result;
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+          return getObserver().whenBecomesWritable().then([=]() {
+            return writevCompletion(firstPiece, morePieces);
+          });
+        } else if (error == EINTR) {
+          return writevCompletion(firstPiece, morePieces);
+        } else {
+          KJ_FAIL_SYSCALL("writev", error) { break; }
+          return kj::READY_NOW;
+        }
+      }
+
+      // Discard all data that was written, then issue a new write for what's left (if any).
+      size_t n = result;
+      auto first = firstPiece;
+      auto more = morePieces;
+      for (;;) {
+        if (n < first.size()) {
+          return writevCompletion(first.slice(n, first.size()), more);
+        } else if (more.size() == 0) {
+          KJ_DASSERT(n == first.size(), n);
+          return kj::READY_NOW;
+        } else {
+          n -= first.size();
+          first = more[0];
+          more = more.slice(1, more.size());
+        }
+      }
+    });
+  }
+#endif  // KJ_USE_IO_URING
 };
 
 // =======================================================================================
@@ -632,54 +779,6 @@ private:
   } addr;
 
   struct LookupParams;
-  class LookupReader;
-};
-
-class SocketAddress::LookupReader {
-  // Reads SocketAddresses off of a pipe coming from another thread that is performing
-  // getaddrinfo.
-
-public:
-  LookupReader(kj::Own<Thread>&& thread, kj::Own<AsyncInputStream>&& input)
-      : thread(kj::mv(thread)), input(kj::mv(input)) {}
-
-  ~LookupReader() {
-    if (thread) thread->detach();
-  }
-
-  Promise<Array<SocketAddress>> read() {
-    return input->tryRead(&current, sizeof(current), sizeof(current)).then(
-        [this](size_t n) -> Promise<Array<SocketAddress>> {
-      if (n < sizeof(current)) {
-        thread = nullptr;
-        // getaddrinfo()'s docs seem to say it will never return an empty list, but let's check
-        // anyway.
-        KJ_REQUIRE(addresses.size() > 0, "DNS lookup returned no addresses.") { break; }
-        return addresses.releaseAsArray();
-      } else {
-        // getaddrinfo() can return multiple copies of the same address for several reasons.
-        // A major one is that we don't give it a socket type (SOCK_STREAM vs. SOCK_DGRAM), so
-        // it may return two copies of the same address, one for each type, unless it explicitly
-        // knows that the service name given is specific to one type.  But we can't tell it a type,
-        // because we don't actually know which one the user wants, and if we specify SOCK_STREAM
-        // while the user specified a UDP service name then they'll get a resolution error which
-        // is lame.  (At least, I think that's how it works.)
-        //
-        // So we instead resort to de-duping results.
-        if (alreadySeen.insert(current).second) {
-          addresses.add(current);
-        }
-        return read();
-      }
-    });
-  }
-
-private:
-  kj::Own<Thread> thread;
-  kj::Own<AsyncInputStream> input;
-  SocketAddress current;
-  kj::Vector<SocketAddress> addresses;
-  std::set<SocketAddress> alreadySeen;
 };
 
 struct SocketAddress::LookupParams {
@@ -689,28 +788,17 @@ struct SocketAddress::LookupParams {
 
 Promise<Array<SocketAddress>> SocketAddress::lookupHost(
     LowLevelAsyncIoProvider& lowLevel, kj::String host, kj::String service, uint portHint) {
-  // This shitty function spawns a thread to run getaddrinfo().  Unfortunately, getaddrinfo() is
-  // the only cross-platform DNS API and it is blocking.
+  // getaddrinfo() is the only cross-platform DNS API and it is blocking, so run it on the shared
+  // thread pool.
   //
-  // TODO(perf):  Use a thread pool?  Maybe kj::Thread should use a thread pool automatically?
-  //   Maybe use the various platform-specific asynchronous DNS libraries?  Please do not implement
-  //   a custom DNS resolver...
-
-  int fds[2];
-#if __linux__ && !__BIONIC__
-  KJ_SYSCALL(pipe2(fds, O_NONBLOCK | O_CLOEXEC));
-#else
-  KJ_SYSCALL(pipe(fds));
-#endif
-
-  auto input = lowLevel.wrapInputFd(fds[0], NEW_FD_FLAGS);
-
-  int outFd = fds[1];
+  // TODO(someday):  Maybe use the various platform-specific asynchronous DNS libraries?  Please
+  //   do not implement a custom DNS resolver...
 
   LookupParams params = { kj::mv(host), kj::mv(service) };
 
-  auto thread = heap<Thread>(kj::mvCapture(params, [outFd,portHint](LookupParams&& params) {
-    FdOutputStream output((AutoCloseFd(outFd)));
+  return ThreadPool::getDefault().run(kj::mvCapture(params,
+      [portHint](LookupParams&& params) -> Array<SocketAddress> {
+    kj::Vector<SocketAddress> addresses;
 
     struct addrinfo* list;
     int status = getaddrinfo(
@@ -720,6 +808,17 @@ Promise<Array<SocketAddress>> SocketAddress::lookupHost(
     if (status == 0) {
       KJ_DEFER(freeaddrinfo(list));
 
+      // getaddrinfo() can return multiple copies of the same address for several reasons.
+      // A major one is that we don't give it a socket type (SOCK_STREAM vs. SOCK_DGRAM), so
+      // it may return two copies of the same address, one for each type, unless it explicitly
+      // knows that the service name given is specific to one type.  But we can't tell it a type,
+      // because we don't actually know which one the user wants, and if we specify SOCK_STREAM
+      // while the user specified a UDP service name then they'll get a resolution error which
+      // is lame.  (At least, I think that's how it works.)
+      //
+      // So we instead resort to de-duping results.
+      std::set<SocketAddress> alreadySeen;
+
       struct addrinfo* cur = list;
       while (cur != nullptr) {
         if (params.service == nullptr) {
@@ -757,24 +856,22 @@ Promise<Array<SocketAddress>> SocketAddress::lookupHost(
           addr.addrlen = cur->ai_addrlen;
           memcpy(&addr.addr.generic, cur->ai_addr, cur->ai_addrlen);
         }
-        KJ_ASSERT_CAN_MEMCPY(SocketAddress);
-        output.write(&addr, sizeof(addr));
+        if (alreadySeen.insert(addr).second) {
+          addresses.add(addr);
+        }
         cur = cur->ai_next;
       }
     } else if (status == EAI_SYSTEM) {
-      KJ_FAIL_SYSCALL("getaddrinfo", errno, params.host, params.service) {
-        return;
-      }
+      KJ_FAIL_SYSCALL("getaddrinfo", errno, params.host, params.service);
     } else {
-      KJ_FAIL_REQUIRE("DNS lookup failed.",
-                      params.host, params.service, gai_strerror(status)) {
-        return;
-      }
+      KJ_FAIL_REQUIRE("DNS lookup failed.", params.host, params.service, gai_strerror(status));
     }
-  }));
 
-  auto reader = heap<LookupReader>(kj::mv(thread), kj::mv(input));
-  return reader->read().attach(kj::mv(reader));
+    // getaddrinfo()'s docs seem to say it will never return an empty list, but let's check
+    // anyway.
+    KJ_REQUIRE(addresses.size() > 0, "DNS lookup returned no addresses.");
+    return addresses.releaseAsArray();
+  }));
 }
 
 // =======================================================================================
@@ -786,9 +883,21 @@ public:
         observer(eventPort, fd, UnixEventPort::FdObserver::OBSERVE_READ) {}
 
   Promise<Own<AsyncIoStream>> accept() override {
+#if KJ_USE_IO_URING
+    if (eventPort.getBackend() == UnixEventPort::Backend::IO_URING) {
+      return eventPort.submitAccept(fd, SOCK_NONBLOCK | SOCK_CLOEXEC)
+          .then([this](int newFd) -> Promise<Own<AsyncIoStream>> {
+        if (newFd >= 0) {
+          return Own<AsyncIoStream>(heap<AsyncStreamFd>(eventPort, newFd, NEW_FD_FLAGS));
+        } else {
+          return handleAcceptError(-newFd);
+        }
+      });
+    }
+#endif
+
     int newFd;
 
-  retry:
 #if __linux__ && !__BIONIC__
     newFd = ::accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
 #else
@@ -798,39 +907,7 @@ public:
     if (newFd >= 0) {
       return Own<AsyncIoStream>(heap<AsyncStreamFd>(eventPort, newFd, NEW_FD_FLAGS));
     } else {
-      int error = errno;
-
-      switch (error) {
-        case EAGAIN:
-#if EAGAIN != EWOULDBLOCK
-        case EWOULDBLOCK:
-#endif
-          // Not ready yet.
-          return observer.whenBecomesReadable().then([this]() {
-            return accept();
-          });
-
-        case EINTR:
-        case ENETDOWN:
-#ifdef EPROTO
-        // EPROTO is not defined on OpenBSD.
-        case EPROTO:
-#endif
-        case EHOSTDOWN:
-        case EHOSTUNREACH:
-        case ENETUNREACH:
-        case ECONNABORTED:
-        case ETIMEDOUT:
-          // According to the Linux man page, accept() may report an error if the accepted
-          // connection is already broken.  In this case, we really ought to just ignore it and
-          // keep waiting.  But it's hard to say exactly what errors are such network errors and
-          // which ones are permanent errors.  We've made a guess here.
-          goto retry;
-
-        default:
-          KJ_FAIL_SYSCALL("accept", error);
-      }
-
+      return handleAcceptError(errno);
     }
   }
 
@@ -846,10 +923,47 @@ public:
   void setsockopt(int level, int option, const void* value, uint length) override {
     KJ_SYSCALL(::setsockopt(fd, level, option, value, length));
   }
+  Maybe<int> getFd() const override {
+    return fd;
+  }
 
 public:
   UnixEventPort& eventPort;
   UnixEventPort::FdObserver observer;
+
+private:
+  Promise<Own<AsyncIoStream>> handleAcceptError(int error) {
+    switch (error) {
+      case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+      case EWOULDBLOCK:
+#endif
+        // Not ready yet.
+        return observer.whenBecomesReadable().then([this]() {
+          return accept();
+        });
+
+      case EINTR:
+      case ENETDOWN:
+#ifdef EPROTO
+      // EPROTO is not defined on OpenBSD.
+      case EPROTO:
+#endif
+      case EHOSTDOWN:
+      case EHOSTUNREACH:
+      case ENETUNREACH:
+      case ECONNABORTED:
+      case ETIMEDOUT:
+        // According to the Linux man page, accept() may report an error if the accepted
+        // connection is already broken.  In this case, we really ought to just ignore it and
+        // keep waiting.  But it's hard to say exactly what errors are such network errors and
+        // which ones are permanent errors.  We've made a guess here.
+        return accept();
+
+      default:
+        KJ_FAIL_SYSCALL("accept", error);
+    }
+  }
 };
 
 class DatagramPortImpl final: public DatagramPort, public OwnedFileDescriptor {
@@ -179,6 +179,9 @@ void ConnectionReceiver::getsockopt(int level, int option, void* value, uint* le
 void ConnectionReceiver::setsockopt(int level, int option, const void* value, uint length) {
   KJ_UNIMPLEMENTED("Not a socket.");
 }
+Maybe<int> ConnectionReceiver::getFd() const {
+  return nullptr;
+}
 void DatagramPort::getsockopt(int level, int option, void* value, uint* length) {
   KJ_UNIMPLEMENTED("Not a socket.");
 }
@@ -159,6 +159,12 @@ public:
   virtual void getsockopt(int level, int option, void* value, uint* length);
   virtual void setsockopt(int level, int option, const void* value, uint length);
   // Same as the methods of AsyncIoStream.
+
+  virtual Maybe<int> getFd() const;
+  // Get the underlying Unix file descriptor, if any.  Returns null if this receiver is not backed
+  // by a file descriptor (e.g. on Windows).  The descriptor remains owned by the receiver.  This
+  // is useful e.g. for sharing one listen socket among several event loops, each of which wraps
+  // it using `LowLevelAsyncIoProvider::wrapListenSocketFd()`.
 };
 
 // =======================================================================================
@@ -176,6 +176,18 @@ class TaskSetImpl;
 
 class Event;
 
+class NullEventPort;
+class CrossThreadQueue;
+class CrossThreadPromiseStateBase;
+class CrossThreadPromiseNodeBase;
+class ExecutorWork;
+class NodeFreeList;
+
+template <typename T>
+class Coroutine;
+template <typename T>
+class PromiseAwaiter;
+
 class PromiseBase {
 public:
   kj::String trace();
@@ -195,6 +207,8 @@ private:
   template <typename U>
   friend Promise<Array<U>> kj::joinPromises(Array<Promise<U>>&& promises);
   friend Promise<void> kj::joinPromises(Array<Promise<void>>&& promises);
+  template <typename>
+  friend class PromiseAwaiter;
 };
 
 void detach(kj::Promise<void>&& promise);
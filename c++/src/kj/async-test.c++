@@ -21,6 +21,8 @@
 
 #include "async.h"
 #include "debug.h"
+#include "thread.h"
+#include "vector.h"
 #include <kj/compat/gtest.h>
 
 namespace kj {
@@ -375,6 +377,169 @@ TEST(Async, SeparateFulfillerMemoryLeak) {
   paf.fulfiller->fulfill();
 }
 
+TEST(Async, CrossThreadFulfiller) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  auto paf = newCrossThreadPromiseAndFulfiller<int>();
+  Thread thread(kj::mvCapture(paf.fulfiller, [](Own<PromiseFulfiller<int>>&& fulfiller) {
+    fulfiller->fulfill(123);
+  }));
+
+  EXPECT_EQ(123, paf.promise.wait(waitScope));
+}
+
+TEST(Async, CrossThreadFulfillerVoid) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  // Several promises completed from several threads, in no particular order.
+  Vector<Promise<void>> promises;
+  Vector<Own<Thread>> threads;
+  for (uint i = 0; i < 4; i++) {
+    auto paf = newCrossThreadPromiseAndFulfiller<void>();
+    promises.add(kj::mv(paf.promise));
+    threads.add(heap<Thread>(kj::mvCapture(paf.fulfiller,
+        [](Own<PromiseFulfiller<void>>&& fulfiller) {
+      fulfiller->fulfill();
+    })));
+  }
+
+  joinPromises(promises.releaseAsArray()).wait(waitScope);
+}
+
+TEST(Async, CrossThreadFulfillerDiscarded) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  auto paf = newCrossThreadPromiseAndFulfiller<int>();
+  Thread thread(kj::mvCapture(paf.fulfiller, [](Own<PromiseFulfiller<int>>&& fulfiller) {
+    // Dropped without fulfilling.
+  }));
+
+  EXPECT_ANY_THROW(paf.promise.wait(waitScope));
+}
+
+TEST(Async, CrossThreadFulfillerCanceled) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  auto paf = newCrossThreadPromiseAndFulfiller<int>();
+  EXPECT_TRUE(paf.fulfiller->isWaiting());
+  paf.promise = nullptr;
+  EXPECT_FALSE(paf.fulfiller->isWaiting());
+
+  // Fulfilling after the promise is gone is a no-op.
+  paf.fulfiller->fulfill(123);
+}
+
+TEST(Async, Executor) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  MutexGuarded<Maybe<Own<const Executor>>> published;
+  Own<PromiseFulfiller<void>> stop;
+
+  Own<const Executor> executor;
+  {
+    Thread thread([&]() {
+      EventLoop loop;
+      WaitScope waitScope(loop);
+
+      auto paf = newPromiseAndFulfiller<void>();
+      stop = kj::mv(paf.fulfiller);
+      *published.lockExclusive() = getCurrentThreadExecutor().addRef();
+      paf.promise.wait(waitScope);
+    });
+
+    executor = published.when(
+        [](const Maybe<Own<const Executor>>& value) { return value != nullptr; },
+        [](Maybe<Own<const Executor>>& value) { return kj::mv(KJ_ASSERT_NONNULL(value)); });
+    EXPECT_TRUE(executor->isLive());
+    EXPECT_FALSE(&getCurrentThreadExecutor() == executor.get());
+
+    // The function runs on the executor's thread.
+    const Executor* ran = nullptr;
+    executor->executeAsync([&]() { ran = &getCurrentThreadExecutor(); }).wait(waitScope);
+    EXPECT_TRUE(ran == executor.get());
+
+    EXPECT_EQ(123, executor->executeAsync([]() { return 123; }).wait(waitScope));
+
+    // A promise returned by the function is resolved on the executor's thread.
+    EXPECT_EQ("foo", executor->executeAsync([]() {
+      return evalLater([]() { return kj::str("foo"); });
+    }).wait(waitScope));
+
+    EXPECT_ANY_THROW(executor->executeAsync([]() -> int {
+      KJ_FAIL_ASSERT("oops");
+    }).wait(waitScope));
+
+    // Work runs in the order it was sent.
+    uint next = 0;
+    Vector<Promise<void>> promises;
+    for (uint i = 0; i < 1000; i++) {
+      promises.add(executor->executeAsync([&next, i]() {
+        KJ_ASSERT(next++ == i);
+      }));
+    }
+    joinPromises(promises.releaseAsArray()).wait(waitScope);
+    EXPECT_EQ(1000, next);
+
+    executor->executeAsync([&]() { stop->fulfill(); }).wait(waitScope);
+  }
+
+  EXPECT_FALSE(executor->isLive());
+  EXPECT_ANY_THROW(executor->executeAsync([]() {}).wait(waitScope));
+}
+
+TEST(Async, ExecutorManySenders) {
+  // Several threads hammer one loop.  Each sender has an EventLoop of its own to receive results.
+
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  const uint SENDERS = 4;
+  const uint COUNT = 2000;
+
+  auto& executor = getCurrentThreadExecutor();
+  uint counter = 0;
+
+  Vector<Promise<void>> done;
+  Vector<Own<Thread>> threads;
+  for (uint i = 0; i < SENDERS; i++) {
+    auto paf = newCrossThreadPromiseAndFulfiller<void>();
+    done.add(kj::mv(paf.promise));
+    threads.add(heap<Thread>(kj::mvCapture(paf.fulfiller,
+        [&](Own<PromiseFulfiller<void>>&& fulfiller) {
+      EventLoop loop;
+      WaitScope waitScope(loop);
+
+      Vector<Promise<uint>> results;
+      for (uint j = 0; j < COUNT; j++) {
+        results.add(executor.executeAsync([&counter]() { return ++counter; }));
+      }
+      uint last = 0;
+      for (auto& result: results) {
+        uint value = result.wait(waitScope);
+        KJ_ASSERT(value > last);
+        last = value;
+      }
+      fulfiller->fulfill();
+    })));
+  }
+
+  joinPromises(done.releaseAsArray()).wait(waitScope);
+  EXPECT_EQ(SENDERS * COUNT, counter);
+}
+
+TEST(Async, NothingToWaitFor) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  // With no cross-thread promises outstanding, nothing could ever wake the loop.
+  EXPECT_ANY_THROW(NEVER_DONE.wait(waitScope));
+}
+
 TEST(Async, Ordering) {
   EventLoop loop;
   WaitScope waitScope(loop);
@@ -620,6 +785,96 @@ TEST(Async, TaskSet) {
   EXPECT_EQ(1u, errorHandler.exceptionCount);
 }
 
+TEST(Async, TaskSetOnEmpty) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  ErrorHandlerImpl errorHandler;
+  TaskSet tasks(errorHandler);
+
+  EXPECT_TRUE(tasks.isEmpty());
+  tasks.onEmpty().wait(waitScope);
+
+  auto paf = newPromiseAndFulfiller<void>();
+  tasks.add(kj::mv(paf.promise));
+  tasks.add(evalLater([]() {}));
+  EXPECT_FALSE(tasks.isEmpty());
+
+  // Dropping the promise lets us ask again.
+  tasks.onEmpty();
+
+  bool empty = false;
+  auto promise = tasks.onEmpty().then([&]() { empty = true; }).eagerlyEvaluate(nullptr);
+  EXPECT_ANY_THROW(tasks.onEmpty());
+
+  evalLater([]() {}).wait(waitScope);
+  EXPECT_FALSE(empty);
+
+  paf.fulfiller->fulfill();
+  promise.wait(waitScope);
+  EXPECT_TRUE(empty);
+  EXPECT_TRUE(tasks.isEmpty());
+  EXPECT_EQ(0u, errorHandler.exceptionCount);
+}
+
+TEST(Async, TaskSetChurn) {
+  // Adds and completes tasks in bulk, the way HttpServer and RpcSystem use TaskSet. With the old
+  // std::map each task also cost a tree node allocation and two O(log n) operations.
+
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  ErrorHandlerImpl errorHandler;
+  TaskSet tasks(errorHandler);
+
+  uint completed = 0;
+  for (uint round = 0; round < 10; round++) {
+    for (uint i = 0; i < 20000; i++) {
+      tasks.add(evalLater([&]() { ++completed; }));
+    }
+    tasks.onEmpty().wait(waitScope);
+  }
+  EXPECT_EQ(200000u, completed);
+
+  // Cancelling a large TaskSet must not recurse once per task.
+  {
+    TaskSet doomed(errorHandler);
+    for (uint i = 0; i < 200000; i++) {
+      doomed.add(NEVER_DONE);
+    }
+  }
+  EXPECT_EQ(0u, errorHandler.exceptionCount);
+}
+
+TEST(Async, ThenChainChurn) {
+  // Ten .then()s per round, each allocating and freeing a node, like a typical request handler.
+  // Nodes are recycled through the loop's free lists, so steady state does no heap allocation.
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  uint64_t total = 0;
+  for (uint round = 0; round < 20000; round++) {
+    Promise<uint> promise = evalLater([round]() { return round; });
+    for (uint i = 0; i < 10; i++) {
+      promise = promise.then([](uint x) { return x + 1; });
+    }
+    total += promise.wait(waitScope);
+  }
+
+  EXPECT_EQ(20000ull * 19999 / 2 + 20000 * 10, total);
+}
+
+TEST(Async, NodesOutliveEventLoop) {
+  // Promises made with no loop, or kept past their loop's lifetime, must still be freed properly.
+  Promise<int> early = 123;
+  Maybe<Promise<int>> late;
+  {
+    EventLoop loop;
+    WaitScope waitScope(loop);
+    late = evalLater([]() { return 456; }).then([](int i) { return i + 1; });
+    EXPECT_EQ(123, early.wait(waitScope));
+  }
+  late = nullptr;
+}
+
 class DestructorDetector {
 public:
   DestructorDetector(bool& setTrue): setTrue(setTrue) {}
@@ -748,5 +1003,84 @@ TEST(Async, SetRunnable) {
   }
 }
 
+#if KJ_HAS_COROUTINE
+
+Promise<int> coroutineAdd(Promise<int> a, Promise<int> b) {
+  int x = co_await a;
+  int y = co_await kj::mv(b);
+  co_return x + y;
+}
+
+TEST(Async, Coroutine) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  EXPECT_EQ(5, coroutineAdd(evalLater([]() { return 2; }), 3).wait(waitScope));
+}
+
+Promise<void> coroutineCountTo(uint n, uint& counter) {
+  for (uint i = 0; i < n; i++) {
+    co_await evalLater([&]() { ++counter; });
+  }
+}
+
+TEST(Async, CoroutineLoop) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  uint counter = 0;
+  coroutineCountTo(10000, counter).wait(waitScope);
+  EXPECT_EQ(10000, counter);
+}
+
+Promise<int> coroutineThrows(Promise<void> promise) {
+  co_await promise;
+  KJ_FAIL_ASSERT("oops");
+}
+
+Promise<kj::String> coroutineCatches(Promise<int> promise) {
+  try {
+    co_await promise;
+    co_return kj::str("no exception");
+  } catch (const kj::Exception& e) {
+    co_return kj::str(e.getDescription());
+  }
+}
+
+TEST(Async, CoroutineExceptions) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  EXPECT_ANY_THROW(coroutineThrows(evalLater([]() {})).wait(waitScope));
+  EXPECT_EQ("oops",
+      coroutineCatches(Promise<int>(KJ_EXCEPTION(FAILED, "oops"))).wait(waitScope));
+}
+
+Promise<void> coroutineAwaitsForever(Promise<void> promise, bool& destroyed) {
+  DestructorDetector detector(destroyed);
+  co_await promise;
+  ADD_FAILURE() << "shouldn't get here";
+}
+
+TEST(Async, CoroutineCancellation) {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  bool destroyed = false;
+  auto paf = newPromiseAndFulfiller<void>();
+  {
+    auto promise = coroutineAwaitsForever(kj::mv(paf.promise), destroyed);
+    evalLater([]() {}).wait(waitScope);
+    EXPECT_TRUE(paf.fulfiller->isWaiting());
+    EXPECT_FALSE(destroyed);
+  }
+
+  // Destroying the promise destroyed the frame, and with it the promise it was awaiting.
+  EXPECT_TRUE(destroyed);
+  EXPECT_FALSE(paf.fulfiller->isWaiting());
+}
+
+#endif  // KJ_HAS_COROUTINE
+
 }  // namespace
 }  // namespace kj
@@ -33,6 +33,7 @@
 #include <netinet/in.h>
 #include <kj/compat/gtest.h>
 #include <pthread.h>
+#include <errno.h>
 #include <algorithm>
 
 namespace kj {
@@ -602,6 +603,260 @@ TEST(AsyncUnixTest, Wake) {
   EXPECT_TRUE(port.wait());
 }
 
+TEST(AsyncUnixTest, CrossThreadFulfiller) {
+  captureSignals();
+  UnixEventPort port;
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  auto paf = newCrossThreadPromiseAndFulfiller<int>();
+  Thread thread(kj::mvCapture(paf.fulfiller, [](Own<PromiseFulfiller<int>>&& fulfiller) {
+    delay();
+    fulfiller->fulfill(123);
+  }));
+
+  EXPECT_EQ(123, paf.promise.wait(waitScope));
+}
+
+TEST(AsyncUnixTest, Executor) {
+  // Work sent to a UnixEventPort's loop wakes it through the port's eventfd.
+
+  captureSignals();
+  UnixEventPort port;
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  auto& executor = getCurrentThreadExecutor();
+  auto paf = newPromiseAndFulfiller<int>();
+
+  Thread thread([&]() {
+    EventLoop loop;
+    WaitScope waitScope(loop);
+
+    delay();
+    executor.executeAsync([&]() { paf.fulfiller->fulfill(123); }).wait(waitScope);
+  });
+
+  EXPECT_EQ(123, paf.promise.wait(waitScope));
+}
+
+struct ReadySockets {
+  // Many socket pairs, each with an observer waiting for its read end to become readable.
+
+  ReadySockets(UnixEventPort& port, uint count) {
+    for (uint i = 0; i < count; i++) {
+      int pair[2];
+      KJ_SYSCALL(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, pair));
+      ins.add(pair[0]);
+      outs.add(pair[1]);
+      observers.add(heap<UnixEventPort::FdObserver>(
+          port, pair[0], UnixEventPort::FdObserver::OBSERVE_READ));
+      promises.add(observers.back()->whenBecomesReadable()
+          .then([this]() { ++readyCount; }).eagerlyEvaluate(nullptr));
+    }
+  }
+
+  void makeAllReadable() {
+    for (auto& out: outs) {
+      KJ_SYSCALL(write(out, "x", 1));
+    }
+  }
+
+  Vector<AutoCloseFd> ins;
+  Vector<AutoCloseFd> outs;
+  Vector<Own<UnixEventPort::FdObserver>> observers;
+  Vector<Promise<void>> promises;
+  uint readyCount = 0;
+};
+
+void runQueued(WaitScope& waitScope) {
+  evalLater([]() {}).wait(waitScope);
+}
+
+TEST(AsyncUnixTest, BulkReadiness) {
+  // When thousands of connections become readable at once, a single poll() picks them all up,
+  // rather than 16 per call as it used to.
+
+  captureSignals();
+  UnixEventPort port;
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  ReadySockets sockets(port, 400);
+  sockets.makeAllReadable();
+
+  port.poll();
+  runQueued(waitScope);
+  EXPECT_EQ(400u, sockets.readyCount);
+}
+
+TEST(AsyncUnixTest, EventBatchLimit) {
+  captureSignals();
+  UnixEventPort port;
+  port.setEventBatchLimit(10);
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  ReadySockets sockets(port, 25);
+  sockets.makeAllReadable();
+
+  port.poll();
+  runQueued(waitScope);
+  EXPECT_EQ(10u, sockets.readyCount);
+
+  port.poll();
+  port.poll();
+  runQueued(waitScope);
+  EXPECT_EQ(25u, sockets.readyCount);
+}
+
+void readByte(UnixEventPort::FdObserver& observer, int fd, WaitScope& waitScope) {
+  for (;;) {
+    char c;
+    ssize_t n;
+    KJ_NONBLOCKING_SYSCALL(n = read(fd, &c, 1));
+    if (n > 0) return;
+    KJ_ASSERT(n < 0, "unexpected EOF");
+    observer.whenBecomesReadable().wait(waitScope);
+  }
+}
+
+void writeByte(int fd) {
+  ssize_t n;
+  KJ_SYSCALL(n = write(fd, "x", 1));
+  KJ_ASSERT(n == 1);
+}
+
+void pingPong(UnixEventPort::Backend backend, Duration spinTime) {
+  // Bounce a byte back and forth between two threads.  The pinging side busy-polls; the replies
+  // arrive well within the spin time, so nearly every wait should be satisfied without sleeping.
+
+  constexpr uint ROUNDS = 1000;
+
+  captureSignals();
+  UnixEventPort port(backend);
+  port.setBusyPoll(spinTime);
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  int pair[2];
+  KJ_SYSCALL(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, pair));
+  kj::AutoCloseFd ping(pair[0]);
+  kj::AutoCloseFd pong(pair[1]);
+
+  Thread thread([&]() {
+    UnixEventPort port;
+    EventLoop loop(port);
+    WaitScope waitScope(loop);
+    UnixEventPort::FdObserver observer(port, pong, UnixEventPort::FdObserver::OBSERVE_READ);
+
+    for (uint i = 0; i < ROUNDS; i++) {
+      readByte(observer, pong, waitScope);
+      writeByte(pong);
+    }
+  });
+
+  UnixEventPort::FdObserver observer(port, ping, UnixEventPort::FdObserver::OBSERVE_READ);
+  for (uint i = 0; i < ROUNDS; i++) {
+    writeByte(ping);
+    readByte(observer, ping, waitScope);
+  }
+
+  auto& stats = port.getBusyPollStats();
+  KJ_EXPECT(stats.hits > 0);
+  KJ_EXPECT(stats.hits + stats.misses <= ROUNDS, stats.hits, stats.misses);
+  KJ_EXPECT(stats.spinTime > 0 * NANOSECONDS);
+  KJ_EXPECT(stats.spinTime <= int64_t(stats.hits + stats.misses) * spinTime + 100 * MILLISECONDS);
+}
+
+#if KJ_USE_EPOLL
+TEST(AsyncUnixTest, BusyPoll) {
+  pingPong(UnixEventPort::Backend::EPOLL, 10 * MILLISECONDS);
+}
+
+TEST(AsyncUnixTest, BusyPollRespectsTimers) {
+  // Spinning stops at the next timer rather than running out the full interval.
+
+  captureSignals();
+  UnixEventPort port;
+  port.setBusyPoll(10 * SECONDS);
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  auto start = port.getTimer().now();
+  port.getTimer().afterDelay(5 * MILLISECONDS).wait(waitScope);
+  EXPECT_TRUE(port.getTimer().now() - start < 5 * SECONDS);
+
+  auto& stats = port.getBusyPollStats();
+  EXPECT_EQ(0u, stats.hits);
+  EXPECT_EQ(0u, stats.misses);
+  EXPECT_TRUE(stats.spinTime < 5 * SECONDS);
+}
+#endif
+
+#if KJ_USE_IO_URING
+TEST(AsyncUnixTest, BusyPollIoUring) {
+  {
+    UnixEventPort port(UnixEventPort::Backend::IO_URING);
+    if (port.getBackend() != UnixEventPort::Backend::IO_URING) {
+      KJ_LOG(WARNING, "io_uring not available; skipping test");
+      return;
+    }
+  }
+  pingPong(UnixEventPort::Backend::IO_URING, 10 * MILLISECONDS);
+}
+
+TEST(AsyncUnixTest, IoUringCompletions) {
+  captureSignals();
+  UnixEventPort port(UnixEventPort::Backend::IO_URING);
+  if (port.getBackend() != UnixEventPort::Backend::IO_URING) {
+    KJ_LOG(WARNING, "io_uring not available; skipping test");
+    return;
+  }
+  EventLoop loop(port);
+  WaitScope waitScope(loop);
+
+  int pair[2];
+  KJ_SYSCALL(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, pair));
+  kj::AutoCloseFd in(pair[0]);
+  kj::AutoCloseFd out(pair[1]);
+
+  // A read submitted before any data exists completes once it arrives.
+  char buffer[16];
+  auto read = port.submitRead(in, buffer, sizeof(buffer));
+  EXPECT_EQ(3, port.submitWrite(out, "foo", 3).wait(waitScope));
+  EXPECT_EQ(3, read.wait(waitScope));
+  EXPECT_EQ("foo", kj::heapString(buffer, 3));
+
+  // Cancelling a pending read doesn't swallow data which arrives later.
+  port.submitRead(in, buffer, sizeof(buffer)) = nullptr;
+  KJ_SYSCALL(write(out, "bar", 3));
+  ssize_t n;
+  KJ_SYSCALL(n = ::read(in, buffer, sizeof(buffer)));
+  EXPECT_EQ(3, n);
+  EXPECT_EQ("bar", kj::heapString(buffer, 3));
+
+  // Errors come back as negated errno values.
+  EXPECT_EQ(-EBADF, port.submitRead(-1, buffer, sizeof(buffer)).wait(waitScope));
+
+  // Timers, FdObservers and wake() keep working alongside the ring.
+  auto start = port.getTimer().now();
+  port.getTimer().afterDelay(10 * MILLISECONDS).wait(waitScope);
+  EXPECT_TRUE(port.getTimer().now() - start >= 10 * MILLISECONDS);
+
+  UnixEventPort::FdObserver observer(port, in, UnixEventPort::FdObserver::OBSERVE_READ);
+  auto readable = observer.whenBecomesReadable();
+  KJ_SYSCALL(write(out, "baz", 3));
+  readable.wait(waitScope);
+
+  Thread thread([&]() {
+    delay();
+    port.wake();
+  });
+  EXPECT_TRUE(port.wait());
+}
+#endif  // KJ_USE_IO_URING
+
 }  // namespace
 }  // namespace kj
 
@@ -36,6 +36,12 @@
 #include <sys/epoll.h>
 #include <sys/signalfd.h>
 #include <sys/eventfd.h>
+#if KJ_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#endif
 #else
 #include <poll.h>
 #endif
@@ -58,6 +64,8 @@ namespace {
 int reservedSignal = SIGUSR1;
 bool tooLateToSetReserved = false;
 
+UnixEventPort::Backend defaultBackend = UnixEventPort::Backend::EPOLL;
+
 struct SignalCapture {
   sigjmp_buf jumpTo;
   siginfo_t siginfo;
@@ -177,6 +185,27 @@ void UnixEventPort::setReservedSignal(int signum) {
   reservedSignal = signum;
 }
 
+UnixEventPort::UnixEventPort(): UnixEventPort(defaultBackend) {}
+
+void UnixEventPort::setDefaultBackend(Backend backend) {
+  defaultBackend = backend;
+}
+
+void UnixEventPort::setEventBatchLimit(uint maxEvents) {
+  KJ_REQUIRE(maxEvents > 0, "event batch limit must be positive");
+  epollBatchLimit = maxEvents;
+#if KJ_USE_EPOLL
+  if (epollEvents.size() > maxEvents) {
+    epollEvents = nullptr;
+  }
+#endif
+}
+
+void UnixEventPort::setBusyPoll(Duration spinTime) {
+  KJ_REQUIRE(spinTime >= 0 * NANOSECONDS, "busy-poll time can't be negative");
+  busyPollTime = spinTime;
+}
+
 void UnixEventPort::gotSignal(const siginfo_t& siginfo) {
   // Fire any events waiting on this signal.
   auto ptr = signalHead;
@@ -194,7 +223,7 @@ void UnixEventPort::gotSignal(const siginfo_t& siginfo) {
 // =======================================================================================
 // epoll FdObserver implementation
 
-UnixEventPort::UnixEventPort()
+UnixEventPort::UnixEventPort(Backend requestedBackend)
     : timerImpl(readClock()),
       epollFd(-1),
       signalFd(-1),
@@ -220,6 +249,12 @@ UnixEventPort::UnixEventPort()
   KJ_SYSCALL(epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event));
   event.data.u64 = 1;
   KJ_SYSCALL(epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &event));
+
+#if KJ_USE_IO_URING
+  if (requestedBackend == Backend::IO_URING) {
+    initIoUring();
+  }
+#endif
 }
 
 UnixEventPort::~UnixEventPort() noexcept(false) {}
@@ -305,6 +340,18 @@ Promise<void> UnixEventPort::FdObserver::whenUrgentDataAvailable() {
 }
 
 bool UnixEventPort::wait() {
+  if (busyPollTime > 0 * NANOSECONDS) {
+    KJ_IF_MAYBE(woken, busyPoll()) {
+      return *woken;
+    }
+  }
+
+#if KJ_USE_IO_URING
+  if (ring.get() != nullptr) {
+    return doIoUringWait(true);
+  }
+#endif
+
   return doEpollWait(
       timerImpl.timeoutToNextEvent(readClock(), MILLISECONDS, int(maxValue))
           .map([](uint64_t t) -> int { return t; })
@@ -312,9 +359,66 @@ bool UnixEventPort::wait() {
 }
 
 bool UnixEventPort::poll() {
+#if KJ_USE_IO_URING
+  if (ring.get() != nullptr) {
+    return doIoUringWait(false);
+  }
+#endif
+
   return doEpollWait(0);
 }
 
+Maybe<bool> UnixEventPort::busyPoll() {
+  // Polls repeatedly until something happens or the spin time runs out.  Returns what wait()
+  // should return in the former case, or null in the latter, in which case the caller goes on to
+  // block as usual.
+
+  TimePoint start = readClock();
+  TimePoint deadline = start + busyPollTime;
+  bool timerDue = false;
+  KJ_IF_MAYBE(next, timerImpl.nextEvent()) {
+    // Don't spin past a timer; blocking until it fires costs no extra latency.
+    if (*next < deadline) {
+      deadline = *next;
+      timerDue = true;
+    }
+  }
+  if (deadline <= start) return nullptr;
+
+  for (;;) {
+    uint eventCount = 0;
+    bool woken;
+#if KJ_USE_IO_URING
+    if (ring.get() != nullptr) {
+      woken = doIoUringWait(false, &eventCount);
+    } else {
+#endif
+      woken = doEpollWait(0, &eventCount);
+#if KJ_USE_IO_URING
+    }
+#endif
+
+    // Each poll advances the timer to the current time.
+    TimePoint now = timerImpl.now();
+
+    if (woken || eventCount > 0) {
+      ++busyPollStats.hits;
+      busyPollStats.spinTime += now - start;
+      return woken;
+    } else if (now >= deadline) {
+      busyPollStats.spinTime += now - start;
+      if (timerDue) {
+        // The poll that got us here has already fired the timer (or at least done whatever
+        // bookkeeping was due), so there's no need to block.
+        return false;
+      } else {
+        ++busyPollStats.misses;
+        return nullptr;
+      }
+    }
+  }
+}
+
 void UnixEventPort::wake() const {
   uint64_t one = 1;
   ssize_t n;
@@ -430,7 +534,7 @@ static siginfo_t toRegularSiginfo(const struct signalfd_siginfo& siginfo) {
   return result;
 }
 
-bool UnixEventPort::doEpollWait(int timeout) {
+void UnixEventPort::updateSignalMask() {
   sigset_t newMask;
   sigemptyset(&newMask);
 
@@ -448,45 +552,456 @@ bool UnixEventPort::doEpollWait(int timeout) {
     signalFdSigset = newMask;
     KJ_SYSCALL(signalfd(signalFd, &signalFdSigset, SFD_NONBLOCK | SFD_CLOEXEC));
   }
+}
 
-  struct epoll_event events[16];
-  int n;
-  KJ_SYSCALL(n = epoll_wait(epollFd, events, kj::size(events), timeout));
+namespace {
+
+constexpr uint INITIAL_EPOLL_BATCH = 16;
+
+}  // namespace
+
+bool UnixEventPort::doEpollWait(int timeout, uint* eventCount) {
+  updateSignalMask();
 
   bool woken = false;
+  uint total = 0;
 
-  for (int i = 0; i < n; i++) {
-    if (events[i].data.u64 == 0) {
-      for (;;) {
-        struct signalfd_siginfo siginfo;
-        ssize_t n;
-        KJ_NONBLOCKING_SYSCALL(n = read(signalFd, &siginfo, sizeof(siginfo)));
-        if (n < 0) break;  // no more signals
+  for (;;) {
+    if (epollEvents.size() == 0) {
+      epollEvents = heapArray<struct epoll_event>(kj::min(INITIAL_EPOLL_BATCH, epollBatchLimit));
+    }
+
+    struct epoll_event* events = epollEvents.begin();
+    int n;
+    KJ_SYSCALL(n = epoll_wait(epollFd, events, epollEvents.size(), timeout));
+    total += n;
+
+    for (int i = 0; i < n; i++) {
+      if (events[i].data.u64 == 0) {
+        for (;;) {
+          struct signalfd_siginfo siginfo;
+          ssize_t n;
+          KJ_NONBLOCKING_SYSCALL(n = read(signalFd, &siginfo, sizeof(siginfo)));
+          if (n < 0) break;  // no more signals
+
+          KJ_ASSERT(n == sizeof(siginfo));
 
-        KJ_ASSERT(n == sizeof(siginfo));
+          gotSignal(toRegularSiginfo(siginfo));
+        }
+      } else if (events[i].data.u64 == 1) {
+        // Someone called wake() from another thread. Consume the event.
+        uint64_t value;
+        ssize_t n;
+        KJ_NONBLOCKING_SYSCALL(n = read(eventFd, &value, sizeof(value)));
+        KJ_ASSERT(n < 0 || n == sizeof(value));
 
-        gotSignal(toRegularSiginfo(siginfo));
+        // We were woken. Need to return true.
+        woken = true;
+      } else {
+        FdObserver* observer = reinterpret_cast<FdObserver*>(events[i].data.ptr);
+        observer->fire(events[i].events);
       }
-    } else if (events[i].data.u64 == 1) {
-      // Someone called wake() from another thread. Consume the event.
-      uint64_t value;
-      ssize_t n;
-      KJ_NONBLOCKING_SYSCALL(n = read(eventFd, &value, sizeof(value)));
-      KJ_ASSERT(n < 0 || n == sizeof(value));
-
-      // We were woken. Need to return true.
-      woken = true;
-    } else {
-      FdObserver* observer = reinterpret_cast<FdObserver*>(events[i].data.ptr);
-      observer->fire(events[i].events);
     }
+
+    if (size_t(n) < epollEvents.size() || epollEvents.size() >= epollBatchLimit) break;
+
+    // The batch was full, so more fds are probably ready. Grow it and pick up the rest now,
+    // rather than one batch per turn of the event loop. Once the batch is at its limit we stop
+    // here, so that a flood of events can't keep us from returning.
+    epollEvents = heapArray<struct epoll_event>(kj::min(epollEvents.size() * 2,
+                                                        size_t(epollBatchLimit)));
+    timeout = 0;
   }
 
+  if (eventCount != nullptr) *eventCount = total;
+
   timerImpl.advanceTo(readClock());
 
   return woken;
 }
 
+#if KJ_USE_IO_URING
+// =======================================================================================
+// io_uring completion backend
+//
+// We drive the ring with raw system calls rather than pulling in liburing. The epoll instance
+// set up above stays in charge of FdObservers, signals and wake(); the ring keeps a one-shot
+// poll outstanding on epollFd so that anything epoll would have reported also completes the
+// ring's wait.
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+
+namespace {
+
+constexpr uint IO_URING_ENTRIES = 256;
+
+constexpr uint64_t IO_URING_EPOLL_TAG = 1;
+constexpr uint64_t IO_URING_TIMEOUT_TAG = 2;
+constexpr uint64_t IO_URING_CANCEL_TAG = 3;
+// user_data values for the ring's internal operations. Any other value is a pointer to the
+// CompletionPromiseAdapter which submitted the operation.
+
+class RingMapping {
+  // One of the regions which io_uring_setup() asks us to mmap().
+
+public:
+  RingMapping(int fd, size_t size, off_t offset): size(size) {
+    void* result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, offset);
+    if (result == MAP_FAILED) {
+      KJ_FAIL_SYSCALL("mmap(io_uring)", errno);
+    }
+    ptr = reinterpret_cast<byte*>(result);
+  }
+  ~RingMapping() noexcept(false) {
+    KJ_SYSCALL(munmap(ptr, size)) { break; }
+  }
+  KJ_DISALLOW_COPY(RingMapping);
+
+  template <typename T>
+  T* at(uint32_t offset) { return reinterpret_cast<T*>(ptr + offset); }
+
+private:
+  byte* ptr;
+  size_t size;
+};
+
+}  // namespace
+
+class UnixEventPort::CompletionPromiseAdapter {
+public:
+  template <typename Func>
+  CompletionPromiseAdapter(PromiseFulfiller<int>& fulfiller, IoUring& ring, Func&& prepare);
+  ~CompletionPromiseAdapter() noexcept(false);
+
+  void complete(int result) {
+    done = true;
+    if (!canceling) {
+      fulfiller.fulfill(kj::mv(result));
+    }
+  }
+
+  PromiseFulfiller<int>& fulfiller;
+  IoUring& ring;
+  bool done = false;
+  bool canceling = false;
+  // Set while the destructor waits for the kernel to acknowledge cancellation, at which point
+  // the fulfiller must no longer be touched.
+};
+
+class UnixEventPort::IoUring {
+public:
+  IoUring(AutoCloseFd fdParam, const struct io_uring_params& params)
+      : fd(kj::mv(fdParam)),
+        sqRing(fd, params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+               IORING_OFF_SQ_RING),
+        cqRing(fd, params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe),
+               IORING_OFF_CQ_RING),
+        sqeRegion(fd, params.sq_entries * sizeof(struct io_uring_sqe), IORING_OFF_SQES),
+        sqHead(sqRing.at<uint32_t>(params.sq_off.head)),
+        sqTail(sqRing.at<uint32_t>(params.sq_off.tail)),
+        sqMask(*sqRing.at<uint32_t>(params.sq_off.ring_mask)),
+        sqEntries(params.sq_entries),
+        sqArray(sqRing.at<uint32_t>(params.sq_off.array)),
+        sqes(sqeRegion.at<struct io_uring_sqe>(0)),
+        cqHead(cqRing.at<uint32_t>(params.cq_off.head)),
+        cqTail(cqRing.at<uint32_t>(params.cq_off.tail)),
+        cqMask(*cqRing.at<uint32_t>(params.cq_off.ring_mask)),
+        cqes(cqRing.at<struct io_uring_cqe>(params.cq_off.cqes)) {}
+
+  struct io_uring_sqe& getSqe() {
+    while (unsubmitted() == sqEntries) {
+      // The submission queue is full. Hand it to the kernel to make room.
+      enter(0);
+      reap();
+    }
+
+    uint32_t tail = *sqTail;
+    uint32_t index = tail & sqMask;
+    struct io_uring_sqe& sqe = sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqArray[index] = index;
+
+    // The kernel only reads the queue during io_uring_enter(), so it's fine to publish the entry
+    // before the caller has filled it in.
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+  }
+
+  void enter(uint minComplete) {
+    // Submits everything queued so far and, if `minComplete` is non-zero, waits for that many
+    // completions. Returns early on EINTR; the event loop will simply come around again.
+
+    uint toSubmit = unsubmitted();
+    if (toSubmit == 0 && minComplete == 0) return;
+
+    uint flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    if (syscall(__NR_io_uring_enter, fd.get(), toSubmit, minComplete, flags, nullptr, 0) < 0) {
+      int error = errno;
+      switch (error) {
+        case EINTR:
+        case EAGAIN:
+        case EBUSY:
+          // EAGAIN and EBUSY mean the completion queue is backed up; reaping will make room.
+          break;
+        default:
+          KJ_FAIL_SYSCALL("io_uring_enter", error);
+      }
+    }
+  }
+
+  bool reap() {
+    // Dispatches all available completions. Returns true if any operation completed or a timeout
+    // expired.
+
+    bool progress = false;
+    for (;;) {
+      // Re-read the head each time around: a completion callback could conceivably reap too.
+      uint32_t head = *cqHead;
+      if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) break;
+
+      struct io_uring_cqe& cqe = cqes[head & cqMask];
+      uint64_t userData = cqe.user_data;
+      int result = cqe.res;
+      __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+      switch (userData) {
+        case IO_URING_EPOLL_TAG:
+          epollArmed = false;
+          break;
+        case IO_URING_TIMEOUT_TAG:
+          if (result == -ETIME) progress = true;
+          break;
+        case IO_URING_CANCEL_TAG:
+          break;
+        default:
+          reinterpret_cast<CompletionPromiseAdapter*>(userData)->complete(result);
+          progress = true;
+          break;
+      }
+    }
+
+    return progress;
+  }
+
+  void cancel(CompletionPromiseAdapter& op) {
+    // Asks the kernel to abandon `op` and blocks until it has, so that the operation's buffers
+    // may be freed as soon as we return. Cancelling a read or write waiting on a socket completes
+    // immediately.
+
+    if (op.done) return;
+    struct io_uring_sqe& sqe = getSqe();
+    sqe.user_data = IO_URING_CANCEL_TAG;
+    if (op.done) {
+      // getSqe() had to reap to make room, and `op` finished in the process. Leave the entry as
+      // a no-op rather than cancelling whatever is allocated at this address next.
+      return;
+    }
+
+    sqe.opcode = IORING_OP_ASYNC_CANCEL;
+    sqe.addr = reinterpret_cast<uintptr_t>(&op);
+
+    // Keep going until the cancellation itself has been submitted, even if `op` completes first.
+    while (!op.done || unsubmitted() > 0) {
+      enter(op.done ? 0 : 1);
+      reap();
+    }
+  }
+
+  void armEpoll(int epollFd) {
+    if (!epollArmed) {
+      struct io_uring_sqe& sqe = getSqe();
+      sqe.opcode = IORING_OP_POLL_ADD;
+      sqe.fd = epollFd;
+      sqe.poll_events = POLLIN;
+      sqe.user_data = IO_URING_EPOLL_TAG;
+      epollArmed = true;
+    }
+  }
+
+  inline bool isEpollArmed() { return epollArmed; }
+
+  void addTimeout(uint64_t ns) {
+    // The kernel copies the timespec at submission time, but submission may be deferred to a
+    // later enter() if the queue is backed up, so it lives here rather than on the stack.
+    timeoutSpec.tv_sec = ns / 1000000000;
+    timeoutSpec.tv_nsec = ns % 1000000000;
+
+    struct io_uring_sqe& sqe = getSqe();
+    sqe.opcode = IORING_OP_TIMEOUT;
+    sqe.addr = reinterpret_cast<uintptr_t>(&timeoutSpec);
+    sqe.len = 1;
+    sqe.off = 1;
+    // With a completion count of 1, the timeout also retires itself as soon as anything else
+    // completes, so timeouts don't pile up across turns.
+    sqe.user_data = IO_URING_TIMEOUT_TAG;
+  }
+
+private:
+  AutoCloseFd fd;
+  RingMapping sqRing;
+  RingMapping cqRing;
+  RingMapping sqeRegion;
+
+  uint32_t* sqHead;
+  uint32_t* sqTail;
+  uint32_t sqMask;
+  uint32_t sqEntries;
+  uint32_t* sqArray;
+  struct io_uring_sqe* sqes;
+
+  uint32_t* cqHead;
+  uint32_t* cqTail;
+  uint32_t cqMask;
+  struct io_uring_cqe* cqes;
+
+  bool epollArmed = false;
+  // Whether a poll on the epoll FD is currently outstanding in the ring.
+
+  struct __kernel_timespec timeoutSpec;
+
+  inline uint unsubmitted() {
+    return *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+  }
+};
+
+template <typename Func>
+UnixEventPort::CompletionPromiseAdapter::CompletionPromiseAdapter(
+    PromiseFulfiller<int>& fulfiller, IoUring& ring, Func&& prepare)
+    : fulfiller(fulfiller), ring(ring) {
+  struct io_uring_sqe& sqe = ring.getSqe();
+  prepare(sqe);
+  sqe.user_data = reinterpret_cast<uintptr_t>(this);
+}
+
+UnixEventPort::CompletionPromiseAdapter::~CompletionPromiseAdapter() noexcept(false) {
+  if (!done) {
+    canceling = true;
+    ring.cancel(*this);
+  }
+}
+
+void UnixEventPort::initIoUring() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  int fd = syscall(__NR_io_uring_setup, IO_URING_ENTRIES, &params);
+  if (fd < 0) {
+    // The kernel predates io_uring, or it has been disabled (by seccomp, or by the
+    // kernel.io_uring_disabled sysctl). Stay on epoll.
+    return;
+  }
+  AutoCloseFd ownFd(fd);
+
+  if ((params.features & IORING_FEAT_FAST_POLL) == 0) {
+    // Pre-5.7 kernel. Some of the opcodes we use may be missing, and operations on sockets don't
+    // wait for readiness on their own. Stay on epoll.
+    return;
+  }
+
+  ring = heap<IoUring>(kj::mv(ownFd), params);
+  backend = Backend::IO_URING;
+}
+
+bool UnixEventPort::doIoUringWait(bool block, uint* eventCount) {
+  for (;;) {
+    updateSignalMask();
+    ring->armEpoll(epollFd);
+
+    uint minComplete = 0;
+    if (block) {
+      minComplete = 1;
+      KJ_IF_MAYBE(ns, timerImpl.timeoutToNextEvent(readClock(), NANOSECONDS, uint64_t(maxValue))) {
+        if (*ns == 0) {
+          // A timer is already due; don't block.
+          minComplete = 0;
+        } else {
+          ring->addTimeout(*ns);
+        }
+      }
+    }
+
+    // This is the one place where a turn's worth of queued submissions reaches the kernel.
+    ring->enter(minComplete);
+    bool progress = ring->reap();
+
+    if (minComplete == 0) {
+      bool woken = doEpollWait(0, eventCount);
+      if (progress && eventCount != nullptr) ++*eventCount;
+      return woken;
+    } else if (ring->isEpollArmed()) {
+      // An operation completed or the timeout expired (or we were interrupted).
+      timerImpl.advanceTo(readClock());
+      return false;
+    }
+
+    // epollFd became readable: an FdObserver fired, a signal arrived, or another thread called
+    // wake().
+    uint eventCount;
+    bool woken = doEpollWait(0, &eventCount);
+    if (progress || eventCount > 0) {
+      return woken;
+    }
+
+    // Nothing actually happened. epoll leaves level-triggered entries (signalFd, eventFd) on its
+    // ready list until the next epoll_wait() finds them drained, so a poll armed right after
+    // handling one of them can complete spuriously. Go back to sleep.
+  }
+}
+
+Promise<int> UnixEventPort::submitRead(int fd, void* buffer, size_t size) {
+  KJ_REQUIRE(ring.get() != nullptr, "The io_uring backend is not in use.");
+  return newAdaptedPromise<int, CompletionPromiseAdapter>(*ring,
+      [&](struct io_uring_sqe& sqe) {
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uintptr_t>(buffer);
+    sqe.len = kj::min(size, size_t(1) << 30);
+    sqe.off = -1;  // Use (and advance) the file position, like read().
+  });
+}
+
+Promise<int> UnixEventPort::submitWrite(int fd, const void* buffer, size_t size) {
+  KJ_REQUIRE(ring.get() != nullptr, "The io_uring backend is not in use.");
+  return newAdaptedPromise<int, CompletionPromiseAdapter>(*ring,
+      [&](struct io_uring_sqe& sqe) {
+    sqe.opcode = IORING_OP_WRITE;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uintptr_t>(buffer);
+    sqe.len = kj::min(size, size_t(1) << 30);
+    sqe.off = -1;
+  });
+}
+
+Promise<int> UnixEventPort::submitWritev(int fd, const struct iovec* iov, uint count) {
+  KJ_REQUIRE(ring.get() != nullptr, "The io_uring backend is not in use.");
+  return newAdaptedPromise<int, CompletionPromiseAdapter>(*ring,
+      [&](struct io_uring_sqe& sqe) {
+    sqe.opcode = IORING_OP_WRITEV;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uintptr_t>(iov);
+    sqe.len = count;
+    sqe.off = -1;
+  });
+}
+
+Promise<int> UnixEventPort::submitAccept(int fd, int flags) {
+  KJ_REQUIRE(ring.get() != nullptr, "The io_uring backend is not in use.");
+  return newAdaptedPromise<int, CompletionPromiseAdapter>(*ring,
+      [&](struct io_uring_sqe& sqe) {
+    sqe.opcode = IORING_OP_ACCEPT;
+    sqe.fd = fd;
+    sqe.accept_flags = flags;
+  });
+}
+
+#endif  // KJ_USE_IO_URING
+
 #else  // KJ_USE_EPOLL
 // =======================================================================================
 // Traditional poll() FdObserver implementation.
@@ -495,8 +1010,9 @@ bool UnixEventPort::doEpollWait(int timeout) {
 #define POLLRDHUP 0
 #endif
 
-UnixEventPort::UnixEventPort()
+UnixEventPort::UnixEventPort(Backend)
     : timerImpl(readClock()) {
+  // Only poll() is available on this platform, whatever was requested.
   static_assert(sizeof(threadId) >= sizeof(pthread_t),
                 "pthread_t is larger than a long long on your platform.  Please port.");
   *reinterpret_cast<pthread_t*>(&threadId) = pthread_self();
@@ -41,6 +41,18 @@
 #define KJ_USE_EPOLL 1
 #endif
 
+#if KJ_USE_EPOLL && !defined(KJ_USE_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+// Build in io_uring support whenever the kernel headers are available. Whether it's actually
+// used is decided at runtime; see UnixEventPort::Backend. Define KJ_USE_IO_URING=0 to opt out
+// when building against headers older than Linux 5.7.
+#define KJ_USE_IO_URING 1
+#endif
+#endif
+
+struct iovec;
+struct epoll_event;
+
 namespace kj {
 
 class UnixEventPort: public EventPort {
@@ -63,9 +75,66 @@ class UnixEventPort: public EventPort {
   //   until after daemonization to create a UnixEventPort.
 
 public:
+  enum class Backend {
+    EPOLL,
+    // Readiness-based: FdObservers, signals and cross-thread wakeups all go through epoll (or
+    // poll() on non-Linux systems).
+
+    IO_URING
+    // Completion-based: reads, writes, accepts and timer timeouts are submitted to an io_uring
+    // and submissions are flushed to the kernel in one batch per event loop turn. FdObservers
+    // and signals still work; they are serviced by an epoll instance which the ring watches.
+    // Requires Linux 5.7 or newer.
+  };
+
   UnixEventPort();
+  // Uses the backend set with setDefaultBackend() (EPOLL unless changed).
+
+  explicit UnixEventPort(Backend backend);
+  // Uses the given backend if it is available. If it isn't -- e.g. IO_URING was requested but
+  // the kernel is too old, or io_uring_setup() is forbidden by a seccomp filter -- falls back to
+  // EPOLL. Check getBackend() to find out what you got.
+
   ~UnixEventPort() noexcept(false);
 
+  static void setDefaultBackend(Backend backend);
+  // Sets the backend used by UnixEventPorts constructed with the default constructor, which
+  // includes the one created by `kj::setupAsyncIo()`. Affects the whole process; call it at
+  // startup.
+
+  inline Backend getBackend() const { return backend; }
+  // Returns the backend actually in use.
+
+  void setEventBatchLimit(uint maxEvents);
+  // Sets the most fd events collected by a single call to `epoll_wait()`.  The batch starts small
+  // and doubles, up to this limit, whenever a wait fills it; a wait which fills the batch also
+  // immediately collects more, so that a burst of readiness across many connections is picked up
+  // by one `wait()` or `poll()` rather than trickling in over several turns.  Defaults to 1024.
+  //
+  // Only the epoll and io_uring backends batch; elsewhere this setting is ignored.
+
+  void setBusyPoll(Duration spinTime);
+  // Before going to sleep in `wait()`, keep polling without blocking for up to `spinTime` (but
+  // never past the next timer), in case an event arrives in the meantime.  An event caught while
+  // spinning is handled without the scheduler latency of sleeping and being woken, at the cost of
+  // burning CPU the whole time the loop is idle.  Zero (the default) disables spinning.
+  //
+  // Only the epoll and io_uring backends spin; elsewhere this setting is ignored.
+
+  struct BusyPollStats {
+    uint64_t hits = 0;
+    // Calls to `wait()` in which an event arrived while spinning.
+
+    uint64_t misses = 0;
+    // Calls to `wait()` which spun for the whole interval and then had to sleep anyway.  (A spin
+    // cut short by a timer coming due counts as neither a hit nor a miss.)
+
+    Duration spinTime = 0 * NANOSECONDS;
+    // Total time spent spinning, i.e. the CPU cost of busy-polling.
+  };
+
+  inline const BusyPollStats& getBusyPollStats() const { return busyPollStats; }
+
   class FdObserver;
   // Class that watches an fd for readability or writability. See definition below.
 
@@ -104,6 +173,23 @@ public:
   bool poll() override;
   void wake() const override;
 
+#if KJ_USE_IO_URING
+  // Completion-based I/O. These may only be called when getBackend() == Backend::IO_URING. Each
+  // returns the raw result of the operation: non-negative on success, or a negated errno value
+  // on failure. Older kernels may complete an operation on a non-blocking fd with -EAGAIN rather
+  // than waiting, so callers should be prepared to fall back to an FdObserver in that case.
+  //
+  // Buffers must remain valid until the promise resolves or is destroyed. Destroying the promise
+  // cancels the operation and blocks until the kernel has acknowledged the cancellation, so the
+  // buffer may be freed immediately afterwards.
+
+  Promise<int> submitRead(int fd, void* buffer, size_t size);
+  Promise<int> submitWrite(int fd, const void* buffer, size_t size);
+  Promise<int> submitWritev(int fd, const struct iovec* iov, uint count);
+  Promise<int> submitAccept(int fd, int flags);
+  // `flags` are as for accept4().
+#endif
+
 private:
   struct TimerSet;  // Defined in source file to avoid STL include.
   class TimerPromiseAdapter;
@@ -114,11 +200,17 @@ private:
   SignalPromiseAdapter* signalHead = nullptr;
   SignalPromiseAdapter** signalTail = &signalHead;
 
+  uint epollBatchLimit = 1024;
+  Duration busyPollTime = 0 * NANOSECONDS;
+  BusyPollStats busyPollStats;
+
   TimePoint readClock();
   void gotSignal(const siginfo_t& siginfo);
 
   friend class TimerPromiseAdapter;
 
+  Backend backend = Backend::EPOLL;
+
 #if KJ_USE_EPOLL
   AutoCloseFd epollFd;
   AutoCloseFd signalFd;
@@ -128,7 +220,23 @@ private:
   // Signal mask as currently set on the signalFd. Tracked so we can detect whether or not it
   // needs updating.
 
-  bool doEpollWait(int timeout);
+  Array<struct epoll_event> epollEvents;
+  // Allocated on first use; see setEventBatchLimit().
+
+  void updateSignalMask();
+  bool doEpollWait(int timeout, uint* eventCount = nullptr);
+  Maybe<bool> busyPoll();
+
+#if KJ_USE_IO_URING
+  class IoUring;
+  class CompletionPromiseAdapter;
+
+  Own<IoUring> ring;
+  // Non-null iff backend == IO_URING.
+
+  void initIoUring();
+  bool doIoUringWait(bool block, uint* eventCount = nullptr);
+#endif
 
 #else
   class PollContext;
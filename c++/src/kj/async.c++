@@ -20,11 +20,12 @@
 // THE SOFTWARE.
 
 #include "async.h"
+#include "event-loop-monitor.h"
 #include "debug.h"
 #include "vector.h"
 #include "threadlocal.h"
 #include <exception>
-#include <map>
+#include <chrono>
 
 #if KJ_USE_FUTEX
 #include <unistd.h>
@@ -54,6 +55,12 @@ EventLoop& currentEventLoop() {
   return *loop;
 }
 
+uint64_t monotonicNanos() {
+  // Only read while an EventLoopMonitor is attached.
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 class BoolEvent: public _::Event {
 public:
   bool fired = false;
@@ -94,12 +101,16 @@ public:
     : errorHandler(errorHandler) {}
 
   ~TaskSetImpl() noexcept(false) {
-    // std::map doesn't like it when elements' destructors throw, so carefully disassemble it.
-    if (!tasks.empty()) {
-      Vector<Own<Task>> deleteMe(tasks.size());
-      for (auto& entry: tasks) {
-        deleteMe.add(kj::mv(entry.second));
+    // Unlink the tasks one at a time rather than letting the list destroy itself recursively,
+    // which could overflow the stack. A task's destructor may even add new tasks, so keep going
+    // until the list stays empty.
+    while (tasks != nullptr) {
+      Own<Task> removed = kj::mv(KJ_ASSERT_NONNULL(tasks));
+      tasks = kj::mv(removed->next);
+      KJ_IF_MAYBE(n, tasks) {
+        n->get()->prev = &tasks;
       }
+      removed->prev = nullptr;
     }
   }
 
@@ -129,11 +140,23 @@ public:
         taskSet.errorHandler.taskFailed(kj::mv(*e));
       }
 
-      // Remove from the task map.
-      auto iter = taskSet.tasks.find(this);
-      KJ_ASSERT(iter != taskSet.tasks.end());
-      Own<Event> self = kj::mv(iter->second);
-      taskSet.tasks.erase(iter);
+      // Remove from the task list.
+      KJ_IF_MAYBE(n, next) {
+        n->get()->prev = prev;
+      }
+      Own<Event> self = kj::mv(KJ_ASSERT_NONNULL(*prev));
+      KJ_ASSERT(self.get() == this);
+      *prev = kj::mv(next);
+      next = nullptr;
+      prev = nullptr;
+
+      if (taskSet.tasks == nullptr) {
+        KJ_IF_MAYBE(f, taskSet.emptyFulfiller) {
+          f->get()->fulfill();
+          taskSet.emptyFulfiller = nullptr;
+        }
+      }
+
       return mv(self);
     }
 
@@ -141,6 +164,12 @@ public:
       return node;
     }
 
+  public:
+    Maybe<Own<Task>> next;
+    Maybe<Own<Task>>* prev = nullptr;
+    // Links in the TaskSetImpl's intrusive list. Each task is owned by its predecessor's `next`
+    // (or the list head), so adding and removing are O(1) with no allocation beyond the task.
+
   private:
     TaskSetImpl& taskSet;
     kj::Own<_::PromiseNode> node;
@@ -148,23 +177,51 @@ public:
 
   void add(Promise<void>&& promise) {
     auto task = heap<Task>(*this, kj::mv(promise.node));
-    Task* ptr = task;
-    tasks.insert(std::make_pair(ptr, kj::mv(task)));
+    KJ_IF_MAYBE(head, tasks) {
+      head->get()->prev = &task->next;
+      task->next = kj::mv(tasks);
+    }
+    task->prev = &tasks;
+    tasks = kj::mv(task);
   }
 
   kj::String trace() {
     kj::Vector<kj::String> traces;
-    for (auto& entry: tasks) {
-      traces.add(entry.second->trace());
+
+    Maybe<Own<Task>>* ptr = &tasks;
+    for (;;) {
+      KJ_IF_MAYBE(task, *ptr) {
+        traces.add(task->get()->trace());
+        ptr = &task->get()->next;
+      } else {
+        break;
+      }
     }
+
     return kj::strArray(traces, "\n============================================\n");
   }
 
+  Promise<void> onEmpty() {
+    KJ_IF_MAYBE(f, emptyFulfiller) {
+      // A promise returned earlier is only outstanding if someone is still waiting on it.
+      KJ_REQUIRE(!f->get()->isWaiting(), "onEmpty() can only be called once at a time");
+    }
+
+    if (tasks == nullptr) {
+      return READY_NOW;
+    } else {
+      auto paf = newPromiseAndFulfiller<void>();
+      emptyFulfiller = kj::mv(paf.fulfiller);
+      return kj::mv(paf.promise);
+    }
+  }
+
+  inline bool isEmpty() { return tasks == nullptr; }
+
 private:
   TaskSet::ErrorHandler& errorHandler;
-
-  // TODO(perf):  Use a linked list instead.
-  std::map<Task*, Own<Task>> tasks;
+  Maybe<Own<Task>> tasks;
+  Maybe<Own<PromiseFulfiller<void>>> emptyFulfiller;
 };
 
 class LoggingErrorHandler: public TaskSet::ErrorHandler {
@@ -178,24 +235,145 @@ public:
 
 LoggingErrorHandler LoggingErrorHandler::instance = LoggingErrorHandler();
 
+class CrossThreadQueue {
+public:
+  MutexGuarded<Vector<CrossThreadPromiseStateBase*>> items;
+  // Promises fulfilled from other threads.  Each entry holds a reference to its state.
+
+  uint pendingNodes = 0;
+  // Number of cross-thread promises on this loop which still exist.  Only accessed by the loop's
+  // thread.
+};
+
+// Recycled memory would hide use-after-free bugs from AddressSanitizer, so don't recycle under it.
+#if __SANITIZE_ADDRESS__
+#define KJ_NODE_FREE_LIST 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define KJ_NODE_FREE_LIST 0
+#endif
+#endif
+#ifndef KJ_NODE_FREE_LIST
+#define KJ_NODE_FREE_LIST 1
+#endif
+
+class NodeFreeList {
+  // Blocks freed by PromiseNodes, kept for reuse by the next node of the same size class.  Nearly
+  // every then(), attach() and eagerlyEvaluate() allocates a node that lives for only a few turns
+  // of the loop, so in steady state this replaces most malloc/free pairs with a list push and pop.
+  //
+  // Blocks in size class `c` always have room for `(c + 1) * GRANULARITY` bytes, whether or not
+  // they ever pass through a free list, so a block can be freed on one loop and reused on another.
+
+public:
+  static constexpr size_t GRANULARITY = 16;
+  static constexpr uint CLASSES = 16;
+  // Nodes larger than CLASSES * GRANULARITY bytes go straight to the heap.
+
+  static constexpr uint MAX_BLOCKS = 256;
+  // Most blocks kept per size class, to bound idle memory after a burst.
+
+  ~NodeFreeList() noexcept(false) {
+    for (auto& list: lists) {
+      while (list.head != nullptr) {
+        Block* block = list.head;
+        list.head = block->next;
+        ::operator delete(block);
+      }
+    }
+  }
+
+  static inline uint sizeClass(size_t size) {
+    // Returns CLASSES or more for sizes that are not pooled.
+    return (size - 1) / GRANULARITY;
+  }
+
+  inline void* pop(uint sizeClass) {
+    List& list = lists[sizeClass];
+    Block* block = list.head;
+    if (block != nullptr) {
+      list.head = block->next;
+      --list.count;
+    }
+    return block;
+  }
+
+  inline bool push(uint sizeClass, void* ptr) {
+    List& list = lists[sizeClass];
+    if (list.count >= MAX_BLOCKS) return false;
+    Block* block = reinterpret_cast<Block*>(ptr);
+    block->next = list.head;
+    list.head = block;
+    ++list.count;
+    return true;
+  }
+
+private:
+  struct Block {
+    Block* next;
+  };
+  struct List {
+    Block* head = nullptr;
+    uint count = 0;
+  };
+  List lists[CLASSES];
+};
+
 class NullEventPort: public EventPort {
+  // The port used by `EventLoop()`.  There are no I/O events, but other threads can still wake
+  // the loop to deliver cross-thread events.
+
 public:
+  explicit NullEventPort(EventLoop& loop): loop(loop) {}
+
   bool wait() override {
-    KJ_FAIL_REQUIRE("Nothing to wait for; this thread would hang forever.");
+    {
+      auto lock = woken.lockExclusive();
+      if (*lock) {
+        *lock = false;
+        return true;
+      }
+
+      KJ_REQUIRE(loop.crossThreadQueue->pendingNodes > 0 || loop.executor.get() != nullptr,
+                 "Nothing to wait for; this thread would hang forever.");
+    }
+
+    woken.when([](const bool& woken) { return woken; },
+               [](bool& woken) { woken = false; });
+    return true;
   }
 
-  bool poll() override { return false; }
+  bool poll() override {
+    auto lock = woken.lockExclusive();
+    bool result = *lock;
+    *lock = false;
+    return result;
+  }
 
   void wake() const override {
-    // TODO(someday): Implement using condvar.
-    kj::throwRecoverableException(KJ_EXCEPTION(UNIMPLEMENTED,
-        "Cross-thread events are not yet implemented for EventLoops with no EventPort."));
+    *woken.lockExclusive() = true;
   }
 
-  static NullEventPort instance;
+private:
+  EventLoop& loop;
+  MutexGuarded<bool> woken;
 };
 
-NullEventPort NullEventPort::instance = NullEventPort();
+class EventTypeTrace {
+  // The types that `Event::trace()` would print, recorded without allocating.  Demangling them
+  // into a string is deferred until someone asks.
+
+public:
+  void capture(Event* event);
+  kj::String toString();
+
+private:
+  static constexpr uint MAX_DEPTH = 16;
+#if !KJ_NO_RTTI
+  const std::type_info* types[MAX_DEPTH];
+  uint count = 0;
+#endif
+};
 
 }  // namespace _ (private)
 
@@ -209,18 +387,33 @@ void EventPort::wake() const {
 }
 
 EventLoop::EventLoop()
-    : port(_::NullEventPort::instance),
-      daemons(kj::heap<_::TaskSetImpl>(_::LoggingErrorHandler::instance)) {}
+    : ownedPort(kj::heap<_::NullEventPort>(*this)),
+      port(*ownedPort),
+      daemons(kj::heap<_::TaskSetImpl>(_::LoggingErrorHandler::instance)),
+      crossThreadQueue(kj::heap<_::CrossThreadQueue>()),
+      nodeFreeList(kj::heap<_::NodeFreeList>()) {}
 
 EventLoop::EventLoop(EventPort& port)
     : port(port),
-      daemons(kj::heap<_::TaskSetImpl>(_::LoggingErrorHandler::instance)) {}
+      daemons(kj::heap<_::TaskSetImpl>(_::LoggingErrorHandler::instance)),
+      crossThreadQueue(kj::heap<_::CrossThreadQueue>()),
+      nodeFreeList(kj::heap<_::NodeFreeList>()) {}
 
 EventLoop::~EventLoop() noexcept(false) {
+  // Stop accepting work from other threads and reject whatever hasn't run yet.
+  if (executor.get() != nullptr) {
+    executor->shutdown();
+    executor = nullptr;
+  }
+
   // Destroy all "daemon" tasks, noting that their destructors might try to access the EventLoop
   // some more.
   daemons = nullptr;
 
+  // Release any cross-thread completions that arrived too late to be noticed.  Their promises are
+  // gone by now, so there is nothing to deliver.
+  drainCrossThreadQueue();
+
   // The application _should_ destroy everything using the EventLoop before destroying the
   // EventLoop itself, so if there are events on the loop, this indicates a memory leak.
   KJ_REQUIRE(head == nullptr, "EventLoop destroyed with events still in the queue.  Memory leak?",
@@ -276,11 +469,15 @@ bool EventLoop::turn() {
     event->next = nullptr;
     event->prev = nullptr;
 
-    Maybe<Own<_::Event>> eventToDestroy;
-    {
-      event->firing = true;
-      KJ_DEFER(event->firing = false);
-      eventToDestroy = event->fire();
+    if (monitor != nullptr) {
+      fireMonitored(event);
+    } else {
+      Maybe<Own<_::Event>> eventToDestroy;
+      {
+        event->firing = true;
+        KJ_DEFER(event->firing = false);
+        eventToDestroy = event->fire();
+      }
     }
 
     depthFirstInsertPoint = &head;
@@ -288,10 +485,82 @@ bool EventLoop::turn() {
   }
 }
 
+void EventLoop::fireMonitored(_::Event* event) {
+  EventLoopMonitor* monitor = this->monitor;
+  monitor->queueLengths.record(queueLength);
+  --queueLength;
+
+  _::EventTypeTrace trace;
+  if (monitor->slowEventNanos != int64_t(maxValue)) {
+    // Firing typically drops the promise nodes that identify the callback, so note their types
+    // now in case it turns out to be slow.
+    trace.capture(event);
+  }
+  uint64_t start = monotonicNanos();
+
+  Maybe<Own<_::Event>> eventToDestroy;
+  {
+    event->firing = true;
+    KJ_DEFER(event->firing = false);
+    eventToDestroy = event->fire();
+  }
+
+  // Re-check the monitor in case the callback destroyed it.
+  if (this->monitor == monitor) {
+    uint64_t nanos = monotonicNanos() - start;
+    monitor->turnTimes.record(nanos);
+    if (int64_t(nanos) >= monitor->slowEventNanos) {
+      ++monitor->slowEventCount;
+      monitor->slowEvent(int64_t(nanos) * NANOSECONDS, trace.toString());
+    }
+  }
+}
+
+void EventLoop::setMonitor(EventLoopMonitor* monitor) {
+  this->monitor = monitor;
+
+  // The queue length isn't tracked while nobody is watching, so count it afresh.
+  queueLength = 0;
+  if (monitor != nullptr) {
+    for (_::Event* event = head; event != nullptr; event = event->next) {
+      ++queueLength;
+    }
+  }
+}
+
 bool EventLoop::isRunnable() {
   return head != nullptr;
 }
 
+const Executor& EventLoop::getExecutor() {
+  if (executor.get() == nullptr) {
+    auto ptr = new Executor(*this);
+    executor = Own<Executor>(ptr, *ptr);
+  }
+  return *executor;
+}
+
+void EventLoop::drainCrossThreadQueue() {
+  Vector<_::CrossThreadPromiseStateBase*> items;
+  {
+    auto lock = crossThreadQueue->items.lockExclusive();
+    items = kj::mv(*lock);
+  }
+
+  for (auto item: items) {
+    // Only this thread modifies `node`, so no need to lock to read it.
+    _::CrossThreadPromiseNodeBase* node = item->shared.getWithoutLock().node;
+    if (node != nullptr) {
+      node->onReadyEvent.arm();
+    }
+    item->removeRef();
+  }
+
+  if (executor.get() != nullptr) {
+    executor->run();
+  }
+}
+
 void EventLoop::setRunnable(bool runnable) {
   if (runnable != lastRunnableState) {
     port.setRunnable(runnable);
@@ -329,7 +598,20 @@ void waitImpl(Own<_::PromiseNode>&& node, _::ExceptionOrValue& result, WaitScope
   while (!doneEvent.fired) {
     if (!loop.turn()) {
       // No events in the queue.  Wait for callback.
-      loop.port.wait();
+      bool woken;
+      if (loop.monitor == nullptr) {
+        woken = loop.port.wait();
+      } else {
+        uint64_t start = monotonicNanos();
+        woken = loop.port.wait();
+        if (loop.monitor != nullptr) {
+          loop.monitor->waitTimes.record(monotonicNanos() - start);
+        }
+      }
+      if (woken) {
+        // Another thread called wake(), possibly to deliver cross-thread events.
+        loop.drainCrossThreadQueue();
+      }
     }
   }
 
@@ -379,6 +661,9 @@ Event::~Event() noexcept(false) {
     if (next != nullptr) {
       next->prev = prev;
     }
+    if (loop.monitor != nullptr) {
+      --loop.queueLength;
+    }
   }
 
   KJ_REQUIRE(!firing, "Promise callback destroyed itself.");
@@ -405,6 +690,9 @@ void Event::armDepthFirst() {
       loop.tail = &next;
     }
 
+    if (loop.monitor != nullptr) {
+      ++loop.queueLength;
+    }
     loop.setRunnable(true);
   }
 }
@@ -424,6 +712,9 @@ void Event::armBreadthFirst() {
 
     loop.tail = &next;
 
+    if (loop.monitor != nullptr) {
+      ++loop.queueLength;
+    }
     loop.setRunnable(true);
   }
 }
@@ -471,10 +762,122 @@ kj::String Event::trace() {
   return traceImpl(this, getInnerForTrace());
 }
 
+void EventTypeTrace::capture(Event* event) {
+#if !KJ_NO_RTTI
+  count = 0;
+  types[count++] = &typeid(*event);
+  for (PromiseNode* node = event->getInnerForTrace(); node != nullptr && count < MAX_DEPTH;
+       node = node->getInnerForTrace()) {
+    types[count++] = &typeid(*node);
+  }
+#endif
+}
+
+kj::String EventTypeTrace::toString() {
+#if KJ_NO_RTTI
+  return heapString("Trace not available because RTTI is disabled.");
+#else
+  kj::Vector<kj::String> trace(count);
+  for (uint i = 0; i < count; i++) {
+    trace.add(demangleTypeName(types[i]->name()));
+  }
+  return strArray(trace, "\n");
+#endif
+}
+
 }  // namespace _ (private)
 
 // =======================================================================================
 
+namespace {
+
+_::ExecutorWork* reverseWorkList(_::ExecutorWork* list) {
+  // The queue is a stack; reverse it so that work runs in the order it was sent.
+  _::ExecutorWork* result = nullptr;
+  while (list != nullptr) {
+    _::ExecutorWork* next = list->next;
+    list->next = result;
+    result = list;
+    list = next;
+  }
+  return result;
+}
+
+void rejectWorkList(_::ExecutorWork* list) {
+  while (list != nullptr) {
+    Own<_::ExecutorWork> work(list, _::HeapDisposer<_::ExecutorWork>::instance);
+    list = list->next;
+    work->reject(KJ_EXCEPTION(DISCONNECTED,
+        "Executor's EventLoop was destroyed before the function could run."));
+  }
+}
+
+}  // namespace
+
+Executor::Executor(EventLoop& loop): loop(&loop) {}
+Executor::~Executor() noexcept(false) {}
+
+bool Executor::isLive() const {
+  return *loop.lockShared() != nullptr;
+}
+
+Own<const Executor> Executor::addRef() const {
+  __atomic_add_fetch(&refcount, 1, __ATOMIC_RELAXED);
+  return Own<const Executor>(this, *this);
+}
+
+void Executor::disposeImpl(void* pointer) const {
+  if (__atomic_sub_fetch(&refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+    delete this;
+  }
+}
+
+void Executor::send(_::ExecutorWork* work) const {
+  _::ExecutorWork* head = __atomic_load_n(&queue, __ATOMIC_RELAXED);
+  do {
+    work->next = head;
+  } while (!__atomic_compare_exchange_n(&queue, &head, work, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+  if (head != nullptr) {
+    // Whoever made the queue non-empty has already woken the loop (or found it dead and will
+    // reject everything it takes, including our work).
+    return;
+  }
+
+  {
+    auto lock = loop.lockShared();
+    if (*lock != nullptr) {
+      (*lock)->port.wake();
+      return;
+    }
+  }
+
+  // The loop is gone, so nobody else will ever take this work.
+  rejectWorkList(reverseWorkList(__atomic_exchange_n(&queue, nullptr, __ATOMIC_ACQUIRE)));
+}
+
+void Executor::run() {
+  _::ExecutorWork* list = reverseWorkList(__atomic_exchange_n(&queue, nullptr, __ATOMIC_ACQUIRE));
+  while (list != nullptr) {
+    Own<_::ExecutorWork> work(list, _::HeapDisposer<_::ExecutorWork>::instance);
+    list = list->next;
+    auto promise = work->run();
+    _::detach(promise.attach(kj::mv(work)));
+  }
+}
+
+void Executor::shutdown() {
+  *loop.lockExclusive() = nullptr;
+  rejectWorkList(reverseWorkList(__atomic_exchange_n(&queue, nullptr, __ATOMIC_ACQUIRE)));
+}
+
+const Executor& getCurrentThreadExecutor() {
+  return currentEventLoop().getExecutor();
+}
+
+// =======================================================================================
+
 TaskSet::TaskSet(ErrorHandler& errorHandler)
     : impl(heap<_::TaskSetImpl>(errorHandler)) {}
 
@@ -488,6 +891,14 @@ kj::String TaskSet::trace() {
   return impl->trace();
 }
 
+Promise<void> TaskSet::onEmpty() {
+  return impl->onEmpty();
+}
+
+bool TaskSet::isEmpty() {
+  return impl->isEmpty();
+}
+
 namespace _ {  // private
 
 kj::String PromiseBase::trace() {
@@ -498,6 +909,93 @@ void PromiseNode::setSelfPointer(Own<PromiseNode>* selfPtr) noexcept {}
 
 PromiseNode* PromiseNode::getInnerForTrace() { return nullptr; }
 
+void* PromiseNode::operator new(size_t size) {
+  uint sizeClass = NodeFreeList::sizeClass(size);
+  if (sizeClass >= NodeFreeList::CLASSES) {
+    return ::operator new(size);
+  }
+
+#if KJ_NODE_FREE_LIST
+  EventLoop* loop = threadLocalEventLoop;
+  if (loop != nullptr) {
+    void* block = loop->nodeFreeList->pop(sizeClass);
+    if (block != nullptr) return block;
+  }
+#endif
+
+  return ::operator new((sizeClass + 1) * NodeFreeList::GRANULARITY);
+}
+
+void PromiseNode::operator delete(void* ptr, size_t size) {
+#if KJ_NODE_FREE_LIST
+  uint sizeClass = NodeFreeList::sizeClass(size);
+  if (sizeClass < NodeFreeList::CLASSES) {
+    EventLoop* loop = threadLocalEventLoop;
+    if (loop != nullptr && loop->nodeFreeList->push(sizeClass, ptr)) {
+      return;
+    }
+  }
+#endif
+
+  ::operator delete(ptr);
+}
+
+ExecutorWork::~ExecutorWork() noexcept(false) {}
+
+CrossThreadPromiseStateBase::CrossThreadPromiseStateBase(): loop(currentEventLoop()) {}
+CrossThreadPromiseStateBase::~CrossThreadPromiseStateBase() noexcept(false) {}
+
+void CrossThreadPromiseStateBase::addRef() const {
+  ++shared.lockExclusive()->refcount;
+}
+
+void CrossThreadPromiseStateBase::removeRef() const {
+  bool last;
+  {
+    auto lock = shared.lockExclusive();
+    last = --lock->refcount == 0;
+  }
+  if (last) {
+    delete this;
+  }
+}
+
+bool CrossThreadPromiseStateBase::isWaiting() const {
+  return !completed && shared.lockShared()->node != nullptr;
+}
+
+void CrossThreadPromiseStateBase::complete() {
+  completed = true;
+
+  // Holding the lock keeps the node -- and therefore the loop -- alive while we queue to it.
+  auto lock = shared.lockExclusive();
+  if (lock->node != nullptr) {
+    ++lock->refcount;
+    loop.crossThreadQueue->items.lockExclusive()->add(this);
+    loop.port.wake();
+  }
+}
+
+CrossThreadPromiseNodeBase::CrossThreadPromiseNodeBase(CrossThreadPromiseStateBase& state)
+    : state(state) {
+  {
+    auto lock = state.shared.lockExclusive();
+    ++lock->refcount;
+    lock->node = this;
+  }
+  ++state.loop.crossThreadQueue->pendingNodes;
+}
+
+CrossThreadPromiseNodeBase::~CrossThreadPromiseNodeBase() noexcept(false) {
+  state.shared.lockExclusive()->node = nullptr;
+  --state.loop.crossThreadQueue->pendingNodes;
+  state.removeRef();
+}
+
+void CrossThreadPromiseNodeBase::onReady(Event& event) noexcept {
+  onReadyEvent.init(event);
+}
+
 void PromiseNode::OnReadyEvent::init(Event& newEvent) {
   if (event == _kJ_ALREADY_READY) {
     // A new continuation was added to a promise that was already ready.  In this case, we schedule
@@ -29,10 +29,23 @@
 #include "async-prelude.h"
 #include "exception.h"
 #include "refcount.h"
+#include "mutex.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && \
+    (defined(__clang__) || !defined(__GNUC__) || __GNUC__ >= 13)
+// GCC before 13 crashes compiling coroutines whose return type has a noexcept(false) destructor,
+// which Promise does (via Own).
+#define KJ_HAS_COROUTINE 1
+#include <coroutine>
+#else
+#define KJ_HAS_COROUTINE 0
+// Coroutines need C++20 (e.g. -std=c++20).
+#endif
 
 namespace kj {
 
 class EventLoop;
+class EventLoopMonitor;
 class WaitScope;
 
 template <typename T>
@@ -302,6 +315,8 @@ private:
   friend Promise<U> newAdaptedPromise(Params&&... adapterConstructorParams);
   template <typename U>
   friend PromiseFulfillerPair<U> newPromiseAndFulfiller();
+  template <typename U>
+  friend PromiseFulfillerPair<U> newCrossThreadPromiseAndFulfiller();
   template <typename>
   friend class _::ForkHub;
   friend class _::TaskSetImpl;
@@ -310,6 +325,10 @@ private:
   template <typename U>
   friend Promise<Array<U>> joinPromises(Array<Promise<U>>&& promises);
   friend Promise<void> joinPromises(Array<Promise<void>>&& promises);
+  template <typename>
+  friend class _::Coroutine;
+  template <typename>
+  friend class _::PromiseAwaiter;
 };
 
 template <typename T>
@@ -369,6 +388,41 @@ template <typename T>
 Promise<Array<T>> joinPromises(Array<Promise<T>>&& promises);
 // Join an array of promises into a promise for an array.
 
+// =======================================================================================
+// Coroutines
+
+#if KJ_HAS_COROUTINE
+
+// When compiled as C++20, any function returning `Promise<T>` may be a coroutine, and may
+// `co_await` other promises:
+//
+//     Promise<size_t> readAll(AsyncInputStream& input, ArrayPtr<byte> buffer) {
+//       size_t total = 0;
+//       while (total < buffer.size()) {
+//         size_t n = co_await input.tryRead(buffer.begin() + total, 1, buffer.size() - total);
+//         if (n == 0) break;
+//         total += n;
+//       }
+//       co_return total;
+//     }
+//
+// The coroutine runs synchronously until its first `co_await` of a promise that isn't ready, as
+// with `evalNow()`.  Its frame is the returned promise's only node and is reused across every
+// `co_await`, where the equivalent `then()` chain allocates a node per step.  Exceptions thrown
+// from the body reject the promise.  Destroying the promise destroys the frame, canceling
+// whatever the coroutine is awaiting, like destroying any other promise.
+//
+// A coroutine must not use `Promise::wait()` -- it always runs inside the event loop.
+
+template <typename T>
+_::PromiseAwaiter<T> operator co_await(Promise<T>&& promise);
+template <typename T>
+_::PromiseAwaiter<T> operator co_await(Promise<T>& promise);
+// Await a promise from within a coroutine returning a `Promise`.  The promise is consumed either
+// way; the lvalue overload just saves writing `kj::mv()`.
+
+#endif  // KJ_HAS_COROUTINE
+
 // =======================================================================================
 // Hack for creating a lambda that holds an owned pointer.
 
@@ -488,6 +542,19 @@ PromiseFulfillerPair<T> newPromiseAndFulfiller();
 // fulfiller will be of type `PromiseFulfiller<Promise<U>>`.  Thus you pass a `Promise<U>` to the
 // `fulfill()` callback, and the promises are chained.
 
+template <typename T>
+PromiseFulfillerPair<T> newCrossThreadPromiseAndFulfiller();
+// Like `newPromiseAndFulfiller()`, except that the fulfiller may be used and destroyed from any
+// thread (though only from one thread at a time).  The promise belongs to the calling thread's
+// `EventLoop`.  When the fulfiller is called, the result is queued to that loop and its
+// `EventPort` is woken with `wake()`, so the port must support cross-thread wakeups; the default
+// port used by `EventLoop()` and `UnixEventPort` both do.  The queued result is picked up the next
+// time the loop's thread would otherwise wait for I/O.
+//
+// The value is moved from the fulfilling thread to the promise's thread, so it must not contain
+// anything tied to the fulfilling thread's `EventLoop`, such as promises.  For the same reason, T
+// cannot be a promise type.
+
 // =======================================================================================
 // TaskSet
 
@@ -519,6 +586,14 @@ public:
   kj::String trace();
   // Return debug info about all promises currently in the TaskSet.
 
+  bool isEmpty();
+  // True if all tasks have completed (or none were ever added).
+
+  Promise<void> onEmpty();
+  // Returns a promise that resolves the next time the TaskSet becomes empty, or immediately if it
+  // already is. Useful for draining in-flight work before shutdown. Only one onEmpty() promise may
+  // be outstanding at a time, though once it has been dropped, onEmpty() may be called again.
+
 private:
   Own<_::TaskSetImpl> impl;
 };
@@ -575,9 +650,65 @@ public:
   // Technically speaking, `wake()` causes the target thread to cease sleeping and not to sleep
   // again until `wait()` or `poll()` has returned true at least once.
   //
-  // The default implementation throws an UNIMPLEMENTED exception.
+  // The default implementation throws an UNIMPLEMENTED exception.  Ports which don't implement
+  // `wake()` cannot receive cross-thread events (see `newCrossThreadPromiseAndFulfiller()`).
 };
 
+class Executor final: private kj::Disposer {
+  // Lets other threads run functions on an `EventLoop`'s thread.  Get one from
+  // `EventLoop::getExecutor()` or `getCurrentThreadExecutor()` and hand it (or a reference from
+  // `addRef()`) to whichever threads need to post work to that loop.
+  //
+  // Requests are pushed onto a lock-free queue.  The loop's `EventPort` is woken only when the
+  // queue goes from empty to non-empty, so a burst of requests costs a single wakeup.
+
+public:
+  template <typename Func>
+  PromiseForResult<Func, void> executeAsync(Func&& func) const;
+  // Call `func()` on the executor's thread and return a promise for the result.  The calling
+  // thread must have an `EventLoop` of its own; the returned promise belongs to it.  If `func()`
+  // returns a promise, the result is delivered once that promise resolves.
+  //
+  // `func` is moved to the executor's thread and destroyed there, so it must not capture
+  // anything belonging to the calling thread's loop.  Likewise the result is moved back, so it
+  // must not contain anything belonging to the executor's loop.
+  //
+  // Dropping the returned promise does not cancel the call.  If the executor's `EventLoop` is
+  // destroyed before `func` runs, the promise is rejected with a DISCONNECTED exception.
+
+  bool isLive() const;
+  // False once the executor's `EventLoop` has been destroyed.
+
+  Own<const Executor> addRef() const;
+  // Returns a new reference to this executor.  The reference keeps the `Executor` object alive,
+  // but not its `EventLoop`.
+
+private:
+  explicit Executor(EventLoop& loop);
+  ~Executor() noexcept(false);
+
+  mutable uint refcount = 1;
+
+  mutable _::ExecutorWork* queue = nullptr;
+  // Lock-free stack of pending work, newest first.  Pushed by any thread; taken as a whole by the
+  // loop's thread.
+
+  MutexGuarded<EventLoop*> loop;
+  // Null once the loop has been destroyed.
+
+  void send(_::ExecutorWork* work) const;
+  void run();
+  void shutdown();
+
+  void disposeImpl(void* pointer) const override;
+
+  friend class EventLoop;
+  friend class _::NullEventPort;
+};
+
+const Executor& getCurrentThreadExecutor();
+// Get the executor for the current thread's `EventLoop`.
+
 class EventLoop {
   // Represents a queue of events being executed in a loop.  Most code won't interact with
   // EventLoop directly, but instead use `Promise`s to interact with it indirectly.  See the
@@ -612,7 +743,8 @@ class EventLoop {
 
 public:
   EventLoop();
-  // Construct an `EventLoop` which does not receive external events at all.
+  // Construct an `EventLoop` which does not receive I/O events.  Its thread sleeps on a condition
+  // variable when it has nothing to do, so it can still receive cross-thread events.
 
   explicit EventLoop(EventPort& port);
   // Construct an `EventLoop` which receives external events through the given `EventPort`.
@@ -627,7 +759,13 @@ public:
   bool isRunnable();
   // Returns true if run() would currently do anything, or false if the queue is empty.
 
+  const Executor& getExecutor();
+  // Returns an `Executor` through which other threads can run functions on this loop's thread.
+
 private:
+  Own<EventPort> ownedPort;
+  // The default port, if no port was passed to the constructor.
+
   EventPort& port;
 
   bool running = false;
@@ -642,16 +780,46 @@ private:
 
   Own<_::TaskSetImpl> daemons;
 
+  Own<_::CrossThreadQueue> crossThreadQueue;
+  // Cross-thread promises which have been fulfilled from other threads and are waiting for this
+  // thread to notice.
+
   bool turn();
   void setRunnable(bool runnable);
   void enterScope();
   void leaveScope();
 
+  void drainCrossThreadQueue();
+  // Arms the events of all promises in `crossThreadQueue`.  Called when the port reports that
+  // `wake()` has been called.
+
+  Own<Executor> executor;
+  // Created on first use by `getExecutor()`.
+
+  Own<_::NodeFreeList> nodeFreeList;
+  // Recycled PromiseNode allocations.
+
+  EventLoopMonitor* monitor = nullptr;
+  // Set while an `EventLoopMonitor` is attached; see `kj/event-loop-monitor.h`.
+
+  size_t queueLength = 0;
+  // Number of events in the queue.  Only kept up to date while a monitor is attached.
+
+  void setMonitor(EventLoopMonitor* monitor);
+  void fireMonitored(_::Event* event);
+  // Like firing `event` directly from `turn()`, but records it in `monitor`.
+
   friend void _::detach(kj::Promise<void>&& promise);
   friend void _::waitImpl(Own<_::PromiseNode>&& node, _::ExceptionOrValue& result,
                           WaitScope& waitScope);
   friend class _::Event;
+  friend class _::NullEventPort;
+  friend class _::CrossThreadPromiseStateBase;
+  friend class _::CrossThreadPromiseNodeBase;
+  friend class Executor;
+  friend class _::PromiseNode;
   friend class WaitScope;
+  friend class EventLoopMonitor;
 };
 
 class WaitScope {
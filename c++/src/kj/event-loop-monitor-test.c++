@@ -0,0 +1,149 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "event-loop-monitor.h"
+#include "thread.h"
+#include "vector.h"
+#include <kj/test.h>
+#include <unistd.h>
+#include <string.h>
+
+namespace kj {
+namespace {
+
+void runQueued(WaitScope& waitScope) {
+  evalLater([]() {}).wait(waitScope);
+}
+
+KJ_TEST("EventLoopMonitor records turns and queue lengths") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  EventLoopMonitor monitor(loop);
+
+  uint count = 0;
+  Vector<Promise<void>> promises;
+  for (uint i = 0; i < 10; i++) {
+    promises.add(evalLater([&]() { ++count; }).eagerlyEvaluate(nullptr));
+  }
+  runQueued(waitScope);
+  KJ_EXPECT(count == 10);
+
+  auto& turns = monitor.getTurnTimes();
+  auto& queue = monitor.getQueueLengths();
+  KJ_EXPECT(turns.getCount() >= 10, turns.getCount());
+  KJ_EXPECT(queue.getCount() == turns.getCount());
+  KJ_EXPECT(queue.getMax() >= 10, queue.getMax());
+  KJ_EXPECT(queue.getPercentile(1.0) == queue.getMax());
+  KJ_EXPECT(monitor.getSlowEventCount() == 0);
+
+  monitor.reset();
+  KJ_EXPECT(monitor.getTurnTimes().getCount() == 0);
+  KJ_EXPECT(monitor.getTurnTimes().getPercentile(0.5) == 0);
+}
+
+KJ_TEST("EventLoopMonitor counts events queued before it was attached") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  Vector<Promise<void>> promises;
+  for (uint i = 0; i < 5; i++) {
+    promises.add(evalLater([]() {}).eagerlyEvaluate(nullptr));
+  }
+
+  EventLoopMonitor monitor(loop);
+  runQueued(waitScope);
+  KJ_EXPECT(monitor.getQueueLengths().getMax() >= 5, monitor.getQueueLengths().getMax());
+  KJ_EXPECT(monitor.getQueueLengths().getMax() < 10, monitor.getQueueLengths().getMax());
+}
+
+KJ_TEST("EventLoopMonitor reports slow callbacks") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  class TestMonitor final: public EventLoopMonitor {
+  public:
+    TestMonitor(EventLoop& loop): EventLoopMonitor(loop, 5 * MILLISECONDS) {}
+
+    Vector<String> traces;
+    Duration longest = 0 * NANOSECONDS;
+
+  protected:
+    void slowEvent(Duration duration, String trace) override {
+      traces.add(kj::mv(trace));
+      if (duration > longest) longest = duration;
+    }
+  };
+  TestMonitor monitor(loop);
+
+  evalLater([]() {}).wait(waitScope);
+  KJ_EXPECT(monitor.traces.size() == 0);
+
+  // Eagerly evaluated, so that the callback runs in a turn of its own rather than inside wait().
+  auto promise = evalLater([]() { usleep(20000); }).eagerlyEvaluate(nullptr);
+  runQueued(waitScope);
+  KJ_ASSERT(monitor.traces.size() == 1);
+  KJ_EXPECT(monitor.getSlowEventCount() == 1);
+  KJ_EXPECT(monitor.longest >= 20 * MILLISECONDS);
+  KJ_EXPECT(monitor.getTurnTimes().getMax() >= 20000000u);
+#if !KJ_NO_RTTI
+  // The trace is taken before the callback runs, so it still names the continuation.
+  KJ_EXPECT(strstr(monitor.traces[0].cStr(), "TransformPromiseNode") != nullptr, monitor.traces[0]);
+#endif
+}
+
+KJ_TEST("EventLoopMonitor records time spent waiting") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  EventLoopMonitor monitor(loop);
+
+  auto paf = newCrossThreadPromiseAndFulfiller<void>();
+  Thread thread([&]() {
+    usleep(10000);
+    paf.fulfiller->fulfill();
+  });
+
+  paf.promise.wait(waitScope);
+  auto& waits = monitor.getWaitTimes();
+  KJ_EXPECT(waits.getCount() >= 1);
+  KJ_EXPECT(waits.getSum() >= 5000000u, waits.getSum());
+}
+
+KJ_TEST("EventLoopMonitor can be destroyed from a callback") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  {
+    EventLoopMonitor other(loop);
+    KJ_EXPECT_THROW_MESSAGE("already has a monitor", EventLoopMonitor second(loop));
+  }
+
+  Maybe<Own<EventLoopMonitor>> monitor = heap<EventLoopMonitor>(loop);
+  evalLater([&]() { monitor = nullptr; }).wait(waitScope);
+  runQueued(waitScope);
+
+  // A new monitor can be attached once the old one is gone.
+  EventLoopMonitor replacement(loop);
+  runQueued(waitScope);
+  KJ_EXPECT(replacement.getTurnTimes().getCount() >= 1);
+}
+
+}  // namespace
+}  // namespace kj
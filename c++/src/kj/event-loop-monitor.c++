@@ -0,0 +1,98 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "event-loop-monitor.h"
+#include "debug.h"
+#include <string.h>
+
+namespace kj {
+
+namespace {
+
+uint bucketFor(uint64_t value) {
+  // Returns one more than the index of the highest set bit, or zero for zero.
+  if (value == 0) return 0;
+  uint result = 1;
+  for (uint shift: {32, 16, 8, 4, 2, 1}) {
+    if (value >> shift) {
+      value >>= shift;
+      result += shift;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+EventLoopMonitor::Histogram::Histogram() {
+  memset(buckets, 0, sizeof(buckets));
+}
+
+void EventLoopMonitor::Histogram::record(uint64_t value) {
+  ++count;
+  sum += value;
+  max = kj::max(max, value);
+  ++buckets[bucketFor(value)];
+}
+
+uint64_t EventLoopMonitor::Histogram::getPercentile(double fraction) const {
+  if (count == 0) return 0;
+
+  uint64_t rank = kj::max(uint64_t(1), uint64_t(fraction * count + 0.5));
+  uint64_t seen = 0;
+  for (uint i = 0; i < BUCKET_COUNT; i++) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      uint64_t top = i == 0 ? 0 : i < 64 ? (uint64_t(1) << i) - 1 : uint64_t(kj::maxValue);
+      return kj::min(max, top);
+    }
+  }
+  return max;
+}
+
+EventLoopMonitor::EventLoopMonitor(EventLoop& loop, Maybe<Duration> slowEventThreshold)
+    : loop(loop), slowEventNanos(kj::maxValue) {
+  KJ_IF_MAYBE(threshold, slowEventThreshold) {
+    slowEventNanos = *threshold / NANOSECONDS;
+  }
+
+  KJ_REQUIRE(loop.monitor == nullptr, "EventLoop already has a monitor attached.");
+  loop.setMonitor(this);
+}
+
+EventLoopMonitor::~EventLoopMonitor() noexcept(false) {
+  if (loop.monitor == this) {
+    loop.setMonitor(nullptr);
+  }
+}
+
+void EventLoopMonitor::reset() {
+  turnTimes = Histogram();
+  waitTimes = Histogram();
+  queueLengths = Histogram();
+  slowEventCount = 0;
+}
+
+void EventLoopMonitor::slowEvent(Duration duration, String trace) {
+  KJ_LOG(WARNING, "event loop callback ran too long", duration / MICROSECONDS, trace);
+}
+
+}  // namespace kj
@@ -0,0 +1,120 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef KJ_EVENT_LOOP_MONITOR_H_
+#define KJ_EVENT_LOOP_MONITOR_H_
+
+#if defined(__GNUC__) && !KJ_HEADER_WARNINGS
+#pragma GCC system_header
+#endif
+
+#include "async.h"
+#include "time.h"
+
+namespace kj {
+
+class EventLoopMonitor {
+  // Records where an `EventLoop`'s time goes:  how long each turn (one event callback) takes, how
+  // many events were queued when it started, and how long the loop slept in `EventPort::wait()`.
+  // Optionally, any callback that runs longer than a threshold is reported along with the trace
+  // of the promise it belonged to, so that whoever is hogging the loop can be found.
+  //
+  // A monitor attaches itself to the loop when constructed and detaches when destroyed.  While no
+  // monitor is attached the loop neither reads the clock nor counts its queue, which leaves a null
+  // check per turn and per event queued or cancelled.  Like the loop, a monitor must only be used
+  // from the loop's thread.
+  //
+  //     EventLoopMonitor monitor(loop, 10 * MILLISECONDS);
+  //     ...
+  //     KJ_LOG(INFO, "p99 turn time", monitor.getTurnTimes().getPercentile(0.99));
+
+public:
+  explicit EventLoopMonitor(EventLoop& loop, Maybe<Duration> slowEventThreshold = nullptr);
+  // Begin monitoring `loop`.  If `slowEventThreshold` is given, `slowEvent()` is called for each
+  // callback that runs for at least that long.
+
+  KJ_DISALLOW_COPY(EventLoopMonitor);
+  virtual ~EventLoopMonitor() noexcept(false);
+
+  class Histogram {
+    // Counts values in power-of-two buckets:  bucket 0 holds zero, and bucket `i` holds values in
+    // [2^(i-1), 2^i).  Recording is a few shifts and an increment; no allocation.
+
+  public:
+    Histogram();
+
+    void record(uint64_t value);
+
+    uint64_t getCount() const { return count; }
+    uint64_t getSum() const { return sum; }
+    uint64_t getMax() const { return max; }
+
+    uint64_t getPercentile(double fraction) const;
+    // Returns a value such that approximately `fraction` (0 to 1) of the samples are no larger
+    // than it -- namely, the upper bound of the bucket containing that sample, capped at the
+    // largest sample seen.  Returns zero if there are no samples.
+
+    ArrayPtr<const uint64_t> getBuckets() const { return buckets; }
+
+    static constexpr uint BUCKET_COUNT = 65;
+
+  private:
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    uint64_t buckets[BUCKET_COUNT];
+  };
+
+  const Histogram& getTurnTimes() const { return turnTimes; }
+  // Nanoseconds spent in each event callback.
+
+  const Histogram& getWaitTimes() const { return waitTimes; }
+  // Nanoseconds spent in each call to `EventPort::wait()`.
+
+  const Histogram& getQueueLengths() const { return queueLengths; }
+  // Number of runnable events (including the one about to run) at the start of each turn.
+
+  uint64_t getSlowEventCount() const { return slowEventCount; }
+
+  void reset();
+  // Clear all statistics collected so far.
+
+protected:
+  virtual void slowEvent(Duration duration, String trace);
+  // Called after a callback ran for at least the threshold passed to the constructor, with the
+  // trace of the event as it stood just before it fired.  The default implementation logs a warning.
+
+private:
+  EventLoop& loop;
+  int64_t slowEventNanos;
+  Histogram turnTimes;
+  Histogram waitTimes;
+  Histogram queueLengths;
+  uint64_t slowEventCount = 0;
+
+  friend class EventLoop;
+  friend void _::waitImpl(Own<_::PromiseNode>&& node, _::ExceptionOrValue& result,
+                          WaitScope& waitScope);
+};
+
+}  // namespace kj
+
+#endif  // KJ_EVENT_LOOP_MONITOR_H_
@@ -126,8 +126,8 @@ private:
   ArrayPtr<const char> content;
 };
 
-inline bool operator==(const char* a, const StringPtr& b) { return b == a; }
-inline bool operator!=(const char* a, const StringPtr& b) { return b != a; }
+inline bool operator==(const char* a, const StringPtr& b) { return b == StringPtr(a); }
+inline bool operator!=(const char* a, const StringPtr& b) { return b != StringPtr(a); }
 
 template <> char StringPtr::parseAs<char>() const;
 template <> signed char StringPtr::parseAs<signed char>() const;
@@ -216,8 +216,8 @@ private:
   Array<char> content;
 };
 
-inline bool operator==(const char* a, const String& b) { return b == a; }
-inline bool operator!=(const char* a, const String& b) { return b != a; }
+inline bool operator==(const char* a, const String& b) { return b == StringPtr(a); }
+inline bool operator!=(const char* a, const String& b) { return b != StringPtr(a); }
 
 String heapString(size_t size);
 // Allocate a String of the given size on the heap, not including NUL terminator.  The NUL
@@ -0,0 +1,152 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "thread-pool.h"
+#include "debug.h"
+#include "mutex.h"
+#include "thread.h"
+#include "vector.h"
+#include <kj/test.h>
+#include <unistd.h>
+
+namespace kj {
+namespace {
+
+const void* threadId() {
+  static thread_local char marker;
+  return &marker;
+}
+
+KJ_TEST("ThreadPool runs functions and returns their results") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  ThreadPool pool(2);
+  KJ_EXPECT(pool.getThreadCount() == 2);
+
+  KJ_EXPECT(pool.run([]() { return 123; }).wait(waitScope) == 123);
+  KJ_EXPECT(pool.run([]() { return kj::str("foo"); }).wait(waitScope) == "foo");
+
+  bool ran = false;
+  pool.run([&]() { ran = true; }).wait(waitScope);
+  KJ_EXPECT(ran);
+
+  KJ_EXPECT_THROW_MESSAGE("oops", pool.run([]() -> int {
+    KJ_FAIL_ASSERT("oops");
+  }).wait(waitScope));
+}
+
+KJ_TEST("ThreadPool churn") {
+  // Many small calls from one event loop, the pattern of e.g. a server offloading DNS lookups or
+  // hashing.  With kj::Thread each would have cost a thread spawn and join.
+
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  ThreadPool pool(4);
+
+  constexpr uint COUNT = 20000;
+  Vector<Promise<uint>> promises(COUNT);
+  for (uint i = 0; i < COUNT; i++) {
+    promises.add(pool.run([i]() { return i * 2; }));
+  }
+
+  uint64_t sum = 0;
+  for (auto& promise: promises) {
+    sum += promise.wait(waitScope);
+  }
+  KJ_EXPECT(sum == uint64_t(COUNT) * (COUNT - 1));
+}
+
+KJ_TEST("ThreadPool workers steal work posted from other workers") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  ThreadPool pool(4);
+
+  constexpr uint COUNT = 64;
+  MutexGuarded<Vector<const void*>> threads;
+  uint remaining = COUNT;
+
+  auto paf = newCrossThreadPromiseAndFulfiller<void>();
+  auto& fulfiller = *paf.fulfiller;
+
+  // One task fans out into many on its own worker's deque.  Each takes a little while, so the
+  // other workers, idle, have time to steal.
+  pool.post([&]() {
+    for (uint i = 0; i < COUNT; i++) {
+      pool.post([&]() {
+        usleep(1000);
+        auto lock = threads.lockExclusive();
+        lock->add(threadId());
+        if (--remaining == 0) fulfiller.fulfill();
+      });
+    }
+  });
+
+  paf.promise.wait(waitScope);
+
+  auto lock = threads.lockExclusive();
+  KJ_EXPECT(lock->size() == COUNT);
+  uint distinct = 0;
+  for (uint i = 0; i < lock->size(); i++) {
+    bool seen = false;
+    for (uint j = 0; j < i; j++) {
+      if ((*lock)[i] == (*lock)[j]) seen = true;
+    }
+    if (!seen) ++distinct;
+  }
+  KJ_EXPECT(distinct > 1, distinct);
+}
+
+KJ_TEST("ThreadPool skips calls whose promise was dropped") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  bool ran = false;
+  {
+    ThreadPool pool(1);
+
+    // Keep the only worker busy until we've dropped the second call.
+    MutexGuarded<bool> release;
+    auto blocker = pool.run([&]() {
+      release.when([](const bool& value) { return value; }, [](bool&) {});
+    });
+    pool.run([&]() { ran = true; });  // promise dropped immediately
+    *release.lockExclusive() = true;
+    blocker.wait(waitScope);
+
+    // The destructor drains the queue.
+  }
+  KJ_EXPECT(!ran);
+}
+
+KJ_TEST("ThreadPool destructor finishes queued work") {
+  // No event loop needed for post().
+  MutexGuarded<uint> counter;
+  {
+    ThreadPool pool(3);
+    for (uint i = 0; i < 1000; i++) {
+      pool.post([&]() { ++*counter.lockExclusive(); });
+    }
+  }
+  KJ_EXPECT(*counter.lockExclusive() == 1000);
+}
+
+}  // namespace
+}  // namespace kj
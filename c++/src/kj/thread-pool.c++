@@ -0,0 +1,365 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "thread-pool.h"
+#include "debug.h"
+#include "thread.h"
+#include "threadlocal.h"
+#include "vector.h"
+
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace kj {
+namespace _ {  // private
+
+ThreadPoolTask::~ThreadPoolTask() noexcept(false) {}
+
+namespace {
+
+constexpr uint MAX_BATCH = 32;
+// Most tasks an idle worker takes from the injection queue at once.
+
+uint defaultThreadCount() {
+#if _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count < 1 ? 1 : count;
+#endif
+}
+
+class PostedTask final: public ThreadPoolTask {
+public:
+  explicit PostedTask(Function<void()> func): func(kj::mv(func)) {}
+
+  void run() override {
+    KJ_IF_MAYBE(exception, kj::runCatchingExceptions([&]() { func(); })) {
+      KJ_LOG(ERROR, "uncaught exception in ThreadPool::post() task", *exception);
+    }
+  }
+
+private:
+  Function<void()> func;
+};
+
+class WorkStealingDeque {
+  // Chase-Lev deque, as formulated for C11 atomics by Lê et al., "Correct and Efficient
+  // Work-Stealing for Weak Memory Models" (PPoPP 2013).  Only the owning worker calls push() and
+  // take(), at the bottom; any other thread may steal() from the top.
+
+public:
+  WorkStealingDeque() {
+    buffers.add(heap<Buffer>(64));
+    buffer = buffers.back();
+  }
+
+  ~WorkStealingDeque() noexcept(false) {
+    // Normally empty, since the pool drains all work before shutting down.
+    while (ThreadPoolTask* task = take()) {
+      delete task;
+    }
+  }
+
+  void push(ThreadPoolTask* task) {
+    int64_t b = __atomic_load_n(&bottom, __ATOMIC_RELAXED);
+    int64_t t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+    Buffer* a = __atomic_load_n(&buffer, __ATOMIC_RELAXED);
+    if (b - t > a->mask) {
+      a = grow(a, t, b);
+    }
+    a->put(b, task);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+  }
+
+  ThreadPoolTask* take() {
+    int64_t b = __atomic_load_n(&bottom, __ATOMIC_RELAXED) - 1;
+    Buffer* a = __atomic_load_n(&buffer, __ATOMIC_RELAXED);
+    __atomic_store_n(&bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t t = __atomic_load_n(&top, __ATOMIC_RELAXED);
+
+    if (t > b) {
+      // Empty.
+      __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+      return nullptr;
+    }
+
+    ThreadPoolTask* task = a->get(b);
+    if (t == b) {
+      // Last element; race any thieves for it.
+      if (!__atomic_compare_exchange_n(&top, &t, t + 1, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        task = nullptr;
+      }
+      __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+  }
+
+  ThreadPoolTask* steal() {
+    // Returns null if the deque is empty or another thread won the race for the top element.
+    int64_t t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&bottom, __ATOMIC_ACQUIRE);
+    if (t >= b) return nullptr;
+
+    Buffer* a = __atomic_load_n(&buffer, __ATOMIC_ACQUIRE);
+    ThreadPoolTask* task = a->get(t);
+    if (!__atomic_compare_exchange_n(&top, &t, t + 1, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+      return nullptr;
+    }
+    return task;
+  }
+
+private:
+  struct Buffer {
+    int64_t mask;
+    Array<ThreadPoolTask*> slots;
+
+    explicit Buffer(size_t size): mask(size - 1), slots(heapArray<ThreadPoolTask*>(size)) {}
+
+    ThreadPoolTask* get(int64_t i) {
+      return __atomic_load_n(&slots[i & mask], __ATOMIC_RELAXED);
+    }
+    void put(int64_t i, ThreadPoolTask* task) {
+      __atomic_store_n(&slots[i & mask], task, __ATOMIC_RELAXED);
+    }
+  };
+
+  int64_t top = 0;
+  int64_t bottom = 0;
+  Buffer* buffer;
+
+  Vector<Own<Buffer>> buffers;
+  // Every buffer this deque has used.  A thief may still be reading from an old buffer after we
+  // grow, so they are only freed with the deque.  Growth doubles, so this at most doubles memory.
+
+  Buffer* grow(Buffer* old, int64_t t, int64_t b) {
+    auto bigger = heap<Buffer>(old->slots.size() * 2);
+    for (int64_t i = t; i < b; i++) {
+      bigger->put(i, old->get(i));
+    }
+    Buffer* result = bigger;
+    buffers.add(kj::mv(bigger));
+    __atomic_store_n(&buffer, result, __ATOMIC_RELEASE);
+    return result;
+  }
+};
+
+}  // namespace
+
+class ThreadPoolWorker {
+public:
+  ThreadPoolWorker(ThreadPool& pool, uint index): pool(pool), index(index) {}
+
+  void start() {
+    thread = heap<Thread>([this]() { loop(); });
+  }
+
+  void join() {
+    thread = nullptr;
+  }
+
+  static ThreadPoolWorker* current();
+
+  ThreadPool& pool;
+  WorkStealingDeque deque;
+
+private:
+  uint index;
+  Own<Thread> thread;
+
+  void loop();
+  ThreadPoolTask* findWork();
+  ThreadPoolTask* waitForWork();
+};
+
+namespace {
+
+KJ_THREADLOCAL_PTR(ThreadPoolWorker) currentWorker = nullptr;
+
+}  // namespace
+
+ThreadPoolWorker* ThreadPoolWorker::current() {
+  return currentWorker;
+}
+
+void ThreadPoolWorker::loop() {
+  currentWorker = this;
+
+  for (;;) {
+    ThreadPoolTask* task = findWork();
+    if (task == nullptr) {
+      task = waitForWork();
+      if (task == nullptr) break;
+
+      // We may have taken a batch from the injection queue.  Keep the first task and make the rest
+      // available for stealing.
+      ThreadPoolTask* rest = task->next;
+      task->next = nullptr;
+      if (rest != nullptr) {
+        while (rest != nullptr) {
+          ThreadPoolTask* next = rest->next;
+          rest->next = nullptr;
+          deque.push(rest);
+          rest = next;
+        }
+        pool.notifyStealable();
+      }
+    }
+
+    Own<ThreadPoolTask> owned(task, HeapDisposer<ThreadPoolTask>::instance);
+    task->run();
+  }
+
+  currentWorker = nullptr;
+}
+
+ThreadPoolTask* ThreadPoolWorker::findWork() {
+  KJ_IF_MAYBE(task, deque.take()) {
+    return task;
+  }
+
+  auto& workers = pool.workers;
+  for (uint i = 1; i < workers.size(); i++) {
+    KJ_IF_MAYBE(task, workers[(index + i) % workers.size()]->deque.steal()) {
+      return task;
+    }
+  }
+
+  return nullptr;
+}
+
+ThreadPoolTask* ThreadPoolWorker::waitForWork() {
+  // Announce that we're idle before the final scan, so that a worker pushing onto its deque
+  // concurrently either sees us and signals, or we see its work.
+  __atomic_add_fetch(&pool.idleCount, 1, __ATOMIC_SEQ_CST);
+  KJ_DEFER(__atomic_sub_fetch(&pool.idleCount, 1, __ATOMIC_SEQ_CST));
+
+  uint threadCount = pool.threadCount;
+  for (;;) {
+    uint64_t signals = pool.shared.lockShared()->signals;
+
+    KJ_IF_MAYBE(task, findWork()) {
+      return task;
+    }
+
+    struct Taken {
+      ThreadPoolTask* batch;
+      bool shuttingDown;
+    };
+    auto taken = pool.shared.when([signals](const ThreadPool::Shared& shared) {
+      return shared.head != nullptr || shared.shuttingDown || shared.signals != signals;
+    }, [threadCount](ThreadPool::Shared& shared) {
+      Taken result = { shared.head, shared.shuttingDown };
+      if (shared.head != nullptr) {
+        // Take a fair share of the queue, leaving the rest for other workers.
+        uint count = kj::min(shared.size / threadCount + 1, MAX_BATCH);
+        ThreadPoolTask** link = &shared.head;
+        for (uint i = 0; i < count && *link != nullptr; i++) {
+          link = &(*link)->next;
+          --shared.size;
+        }
+        shared.head = *link;
+        *link = nullptr;
+        if (shared.head == nullptr) shared.tail = &shared.head;
+      }
+      return result;
+    });
+
+    if (taken.batch != nullptr) return taken.batch;
+    if (taken.shuttingDown) return nullptr;
+  }
+}
+
+}  // namespace _ (private)
+
+// =======================================================================================
+
+ThreadPool::ThreadPool(uint threadCount)
+    : threadCount(threadCount == 0 ? _::defaultThreadCount() : threadCount) {
+  auto builder = heapArrayBuilder<Own<_::ThreadPoolWorker>>(this->threadCount);
+  for (uint i = 0; i < this->threadCount; i++) {
+    builder.add(heap<_::ThreadPoolWorker>(*this, i));
+  }
+  workers = builder.finish();
+
+  // Start threads only once all deques exist, since workers steal from each other.
+  for (auto& worker: workers) {
+    worker->start();
+  }
+}
+
+ThreadPool::~ThreadPool() noexcept(false) {
+  shared.lockExclusive()->shuttingDown = true;
+
+  // Join every thread before destroying any deque, since workers steal from each other.
+  for (auto& worker: workers) {
+    worker->join();
+  }
+}
+
+void ThreadPool::post(Function<void()> func) {
+  submit(new _::PostedTask(kj::mv(func)));
+}
+
+ThreadPool& ThreadPool::getDefault() {
+  // Lookups mostly wait on the network, so allow a few even on small machines.
+  static ThreadPool* pool = new ThreadPool(kj::max(_::defaultThreadCount(), 4u));
+  return *pool;
+}
+
+void ThreadPool::submit(_::ThreadPoolTask* task) {
+  _::ThreadPoolWorker* worker = _::ThreadPoolWorker::current();
+  if (worker != nullptr && &worker->pool == this) {
+    worker->deque.push(task);
+    notifyStealable();
+    return;
+  }
+
+  auto lock = shared.lockExclusive();
+  KJ_REQUIRE(!lock->shuttingDown, "ThreadPool is shutting down") {
+    delete task;
+    return;
+  }
+  *lock->tail = task;
+  lock->tail = &task->next;
+  ++lock->size;
+}
+
+void ThreadPool::notifyStealable() {
+  // Pairs with the fence implied by the idle count increment in waitForWork().
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&idleCount, __ATOMIC_RELAXED) > 0) {
+    ++shared.lockExclusive()->signals;
+  }
+}
+
+}  // namespace kj
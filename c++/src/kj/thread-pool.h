@@ -0,0 +1,163 @@
+// Copyright (c) 2013-2014 Sandstorm Development Group, Inc. and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef KJ_THREAD_POOL_H_
+#define KJ_THREAD_POOL_H_
+
+#if defined(__GNUC__) && !KJ_HEADER_WARNINGS
+#pragma GCC system_header
+#endif
+
+#include "async.h"
+#include "function.h"
+#include "mutex.h"
+
+namespace kj {
+namespace _ {  // private
+
+class ThreadPoolWorker;
+
+class ThreadPoolTask {
+public:
+  virtual ~ThreadPoolTask() noexcept(false);
+  virtual void run() = 0;
+
+  ThreadPoolTask* next = nullptr;
+  // Link in the pool's injection queue.
+};
+
+template <typename T, typename Func>
+inline void callAndFulfill(PromiseFulfiller<T>& fulfiller, Func& func) {
+  fulfiller.fulfill(func());
+}
+template <typename Func>
+inline void callAndFulfill(PromiseFulfiller<void>& fulfiller, Func& func) {
+  func();
+  fulfiller.fulfill();
+}
+
+template <typename Func, typename T>
+class ThreadPoolCall final: public ThreadPoolTask {
+public:
+  template <typename F>
+  ThreadPoolCall(F&& func, Own<PromiseFulfiller<T>>&& fulfiller)
+      : func(kj::fwd<F>(func)), fulfiller(kj::mv(fulfiller)) {}
+
+  void run() override {
+    if (!fulfiller->isWaiting()) {
+      // The caller dropped the promise while the call was queued.
+      return;
+    }
+    KJ_IF_MAYBE(exception, kj::runCatchingExceptions([&]() {
+      callAndFulfill(*fulfiller, func);
+    })) {
+      fulfiller->reject(kj::mv(*exception));
+    }
+  }
+
+private:
+  Func func;
+  Own<PromiseFulfiller<T>> fulfiller;
+};
+
+}  // namespace _ (private)
+
+class ThreadPool {
+  // A fixed set of worker threads for blocking calls (DNS lookups, filesystem access) and
+  // CPU-heavy work, so that such work can be moved off an event loop without paying for a new
+  // kj::Thread each time.
+  //
+  // Work sent from outside the pool goes to a shared injection queue; an idle worker takes a batch
+  // of it into its own work-stealing deque (Chase-Lev), from which other idle workers steal.  Work
+  // posted from a worker thread goes straight to that worker's deque.
+  //
+  // Destroying the pool waits for all queued work to finish, then joins the workers.
+
+public:
+  explicit ThreadPool(uint threadCount = 0);
+  // Zero means one thread per online CPU.
+
+  KJ_DISALLOW_COPY(ThreadPool);
+  ~ThreadPool() noexcept(false);
+
+  template <typename Func>
+  Promise<_::ReturnType<Func, void>> run(Func&& func);
+  // Call `func()` on a worker thread and return a promise for its result, which completes on the
+  // calling thread's EventLoop.  `func` must return a plain value, not a promise: workers do not
+  // have event loops.  Like anything sent between threads, `func` and its result must not refer
+  // to objects belonging to the caller's EventLoop.
+  //
+  // If the promise is dropped before a worker gets to `func`, the call is skipped.  Once `func` has
+  // started it runs to completion.
+
+  void post(Function<void()> func);
+  // Queue `func` to run on a worker thread, with no result.  May be called from any thread,
+  // including the pool's own workers, e.g. to split up a large job.  Exceptions are logged.
+
+  uint getThreadCount() const { return threadCount; }
+
+  static ThreadPool& getDefault();
+  // A process-wide pool, created on first use and never destroyed.  KJ uses it for getaddrinfo().
+
+private:
+  struct Shared {
+    _::ThreadPoolTask* head = nullptr;
+    _::ThreadPoolTask** tail = &head;
+    uint size = 0;
+    // Injection queue, FIFO.
+
+    uint64_t signals = 0;
+    // Bumped when a worker pushes stealable work onto its deque while other workers are idle.
+
+    bool shuttingDown = false;
+  };
+
+  uint threadCount;
+  MutexGuarded<Shared> shared;
+
+  uint idleCount = 0;
+  // Workers currently out of work, or about to be.  Accessed atomically.
+
+  Array<Own<_::ThreadPoolWorker>> workers;
+
+  void submit(_::ThreadPoolTask* task);
+  void notifyStealable();
+
+  friend class _::ThreadPoolWorker;
+};
+
+// =======================================================================================
+// inline implementation details
+
+template <typename Func>
+Promise<_::ReturnType<Func, void>> ThreadPool::run(Func&& func) {
+  typedef _::ReturnType<Func, void> T;
+  static_assert(isSameType<_::JoinPromises<T>, T>(),
+                "ThreadPool::run() functions cannot return promises");
+
+  auto paf = newCrossThreadPromiseAndFulfiller<T>();
+  submit(new _::ThreadPoolCall<Decay<Func>, T>(kj::fwd<Func>(func), kj::mv(paf.fulfiller)));
+  return kj::mv(paf.promise);
+}
+
+}  // namespace kj
+
+#endif  // KJ_THREAD_POOL_H_
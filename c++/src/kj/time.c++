@@ -22,7 +22,9 @@
 
 #include "time.h"
 #include "debug.h"
-#include <set>
+#include "vector.h"
+#include <algorithm>
+#include <string.h>
 
 namespace kj {
 
@@ -39,44 +41,256 @@ Clock& nullClock() {
   return NULL_CLOCK;
 }
 
+// =======================================================================================
+// TimerImpl
+//
+// Pending timers live in a hierarchical timing wheel: LEVELS levels of SLOTS slots each, where
+// a slot at level L spans SLOTS^L ticks. A timer is filed under the most significant base-SLOTS
+// digit in which its tick differs from the current tick, so inserting and cancelling are O(1)
+// list operations. As the current tick reaches a higher-level slot, that slot's timers are
+// "cascaded" down to finer levels; most timers (RPC timeouts, say) are cancelled long before
+// that happens.
+//
+// Everything at level 0 is earlier than everything at level 1, and so on, so the earliest
+// timer is always in the first occupied slot of the lowest occupied level.
+
+namespace {
+
+constexpr uint SLOT_BITS = 6;
+constexpr uint SLOTS = 1u << SLOT_BITS;
+constexpr uint LEVELS = (64 + SLOT_BITS - 1) / SLOT_BITS;
+
+constexpr uint EXACT_TICK_SHIFT = 20;
+// In exact mode, a tick is 2^20ns (about a millisecond). The tick only controls how timers are
+// bucketed; they still fire at exactly their scheduled time.
+
+inline uint countTrailingZeros(uint64_t value) {
+#if _MSC_VER
+  unsigned long result;
+  _BitScanForward64(&result, value);
+  return result;
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
+inline uint highestSetBit(uint64_t value) {
+#if _MSC_VER
+  unsigned long result;
+  _BitScanReverse64(&result, value);
+  return result;
+#else
+  return 63 - __builtin_clzll(value);
+#endif
+}
+
+inline uint digitAt(uint64_t tick, uint level) {
+  return (tick >> (level * SLOT_BITS)) & (SLOTS - 1);
+}
+
+}  // namespace
+
 struct TimerImpl::Impl {
-  struct TimerBefore {
-    bool operator()(TimerPromiseAdapter* lhs, TimerPromiseAdapter* rhs);
-  };
-  using Timers = std::multiset<TimerPromiseAdapter*, TimerBefore>;
-  Timers timers;
+  Impl(TimePoint base, Duration slack): base(base), slack(slack) {
+    memset(slots, 0, sizeof(slots));
+    memset(occupied, 0, sizeof(occupied));
+  }
+
+  const TimePoint base;
+  // Tick zero. Times before this are treated as already past.
+
+  const Duration slack;
+  // Zero for exact mode; otherwise the tick length, with deadlines rounded up to a tick boundary.
+
+  uint64_t currentTick = 0;
+
+  uint64_t nextSequence = 0;
+
+  TimerPromiseAdapter* slots[LEVELS][SLOTS];
+  uint64_t occupied[LEVELS];
+  // Bit i of occupied[L] is set iff slots[L][i] is non-empty.
+
+  Vector<TimerPromiseAdapter*> due;
+  // Scratch space for advanceTo(), kept to avoid reallocating.
+
+  uint64_t tickFor(TimePoint time) const;
+  TimePoint startOfTick(uint64_t tick) const;
+  void insert(TimerPromiseAdapter& timer);
+  void remove(TimerPromiseAdapter& timer);
+  Maybe<uint64_t> nextInterestingTick(uint& level) const;
+  void cascade(uint level);
+  void fireDue(TimePoint now);
+  Maybe<TimePoint> nextEvent() const;
 };
 
 class TimerImpl::TimerPromiseAdapter {
 public:
   TimerPromiseAdapter(PromiseFulfiller<void>& fulfiller, TimerImpl::Impl& impl, TimePoint time)
-      : time(time), fulfiller(fulfiller), impl(impl) {
-    pos = impl.timers.insert(this);
+      : time(time), tick(impl.tickFor(time)), sequence(impl.nextSequence++),
+        fulfiller(fulfiller), impl(impl) {
+    impl.insert(*this);
   }
 
   ~TimerPromiseAdapter() {
-    if (pos != impl.timers.end()) {
-      impl.timers.erase(pos);
+    if (prev != nullptr) {
+      impl.remove(*this);
     }
   }
 
   void fulfill() {
+    impl.remove(*this);
     fulfiller.fulfill();
-    impl.timers.erase(pos);
-    pos = impl.timers.end();
   }
 
   const TimePoint time;
+  const uint64_t tick;
+  const uint64_t sequence;
+  // Breaks ties between timers scheduled for the same time: they fire in order of creation.
+
+  TimerPromiseAdapter* next = nullptr;
+  TimerPromiseAdapter** prev = nullptr;
+  // Position in the slot's list. `prev` is null when not in the wheel.
+
+  uint8_t level;
+  uint8_t slot;
 
 private:
   PromiseFulfiller<void>& fulfiller;
   TimerImpl::Impl& impl;
-  Impl::Timers::const_iterator pos;
 };
 
-inline bool TimerImpl::Impl::TimerBefore::operator()(
-    TimerPromiseAdapter* lhs, TimerPromiseAdapter* rhs) {
-  return lhs->time < rhs->time;
+uint64_t TimerImpl::Impl::tickFor(TimePoint time) const {
+  if (time <= base) return 0;
+  Duration offset = time - base;
+  if (slack == 0 * NANOSECONDS) {
+    return (offset / NANOSECONDS) >> EXACT_TICK_SHIFT;
+  } else {
+    // Round up so that the timer never fires early.
+    return offset / slack + (offset % slack > 0 * NANOSECONDS);
+  }
+}
+
+TimePoint TimerImpl::Impl::startOfTick(uint64_t tick) const {
+  if (slack == 0 * NANOSECONDS) {
+    return base + (tick << EXACT_TICK_SHIFT) * NANOSECONDS;
+  } else {
+    return base + tick * slack;
+  }
+}
+
+void TimerImpl::Impl::insert(TimerPromiseAdapter& timer) {
+  // Timers that are already due go in the current slot and fire on the next advanceTo().
+  uint64_t tick = kj::max(timer.tick, currentTick);
+  uint64_t diff = tick ^ currentTick;
+  uint level = diff == 0 ? 0 : highestSetBit(diff) / SLOT_BITS;
+  uint slot = digitAt(tick, level);
+
+  timer.level = level;
+  timer.slot = slot;
+
+  TimerPromiseAdapter*& head = slots[level][slot];
+  timer.next = head;
+  timer.prev = &head;
+  if (head != nullptr) {
+    head->prev = &timer.next;
+  }
+  head = &timer;
+  occupied[level] |= uint64_t(1) << slot;
+}
+
+void TimerImpl::Impl::remove(TimerPromiseAdapter& timer) {
+  *timer.prev = timer.next;
+  if (timer.next != nullptr) {
+    timer.next->prev = timer.prev;
+  }
+  if (slots[timer.level][timer.slot] == nullptr) {
+    occupied[timer.level] &= ~(uint64_t(1) << timer.slot);
+  }
+  timer.next = nullptr;
+  timer.prev = nullptr;
+}
+
+Maybe<uint64_t> TimerImpl::Impl::nextInterestingTick(uint& level) const {
+  // Returns the next tick after currentTick at which something happens: either a level-0 slot
+  // comes due or a higher-level slot must be cascaded. Sets `level` to the level concerned.
+
+  for (uint l = 0; l < LEVELS; l++) {
+    uint digit = digitAt(currentTick, l);
+    uint64_t later = digit == SLOTS - 1 ? 0 : occupied[l] & (~uint64_t(0) << (digit + 1));
+    if (later != 0) {
+      uint shift = l * SLOT_BITS;
+      uint64_t above = shift + SLOT_BITS >= 64 ? 0 :
+          (currentTick >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+      level = l;
+      return above | (uint64_t(countTrailingZeros(later)) << shift);
+    }
+  }
+  return nullptr;
+}
+
+void TimerImpl::Impl::cascade(uint level) {
+  // currentTick has just entered a slot at `level`; refile its timers at finer levels.
+  uint slot = digitAt(currentTick, level);
+  TimerPromiseAdapter* list = slots[level][slot];
+  slots[level][slot] = nullptr;
+  occupied[level] &= ~(uint64_t(1) << slot);
+
+  while (list != nullptr) {
+    TimerPromiseAdapter* timer = list;
+    list = timer->next;
+    insert(*timer);
+  }
+}
+
+void TimerImpl::Impl::fireDue(TimePoint now) {
+  uint slot = digitAt(currentTick, 0);
+  for (TimerPromiseAdapter* timer = slots[0][slot]; timer != nullptr; timer = timer->next) {
+    // With slack, everything in the current slot is due by construction. In exact mode the
+    // slot may also hold timers scheduled later within the tick.
+    if (slack > 0 * NANOSECONDS || timer->time <= now) {
+      due.add(timer);
+    }
+  }
+  if (due.size() == 0) return;
+
+  // Slots are unordered, so sort what's due by scheduled time.
+  std::sort(due.begin(), due.end(), [](TimerPromiseAdapter* a, TimerPromiseAdapter* b) {
+    return a->time < b->time || (a->time == b->time && a->sequence < b->sequence);
+  });
+  for (auto timer: due) {
+    timer->fulfill();
+  }
+  due.clear();
+}
+
+Maybe<TimePoint> TimerImpl::Impl::nextEvent() const {
+  uint digit = digitAt(currentTick, 0);
+  uint64_t pending = occupied[0] & (~uint64_t(0) << digit);
+  if (pending != 0) {
+    uint slot = countTrailingZeros(pending);
+    uint64_t tick = (currentTick & ~uint64_t(SLOTS - 1)) | slot;
+    if (slack > 0 * NANOSECONDS) {
+      return startOfTick(tick);
+    }
+
+    // Exact mode: the earliest timer is somewhere in this slot.
+    TimerPromiseAdapter* timer = slots[0][slot];
+    TimePoint result = timer->time;
+    for (timer = timer->next; timer != nullptr; timer = timer->next) {
+      result = kj::min(result, timer->time);
+    }
+    return result;
+  }
+
+  uint level;
+  KJ_IF_MAYBE(tick, nextInterestingTick(level)) {
+    // The earliest timer is in a higher-level slot. We don't know exactly when it's due without
+    // scanning the slot, but the slot's start is a valid lower bound: waking then just cascades
+    // the slot and waits again.
+    return startOfTick(*tick);
+  }
+
+  return nullptr;
 }
 
 Promise<void> TimerImpl::atTime(TimePoint time) {
@@ -87,18 +301,15 @@ Promise<void> TimerImpl::afterDelay(Duration delay) {
   return newAdaptedPromise<void, TimerPromiseAdapter>(*impl, time + delay);
 }
 
-TimerImpl::TimerImpl(TimePoint startTime)
-    : time(startTime), impl(heap<Impl>()) {}
+TimerImpl::TimerImpl(TimePoint startTime, Duration slack)
+    : time(startTime), impl(heap<Impl>(startTime, slack)) {
+  KJ_REQUIRE(slack >= 0 * NANOSECONDS, "timer slack can't be negative");
+}
 
 TimerImpl::~TimerImpl() noexcept(false) {}
 
 Maybe<TimePoint> TimerImpl::nextEvent() {
-  auto iter = impl->timers.begin();
-  if (iter == impl->timers.end()) {
-    return nullptr;
-  } else {
-    return (*iter)->time;
-  }
+  return impl->nextEvent();
 }
 
 Maybe<uint64_t> TimerImpl::timeoutToNextEvent(TimePoint start, Duration unit, uint64_t max) {
@@ -122,13 +333,26 @@ void TimerImpl::advanceTo(TimePoint newTime) {
   KJ_REQUIRE(newTime >= time, "can't advance backwards in time") { return; }
 
   time = newTime;
+  uint64_t newTick = impl->tickFor(newTime);
+  if (impl->slack > 0 * NANOSECONDS && impl->startOfTick(newTick) > newTime) {
+    // tickFor() rounds up with slack; we want the last tick that has fully begun.
+    --newTick;
+  }
+
+  impl->fireDue(time);
   for (;;) {
-    auto front = impl->timers.begin();
-    if (front == impl->timers.end() || (*front)->time > time) {
-      break;
+    uint level;
+    KJ_IF_MAYBE(tick, impl->nextInterestingTick(level)) {
+      if (*tick <= newTick) {
+        impl->currentTick = *tick;
+        if (level > 0) impl->cascade(level);
+        impl->fireDue(time);
+        continue;
+      }
     }
-    (*front)->fulfill();
+    break;
   }
+  impl->currentTick = kj::max(impl->currentTick, newTick);
 }
 
 }  // namespace kj
@@ -112,12 +112,19 @@ class TimerImpl final: public Timer {
   // implementation -- to tell it when time has advanced.
 
 public:
-  TimerImpl(TimePoint startTime);
+  TimerImpl(TimePoint startTime, Duration slack = 0 * NANOSECONDS);
+  // With the default slack of zero, timers fire at the first advanceTo() at or after their
+  // scheduled time. A non-zero slack trades precision for cheaper bookkeeping: timers may fire up
+  // to `slack` late, and all timers falling within the same `slack`-sized window fire together.
+  // Creating and cancelling a timer is O(1) either way.
+
   ~TimerImpl() noexcept(false);
 
   Maybe<TimePoint> nextEvent();
   // Returns the time at which the next scheduled timer event will occur, or null if no timer
-  // events are scheduled.
+  // events are scheduled. If the next event is far off, this may return an earlier time at which
+  // the timer needs to do some internal bookkeeping; waking then is harmless, as advanceTo() will
+  // simply fire nothing and nextEvent() will then report a later time.
 
   Maybe<uint64_t> timeoutToNextEvent(TimePoint start, Duration unit, uint64_t max);
   // Convenience method which computes a timeout value to pass to an event-waiting system call to
@@ -139,7 +146,9 @@ public:
   // Set the time to `time` and fire any at() events that have been passed.
 
   // implements Timer ----------------------------------------------------------
-  TimePoint now() override;
+  TimePoint now() override { return time; }
+  // Defined in-class so that it isn't the key function; otherwise every file including this
+  // header would emit TimerImpl's vtable and need to link against kj-async.
   Promise<void> atTime(TimePoint time) override;
   Promise<void> afterDelay(Duration delay) override;
 
@@ -167,8 +176,6 @@ Promise<T> Timer::timeoutAfter(Duration delay, Promise<T>&& promise) {
   }));
 }
 
-inline TimePoint TimerImpl::now() { return time; }
-
 }  // namespace kj
 
 #endif  // KJ_TIME_H_